@@ -132,9 +132,8 @@ static int64_t getmaxrss(void);
 static int ifilter_has_all_input_formats(FilterGraph *fg);
 
 static int run_as_daemon  = 0;
-static int nb_frames_dup = 0;
-static unsigned dup_warning = 1000;
-static int nb_frames_drop = 0;
+static atomic_int nb_frames_dup = 0;
+static atomic_int nb_frames_drop = 0;
 static int64_t decode_error_stat[2];
 static unsigned nb_output_dumped = 0;
 
@@ -167,6 +166,8 @@ static int restore_tty;
 
 #if HAVE_THREADS
 static void free_input_threads(void);
+static void free_output_threads(void);
+static int free_encoder_threads(void);
 #endif
 
 /* sub2video hack:
@@ -344,7 +345,7 @@ static volatile int received_sigterm = 0;
 static volatile int received_nb_signals = 0;
 static atomic_int transcode_init_done = ATOMIC_VAR_INIT(0);
 static volatile int ffmpeg_exited = 0;
-static int main_return_code = 0;
+static atomic_int main_return_code = ATOMIC_VAR_INIT(0);
 static int64_t copy_ts_first_pts = AV_NOPTS_VALUE;
 
 static void
@@ -516,6 +517,21 @@ static void ffmpeg_cleanup(int ret)
 {
     int i, j;
 
+#if HAVE_THREADS
+    /* A fatal error in an encoder thread only stops that thread, the main
+     * thread exits when it notices. */
+    for (i = 0; i < nb_output_streams; i++) {
+        OutputStream *ost = output_streams[i];
+        if (ost && ost->enc_thread_queue && pthread_equal(ost->enc_thread, pthread_self())) {
+            av_thread_message_queue_set_err_send(ost->enc_thread_queue, AVERROR_EXIT);
+            pthread_exit((void *)(intptr_t)AVERROR_EXIT);
+        }
+    }
+
+    /* the encoder threads use the filtergraphs and the output files */
+    free_encoder_threads();
+#endif
+
     if (do_benchmark) {
         int maxrss = getmaxrss() / 1024;
         av_log(NULL, AV_LOG_INFO, "bench: maxrss=%ikB\n", maxrss);
@@ -568,6 +584,10 @@ static void ffmpeg_cleanup(int ret)
 
     av_freep(&subtitle_out);
 
+#if HAVE_THREADS
+    free_output_threads();
+#endif
+
     /* close files */
     for (i = 0; i < nb_output_files; i++) {
         OutputFile *of = output_files[i];
@@ -653,6 +673,7 @@ static void ffmpeg_cleanup(int ret)
                    av_err2str(AVERROR(errno)));
     }
     av_freep(&vstats_filename);
+    av_freep(&filter_thread_type);
 
     av_freep(&input_streams);
     av_freep(&input_files);
@@ -722,10 +743,144 @@ static void close_all_output_streams(OutputStream *ost, OSTFinished this_stream,
     int i;
     for (i = 0; i < nb_output_streams; i++) {
         OutputStream *ost2 = output_streams[i];
-        ost2->finished |= ost == ost2 ? this_stream : others;
+        atomic_fetch_or(&ost2->finished, ost == ost2 ? this_stream : others);
     }
 }
 
+/* Publish the muxer state of a stream for choose_output() and print_report(). */
+static void update_mux_progress(OutputStream *ost)
+{
+    atomic_store(&ost->mux_cur_dts, ost->st->cur_dts);
+    atomic_store(&ost->mux_end_pts, av_stream_get_end_pts(ost->st));
+}
+
+#if HAVE_THREADS
+static void *mux_thread(void *arg)
+{
+    OutputFile *of = arg;
+    AVFormatContext *s = of->ctx;
+    OutputStream *ost;
+    AVPacket *pkt;
+    int ret;
+
+    while (1) {
+        ret = av_thread_message_queue_recv(of->mux_thread_queue, &pkt, 0);
+        if (ret < 0) {
+            if (ret == AVERROR_EOF)
+                ret = 0;
+            break;
+        }
+
+        ost = output_streams[of->ost_index + pkt->stream_index];
+        ret = av_interleaved_write_frame(s, pkt);
+        av_packet_free(&pkt);
+        if (ret < 0) {
+            print_error("av_interleaved_write_frame()", ret);
+            av_thread_message_queue_set_err_send(of->mux_thread_queue, ret);
+            break;
+        }
+        update_mux_progress(ost);
+        if (s->pb)
+            atomic_store(&of->last_filesize, avio_tell(s->pb));
+    }
+
+    return (void *)(intptr_t)ret;
+}
+
+static int send_packet_to_mux_thread(OutputFile *of, AVPacket *pkt)
+{
+    AVPacket *queue_pkt;
+    int ret;
+
+    /* the packet may point to data owned by the caller, e.g. subtitles */
+    ret = av_packet_make_refcounted(pkt);
+    if (ret < 0)
+        return ret;
+
+    queue_pkt = av_packet_alloc();
+    if (!queue_pkt)
+        return AVERROR(ENOMEM);
+    av_packet_move_ref(queue_pkt, pkt);
+
+    /* blocks while the queue is full, throttling the encoders to the muxer */
+    ret = av_thread_message_queue_send(of->mux_thread_queue, &queue_pkt, 0);
+    if (ret < 0)
+        av_packet_free(&queue_pkt);
+    return ret;
+}
+
+static int init_output_thread(OutputFile *of)
+{
+    int ret;
+
+    if (of->thread_queue_size < 0)
+        of->thread_queue_size = 8;
+    if (!of->thread_queue_size)
+        return 0;
+
+    ret = av_thread_message_queue_alloc(&of->mux_thread_queue,
+                                        of->thread_queue_size, sizeof(AVPacket *));
+    if (ret < 0)
+        return ret;
+
+    if ((ret = pthread_create(&of->mux_thread, NULL, mux_thread, of))) {
+        av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+        av_thread_message_queue_free(&of->mux_thread_queue);
+        return AVERROR(ret);
+    }
+
+    return 0;
+}
+
+/* Wait for all queued packets to be written, then stop the muxer thread. */
+static void free_output_thread(int i)
+{
+    OutputFile *of = output_files[i];
+    AVPacket *pkt;
+    void *thread_ret;
+
+    if (!of || !of->mux_thread_queue)
+        return;
+    av_thread_message_queue_set_err_recv(of->mux_thread_queue, AVERROR_EOF);
+    pthread_join(of->mux_thread, &thread_ret);
+    if ((intptr_t)thread_ret < 0)
+        atomic_store(&main_return_code, 1);
+
+    /* packets left over after a muxing error */
+    while (av_thread_message_queue_recv(of->mux_thread_queue, &pkt, 0) >= 0)
+        av_packet_free(&pkt);
+    av_thread_message_queue_free(&of->mux_thread_queue);
+}
+
+static void free_output_threads(void)
+{
+    int i;
+
+    for (i = 0; i < nb_output_files; i++)
+        free_output_thread(i);
+}
+#endif
+
+/* Current size of the output file, safe to call while it is being written. */
+static int64_t output_file_size(OutputFile *of, int total)
+{
+    AVIOContext *pb = of->ctx->pb;
+    int64_t size;
+
+    if (!pb)
+        return AVERROR(EINVAL);
+#if HAVE_THREADS
+    if (of->mux_thread_queue)
+        return atomic_load(&of->last_filesize);
+#endif
+    if (!total)
+        return avio_tell(pb);
+    size = avio_size(pb);
+    if (size <= 0) // FIXME improve avio_size() so it works with non seekable output too
+        size = avio_tell(pb);
+    return size;
+}
+
 static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int unqueue)
 {
     AVFormatContext *s = of->ctx;
@@ -741,11 +896,11 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
      * Do not count the packet when unqueued because it has been counted when queued.
      */
     if (!(st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && ost->encoding_needed) && !unqueue) {
-        if (ost->frame_number >= ost->max_frames) {
+        if (atomic_load(&ost->frame_number) >= ost->max_frames) {
             av_packet_unref(pkt);
             return;
         }
-        ost->frame_number++;
+        atomic_fetch_add(&ost->frame_number, 1);
     }
 
     if (!of->header_written) {
@@ -789,14 +944,14 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
         int i;
         uint8_t *sd = av_packet_get_side_data(pkt, AV_PKT_DATA_QUALITY_STATS,
                                               NULL);
-        ost->quality = sd ? AV_RL32(sd) : -1;
-        ost->pict_type = sd ? sd[4] : AV_PICTURE_TYPE_NONE;
+        atomic_store(&ost->quality, sd ? AV_RL32(sd) : -1);
+        atomic_store(&ost->pict_type, sd ? sd[4] : AV_PICTURE_TYPE_NONE);
 
         for (i = 0; i<FF_ARRAY_ELEMS(ost->error); i++) {
             if (sd && i < sd[5])
-                ost->error[i] = AV_RL64(sd + 8 + 8*i);
+                atomic_store(&ost->error[i], AV_RL64(sd + 8 + 8*i));
             else
-                ost->error[i] = -1;
+                atomic_store(&ost->error[i], -1);
         }
 
         if (ost->frame_rate.num && ost->is_cfr) {
@@ -863,12 +1018,26 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
               );
     }
 
+#if HAVE_THREADS
+    if (of->mux_thread_queue) {
+        ret = send_packet_to_mux_thread(of, pkt);
+        if (ret < 0) {
+            /* the muxer thread has already reported the actual error */
+            atomic_store(&main_return_code, 1);
+            close_all_output_streams(ost, MUXER_FINISHED | ENCODER_FINISHED, ENCODER_FINISHED);
+        }
+        av_packet_unref(pkt);
+        return;
+    }
+#endif
+
     ret = av_interleaved_write_frame(s, pkt);
     if (ret < 0) {
         print_error("av_interleaved_write_frame()", ret);
-        main_return_code = 1;
+        atomic_store(&main_return_code, 1);
         close_all_output_streams(ost, MUXER_FINISHED | ENCODER_FINISHED, ENCODER_FINISHED);
-    }
+    } else
+        update_mux_progress(ost);
     av_packet_unref(pkt);
 }
 
@@ -876,7 +1045,7 @@ static void close_output_stream(OutputStream *ost)
 {
     OutputFile *of = output_files[ost->file_index];
 
-    ost->finished |= ENCODER_FINISHED;
+    atomic_fetch_or(&ost->finished, ENCODER_FINISHED);
     if (of->shortest) {
         int64_t end = av_rescale_q(ost->sync_opts - ost->first_pts, ost->enc_ctx->time_base, AV_TIME_BASE_Q);
         of->recording_time = FFMIN(of->recording_time, end);
@@ -1008,8 +1177,6 @@ static void do_audio_out(OutputFile *of, OutputStream *ost,
     AVPacket *pkt = ost->pkt;
     int ret;
 
-    adjust_frame_pts_to_encoder_tb(of, ost, frame);
-
     if (!check_recording_time(ost))
         return;
 
@@ -1144,27 +1311,22 @@ static void do_subtitle_out(OutputFile *of,
 
 static void do_video_out(OutputFile *of,
                          OutputStream *ost,
-                         AVFrame *next_picture)
+                         AVFrame *next_picture,
+                         double sync_ipts,
+                         AVRational frame_rate)
 {
     int ret, format_video_sync;
     AVPacket *pkt = ost->pkt;
     AVCodecContext *enc = ost->enc_ctx;
-    AVRational frame_rate;
     int nb_frames, nb0_frames, i;
     double delta, delta0;
     double duration = 0;
-    double sync_ipts = AV_NOPTS_VALUE;
     int frame_size = 0;
     InputStream *ist = NULL;
-    AVFilterContext *filter = ost->filter->filter;
-
-    init_output_stream_wrapper(ost, next_picture, 1);
-    sync_ipts = adjust_frame_pts_to_encoder_tb(of, ost, next_picture);
 
     if (ost->source_index >= 0)
         ist = input_streams[ost->source_index];
 
-    frame_rate = av_buffersink_get_frame_rate(filter);
     if (frame_rate.num > 0 && frame_rate.den > 0)
         duration = 1/(av_q2d(frame_rate) * av_q2d(enc->time_base));
 
@@ -1226,7 +1388,7 @@ static void do_video_out(OutputFile *of,
 
         switch (format_video_sync) {
         case VSYNC_VSCFR:
-            if (ost->frame_number == 0 && delta0 >= 0.5) {
+            if (!atomic_load(&ost->frame_number) && delta0 >= 0.5) {
                 av_log(NULL, AV_LOG_DEBUG, "Not duplicating %d initial frames\n", (int)lrintf(delta0));
                 delta = duration;
                 delta0 = 0;
@@ -1234,7 +1396,7 @@ static void do_video_out(OutputFile *of,
             }
         case VSYNC_CFR:
             // FIXME set to 0.5 after we fix some dts/pts bugs like in avidec.c
-            if (frame_drop_threshold && delta < frame_drop_threshold && ost->frame_number) {
+            if (frame_drop_threshold && delta < frame_drop_threshold && atomic_load(&ost->frame_number)) {
                 nb_frames = 0;
             } else if (delta < -1.1)
                 nb_frames = 0;
@@ -1259,7 +1421,7 @@ static void do_video_out(OutputFile *of,
         }
     }
 
-    nb_frames = FFMIN(nb_frames, ost->max_frames - ost->frame_number);
+    nb_frames = FFMIN(nb_frames, ost->max_frames - atomic_load(&ost->frame_number));
     nb0_frames = FFMIN(nb0_frames, nb_frames);
 
     memmove(ost->last_nb0_frames + 1,
@@ -1268,23 +1430,27 @@ static void do_video_out(OutputFile *of,
     ost->last_nb0_frames[0] = nb0_frames;
 
     if (nb0_frames == 0 && ost->last_dropped) {
-        nb_frames_drop++;
+        atomic_fetch_add(&nb_frames_drop, 1);
         av_log(NULL, AV_LOG_VERBOSE,
                "*** dropping frame %d from stream %d at ts %"PRId64"\n",
-               ost->frame_number, ost->st->index, ost->last_frame->pts);
+               atomic_load(&ost->frame_number), ost->st->index, ost->last_frame->pts);
     }
     if (nb_frames > (nb0_frames && ost->last_dropped) + (nb_frames > nb0_frames)) {
+        int nb_dups = nb_frames - (nb0_frames && ost->last_dropped) - (nb_frames > nb0_frames);
+        unsigned dup_warning;
+        int prev_dups;
+
         if (nb_frames > dts_error_threshold * 30) {
             av_log(NULL, AV_LOG_ERROR, "%d frame duplication too large, skipping\n", nb_frames - 1);
-            nb_frames_drop++;
+            atomic_fetch_add(&nb_frames_drop, 1);
             return;
         }
-        nb_frames_dup += nb_frames - (nb0_frames && ost->last_dropped) - (nb_frames > nb0_frames);
+        prev_dups = atomic_fetch_add(&nb_frames_dup, nb_dups);
         av_log(NULL, AV_LOG_VERBOSE, "*** %d dup!\n", nb_frames - 1);
-        if (nb_frames_dup > dup_warning) {
-            av_log(NULL, AV_LOG_WARNING, "More than %d frames duplicated\n", dup_warning);
-            dup_warning *= 10;
-        }
+        /* warn at 1000, 10000, ... duplicates, from the thread crossing the step */
+        for (dup_warning = 1000; dup_warning * 10LL < prev_dups + nb_dups; dup_warning *= 10);
+        if (prev_dups + nb_dups > dup_warning && prev_dups <= dup_warning)
+            av_log(NULL, AV_LOG_WARNING, "More than %u frames duplicated\n", dup_warning);
     }
     ost->last_dropped = nb_frames == nb0_frames && next_picture;
 
@@ -1412,7 +1578,7 @@ static void do_video_out(OutputFile *of,
          * But there may be reordering, so we can't throw away frames on encoder
          * flush, we need to limit them here, before they go into encoder.
          */
-        ost->frame_number++;
+        atomic_fetch_add(&ost->frame_number, 1);
 
         if (vstats_filename && frame_size)
             do_video_stats(ost, frame_size);
@@ -1441,6 +1607,7 @@ static void do_video_stats(OutputStream *ost, int frame_size)
 {
     AVCodecContext *enc;
     int frame_number;
+    int64_t error;
     double ti1, bitrate, avg_bitrate;
 
     /* this is executed just the first time do_video_stats is called */
@@ -1457,18 +1624,19 @@ static void do_video_stats(OutputStream *ost, int frame_size)
         frame_number = ost->st->nb_frames;
         if (vstats_version <= 1) {
             fprintf(vstats_file, "frame= %5d q= %2.1f ", frame_number,
-                    ost->quality / (float)FF_QP2LAMBDA);
+                    atomic_load(&ost->quality) / (float)FF_QP2LAMBDA);
         } else  {
             fprintf(vstats_file, "out= %2d st= %2d frame= %5d q= %2.1f ", ost->file_index, ost->index, frame_number,
-                    ost->quality / (float)FF_QP2LAMBDA);
+                    atomic_load(&ost->quality) / (float)FF_QP2LAMBDA);
         }
 
-        if (ost->error[0]>=0 && (enc->flags & AV_CODEC_FLAG_PSNR))
-            fprintf(vstats_file, "PSNR= %6.2f ", psnr(ost->error[0] / (enc->width * enc->height * 255.0 * 255.0)));
+        error = atomic_load(&ost->error[0]);
+        if (error >= 0 && (enc->flags & AV_CODEC_FLAG_PSNR))
+            fprintf(vstats_file, "PSNR= %6.2f ", psnr(error / (enc->width * enc->height * 255.0 * 255.0)));
 
         fprintf(vstats_file,"f_size= %6d ", frame_size);
         /* compute pts value */
-        ti1 = av_stream_get_end_pts(ost->st) * av_q2d(ost->st->time_base);
+        ti1 = atomic_load(&ost->mux_end_pts) * av_q2d(ost->st->time_base);
         if (ti1 < 0.01)
             ti1 = 0.01;
 
@@ -1476,7 +1644,7 @@ static void do_video_stats(OutputStream *ost, int frame_size)
         avg_bitrate = (double)(ost->data_size * 8) / ti1 / 1000.0;
         fprintf(vstats_file, "s_size= %8.0fkB time= %0.3f br= %7.1fkbits/s avg_br= %7.1fkbits/s ",
                (double)ost->data_size / 1024, ti1, bitrate, avg_bitrate);
-        fprintf(vstats_file, "type= %c\n", av_get_picture_type_char(ost->pict_type));
+        fprintf(vstats_file, "type= %c\n", av_get_picture_type_char(atomic_load(&ost->pict_type)));
     }
 }
 
@@ -1485,12 +1653,154 @@ static void finish_output_stream(OutputStream *ost)
     OutputFile *of = output_files[ost->file_index];
     int i;
 
-    ost->finished = ENCODER_FINISHED | MUXER_FINISHED;
+    atomic_store(&ost->finished, ENCODER_FINISHED | MUXER_FINISHED);
 
     if (of->shortest) {
         for (i = 0; i < of->ctx->nb_streams; i++)
-            output_streams[of->ost_index + i]->finished = ENCODER_FINISHED | MUXER_FINISHED;
+            atomic_store(&output_streams[of->ost_index + i]->finished, ENCODER_FINISHED | MUXER_FINISHED);
+    }
+}
+
+/* A filtered frame with what do_video_out() needs from the filtergraph, which
+ * may be reconfigured by the main thread while the frame is encoded. */
+typedef struct EncodeJob {
+    AVFrame *frame;         /* NULL to flush the video frame rate conversion */
+    double float_pts;       /* frame pts in the encoder time base */
+    AVRational frame_rate;
+} EncodeJob;
+
+static void encode_frame(OutputFile *of, OutputStream *ost, EncodeJob *job)
+{
+    AVCodecContext *enc = ost->enc_ctx;
+
+    if (enc->codec_type == AVMEDIA_TYPE_VIDEO) {
+        if (job->frame && !ost->frame_aspect_ratio.num)
+            enc->sample_aspect_ratio = job->frame->sample_aspect_ratio;
+
+        do_video_out(of, ost, job->frame, job->float_pts, job->frame_rate);
+    } else {
+        do_audio_out(of, ost, job->frame);
+    }
+}
+
+#if HAVE_THREADS
+static void *encoder_thread(void *arg)
+{
+    OutputStream *ost = arg;
+    OutputFile    *of = output_files[ost->file_index];
+    EncodeJob job;
+
+    /* fatal errors end the thread from ffmpeg_cleanup() */
+    while (av_thread_message_queue_recv(ost->enc_thread_queue, &job, 0) >= 0) {
+        encode_frame(of, ost, &job);
+        av_frame_free(&job.frame);
     }
+
+    return NULL;
+}
+
+/*
+ * The encoder threads lag behind the main thread, so nothing the main thread
+ * decides may depend on their progress: -shortest and -frames end all the
+ * streams of the file when one of them ends. The per-stage benchmark and the
+ * video statistics file are not thread safe.
+ */
+static int can_encode_in_thread(OutputFile *of)
+{
+    int i;
+
+    if (!of->mux_thread_queue || of->shortest || do_benchmark_all || vstats_filename)
+        return 0;
+    for (i = 0; i < of->ctx->nb_streams; i++)
+        if (output_streams[of->ost_index + i]->max_frames != INT64_MAX)
+            return 0;
+    return 1;
+}
+
+static void init_encoder_thread(OutputFile *of, OutputStream *ost)
+{
+    int ret;
+
+    ret = av_thread_message_queue_alloc(&ost->enc_thread_queue,
+                                        of->thread_queue_size, sizeof(EncodeJob));
+    if (ret < 0)
+        exit_program(1);
+
+    if ((ret = pthread_create(&ost->enc_thread, NULL, encoder_thread, ost))) {
+        av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+        av_thread_message_queue_free(&ost->enc_thread_queue);
+        exit_program(1);
+    }
+}
+
+/* Wait for the queued frames to be encoded, then stop the encoder thread. */
+static int free_encoder_thread(OutputStream *ost)
+{
+    EncodeJob job;
+    void *thread_ret;
+
+    if (!ost || !ost->enc_thread_queue)
+        return 0;
+    av_thread_message_queue_set_err_recv(ost->enc_thread_queue, AVERROR_EOF);
+    pthread_join(ost->enc_thread, &thread_ret);
+
+    /* frames left over after an encoding error */
+    while (av_thread_message_queue_recv(ost->enc_thread_queue, &job, 0) >= 0)
+        av_frame_free(&job.frame);
+    av_thread_message_queue_free(&ost->enc_thread_queue);
+
+    return (intptr_t)thread_ret;
+}
+
+static int free_encoder_threads(void)
+{
+    int i, ret = 0;
+
+    for (i = 0; i < nb_output_streams; i++)
+        ret = FFMIN(ret, free_encoder_thread(output_streams[i]));
+    return ret;
+}
+#endif
+
+/**
+ * Encode a frame from the filtergraph, or flush the video frame rate
+ * conversion if frame is NULL. Once the output file is initialized, this is
+ * done by a thread per output stream when possible.
+ */
+static void send_frame_to_encoder(OutputFile *of, OutputStream *ost, AVFrame *frame)
+{
+    AVFilterContext *filter = ost->filter->filter;
+    EncodeJob job = { frame };
+
+    if (av_buffersink_get_type(filter) == AVMEDIA_TYPE_VIDEO) {
+        init_output_stream_wrapper(ost, frame, 1);
+        job.frame_rate = av_buffersink_get_frame_rate(filter);
+    }
+    job.float_pts = adjust_frame_pts_to_encoder_tb(of, ost, frame);
+
+#if HAVE_THREADS
+    if (!ost->enc_thread_queue && can_encode_in_thread(of))
+        init_encoder_thread(of, ost);
+    if (ost->enc_thread_queue) {
+        int ret;
+
+        if (frame) {
+            if (!(job.frame = av_frame_alloc()))
+                exit_program(1);
+            av_frame_move_ref(job.frame, frame);
+        }
+        /* blocks while the queue is full, throttling the filters to the encoder */
+        ret = av_thread_message_queue_send(ost->enc_thread_queue, &job, 0);
+        if (ret < 0) {
+            /* the encoder thread has already reported the actual error */
+            av_frame_free(&job.frame);
+            exit_program(1);
+        }
+        return;
+    }
+#endif
+
+    encode_frame(of, ost, &job);
 }
 
 /**
@@ -1545,21 +1855,18 @@ static int reap_filters(int flush)
                            "Error in av_buffersink_get_frame_flags(): %s\n", av_err2str(ret));
                 } else if (flush && ret == AVERROR_EOF) {
                     if (av_buffersink_get_type(filter) == AVMEDIA_TYPE_VIDEO)
-                        do_video_out(of, ost, NULL);
+                        send_frame_to_encoder(of, ost, NULL);
                 }
                 break;
             }
-            if (ost->finished) {
+            if (atomic_load(&ost->finished)) {
                 av_frame_unref(filtered_frame);
                 continue;
             }
 
             switch (av_buffersink_get_type(filter)) {
             case AVMEDIA_TYPE_VIDEO:
-                if (!ost->frame_aspect_ratio.num)
-                    enc->sample_aspect_ratio = filtered_frame->sample_aspect_ratio;
-
-                do_video_out(of, ost, filtered_frame);
+                send_frame_to_encoder(of, ost, filtered_frame);
                 break;
             case AVMEDIA_TYPE_AUDIO:
                 if (!(enc->codec->capabilities & AV_CODEC_CAP_PARAM_CHANGE) &&
@@ -1568,7 +1875,7 @@ static int reap_filters(int flush)
                            "Audio filter graph output is not normalized and encoder does not support parameter changes\n");
                     break;
                 }
-                do_audio_out(of, ost, filtered_frame);
+                send_frame_to_encoder(of, ost, filtered_frame);
                 break;
             default:
                 // TODO support subtitle filters
@@ -1703,13 +2010,13 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
 {
     AVBPrint buf, buf_script;
     OutputStream *ost;
-    AVFormatContext *oc;
     int64_t total_size;
     AVCodecContext *enc;
     int frame_number, vid, i;
+    int nb_dups, nb_drops;
     double bitrate;
     double speed;
-    int64_t pts = INT64_MIN + 1;
+    int64_t pts = INT64_MIN + 1, end_pts;
     static int64_t last_time = -1;
     static int first_report = 1;
     static int qp_histogram[52];
@@ -1734,11 +2041,7 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
     t = (cur_time-timer_start) / 1000000.0;
 
 
-    oc = output_files[0]->ctx;
-
-    total_size = avio_size(oc->pb);
-    if (total_size <= 0) // FIXME improve avio_size() so it works with non seekable output too
-        total_size = avio_tell(oc->pb);
+    total_size = output_file_size(output_files[0], 1);
 
     vid = 0;
     av_bprint_init(&buf, 0, AV_BPRINT_SIZE_AUTOMATIC);
@@ -1748,7 +2051,7 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
         ost = output_streams[i];
         enc = ost->enc_ctx;
         if (!ost->stream_copy)
-            q = ost->quality / (float) FF_QP2LAMBDA;
+            q = atomic_load(&ost->quality) / (float) FF_QP2LAMBDA;
 
         if (vid && enc->codec_type == AVMEDIA_TYPE_VIDEO) {
             av_bprintf(&buf, "q=%2.1f ", q);
@@ -1758,7 +2061,7 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
         if (!vid && enc->codec_type == AVMEDIA_TYPE_VIDEO) {
             float fps;
 
-            frame_number = ost->frame_number;
+            frame_number = atomic_load(&ost->frame_number);
             fps = t > 1 ? frame_number / t : 0;
             av_bprintf(&buf, "frame=%5d fps=%3.*f q=%3.1f ",
                      frame_number, fps < 9.95, fps, q);
@@ -1777,7 +2080,7 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
                     av_bprintf(&buf, "%X", av_log2(qp_histogram[j] + 1));
             }
 
-            if ((enc->flags & AV_CODEC_FLAG_PSNR) && (ost->pict_type != AV_PICTURE_TYPE_NONE || is_last_report)) {
+            if ((enc->flags & AV_CODEC_FLAG_PSNR) && (atomic_load(&ost->pict_type) != AV_PICTURE_TYPE_NONE || is_last_report)) {
                 int j;
                 double error, error_sum = 0;
                 double scale, scale_sum = 0;
@@ -1789,7 +2092,7 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
                         error = enc->error[j];
                         scale = enc->width * enc->height * 255.0 * 255.0 * frame_number;
                     } else {
-                        error = ost->error[j];
+                        error = atomic_load(&ost->error[j]);
                         scale = enc->width * enc->height * 255.0 * 255.0;
                     }
                     if (j)
@@ -1809,8 +2112,9 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
             vid = 1;
         }
         /* compute min output value */
-        if (av_stream_get_end_pts(ost->st) != AV_NOPTS_VALUE) {
-            pts = FFMAX(pts, av_rescale_q(av_stream_get_end_pts(ost->st),
+        end_pts = atomic_load(&ost->mux_end_pts);
+        if (end_pts != AV_NOPTS_VALUE) {
+            pts = FFMAX(pts, av_rescale_q(end_pts,
                                           ost->st->time_base, AV_TIME_BASE_Q));
             if (copy_ts) {
                 if (copy_ts_first_pts == AV_NOPTS_VALUE && pts > 1)
@@ -1821,7 +2125,7 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
         }
 
         if (is_last_report)
-            nb_frames_drop += ost->last_dropped;
+            atomic_fetch_add(&nb_frames_drop, ost->last_dropped);
     }
 
     secs = FFABS(pts) / AV_TIME_BASE;
@@ -1865,10 +2169,12 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
                    hours_sign, hours, mins, secs, us);
     }
 
-    if (nb_frames_dup || nb_frames_drop)
-        av_bprintf(&buf, " dup=%d drop=%d", nb_frames_dup, nb_frames_drop);
-    av_bprintf(&buf_script, "dup_frames=%d\n", nb_frames_dup);
-    av_bprintf(&buf_script, "drop_frames=%d\n", nb_frames_drop);
+    nb_dups  = atomic_load(&nb_frames_dup);
+    nb_drops = atomic_load(&nb_frames_drop);
+    if (nb_dups || nb_drops)
+        av_bprintf(&buf, " dup=%d drop=%d", nb_dups, nb_drops);
+    av_bprintf(&buf_script, "dup_frames=%d\n", nb_dups);
+    av_bprintf(&buf_script, "drop_frames=%d\n", nb_drops);
 
     if (speed < 0) {
         av_bprintf(&buf, " speed=N/A");
@@ -2012,7 +2318,7 @@ static void flush_encoders(void)
                 output_packet(of, pkt, ost, 1);
                 break;
             }
-            if (ost->finished & MUXER_FINISHED) {
+            if (atomic_load(&ost->finished) & MUXER_FINISHED) {
                 av_packet_unref(pkt);
                 continue;
             }
@@ -2037,7 +2343,7 @@ static int check_output_constraints(InputStream *ist, OutputStream *ost)
     if (ost->source_index != ist_index)
         return 0;
 
-    if (ost->finished)
+    if (atomic_load(&ost->finished))
         return 0;
 
     if (of->start_time != AV_NOPTS_VALUE && ist->pts < of->start_time)
@@ -2061,11 +2367,11 @@ static void do_streamcopy(InputStream *ist, OutputStream *ost, const AVPacket *p
         return;
     }
 
-    if ((!ost->frame_number && !(pkt->flags & AV_PKT_FLAG_KEY)) &&
+    if ((!atomic_load(&ost->frame_number) && !(pkt->flags & AV_PKT_FLAG_KEY)) &&
         !ost->copy_initial_nonkeyframes)
         return;
 
-    if (!ost->frame_number && !ost->copy_prior_start) {
+    if (!atomic_load(&ost->frame_number) && !ost->copy_prior_start) {
         int64_t comp_start = start_time;
         if (copy_ts && f->start_time != AV_NOPTS_VALUE)
             comp_start = FFMAX(start_time, f->start_time + f->ts_offset);
@@ -3044,6 +3350,8 @@ static int check_init_output_file(OutputFile *of, int file_index)
     }
     //assert_avoptions(of->opts);
     of->header_written = 1;
+    for (i = 0; i < of->ctx->nb_streams; i++)
+        update_mux_progress(output_streams[of->ost_index + i]);
 
     av_dump_format(of->ctx, file_index, of->ctx->url, 1);
     nb_output_dumped++;
@@ -3051,6 +3359,12 @@ static int check_init_output_file(OutputFile *of, int file_index)
     if (sdp_filename || want_sdp)
         print_sdp();
 
+#if HAVE_THREADS
+    ret = init_output_thread(of);
+    if (ret < 0)
+        return ret;
+#endif
+
     /* flush the muxing queues */
     for (i = 0; i < of->ctx->nb_streams; i++) {
         OutputStream *ost = output_streams[of->ost_index + i];
@@ -3912,10 +4226,10 @@ static int need_output(void)
         OutputFile *of       = output_files[ost->file_index];
         AVFormatContext *os  = output_files[ost->file_index]->ctx;
 
-        if (ost->finished ||
-            (os->pb && avio_tell(os->pb) >= of->limit_filesize))
+        if (atomic_load(&ost->finished) ||
+            (os->pb && output_file_size(of, 0) >= of->limit_filesize))
             continue;
-        if (ost->frame_number >= ost->max_frames) {
+        if (atomic_load(&ost->frame_number) >= ost->max_frames) {
             int j;
             for (j = 0; j < of->ctx->nb_streams; j++)
                 close_output_stream(output_streams[of->ost_index + j]);
@@ -3941,18 +4255,20 @@ static OutputStream *choose_output(void)
 
     for (i = 0; i < nb_output_streams; i++) {
         OutputStream *ost = output_streams[i];
-        int64_t opts = ost->st->cur_dts == AV_NOPTS_VALUE ? INT64_MIN :
-                       av_rescale_q(ost->st->cur_dts, ost->st->time_base,
+        int64_t cur_dts = atomic_load(&ost->mux_cur_dts);
+        int finished    = atomic_load(&ost->finished);
+        int64_t opts = cur_dts == AV_NOPTS_VALUE ? INT64_MIN :
+                       av_rescale_q(cur_dts, ost->st->time_base,
                                     AV_TIME_BASE_Q);
-        if (ost->st->cur_dts == AV_NOPTS_VALUE)
+        if (cur_dts == AV_NOPTS_VALUE)
             av_log(NULL, AV_LOG_DEBUG,
                 "cur_dts is invalid st:%d (%d) [init:%d i_done:%d finish:%d] (this is harmless if it occurs once at the start per stream)\n",
-                ost->st->index, ost->st->id, ost->initialized, ost->inputs_done, ost->finished);
+                ost->st->index, ost->st->id, ost->initialized, ost->inputs_done, finished);
 
         if (!ost->initialized && !ost->inputs_done)
             return ost;
 
-        if (!ost->finished && opts < opts_min) {
+        if (!finished && opts < opts_min) {
             opts_min = opts;
             ost_min  = ost->unavailable ? NULL : ost;
         }
@@ -4164,12 +4480,14 @@ static int init_input_thread(int i)
     InputFile *f = input_files[i];
 
     if (f->thread_queue_size < 0)
-        f->thread_queue_size = (nb_input_files > 1 ? 8 : 0);
+        f->thread_queue_size = 8;
     if (!f->thread_queue_size)
         return 0;
 
-    if (f->ctx->pb ? !f->ctx->pb->seekable :
-        strcmp(f->ctx->iformat->name, "lavfi"))
+    /* with a single input there is nothing else to do while waiting */
+    if (nb_input_files > 1 &&
+        (f->ctx->pb ? !f->ctx->pb->seekable :
+         strcmp(f->ctx->iformat->name, "lavfi")))
         f->non_blocking = 1;
     ret = av_thread_message_queue_alloc(&f->in_thread_queue,
                                         f->thread_queue_size, sizeof(f->pkt));
@@ -4817,8 +5135,16 @@ static int transcode(void)
             process_input_packet(ist, NULL, 0);
         }
     }
+#if HAVE_THREADS
+    if (free_encoder_threads() < 0)
+        exit_program(1);
+#endif
     flush_encoders();
 
+#if HAVE_THREADS
+    free_output_threads();
+#endif
+
     term_exit();
 
     /* write the trailer if needed and close file */
@@ -5019,6 +5345,6 @@ int main(int argc, char **argv)
     if ((decode_error_stat[0] + decode_error_stat[1]) * max_error_rate < decode_error_stat[1])
         exit_program(69);
 
-    exit_program(received_nb_signals ? 255 : main_return_code);
-    return main_return_code;
+    exit_program(received_nb_signals ? 255 : atomic_load(&main_return_code));
+    return atomic_load(&main_return_code);
 }
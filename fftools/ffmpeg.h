@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <signal.h>
+#include <stdatomic.h>
 
 #include "cmdutils.h"
 
@@ -455,7 +456,7 @@ typedef struct OutputStream {
     int source_index;        /* InputStream index */
     AVStream *st;            /* stream in the output file */
     int encoding_needed;     /* true if encoding needed for this stream */
-    int frame_number;
+    atomic_int frame_number; /* read by the main thread while the encoder thread runs */
     /* input pts and corresponding output pts
        for A/V sync */
     struct InputStream *sync_ist; /* input stream to sync against */
@@ -465,6 +466,10 @@ typedef struct OutputStream {
     int64_t first_pts;
     /* dts of the last packet sent to the muxer */
     int64_t last_mux_dts;
+    /* AVStream.cur_dts and end pts as of the last packet written by the muxer,
+     * which may run in its own thread */
+    atomic_int_least64_t mux_cur_dts;
+    atomic_int_least64_t mux_end_pts;
     // the timebase of the packets sent to the muxer
     AVRational mux_timebase;
     AVRational enc_timebase;
@@ -521,7 +526,7 @@ typedef struct OutputStream {
     AVDictionary *swr_opts;
     AVDictionary *resample_opts;
     char *apad;
-    OSTFinished finished;        /* no more packets should be written for this stream */
+    atomic_int finished;         /* OSTFinished, no more packets should be written for this stream */
     int unavailable;                     /* true if the steram is unavailable (possibly temporarily) */
     int stream_copy;
 
@@ -549,7 +554,7 @@ typedef struct OutputStream {
     uint64_t samples_encoded;
 
     /* packet quality factor */
-    int quality;
+    atomic_int quality;
 
     int max_muxing_queue_size;
 
@@ -566,10 +571,15 @@ typedef struct OutputStream {
     size_t muxing_queue_data_threshold;
 
     /* packet picture type */
-    int pict_type;
+    atomic_int pict_type;
 
     /* frame encode sum of squared error values */
-    int64_t error[4];
+    atomic_int_least64_t error[4];
+
+#if HAVE_THREADS
+    AVThreadMessageQueue *enc_thread_queue;
+    pthread_t enc_thread;       /* thread encoding the filtered frames */
+#endif
 } OutputStream;
 
 typedef struct OutputFile {
@@ -583,6 +593,13 @@ typedef struct OutputFile {
     int shortest;
 
     int header_written;
+
+#if HAVE_THREADS
+    AVThreadMessageQueue *mux_thread_queue;
+    pthread_t mux_thread;       /* thread writing packets to this file */
+    int thread_queue_size;      /* maximum number of queued packets */
+    atomic_int_least64_t last_filesize; /* output size as seen by the muxer thread */
+#endif
 } OutputFile;
 
 extern InputStream **input_streams;
@@ -631,6 +648,7 @@ extern char *videotoolbox_pixfmt;
 
 extern int filter_nbthreads;
 extern int filter_complex_nbthreads;
+extern char *filter_thread_type;
 extern int vstats_version;
 extern int auto_conversion_filters;
 
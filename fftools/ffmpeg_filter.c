@@ -1031,6 +1031,10 @@ int configure_filtergraph(FilterGraph *fg)
         fg->graph->nb_threads = filter_complex_nbthreads;
     }
 
+    if (filter_thread_type &&
+        (ret = av_opt_set(fg->graph, "thread_type", filter_thread_type, 0)) < 0)
+        goto fail;
+
     if ((ret = avfilter_graph_parse2(fg->graph, graph_desc, &inputs, &outputs)) < 0)
         goto fail;
 
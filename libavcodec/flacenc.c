@@ -24,6 +24,7 @@
 #include "libavutil/intmath.h"
 #include "libavutil/md5.h"
 #include "libavutil/opt.h"
+#include "libavutil/slicethread.h"
 
 #include "avcodec.h"
 #include "bswapdsp.h"
@@ -66,6 +67,7 @@ typedef struct CompressionOptions {
     int ch_mode;
     int exact_rice_parameters;
     int multi_dim_quant;
+    int frame_threads;
 } CompressionOptions;
 
 typedef struct RiceContext {
@@ -100,6 +102,17 @@ typedef struct FlacFrame {
     int verbatim_only;
 } FlacFrame;
 
+/**
+ * A frame queued for frame-parallel encoding.
+ */
+typedef struct FlacEncodeJob {
+    AVFrame *frame;
+    AVPacket *pkt;
+    uint32_t frame_count;
+    int max_framesize;
+    int ret;
+} FlacEncodeJob;
+
 typedef struct FlacEncodeContext {
     AVClass *class;
     PutBitContext pb;
@@ -126,6 +139,13 @@ typedef struct FlacEncodeContext {
 
     int flushed;
     int64_t next_pts;
+
+    AVSliceThread *slicethread;           ///< threads for frame-parallel encoding
+    struct FlacEncodeContext *thread_ctx; ///< per-thread contexts for frame-parallel encoding
+    FlacEncodeJob *jobs;
+    int nb_jobs;                          ///< number of frames encoded in parallel
+    int nb_queued;                        ///< frames waiting to be encoded
+    int nb_pending, next_pending;         ///< encoded packets waiting to be returned
 } FlacEncodeContext;
 
 
@@ -236,6 +256,59 @@ static av_cold void dprint_compression_options(FlacEncodeContext *s)
 }
 
 
+static void encode_frame_job(void *priv, int jobnr, int threadnr,
+                             int nb_jobs, int nb_threads);
+
+/**
+ * Set up one context per thread, so that a batch of frames can be encoded
+ * in parallel. Frames do not depend on each other, only the MD5 sum and the
+ * frame size statistics are updated afterwards in submission order.
+ */
+static av_cold int init_frame_threads(AVCodecContext *avctx)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    int i, ret;
+
+    ret = avpriv_slicethread_create(&s->slicethread, s, encode_frame_job,
+                                    NULL, s->options.frame_threads);
+    if (ret == AVERROR(ENOSYS))
+        return 0;
+    if (ret < 0)
+        return ret;
+    if (ret < 2) {
+        avpriv_slicethread_free(&s->slicethread);
+        return 0;
+    }
+
+    s->thread_ctx = av_mallocz_array(ret, sizeof(*s->thread_ctx));
+    s->jobs       = av_mallocz_array(ret, sizeof(*s->jobs));
+    if (!s->thread_ctx || !s->jobs)
+        return AVERROR(ENOMEM);
+    s->nb_jobs = ret;
+
+    for (i = 0; i < s->nb_jobs; i++) {
+        FlacEncodeContext *tc = &s->thread_ctx[i];
+
+        if (!(s->jobs[i].frame = av_frame_alloc()) ||
+            !(s->jobs[i].pkt   = av_packet_alloc()))
+            return AVERROR(ENOMEM);
+
+        memcpy(tc, s, sizeof(*tc));
+        tc->md5ctx      = NULL;
+        tc->md5_buffer  = NULL;
+        tc->slicethread = NULL;
+        tc->thread_ctx  = NULL;
+        tc->jobs        = NULL;
+        ret = ff_lpc_init(&tc->lpc_ctx, avctx->frame_size,
+                          s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+
 static av_cold int flac_encode_init(AVCodecContext *avctx)
 {
     int freq = avctx->sample_rate;
@@ -461,6 +534,9 @@ FF_ENABLE_DEPRECATION_WARNINGS
     ff_flacdsp_init(&s->flac_dsp, avctx->sample_fmt, channels,
                     avctx->bits_per_raw_sample);
 
+    if (ret >= 0 && s->options.frame_threads != 1)
+        ret = init_frame_threads(avctx);
+
     dprint_compression_options(s);
 
     return ret;
@@ -1320,10 +1396,11 @@ static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
 }
 
 
-static int update_md5_sum(FlacEncodeContext *s, const void *samples)
+static int update_md5_sum(FlacEncodeContext *s, const void *samples,
+                          int nb_samples)
 {
     const uint8_t *buf;
-    int buf_size = s->frame.blocksize * s->channels *
+    int buf_size = nb_samples * s->channels *
                    ((s->avctx->bits_per_raw_sample + 7) / 8);
 
     if (s->avctx->bits_per_raw_sample > 16 || HAVE_BIGENDIAN) {
@@ -1344,7 +1421,7 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
         const int32_t *samples0 = samples;
         uint8_t *tmp            = s->md5_buffer;
 
-        for (i = 0; i < s->frame.blocksize * s->channels; i++) {
+        for (i = 0; i < nb_samples * s->channels; i++) {
             int32_t v = samples0[i] >> 8;
             AV_WL24(tmp + 3*i, v);
         }
@@ -1356,6 +1433,160 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
 }
 
 
+/**
+ * Encode the samples of one frame, the returned size is an upper bound for
+ * the output of write_frame().
+ */
+static int encode_samples(FlacEncodeContext *s, const AVFrame *frame)
+{
+    int frame_bytes;
+
+    init_frame(s, frame->nb_samples);
+
+    copy_samples(s, frame->data[0]);
+
+    channel_decorrelation(s);
+
+    remove_wasted_bits(s);
+
+    frame_bytes = encode_frame(s);
+
+    /* Fall back on verbatim mode if the compressed frame is larger than it
+       would be if encoded uncompressed. */
+    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
+        s->frame.verbatim_only = 1;
+        frame_bytes = encode_frame(s);
+        if (frame_bytes < 0) {
+            av_log(s->avctx, AV_LOG_ERROR, "Bad frame count\n");
+            return frame_bytes;
+        }
+    }
+
+    return frame_bytes;
+}
+
+
+/**
+ * Update the stream statistics with an encoded frame, in submission order.
+ */
+static int finish_frame(FlacEncodeContext *s, AVPacket *avpkt,
+                        const AVFrame *frame, int out_bytes)
+{
+    int ret;
+
+    s->frame_count++;
+    s->sample_count += frame->nb_samples;
+    if ((ret = update_md5_sum(s, frame->data[0], frame->nb_samples)) < 0) {
+        av_log(s->avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+        return ret;
+    }
+    if (out_bytes > s->max_encoded_framesize)
+        s->max_encoded_framesize = out_bytes;
+    if (out_bytes < s->min_framesize)
+        s->min_framesize = out_bytes;
+
+    avpkt->pts      = frame->pts;
+    avpkt->duration = ff_samples_to_time_base(s->avctx, frame->nb_samples);
+    avpkt->size     = out_bytes;
+
+    s->next_pts = avpkt->pts + avpkt->duration;
+
+    return 0;
+}
+
+
+static void encode_frame_job(void *priv, int jobnr, int threadnr,
+                             int nb_jobs, int nb_threads)
+{
+    FlacEncodeContext *s  = priv;
+    FlacEncodeContext *tc = &s->thread_ctx[threadnr];
+    FlacEncodeJob *job    = &s->jobs[jobnr];
+    int frame_bytes;
+
+    tc->frame_count   = job->frame_count;
+    tc->max_framesize = job->max_framesize;
+
+    frame_bytes = encode_samples(tc, job->frame);
+    if (frame_bytes < 0) {
+        job->ret = frame_bytes;
+        return;
+    }
+
+    if ((job->ret = av_new_packet(job->pkt, frame_bytes)) < 0)
+        return;
+
+    job->ret = write_frame(tc, job->pkt);
+}
+
+
+/**
+ * Queue a frame for frame-parallel encoding. Once a frame per thread is
+ * queued and the packets of the previous batch are returned, or when
+ * flushing, the queued frames are encoded together and their packets are
+ * then returned one per call.
+ * @return 1 if the caller should proceed with flushing, 0 or an error code
+ *         otherwise
+ */
+static int encode_frame_threaded(AVCodecContext *avctx, AVPacket *avpkt,
+                                 const AVFrame *frame, int *got_packet_ptr)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    FlacEncodeJob *job;
+    int i, ret;
+
+    if (s->next_pending == s->nb_pending && s->nb_queued &&
+        (s->nb_queued == s->nb_jobs || !frame)) {
+        avpriv_slicethread_execute(s->slicethread, s->nb_queued, 0);
+
+        for (i = 0; i < s->nb_queued; i++) {
+            job = &s->jobs[i];
+            ret = job->ret;
+            if (ret >= 0)
+                ret = finish_frame(s, job->pkt, job->frame, job->ret);
+            av_frame_unref(job->frame);
+            if (ret < 0) {
+                /* drop the packets of the jobs before the failed one too */
+                for (i = 0; i < s->nb_queued; i++) {
+                    av_frame_unref(s->jobs[i].frame);
+                    av_packet_unref(s->jobs[i].pkt);
+                }
+                s->nb_queued = 0;
+                return ret;
+            }
+        }
+        s->nb_pending   = s->nb_queued;
+        s->next_pending = 0;
+        s->nb_queued    = 0;
+    }
+
+    if (frame) {
+        job = &s->jobs[s->nb_queued];
+
+        /* change max_framesize for small final frame */
+        if (frame->nb_samples < s->frame.blocksize) {
+            s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
+                                                          s->channels,
+                                                          avctx->bits_per_raw_sample);
+        }
+        s->frame.blocksize = frame->nb_samples;
+
+        if ((ret = av_frame_ref(job->frame, frame)) < 0)
+            return ret;
+        job->frame_count   = s->frame_count + s->nb_queued;
+        job->max_framesize = s->max_framesize;
+        s->nb_queued++;
+    }
+
+    if (s->next_pending < s->nb_pending) {
+        av_packet_move_ref(avpkt, s->jobs[s->next_pending++].pkt);
+        *got_packet_ptr = 1;
+        return 0;
+    }
+
+    return !frame;
+}
+
+
 static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                              const AVFrame *frame, int *got_packet_ptr)
 {
@@ -1364,6 +1595,12 @@ static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
 
     s = avctx->priv_data;
 
+    if (s->jobs) {
+        ret = encode_frame_threaded(avctx, avpkt, frame, got_packet_ptr);
+        if (ret <= 0)
+            return ret;
+    }
+
     /* when the last block is reached, update the header in extradata */
     if (!frame) {
         s->max_framesize = s->max_encoded_framesize;
@@ -1399,48 +1636,17 @@ FF_ENABLE_DEPRECATION_WARNINGS
                                                       avctx->bits_per_raw_sample);
     }
 
-    init_frame(s, frame->nb_samples);
-
-    copy_samples(s, frame->data[0]);
-
-    channel_decorrelation(s);
-
-    remove_wasted_bits(s);
-
-    frame_bytes = encode_frame(s);
-
-    /* Fall back on verbatim mode if the compressed frame is larger than it
-       would be if encoded uncompressed. */
-    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
-        s->frame.verbatim_only = 1;
-        frame_bytes = encode_frame(s);
-        if (frame_bytes < 0) {
-            av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
-            return frame_bytes;
-        }
-    }
+    frame_bytes = encode_samples(s, frame);
+    if (frame_bytes < 0)
+        return frame_bytes;
 
     if ((ret = ff_alloc_packet2(avctx, avpkt, frame_bytes, 0)) < 0)
         return ret;
 
     out_bytes = write_frame(s, avpkt);
 
-    s->frame_count++;
-    s->sample_count += frame->nb_samples;
-    if ((ret = update_md5_sum(s, frame->data[0])) < 0) {
-        av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+    if ((ret = finish_frame(s, avpkt, frame, out_bytes)) < 0)
         return ret;
-    }
-    if (out_bytes > s->max_encoded_framesize)
-        s->max_encoded_framesize = out_bytes;
-    if (out_bytes < s->min_framesize)
-        s->min_framesize = out_bytes;
-
-    avpkt->pts      = frame->pts;
-    avpkt->duration = ff_samples_to_time_base(avctx, frame->nb_samples);
-    avpkt->size     = out_bytes;
-
-    s->next_pts = avpkt->pts + avpkt->duration;
 
     *got_packet_ptr = 1;
     return 0;
@@ -1451,6 +1657,19 @@ static av_cold int flac_encode_close(AVCodecContext *avctx)
 {
     if (avctx->priv_data) {
         FlacEncodeContext *s = avctx->priv_data;
+        int i;
+
+        avpriv_slicethread_free(&s->slicethread);
+        for (i = 0; i < s->nb_jobs; i++) {
+            if (s->thread_ctx)
+                ff_lpc_end(&s->thread_ctx[i].lpc_ctx);
+            if (s->jobs) {
+                av_frame_free(&s->jobs[i].frame);
+                av_packet_free(&s->jobs[i].pkt);
+            }
+        }
+        av_freep(&s->thread_ctx);
+        av_freep(&s->jobs);
         av_freep(&s->md5ctx);
         av_freep(&s->md5_buffer);
         ff_lpc_end(&s->lpc_ctx);
@@ -1488,6 +1707,7 @@ static const AVOption options[] = {
 { "multi_dim_quant",       "Multi-dimensional quantization",    offsetof(FlacEncodeContext, options.multi_dim_quant),       AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, FLAGS },
 { "min_prediction_order", NULL, offsetof(FlacEncodeContext, options.min_prediction_order), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, MAX_LPC_ORDER, FLAGS },
 { "max_prediction_order", NULL, offsetof(FlacEncodeContext, options.max_prediction_order), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, MAX_LPC_ORDER, FLAGS },
+{ "frame_threads", "Number of frames encoded in parallel, 0 for automatic", offsetof(FlacEncodeContext, options.frame_threads), AV_OPT_TYPE_INT, { .i64 = 1 }, 0, INT_MAX, FLAGS },
 
 { NULL },
 };
@@ -1513,4 +1733,5 @@ AVCodec ff_flac_encoder = {
                                                      AV_SAMPLE_FMT_S32,
                                                      AV_SAMPLE_FMT_NONE },
     .priv_class     = &flac_encoder_class,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP,
 };
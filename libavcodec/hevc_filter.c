@@ -711,17 +711,83 @@ static int boundary_strength(HEVCContext *s, MvField *curr, MvField *neigh,
     return 1;
 }
 
+static void deblocking_bs_upper_edge(HEVCContext *s, int x0, int y0,
+                                     int width, RefPicList *rpl_top)
+{
+    MvField *tab_mvf     = s->ref->tab_mvf;
+    int log2_min_pu_size = s->ps.sps->log2_min_pu_size;
+    int log2_min_tu_size = s->ps.sps->log2_min_tb_size;
+    int min_pu_width     = s->ps.sps->min_pu_width;
+    int min_tu_width     = s->ps.sps->min_tb_width;
+    int yp_pu = (y0 - 1) >> log2_min_pu_size;
+    int yq_pu =  y0      >> log2_min_pu_size;
+    int yp_tu = (y0 - 1) >> log2_min_tu_size;
+    int yq_tu =  y0      >> log2_min_tu_size;
+    int i, bs;
+
+    for (i = 0; i < width; i += 4) {
+        int x_pu = (x0 + i) >> log2_min_pu_size;
+        int x_tu = (x0 + i) >> log2_min_tu_size;
+        MvField *top  = &tab_mvf[yp_pu * min_pu_width + x_pu];
+        MvField *curr = &tab_mvf[yq_pu * min_pu_width + x_pu];
+        uint8_t top_cbf_luma  = s->cbf_luma[yp_tu * min_tu_width + x_tu];
+        uint8_t curr_cbf_luma = s->cbf_luma[yq_tu * min_tu_width + x_tu];
+
+        if (curr->pred_flag == PF_INTRA || top->pred_flag == PF_INTRA)
+            bs = 2;
+        else if (curr_cbf_luma || top_cbf_luma)
+            bs = 1;
+        else
+            bs = boundary_strength(s, curr, top, rpl_top);
+        s->horizontal_bs[((x0 + i) + y0 * s->bs_width) >> 2] = bs;
+    }
+}
+
+static void deblocking_bs_left_edge(HEVCContext *s, int x0, int y0,
+                                    int height, RefPicList *rpl_left)
+{
+    MvField *tab_mvf     = s->ref->tab_mvf;
+    int log2_min_pu_size = s->ps.sps->log2_min_pu_size;
+    int log2_min_tu_size = s->ps.sps->log2_min_tb_size;
+    int min_pu_width     = s->ps.sps->min_pu_width;
+    int min_tu_width     = s->ps.sps->min_tb_width;
+    int xp_pu = (x0 - 1) >> log2_min_pu_size;
+    int xq_pu =  x0      >> log2_min_pu_size;
+    int xp_tu = (x0 - 1) >> log2_min_tu_size;
+    int xq_tu =  x0      >> log2_min_tu_size;
+    int i, bs;
+
+    for (i = 0; i < height; i += 4) {
+        int y_pu      = (y0 + i) >> log2_min_pu_size;
+        int y_tu      = (y0 + i) >> log2_min_tu_size;
+        MvField *left = &tab_mvf[y_pu * min_pu_width + xp_pu];
+        MvField *curr = &tab_mvf[y_pu * min_pu_width + xq_pu];
+        uint8_t left_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xp_tu];
+        uint8_t curr_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xq_tu];
+
+        if (curr->pred_flag == PF_INTRA || left->pred_flag == PF_INTRA)
+            bs = 2;
+        else if (curr_cbf_luma || left_cbf_luma)
+            bs = 1;
+        else
+            bs = boundary_strength(s, curr, left, rpl_left);
+        s->vertical_bs[(x0 + (y0 + i) * s->bs_width) >> 2] = bs;
+    }
+}
+
 void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                                            int log2_trafo_size)
 {
     HEVCLocalContext *lc = s->HEVClc;
     MvField *tab_mvf     = s->ref->tab_mvf;
     int log2_min_pu_size = s->ps.sps->log2_min_pu_size;
-    int log2_min_tu_size = s->ps.sps->log2_min_tb_size;
     int min_pu_width     = s->ps.sps->min_pu_width;
-    int min_tu_width     = s->ps.sps->min_tb_width;
     int is_intra = tab_mvf[(y0 >> log2_min_pu_size) * min_pu_width +
                            (x0 >> log2_min_pu_size)].pred_flag == PF_INTRA;
+    /* tile edges of slices whose tiles are decoded in parallel are handled by
+     * ff_hevc_deblocking_boundary_strengths_tiles() once all tiles are done */
+    int skip_tile_edges  = !s->ps.pps->loop_filter_across_tiles_enabled_flag ||
+                           (s->enable_parallel_tiles && s->sh.num_entry_point_offsets > 0);
     int boundary_upper, boundary_left;
     int i, j, bs;
 
@@ -730,7 +796,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         ((!s->sh.slice_loop_filter_across_slices_enabled_flag &&
           lc->boundary_flags & BOUNDARY_UPPER_SLICE &&
           (y0 % (1 << s->ps.sps->log2_ctb_size)) == 0) ||
-         (!s->ps.pps->loop_filter_across_tiles_enabled_flag &&
+         (skip_tile_edges &&
           lc->boundary_flags & BOUNDARY_UPPER_TILE &&
           (y0 % (1 << s->ps.sps->log2_ctb_size)) == 0)))
         boundary_upper = 0;
@@ -739,27 +805,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         RefPicList *rpl_top = (lc->boundary_flags & BOUNDARY_UPPER_SLICE) ?
                               ff_hevc_get_ref_list(s, s->ref, x0, y0 - 1) :
                               s->ref->refPicList;
-        int yp_pu = (y0 - 1) >> log2_min_pu_size;
-        int yq_pu =  y0      >> log2_min_pu_size;
-        int yp_tu = (y0 - 1) >> log2_min_tu_size;
-        int yq_tu =  y0      >> log2_min_tu_size;
-
-            for (i = 0; i < (1 << log2_trafo_size); i += 4) {
-                int x_pu = (x0 + i) >> log2_min_pu_size;
-                int x_tu = (x0 + i) >> log2_min_tu_size;
-                MvField *top  = &tab_mvf[yp_pu * min_pu_width + x_pu];
-                MvField *curr = &tab_mvf[yq_pu * min_pu_width + x_pu];
-                uint8_t top_cbf_luma  = s->cbf_luma[yp_tu * min_tu_width + x_tu];
-                uint8_t curr_cbf_luma = s->cbf_luma[yq_tu * min_tu_width + x_tu];
-
-                if (curr->pred_flag == PF_INTRA || top->pred_flag == PF_INTRA)
-                    bs = 2;
-                else if (curr_cbf_luma || top_cbf_luma)
-                    bs = 1;
-                else
-                    bs = boundary_strength(s, curr, top, rpl_top);
-                s->horizontal_bs[((x0 + i) + y0 * s->bs_width) >> 2] = bs;
-            }
+        deblocking_bs_upper_edge(s, x0, y0, 1 << log2_trafo_size, rpl_top);
     }
 
     // bs for vertical TU boundaries
@@ -768,7 +814,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         ((!s->sh.slice_loop_filter_across_slices_enabled_flag &&
           lc->boundary_flags & BOUNDARY_LEFT_SLICE &&
           (x0 % (1 << s->ps.sps->log2_ctb_size)) == 0) ||
-         (!s->ps.pps->loop_filter_across_tiles_enabled_flag &&
+         (skip_tile_edges &&
           lc->boundary_flags & BOUNDARY_LEFT_TILE &&
           (x0 % (1 << s->ps.sps->log2_ctb_size)) == 0)))
         boundary_left = 0;
@@ -777,27 +823,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         RefPicList *rpl_left = (lc->boundary_flags & BOUNDARY_LEFT_SLICE) ?
                                ff_hevc_get_ref_list(s, s->ref, x0 - 1, y0) :
                                s->ref->refPicList;
-        int xp_pu = (x0 - 1) >> log2_min_pu_size;
-        int xq_pu =  x0      >> log2_min_pu_size;
-        int xp_tu = (x0 - 1) >> log2_min_tu_size;
-        int xq_tu =  x0      >> log2_min_tu_size;
-
-            for (i = 0; i < (1 << log2_trafo_size); i += 4) {
-                int y_pu      = (y0 + i) >> log2_min_pu_size;
-                int y_tu      = (y0 + i) >> log2_min_tu_size;
-                MvField *left = &tab_mvf[y_pu * min_pu_width + xp_pu];
-                MvField *curr = &tab_mvf[y_pu * min_pu_width + xq_pu];
-                uint8_t left_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xp_tu];
-                uint8_t curr_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xq_tu];
-
-                if (curr->pred_flag == PF_INTRA || left->pred_flag == PF_INTRA)
-                    bs = 2;
-                else if (curr_cbf_luma || left_cbf_luma)
-                    bs = 1;
-                else
-                    bs = boundary_strength(s, curr, left, rpl_left);
-                s->vertical_bs[(x0 + (y0 + i) * s->bs_width) >> 2] = bs;
-            }
+        deblocking_bs_left_edge(s, x0, y0, 1 << log2_trafo_size, rpl_left);
     }
 
     if (log2_trafo_size > log2_min_pu_size && !is_intra) {
@@ -835,6 +861,44 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
     }
 }
 
+void ff_hevc_deblocking_boundary_strengths_tiles(HEVCContext *s, int x0, int y0)
+{
+    int log2_ctb_size = s->ps.sps->log2_ctb_size;
+    int ctb_size      = 1 << log2_ctb_size;
+    int ctb_width     = s->ps.sps->ctb_width;
+    int ctb_addr_rs   = (y0 >> log2_ctb_size) * ctb_width + (x0 >> log2_ctb_size);
+    int ctb_addr_ts   = s->ps.pps->ctb_addr_rs_to_ts[ctb_addr_rs];
+    int tile_id       = s->ps.pps->tile_id[ctb_addr_ts];
+
+    if (s->sh.disable_deblocking_filter_flag ||
+        !s->ps.pps->loop_filter_across_tiles_enabled_flag)
+        return;
+
+    if (y0 > 0 &&
+        s->ps.pps->tile_id[s->ps.pps->ctb_addr_rs_to_ts[ctb_addr_rs - ctb_width]] != tile_id) {
+        int upper_slice = s->tab_slice_address[ctb_addr_rs] !=
+                          s->tab_slice_address[ctb_addr_rs - ctb_width];
+
+        if (!upper_slice || s->sh.slice_loop_filter_across_slices_enabled_flag)
+            deblocking_bs_upper_edge(s, x0, y0,
+                                     FFMIN(ctb_size, s->ps.sps->width - x0),
+                                     upper_slice ? ff_hevc_get_ref_list(s, s->ref, x0, y0 - 1) :
+                                                   s->ref->refPicList);
+    }
+
+    if (x0 > 0 &&
+        s->ps.pps->tile_id[s->ps.pps->ctb_addr_rs_to_ts[ctb_addr_rs - 1]] != tile_id) {
+        int left_slice = s->tab_slice_address[ctb_addr_rs] !=
+                         s->tab_slice_address[ctb_addr_rs - 1];
+
+        if (!left_slice || s->sh.slice_loop_filter_across_slices_enabled_flag)
+            deblocking_bs_left_edge(s, x0, y0,
+                                    FFMIN(ctb_size, s->ps.sps->height - y0),
+                                    left_slice ? ff_hevc_get_ref_list(s, s->ref, x0 - 1, y0) :
+                                                 s->ref->refPicList);
+    }
+}
+
 #undef LUMA
 #undef CB
 #undef CR
@@ -842,13 +906,18 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
 void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size)
 {
     int x_end = x >= s->ps.sps->width  - ctb_size;
+    int ctb_addr_rs = (y >> s->ps.sps->log2_ctb_size) * s->ps.sps->ctb_width +
+                      (x >> s->ps.sps->log2_ctb_size);
+    /* the slice of this CTB, which is not the current one when the whole
+     * picture is filtered after its tiles have been decoded */
+    int slice_type = s->tab_slice_type[ctb_addr_rs];
     int skip = 0;
     if (s->avctx->skip_loop_filter >= AVDISCARD_ALL ||
         (s->avctx->skip_loop_filter >= AVDISCARD_NONKEY && !IS_IDR(s)) ||
         (s->avctx->skip_loop_filter >= AVDISCARD_NONINTRA &&
-         s->sh.slice_type != HEVC_SLICE_I) ||
+         slice_type != HEVC_SLICE_I) ||
         (s->avctx->skip_loop_filter >= AVDISCARD_BIDIR &&
-         s->sh.slice_type == HEVC_SLICE_B) ||
+         slice_type == HEVC_SLICE_B) ||
         (s->avctx->skip_loop_filter >= AVDISCARD_NONREF &&
         ff_hevc_nal_is_nonref(s->nal_unit_type)))
         skip = 1;
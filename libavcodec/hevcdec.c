@@ -72,6 +72,7 @@ static void pic_arrays_free(HEVCContext *s)
     av_freep(&s->qp_y_tab);
     av_freep(&s->tab_slice_address);
     av_freep(&s->filter_slice_edges);
+    av_freep(&s->tab_slice_type);
 
     av_freep(&s->horizontal_bs);
     av_freep(&s->vertical_bs);
@@ -115,11 +116,13 @@ static int pic_arrays_init(HEVCContext *s, const HEVCSPS *sps)
         goto fail;
 
     s->filter_slice_edges = av_mallocz(ctb_count);
+    s->tab_slice_type     = av_mallocz(ctb_count);
     s->tab_slice_address  = av_malloc_array(pic_size_in_ctb,
                                       sizeof(*s->tab_slice_address));
     s->qp_y_tab           = av_malloc_array(pic_size_in_ctb,
                                       sizeof(*s->qp_y_tab));
-    if (!s->qp_y_tab || !s->filter_slice_edges || !s->tab_slice_address)
+    if (!s->qp_y_tab || !s->filter_slice_edges || !s->tab_slice_type ||
+        !s->tab_slice_address)
         goto fail;
 
     s->horizontal_bs = av_mallocz_array(s->bs_width, s->bs_height);
@@ -916,13 +919,10 @@ static int hls_slice_header(HEVCContext *s)
                 unsigned val = get_bits_long(gb, offset_len);
                 sh->entry_point_offset[i] = val + 1; // +1; // +1 to get the size
             }
-            if (s->threads_number > 1 && (s->ps.pps->num_tile_rows > 1 || s->ps.pps->num_tile_columns > 1)) {
-                s->enable_parallel_tiles = 0; // TODO: you can enable tiles in parallel here
-                s->threads_number = 1;
-            } else
-                s->enable_parallel_tiles = 0;
-        } else
-            s->enable_parallel_tiles = 0;
+            if (s->threads_number > 1 && s->ps.pps->entropy_coding_sync_enabled_flag &&
+                (s->ps.pps->num_tile_rows > 1 || s->ps.pps->num_tile_columns > 1))
+                s->threads_number = 1; // wavefronts inside tiles are decoded on a single thread
+        }
     }
 
     if (s->ps.pps->slice_header_extension_present_flag) {
@@ -2409,8 +2409,6 @@ static void hls_decode_neighbour(HEVCContext *s, int x_ctb, int y_ctb,
     int ctb_addr_rs       = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
     int ctb_addr_in_slice = ctb_addr_rs - s->sh.slice_addr;
 
-    s->tab_slice_address[ctb_addr_rs] = s->sh.slice_addr;
-
     if (s->ps.pps->entropy_coding_sync_enabled_flag) {
         if (x_ctb == 0 && (y_ctb & (ctb_size - 1)) == 0)
             lc->first_qp_group = 1;
@@ -2478,6 +2476,7 @@ static int hls_decode_entry(AVCodecContext *avctxt, void *isFilterThread)
 
         x_ctb = (ctb_addr_rs % ((s->ps.sps->width + ctb_size - 1) >> s->ps.sps->log2_ctb_size)) << s->ps.sps->log2_ctb_size;
         y_ctb = (ctb_addr_rs / ((s->ps.sps->width + ctb_size - 1) >> s->ps.sps->log2_ctb_size)) << s->ps.sps->log2_ctb_size;
+        s->tab_slice_address[ctb_addr_rs] = s->sh.slice_addr;
         hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
 
         ret = ff_hevc_cabac_init(s, ctb_addr_ts, 0);
@@ -2491,6 +2490,7 @@ static int hls_decode_entry(AVCodecContext *avctxt, void *isFilterThread)
         s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
         s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
         s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
+        s->tab_slice_type[ctb_addr_rs]      = s->sh.slice_type;
 
         more_data = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
         if (more_data < 0) {
@@ -2501,11 +2501,12 @@ static int hls_decode_entry(AVCodecContext *avctxt, void *isFilterThread)
 
         ctb_addr_ts++;
         ff_hevc_save_states(s, ctb_addr_ts);
-        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+        if (!s->enable_parallel_tiles)
+            ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
     }
 
     if (x_ctb + ctb_size >= s->ps.sps->width &&
-        y_ctb + ctb_size >= s->ps.sps->height)
+        y_ctb + ctb_size >= s->ps.sps->height && !s->enable_parallel_tiles)
         ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
 
     return ctb_addr_ts;
@@ -2549,6 +2550,7 @@ static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *input_ctb_row, int
         int x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
         int y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
 
+        s->tab_slice_address[ctb_addr_rs] = s->sh.slice_addr;
         hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
 
         ff_thread_await_progress2(s->avctx, ctb_row, thread, SHIFT_CTB_WPP);
@@ -2603,6 +2605,156 @@ error:
     return ret;
 }
 
+static int hls_decode_entry_tiles(AVCodecContext *avctxt, void *input_offset, int job, int self_id)
+{
+    HEVCContext *s1  = avctxt->priv_data, *s;
+    HEVCLocalContext *lc;
+    int more_data    = 1;
+    int *offset_p    = input_offset;
+    int offset       = offset_p[job];
+    int size         = job ? s1->sh.size[job - 1] : s1->sh.offset[0] - offset;
+    int tile         = s1->ps.pps->tile_id[s1->ps.pps->ctb_addr_rs_to_ts[s1->sh.slice_ctb_addr_rs]] + job;
+    int ctb_addr_rs  = s1->ps.pps->tile_pos_rs[tile];
+    int ctb_addr_ts  = s1->ps.pps->ctb_addr_rs_to_ts[ctb_addr_rs];
+    int x_ctb        = (ctb_addr_rs % s1->ps.sps->ctb_width) << s1->ps.sps->log2_ctb_size;
+    int ret;
+
+    s  = s1->sList[self_id];
+    lc = s->HEVClc;
+
+    ret = init_get_bits8(&lc->gb, s->data + offset, size);
+    if (ret < 0)
+        goto error;
+
+    /* every tile starts a new quantization group and has its own
+     * neighbourhood, whichever thread local context decodes it */
+    lc->first_qp_group     = 1;
+    lc->qp_y               = s1->sh.slice_qp;
+    lc->tu.cu_qp_offset_cb = 0;
+    lc->tu.cu_qp_offset_cr = 0;
+    lc->end_of_tiles_x     = x_ctb + (s->ps.pps->column_width[tile % s->ps.pps->num_tile_columns] << s->ps.sps->log2_ctb_size);
+
+    while (more_data && ctb_addr_ts < s->ps.sps->ctb_size &&
+           s->ps.pps->tile_id[ctb_addr_ts] == tile) {
+        int y_ctb;
+
+        ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+        x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
+
+        ret = ff_hevc_cabac_init(s, ctb_addr_ts, 0);
+        if (ret < 0)
+            goto error;
+
+        hls_sao_param(s, x_ctb >> s->ps.sps->log2_ctb_size, y_ctb >> s->ps.sps->log2_ctb_size);
+
+        s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
+        s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
+        s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
+        s->tab_slice_type[ctb_addr_rs]      = s->sh.slice_type;
+
+        more_data = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
+        if (more_data < 0) {
+            ret = more_data;
+            goto error;
+        }
+
+        ctb_addr_ts++;
+    }
+
+    return job == s->sh.num_entry_point_offsets ? ctb_addr_ts : 0;
+error:
+    s->tab_slice_address[ctb_addr_rs] = -1;
+    return ret;
+}
+
+static int alloc_thread_contexts(HEVCContext *s)
+{
+    int i;
+
+    for (i = 1; i < s->threads_number; i++) {
+        if (s->sList[i] && s->HEVClcList[i])
+            continue;
+        av_freep(&s->sList[i]);
+        av_freep(&s->HEVClcList[i]);
+        s->sList[i] = av_malloc(sizeof(HEVCContext));
+        s->HEVClcList[i] = av_mallocz(sizeof(HEVCLocalContext));
+        if (!s->sList[i] || !s->HEVClcList[i])
+            return AVERROR(ENOMEM);
+        memcpy(s->sList[i], s, sizeof(HEVCContext));
+        s->sList[i]->HEVClc = s->HEVClcList[i];
+    }
+    return 0;
+}
+
+/* end of the tiles covered by a slice segment with entry points, in tile scan */
+static int hls_slice_tiles_end(HEVCContext *s)
+{
+    const HEVCPPS *pps = s->ps.pps;
+    int tile = pps->tile_id[pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs]] +
+               s->sh.num_entry_point_offsets + 1;
+
+    if (tile >= pps->num_tile_columns * pps->num_tile_rows)
+        return s->ps.sps->ctb_size;
+    return pps->ctb_addr_rs_to_ts[pps->tile_pos_rs[tile]];
+}
+
+static int hls_check_slice_tiles(HEVCContext *s)
+{
+    const HEVCPPS *pps = s->ps.pps;
+    int ctb_addr_ts    = pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+    int tile           = pps->tile_id[ctb_addr_ts];
+    int end;
+
+    if (pps->tile_pos_rs[tile] != s->sh.slice_ctb_addr_rs ||
+        tile + s->sh.num_entry_point_offsets >= pps->num_tile_columns * pps->num_tile_rows) {
+        av_log(s->avctx, AV_LOG_ERROR, "Tile entry points are wrong (%d %d %d)\n",
+               s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
+               pps->num_tile_columns * pps->num_tile_rows);
+        return AVERROR_INVALIDDATA;
+    }
+
+    if (s->sh.dependent_slice_segment_flag) {
+        int prev_rs;
+
+        if (!ctb_addr_ts) {
+            av_log(s->avctx, AV_LOG_ERROR, "Impossible initial tile.\n");
+            return AVERROR_INVALIDDATA;
+        }
+        prev_rs = pps->ctb_addr_ts_to_rs[ctb_addr_ts - 1];
+        if (s->tab_slice_address[prev_rs] != s->sh.slice_addr) {
+            av_log(s->avctx, AV_LOG_ERROR, "Previous slice segment missing\n");
+            return AVERROR_INVALIDDATA;
+        }
+    }
+
+    /* the slice segment covers whole tiles; mark all of them up front, so
+     * that the tiles decoded concurrently see their neighbours' slice
+     * address without racing on it */
+    end = hls_slice_tiles_end(s);
+    for (; ctb_addr_ts < end; ctb_addr_ts++)
+        s->tab_slice_address[pps->ctb_addr_ts_to_rs[ctb_addr_ts]] = s->sh.slice_addr;
+
+    return 0;
+}
+
+static void hls_tiles_boundary_strengths(HEVCContext *s)
+{
+    int ctb_addr_ts = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+    int end         = hls_slice_tiles_end(s);
+
+    for (; ctb_addr_ts < end; ctb_addr_ts++) {
+        int ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+
+        if (s->tab_slice_address[ctb_addr_rs] != s->sh.slice_addr)
+            continue;
+        ff_hevc_deblocking_boundary_strengths_tiles(s,
+            (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size,
+            (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size);
+    }
+}
+
 static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
 {
     const uint8_t *data = nal->data;
@@ -2620,31 +2772,26 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
         return AVERROR(ENOMEM);
     }
 
-    if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * s->ps.sps->ctb_width >= s->ps.sps->ctb_width * s->ps.sps->ctb_height) {
-        av_log(s->avctx, AV_LOG_ERROR, "WPP ctb addresses are wrong (%d %d %d %d)\n",
-            s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
-            s->ps.sps->ctb_width, s->ps.sps->ctb_height
-        );
-        res = AVERROR_INVALIDDATA;
-        goto error;
+    if (s->ps.pps->entropy_coding_sync_enabled_flag) {
+        if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * s->ps.sps->ctb_width >= s->ps.sps->ctb_width * s->ps.sps->ctb_height) {
+            av_log(s->avctx, AV_LOG_ERROR, "WPP ctb addresses are wrong (%d %d %d %d)\n",
+                s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
+                s->ps.sps->ctb_width, s->ps.sps->ctb_height
+            );
+            res = AVERROR_INVALIDDATA;
+            goto error;
+        }
+    } else {
+        res = hls_check_slice_tiles(s);
+        if (res < 0)
+            goto error;
     }
 
     ff_alloc_entries(s->avctx, s->sh.num_entry_point_offsets + 1);
 
-    for (i = 1; i < s->threads_number; i++) {
-        if (s->sList[i] && s->HEVClcList[i])
-            continue;
-        av_freep(&s->sList[i]);
-        av_freep(&s->HEVClcList[i]);
-        s->sList[i] = av_malloc(sizeof(HEVCContext));
-        s->HEVClcList[i] = av_mallocz(sizeof(HEVCLocalContext));
-        if (!s->sList[i] || !s->HEVClcList[i]) {
-            res = AVERROR(ENOMEM);
-            goto error;
-        }
-        memcpy(s->sList[i], s, sizeof(HEVCContext));
-        s->sList[i]->HEVClc = s->HEVClcList[i];
-    }
+    res = alloc_thread_contexts(s);
+    if (res < 0)
+        goto error;
 
     offset = (lc->gb.index >> 3);
 
@@ -2696,8 +2843,15 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
         ret[i] = 0;
     }
 
-    if (s->ps.pps->entropy_coding_sync_enabled_flag)
+    if (s->ps.pps->entropy_coding_sync_enabled_flag) {
         s->avctx->execute2(s->avctx, hls_decode_entry_wpp, arg, ret, s->sh.num_entry_point_offsets + 1);
+    } else {
+        arg[0] = lc->gb.index >> 3;
+        for (i = 1; i <= s->sh.num_entry_point_offsets; i++)
+            arg[i] = s->sh.offset[i - 1];
+        s->avctx->execute2(s->avctx, hls_decode_entry_tiles, arg, ret, s->sh.num_entry_point_offsets + 1);
+        hls_tiles_boundary_strengths(s);
+    }
 
     for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
         res += ret[i];
@@ -2707,6 +2861,54 @@ error:
     return res;
 }
 
+static int hls_filter_row(AVCodecContext *avctxt, void *arg, int job, int self_id)
+{
+    HEVCContext *s1 = avctxt->priv_data;
+    HEVCContext *s  = s1->sList[self_id];
+    int ctb_size    = 1 << s->ps.sps->log2_ctb_size;
+    int y_ctb       = job << s->ps.sps->log2_ctb_size;
+    int thread      = job % s->threads_number;
+    int x_ctb;
+
+    /* a CTB is filtered once the row above is two CTBs ahead, as
+     * ff_hevc_hls_filter() also finishes SAO of the CTB above-left */
+    for (x_ctb = 0; x_ctb < s->ps.sps->width; x_ctb += ctb_size) {
+        ff_thread_await_progress2(s->avctx, job, thread, SHIFT_CTB_WPP);
+        ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
+        ff_thread_report_progress2(s->avctx, job, thread, 1);
+    }
+    ff_thread_report_progress2(s->avctx, job, thread, SHIFT_CTB_WPP);
+
+    return 0;
+}
+
+/**
+ * Run the in-loop filters on the whole picture, one CTB row per job, after
+ * its tiles have been decoded in parallel.
+ */
+static int hls_filter_picture(HEVCContext *s)
+{
+    int i, ret;
+
+    ret = ff_alloc_entries(s->avctx, s->ps.sps->ctb_height);
+    if (ret < 0)
+        return ret;
+
+    ret = alloc_thread_contexts(s);
+    if (ret < 0)
+        return ret;
+
+    for (i = 1; i < s->threads_number; i++) {
+        memcpy(s->sList[i], s, sizeof(HEVCContext));
+        s->sList[i]->HEVClc = s->HEVClcList[i];
+    }
+
+    ff_reset_entries(s->avctx);
+    s->avctx->execute2(s->avctx, hls_filter_row, NULL, NULL, s->ps.sps->ctb_height);
+
+    return 0;
+}
+
 static int set_side_data(HEVCContext *s)
 {
     AVFrame *out = s->ref->frame;
@@ -2915,6 +3117,11 @@ static int hevc_frame_start(HEVCContext *s)
     if (s->ps.pps->tiles_enabled_flag)
         lc->end_of_tiles_x = s->ps.pps->column_width[0] << s->ps.sps->log2_ctb_size;
 
+    s->enable_parallel_tiles = s->threads_number > 1 && !s->avctx->hwaccel &&
+                               s->ps.pps->tiles_enabled_flag &&
+                               !s->ps.pps->entropy_coding_sync_enabled_flag &&
+                               (s->ps.pps->num_tile_rows > 1 || s->ps.pps->num_tile_columns > 1);
+
     ret = ff_hevc_set_new_ref(s, &s->frame, s->poc);
     if (ret < 0)
         goto fail;
@@ -3193,6 +3400,11 @@ static int decode_nal_units(HEVCContext *s, const uint8_t *buf, int length)
     }
 
 fail:
+    if (s->ref && s->enable_parallel_tiles) {
+        int err = hls_filter_picture(s);
+        if (err < 0 && ret >= 0)
+            ret = err;
+    }
     if (s->ref && s->threads_type == FF_THREAD_FRAME)
         ff_thread_report_progress(&s->ref->tf, INT_MAX, 0);
 
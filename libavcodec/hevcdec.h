@@ -542,6 +542,7 @@ typedef struct HEVCContext {
 
     // CTB-level flags affecting loop filter operation
     uint8_t *filter_slice_edges;
+    uint8_t *tab_slice_type;
 
     /** used on BE to byteswap the lines for checksumming */
     uint8_t *checksum_buf;
@@ -554,6 +555,10 @@ typedef struct HEVCContext {
     uint16_t seq_decode;
     uint16_t seq_output;
 
+    /**
+     * tiles of the current picture are decoded in parallel and the in-loop
+     * filters run on the whole picture once all slices are decoded
+     */
     int enable_parallel_tiles;
     atomic_int wpp_err;
 
@@ -675,6 +680,12 @@ void ff_hevc_set_qPy(HEVCContext *s, int xBase, int yBase,
                      int log2_cb_size);
 void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                                            int log2_trafo_size);
+/**
+ * Compute the boundary strengths of the edges of the CTB at x0, y0 that lie
+ * on a tile boundary; these are skipped while the tiles of a slice are being
+ * decoded in parallel.
+ */
+void ff_hevc_deblocking_boundary_strengths_tiles(HEVCContext *s, int x0, int y0);
 int ff_hevc_cu_qp_delta_sign_flag(HEVCContext *s);
 int ff_hevc_cu_qp_delta_abs(HEVCContext *s);
 int ff_hevc_cu_chroma_qp_offset_flag(HEVCContext *s);
@@ -46,6 +46,7 @@
 #include "jpeglsdec.h"
 #include "profiles.h"
 #include "put_bits.h"
+#include "thread.h"
 #include "tiff.h"
 #include "exif.h"
 #include "bytestream.h"
@@ -298,6 +299,7 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     unsigned pix_fmt_id;
     int h_count[MAX_COMPONENTS] = { 0 };
     int v_count[MAX_COMPONENTS] = { 0 };
+    ThreadFrame tf = { 0 };
 
     s->cur_scan = 0;
     memset(s->upscale_h, 0, sizeof(s->upscale_h));
@@ -706,7 +708,7 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
                 s->avctx->pix_fmt,
                 AV_PIX_FMT_NONE,
             };
-            s->hwaccel_pix_fmt = ff_get_format(s->avctx, pix_fmts);
+            s->hwaccel_pix_fmt = ff_thread_get_format(s->avctx, pix_fmts);
             if (s->hwaccel_pix_fmt < 0)
                 return AVERROR(EINVAL);
 
@@ -721,8 +723,9 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
             return 0;
         }
 
-        av_frame_unref(s->picture_ptr);
-        if (ff_get_buffer(s->avctx, s->picture_ptr, AV_GET_BUFFER_FLAG_REF) < 0)
+        tf.f = s->picture_ptr;
+        ff_thread_release_buffer(s->avctx, &tf);
+        if (ff_thread_get_buffer(s->avctx, &tf, AV_GET_BUFFER_FLAG_REF) < 0)
             return -1;
         s->picture_ptr->pict_type = AV_PICTURE_TYPE_I;
         s->picture_ptr->key_frame = 1;
@@ -1412,26 +1415,17 @@ static void shift_output(MJpegDecodeContext *s, uint8_t *ptr, int linesize)
     }
 }
 
-static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
-                             int Al, const uint8_t *mb_bitmask,
-                             int mb_bitmask_size,
-                             const AVFrame *reference)
+static int mjpeg_decode_scan_mbs(MJpegDecodeContext *s, int nb_components,
+                                 int Ah, int Al, GetBitContext *mb_bitmask_gb,
+                                 const AVFrame *reference,
+                                 int mb_start, int mb_end)
 {
     int i, mb_x, mb_y, chroma_h_shift, chroma_v_shift, chroma_width, chroma_height;
     uint8_t *data[MAX_COMPONENTS];
     const uint8_t *reference_data[MAX_COMPONENTS];
     int linesize[MAX_COMPONENTS];
-    GetBitContext mb_bitmask_gb = {0}; // initialize to silence gcc warning
     int bytes_per_pixel = 1 + (s->bits > 8);
 
-    if (mb_bitmask) {
-        if (mb_bitmask_size != (s->mb_width * s->mb_height + 7)>>3) {
-            av_log(s->avctx, AV_LOG_ERROR, "mb_bitmask_size mismatches\n");
-            return AVERROR_INVALIDDATA;
-        }
-        init_get_bits(&mb_bitmask_gb, mb_bitmask, s->mb_width * s->mb_height);
-    }
-
     s->restart_count = 0;
 
     av_pix_fmt_get_chroma_sub_sample(s->avctx->pix_fmt, &chroma_h_shift,
@@ -1447,9 +1441,13 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
         s->coefs_finished[c] |= 1;
     }
 
-    for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
-        for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
-            const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
+    for (mb_y = mb_start / s->mb_width; mb_y < s->mb_height; mb_y++) {
+        for (mb_x = mb_y == mb_start / s->mb_width ? mb_start % s->mb_width : 0;
+             mb_x < s->mb_width; mb_x++) {
+            const int copy_mb = mb_bitmask_gb && !get_bits1(mb_bitmask_gb);
+
+            if (mb_y * s->mb_width + mb_x >= mb_end)
+                return 0;
 
             if (s->restart_interval && !s->restart_count)
                 s->restart_count = s->restart_interval;
@@ -1533,6 +1531,117 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
     return 0;
 }
 
+#if HAVE_THREADS
+typedef struct ScanThreadArg {
+    int nb_components;
+    int Ah, Al;
+    int nb_intervals;
+    int nb_jobs;
+} ScanThreadArg;
+
+static int decode_scan_thread(AVCodecContext *avctx, void *arg,
+                              int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s  = avctx->priv_data;
+    MJpegDecodeContext *sc = &s->slice_ctx[threadnr];
+    const ScanThreadArg *a = arg;
+    int first = (int64_t) jobnr      * a->nb_intervals / a->nb_jobs;
+    int last  = (int64_t)(jobnr + 1) * a->nb_intervals / a->nb_jobs;
+    int start = first ? s->restart_pos[first - 1] : get_bits_count(&s->gb) >> 3;
+    int end   = last < a->nb_intervals ? s->restart_pos[last - 1]
+                                       : s->gb.size_in_bits >> 3;
+    int i, ret;
+
+    memcpy(sc, s, sizeof(*sc));
+    ret = init_get_bits8(&sc->gb, s->gb.buffer + start, end - start);
+    if (ret < 0)
+        return ret;
+    for (i = 0; i < a->nb_components; i++)
+        sc->last_dc[i] = 4 << s->bits;
+
+    return mjpeg_decode_scan_mbs(sc, a->nb_components, a->Ah, a->Al, NULL, NULL,
+                                 first * s->restart_interval,
+                                 FFMIN(last * (int64_t)s->restart_interval,
+                                       s->mb_width * s->mb_height));
+}
+
+/**
+ * Decode the restart intervals of a sequential scan in parallel. Returns 0
+ * if the scan is not split as expected, so that it is decoded serially.
+ */
+static int mjpeg_decode_scan_threaded(MJpegDecodeContext *s, int nb_components,
+                                      int Ah, int Al)
+{
+    AVCodecContext *avctx = s->avctx;
+    ScanThreadArg arg = { nb_components, Ah, Al };
+    int i, *rets;
+
+    if (!s->restart_interval || s->restart_interval == INT_MAX ||
+        (get_bits_count(&s->gb) & 7))
+        return 0;
+
+    arg.nb_intervals = (s->mb_width * s->mb_height - 1) / s->restart_interval + 1;
+    if (arg.nb_intervals < 2 || s->nb_restart_pos != arg.nb_intervals - 1)
+        return 0;
+    for (i = 0; i < s->nb_restart_pos; i++)
+        if (s->restart_pos[i] <= (i ? s->restart_pos[i - 1] : get_bits_count(&s->gb) >> 3) ||
+            s->restart_pos[i] > s->gb.size_in_bits >> 3)
+            return 0;
+
+    if (!s->slice_ctx) {
+        s->slice_ctx = av_malloc_array(avctx->thread_count, sizeof(*s->slice_ctx));
+        if (!s->slice_ctx)
+            return AVERROR(ENOMEM);
+    }
+    arg.nb_jobs = FFMIN(arg.nb_intervals, avctx->thread_count);
+    rets = av_malloc_array(arg.nb_jobs, sizeof(*rets));
+    if (!rets)
+        return AVERROR(ENOMEM);
+
+    avctx->execute2(avctx, decode_scan_thread, &arg, rets, arg.nb_jobs);
+
+    for (i = 0; i < arg.nb_jobs; i++) {
+        if (rets[i] < 0) {
+            av_free(rets);
+            return rets[i];
+        }
+    }
+    av_free(rets);
+
+    skip_bits_long(&s->gb, get_bits_left(&s->gb));
+    return 1;
+}
+#endif
+
+static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
+                             int Al, const uint8_t *mb_bitmask,
+                             int mb_bitmask_size,
+                             const AVFrame *reference)
+{
+    GetBitContext mb_bitmask_gb;
+
+    if (mb_bitmask) {
+        if (mb_bitmask_size != (s->mb_width * s->mb_height + 7)>>3) {
+            av_log(s->avctx, AV_LOG_ERROR, "mb_bitmask_size mismatches\n");
+            return AVERROR_INVALIDDATA;
+        }
+        init_get_bits(&mb_bitmask_gb, mb_bitmask, s->mb_width * s->mb_height);
+    }
+
+#if HAVE_THREADS
+    if (s->avctx->active_thread_type & FF_THREAD_SLICE &&
+        s->avctx->thread_count > 1 && !mb_bitmask && !s->progressive) {
+        int ret = mjpeg_decode_scan_threaded(s, nb_components, Ah, Al);
+        if (ret)
+            return FFMIN(ret, 0);
+    }
+#endif
+
+    return mjpeg_decode_scan_mbs(s, nb_components, Ah, Al,
+                                 mb_bitmask ? &mb_bitmask_gb : NULL, reference,
+                                 0, s->mb_width * s->mb_height);
+}
+
 static int mjpeg_decode_scan_progressive_ac(MJpegDecodeContext *s, int ss,
                                             int se, int Ah, int Al)
 {
@@ -1620,6 +1729,53 @@ static void mjpeg_idct_scan_progressive_ac(MJpegDecodeContext *s)
     }
 }
 
+static int find_marker(const uint8_t **pbuf_ptr, const uint8_t *buf_end)
+{
+    const uint8_t *buf_ptr;
+    unsigned int v, v2;
+    int val;
+    int skipped = 0;
+
+    buf_ptr = *pbuf_ptr;
+    while (buf_end - buf_ptr > 1) {
+        v  = *buf_ptr++;
+        v2 = *buf_ptr;
+        if ((v == 0xff) && (v2 >= SOF0) && (v2 <= COM) && buf_ptr < buf_end) {
+            val = *buf_ptr++;
+            goto found;
+        }
+        skipped++;
+    }
+    buf_ptr = buf_end;
+    val = -1;
+found:
+    ff_dlog(NULL, "find_marker skipped %d bytes\n", skipped);
+    *pbuf_ptr = buf_ptr;
+    return val;
+}
+
+/**
+ * Check whether the scan starting at raw_scan_buffer is only followed by
+ * restart markers and EOI, i.e. it is the last one of the packet.
+ */
+static int is_last_scan(MJpegDecodeContext *s)
+{
+    const uint8_t *buf_ptr = s->raw_scan_buffer;
+    const uint8_t *buf_end = s->raw_scan_buffer + s->raw_scan_buffer_size;
+    int start_code;
+
+    if (s->raw_scan_buffer_size < 2 ||
+        AV_RB16(buf_ptr) > s->raw_scan_buffer_size)
+        return 0;
+    buf_ptr += AV_RB16(buf_ptr);
+
+    do {
+        start_code = find_marker(&buf_ptr, buf_end);
+    } while (start_code >= RST0 && start_code <= RST7);
+
+    return start_code < 0 || start_code == EOI;
+}
+
 int ff_mjpeg_decode_sos(MJpegDecodeContext *s, const uint8_t *mb_bitmask,
                         int mb_bitmask_size, const AVFrame *reference)
 {
@@ -1726,6 +1882,15 @@ int ff_mjpeg_decode_sos(MJpegDecodeContext *s, const uint8_t *mb_bitmask,
     for (i = s->mjpb_skiptosod; i > 0; i--)
         skip_bits(&s->gb, 8);
 
+    /* Once the final scan of a picture that is output by this packet is
+     * reached, nothing the next packet depends on can change anymore. */
+    if (s->avctx->active_thread_type & FF_THREAD_FRAME && !s->setup_finished &&
+        (!s->interlaced || s->bottom_field == !s->interlace_polarity) &&
+        is_last_scan(s)) {
+        s->setup_finished = 1;
+        ff_thread_finish_setup(s->avctx);
+    }
+
 next_field:
     for (i = 0; i < nb_components; i++)
         s->last_dc[i] = (4 << s->bits);
@@ -2167,31 +2332,6 @@ static int mjpeg_decode_com(MJpegDecodeContext *s)
 
 /* return the 8 bit start code value and update the search
    state. Return -1 if no start code found */
-static int find_marker(const uint8_t **pbuf_ptr, const uint8_t *buf_end)
-{
-    const uint8_t *buf_ptr;
-    unsigned int v, v2;
-    int val;
-    int skipped = 0;
-
-    buf_ptr = *pbuf_ptr;
-    while (buf_end - buf_ptr > 1) {
-        v  = *buf_ptr++;
-        v2 = *buf_ptr;
-        if ((v == 0xff) && (v2 >= SOF0) && (v2 <= COM) && buf_ptr < buf_end) {
-            val = *buf_ptr++;
-            goto found;
-        }
-        skipped++;
-    }
-    buf_ptr = buf_end;
-    val = -1;
-found:
-    ff_dlog(NULL, "find_marker skipped %d bytes\n", skipped);
-    *pbuf_ptr = buf_ptr;
-    return val;
-}
-
 int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                          const uint8_t **buf_ptr, const uint8_t *buf_end,
                          const uint8_t **unescaped_buf_ptr,
@@ -2210,6 +2350,8 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
         const uint8_t *ptr = src;
         uint8_t *dst = s->buffer;
 
+        s->nb_restart_pos = 0;
+
         #define copy_data_segment(skip) do {       \
             ptrdiff_t length = (ptr - src) - (skip);  \
             if (length > 0) {                         \
@@ -2247,6 +2389,14 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                         copy_data_segment(1);
                         if (x)
                             break;
+                    } else if (s->avctx->active_thread_type & FF_THREAD_SLICE) {
+                        /* remember where the next restart interval starts */
+                        int *pos = av_fast_realloc(s->restart_pos, &s->restart_pos_size,
+                                                   (s->nb_restart_pos + 1) * sizeof(*pos));
+                        if (!pos)
+                            return AVERROR(ENOMEM);
+                        s->restart_pos = pos;
+                        s->restart_pos[s->nb_restart_pos++] = dst - s->buffer + (ptr - src);
                     }
                 }
             }
@@ -2386,7 +2536,8 @@ static int mjpeg_get_packet(AVCodecContext *avctx)
     return 0;
 }
 
-int ff_mjpeg_receive_frame(AVCodecContext *avctx, AVFrame *frame)
+static int mjpeg_decode_packet(AVCodecContext *avctx, AVFrame *frame,
+                               const AVPacket *pkt)
 {
     MJpegDecodeContext *s = avctx->priv_data;
     const uint8_t *buf_end, *buf_ptr;
@@ -2398,22 +2549,16 @@ int ff_mjpeg_receive_frame(AVCodecContext *avctx, AVFrame *frame)
     int ret = 0;
     int is16bit;
 
-    if (avctx->codec_id == AV_CODEC_ID_SMVJPEG && s->smv_next_frame > 0)
-        return smv_process_frame(avctx, frame);
-
     av_dict_free(&s->exif_metadata);
     av_freep(&s->stereo3d);
     s->adobe_transform = -1;
+    s->setup_finished  = 0;
 
     if (s->iccnum != 0)
         reset_icc_profile(s);
 
-    ret = mjpeg_get_packet(avctx);
-    if (ret < 0)
-        return ret;
-
-    buf_ptr = s->pkt->data;
-    buf_end = s->pkt->data + s->pkt->size;
+    buf_ptr = pkt->data;
+    buf_end = pkt->data + pkt->size;
     while (buf_ptr < buf_end) {
         /* find start next marker */
         start_code = ff_mjpeg_find_marker(s, &buf_ptr, buf_end,
@@ -2425,7 +2570,7 @@ int ff_mjpeg_receive_frame(AVCodecContext *avctx, AVFrame *frame)
         } else if (unescaped_buf_size > INT_MAX / 8) {
             av_log(avctx, AV_LOG_ERROR,
                    "MJPEG packet 0x%x too big (%d/%d), corrupt data?\n",
-                   start_code, unescaped_buf_size, s->pkt->size);
+                   start_code, unescaped_buf_size, pkt->size);
             return AVERROR_INVALIDDATA;
         }
         av_log(avctx, AV_LOG_DEBUG, "marker=%x avail_size_in_buf=%"PTRDIFF_SPECIFIER"\n",
@@ -2576,7 +2721,7 @@ eoi_parser:
                 return ret;
             s->got_picture = 0;
 
-            frame->pkt_dts = s->pkt->dts;
+            frame->pkt_dts = pkt->dts;
 
             if (!s->lossless && avctx->debug & FF_DEBUG_QP) {
                 int qp = FFMAX3(s->qscale[0],
@@ -2877,6 +3022,42 @@ the_end_no_picture:
     return ret;
 }
 
+int ff_mjpeg_receive_frame(AVCodecContext *avctx, AVFrame *frame)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    int ret;
+
+    if (avctx->codec_id == AV_CODEC_ID_SMVJPEG && s->smv_next_frame > 0)
+        return smv_process_frame(avctx, frame);
+
+    ret = mjpeg_get_packet(avctx);
+    if (ret < 0)
+        return ret;
+
+    return mjpeg_decode_packet(avctx, frame, s->pkt);
+}
+
+#if CONFIG_MJPEG_DECODER
+static int mjpeg_decode_frame(AVCodecContext *avctx, void *data,
+                              int *got_frame, AVPacket *avpkt)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    AVFrame *frame = data;
+    int ret;
+
+    s->buf_size = avpkt->size;
+
+    ret = mjpeg_decode_packet(avctx, frame, avpkt);
+    if (ret < 0) {
+        av_frame_unref(frame);
+        return ret == AVERROR(EAGAIN) ? avpkt->size : ret;
+    }
+
+    *got_frame = 1;
+    return avpkt->size;
+}
+#endif
+
 /* mxpeg may call the following function (with a blank MJpegDecodeContext)
  * even without having called ff_mjpeg_decode_init(). */
 av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
@@ -2889,6 +3070,8 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     }
 
     if (s->picture) {
+        ThreadFrame tf = { .f = s->picture };
+        ff_thread_release_buffer(avctx, &tf);
         av_frame_free(&s->picture);
         s->picture_ptr = NULL;
     } else if (s->picture_ptr)
@@ -2899,6 +3082,8 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     av_frame_free(&s->smv_frame);
 
     av_freep(&s->buffer);
+    av_freep(&s->restart_pos);
+    av_freep(&s->slice_ctx);
     av_freep(&s->stereo3d);
     av_freep(&s->ljpeg_buffer);
     s->ljpeg_buffer_size = 0;
@@ -2929,6 +3114,92 @@ static void decode_flush(AVCodecContext *avctx)
     av_frame_unref(s->smv_frame);
 }
 
+#if CONFIG_MJPEG_DECODER && HAVE_THREADS
+#define copy_fields(to, from, start_field, end_field)                   \
+    memcpy(&(to)->start_field, &(from)->start_field,                   \
+           (char *)&(to)->end_field - (char *)&(to)->start_field)
+
+static int mjpeg_update_thread_context(AVCodecContext *dst,
+                                       const AVCodecContext *src)
+{
+    MJpegDecodeContext *s = dst->priv_data, *s1 = src->priv_data;
+    int i, j, ret;
+
+    if (dst == src)
+        return 0;
+
+    for (i = 0; i < 2; i++) {
+        for (j = 0; j < 4; j++) {
+            uint8_t bits_table[17] = { 0 };
+            int n = 0, k;
+
+            if (!s1->vlcs[i][j].table) {
+                ff_free_vlc(&s->vlcs[i][j]);
+                if (i)
+                    ff_free_vlc(&s->vlcs[2][j]);
+                continue;
+            }
+            for (k = 0; k < 16; k++)
+                n += s1->raw_huffman_lengths[i][j][k];
+            if (s->vlcs[i][j].table &&
+                !memcmp(s->raw_huffman_lengths[i][j], s1->raw_huffman_lengths[i][j], 16) &&
+                !memcmp(s->raw_huffman_values[i][j],  s1->raw_huffman_values[i][j],  n))
+                continue;
+
+            memcpy(s->raw_huffman_lengths[i][j], s1->raw_huffman_lengths[i][j], 16);
+            memcpy(s->raw_huffman_values[i][j],  s1->raw_huffman_values[i][j],  256);
+            memcpy(bits_table + 1, s->raw_huffman_lengths[i][j], 16);
+
+            ff_free_vlc(&s->vlcs[i][j]);
+            ret = ff_mjpeg_build_vlc(&s->vlcs[i][j], bits_table,
+                                     s->raw_huffman_values[i][j], i, dst);
+            if (ret < 0)
+                return ret;
+            if (i) {
+                ff_free_vlc(&s->vlcs[2][j]);
+                ret = ff_mjpeg_build_vlc(&s->vlcs[2][j], bits_table,
+                                         s->raw_huffman_values[i][j], 0, dst);
+                if (ret < 0)
+                    return ret;
+            }
+        }
+    }
+
+    memcpy(s->quant_matrixes, s1->quant_matrixes, sizeof(s->quant_matrixes));
+    memcpy(s->qscale,         s1->qscale,         sizeof(s->qscale));
+    memcpy(s->linesize,       s1->linesize,       sizeof(s->linesize));
+    copy_fields(s, s1, lossless, last_dc);
+    copy_fields(s, s1, buggy_avid, mjpb_skiptosod);
+    s->first_picture      = s1->first_picture;
+    s->interlaced         = s1->interlaced;
+    s->flipped            = s1->flipped;
+    s->pix_desc           = s1->pix_desc;
+    s->hwaccel_sw_pix_fmt = s1->hwaccel_sw_pix_fmt;
+    s->hwaccel_pix_fmt    = s1->hwaccel_pix_fmt;
+
+    if (s1->setup_finished) {
+        /* The source thread is still decoding the last scan of a picture
+         * it will output itself, apply the effects of its EOI. */
+        s->bottom_field = s1->interlaced ? s1->interlace_polarity : s1->bottom_field;
+        s->got_picture  = 0;
+    } else {
+        /* Either no picture or the first field of an interlaced picture
+         * whose second field is in the next packet. */
+        s->bottom_field = s1->bottom_field;
+        s->got_picture  = s1->got_picture;
+        if (s->got_picture) {
+            ThreadFrame tf = { .f = s->picture_ptr };
+            ff_thread_release_buffer(dst, &tf);
+            ret = av_frame_ref(s->picture_ptr, s1->picture_ptr);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    return 0;
+}
+#endif
+
 #if CONFIG_MJPEG_DECODER
 #define OFFSET(x) offsetof(MJpegDecodeContext, x)
 #define VD AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_DECODING_PARAM
@@ -2953,9 +3224,11 @@ AVCodec ff_mjpeg_decoder = {
     .priv_data_size = sizeof(MJpegDecodeContext),
     .init           = ff_mjpeg_decode_init,
     .close          = ff_mjpeg_decode_end,
-    .receive_frame  = ff_mjpeg_receive_frame,
+    .decode         = mjpeg_decode_frame,
     .flush          = decode_flush,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(mjpeg_update_thread_context),
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .max_lowres     = 3,
     .priv_class     = &mjpegdec_class,
     .profiles       = NULL_IF_CONFIG_SMALL(ff_mjpeg_profiles),
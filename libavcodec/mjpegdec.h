@@ -103,6 +103,7 @@ typedef struct MJpegDecodeContext {
     AVFrame *picture; /* picture structure */
     AVFrame *picture_ptr; /* pointer to picture structure */
     int got_picture;                                ///< we found a SOF and picture is valid, too.
+    int setup_finished;                             ///< frame threading setup was finished before the last scan
     int linesize[MAX_COMPONENTS];                   ///< linesize << interlaced
     int8_t *qscale_table;
     DECLARE_ALIGNED(32, int16_t, block)[64];
@@ -117,6 +118,10 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    int *restart_pos;           ///< buffer offsets of the restart intervals following the first one
+    unsigned int restart_pos_size;
+    int nb_restart_pos;
+    struct MJpegDecodeContext *slice_ctx; ///< per-thread copies for slice threaded scans
 
     int buggy_avid;
     int cs_itu601;
@@ -398,6 +398,9 @@ typedef struct VC1Context{
 
     int parse_only;              ///< Context is used within parser
     int resync_marker;           ///< could this stream contain resync markers
+
+    struct VC1SliceContext *slice_ctx; ///< per-thread contexts for slice threading
+    int nb_slice_ctx;
 } VC1Context;
 
 /**
@@ -30,6 +30,7 @@
 #include "mpegutils.h"
 #include "mpegvideo.h"
 #include "msmpeg4data.h"
+#include "thread.h"
 #include "unary.h"
 #include "vc1.h"
 #include "vc1_pred.h"
@@ -473,6 +474,7 @@ static inline int ff_vc1_pred_dc(MpegEncContext *s, int overlap, int pq, int n,
  */
 
 static inline int vc1_coded_block_pred(MpegEncContext * s, int n,
+                                       int first_line,
                                        uint8_t **coded_block_ptr)
 {
     int xy, wrap, pred, a, b, c;
@@ -484,8 +486,13 @@ static inline int vc1_coded_block_pred(MpegEncContext * s, int n,
      * A X
      */
     a = s->coded_block[xy - 1       ];
-    b = s->coded_block[xy - 1 - wrap];
-    c = s->coded_block[xy     - wrap];
+    if (first_line && n < 2) {
+        /* the row above belongs to another slice, treat it as not coded */
+        b = c = 0;
+    } else {
+        b = s->coded_block[xy - 1 - wrap];
+        c = s->coded_block[xy     - wrap];
+    }
 
     if (b == c) {
         pred = a;
@@ -2522,6 +2529,48 @@ static int vc1_decode_b_mb_intfr(VC1Context *v)
     return 0;
 }
 
+/** Wait until the reference pictures are decoded far enough for all motion
+ *  vectors of the current macroblock row to be usable with frame threading.
+ */
+static void vc1_await_references(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+    int range_y, y;
+
+    if (!(s->avctx->active_thread_type & FF_THREAD_FRAME))
+        return;
+
+    /* direct mode vectors are scaled from the next anchor, which may use a
+     * larger MV range than the current picture, so assume the largest one */
+    range_y = s->pict_type == AV_PICTURE_TYPE_B ? 1 << 10 : v->range_y;
+
+    /* lowest luma line in the reference frame reachable from this row,
+     * including the subpel filter taps; field MVs are in field lines */
+    y = ((s->mb_y + 1) * 16 << v->field_mode) +
+        (((range_y >> 2) + 4) << (v->fcm != PROGRESSIVE));
+    y = FFMIN(y >> 4, s->mb_height - 1);
+
+    if (s->last_picture_ptr)
+        ff_thread_await_progress(&s->last_picture_ptr->tf, y, 0);
+    if (s->pict_type == AV_PICTURE_TYPE_B && s->next_picture_ptr)
+        ff_thread_await_progress(&s->next_picture_ptr->tf, y, 0);
+}
+
+/** Report the macroblock rows of a frame picture which are final.
+ */
+static void vc1_report_row_progress(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+
+    /* field pictures report completion in ff_mpv_frame_end(); otherwise the
+     * overlap and loop filters lag up to two rows behind the decoding loop
+     * and may still touch the bottom lines of the row above those */
+    if (v->field_mode || s->er.error_occurred)
+        return;
+
+    ff_thread_report_progress(&s->current_picture_ptr->tf, s->mb_y - 3, 0);
+}
+
 /** Decode blocks of I-frame
  */
 static void vc1_decode_i_blocks(VC1Context *v)
@@ -2589,7 +2638,7 @@ static void vc1_decode_i_blocks(VC1Context *v)
                 val = ((cbp >> (5 - k)) & 1);
 
                 if (k < 4) {
-                    int pred   = vc1_coded_block_pred(&v->s, k, &coded_val);
+                    int pred   = vc1_coded_block_pred(&v->s, k, 0, &coded_val);
                     val        = val ^ pred;
                     *coded_val = val;
                 }
@@ -2636,6 +2685,7 @@ static void vc1_decode_i_blocks(VC1Context *v)
             ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
         else if (s->mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
+        vc1_report_row_progress(v);
 
         s->first_slice_line = 0;
     }
@@ -2693,12 +2743,6 @@ static int vc1_decode_i_blocks_adv(VC1Context *v)
     s->mb_intra         = 1;
     s->first_slice_line = 1;
     s->mb_y             = s->start_mb_y;
-    if (s->start_mb_y) {
-        s->mb_x = 0;
-        init_block_index(v);
-        memset(&s->coded_block[s->block_index[0] - s->b8_stride], 0,
-               (1 + s->b8_stride) * sizeof(*s->coded_block));
-    }
     for (; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
@@ -2743,7 +2787,8 @@ static int vc1_decode_i_blocks_adv(VC1Context *v)
                 val = ((cbp >> (5 - k)) & 1);
 
                 if (k < 4) {
-                    int pred   = vc1_coded_block_pred(&v->s, k, &coded_val);
+                    int pred   = vc1_coded_block_pred(&v->s, k, s->first_slice_line,
+                                                      &coded_val);
                     val        = val ^ pred;
                     *coded_val = val;
                 }
@@ -2782,6 +2827,7 @@ static int vc1_decode_i_blocks_adv(VC1Context *v)
             ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
         else if (s->mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y-1) * 16, 16);
+        vc1_report_row_progress(v);
         s->first_slice_line = 0;
     }
 
@@ -2828,6 +2874,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -2876,6 +2923,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
                 sizeof(v->luma_mv_base[0]) * 2 * s->mb_stride);
         if (s->mb_y != s->start_mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
+        vc1_report_row_progress(v);
         s->first_slice_line = 0;
     }
     if (s->end_mb_y >= s->start_mb_y)
@@ -2917,6 +2965,7 @@ static void vc1_decode_b_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -2981,10 +3030,13 @@ static void vc1_decode_skip_blocks(VC1Context *v)
         s->mb_x = 0;
         init_block_index(v);
         ff_update_block_index(s);
+        if (s->avctx->active_thread_type & FF_THREAD_FRAME)
+            ff_thread_await_progress(&s->last_picture_ptr->tf, s->mb_y, 0);
         memcpy(s->dest[0], s->last_picture.f->data[0] + s->mb_y * 16 * s->linesize,   s->linesize   * 16);
         memcpy(s->dest[1], s->last_picture.f->data[1] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         memcpy(s->dest[2], s->last_picture.f->data[2] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
+        vc1_report_row_progress(v);
         s->first_slice_line = 0;
     }
     s->pict_type = AV_PICTURE_TYPE_P;
@@ -36,6 +36,7 @@
 #include "msmpeg4.h"
 #include "msmpeg4data.h"
 #include "profiles.h"
+#include "thread.h"
 #include "vc1.h"
 #include "vc1data.h"
 #include "libavutil/avassert.h"
@@ -321,6 +322,149 @@ static void vc1_sprite_flush(AVCodecContext *avctx)
 
 #endif
 
+/**
+ * Per-thread state for slice threading. The context is a copy of the main
+ * context taken for every slice, with the row buffers which are carried from
+ * one macroblock row to the next replaced by private ones.
+ */
+typedef struct VC1SliceContext {
+    VC1Context v;
+    int16_t (*block)[6][64];
+    uint32_t *cbp_base;
+    int *ttblk_base;
+    uint8_t *is_intra_base;
+    int16_t (*luma_mv_base)[2];
+    ScratchpadContext sc;
+    uint8_t *scratchpad;
+} VC1SliceContext;
+
+typedef struct VC1SliceJob {
+    GetBitContext gb;
+    int start_mb_y, end_mb_y;
+    int second_field, blocks_off, mb_off;
+    int error_occurred, error_count;
+} VC1SliceJob;
+
+static void vc1_free_slice_contexts(VC1Context *v)
+{
+    int i;
+
+    for (i = 0; i < v->nb_slice_ctx; i++) {
+        VC1SliceContext *sc = &v->slice_ctx[i];
+
+        av_freep(&sc->block);
+        av_freep(&sc->cbp_base);
+        av_freep(&sc->ttblk_base);
+        av_freep(&sc->is_intra_base);
+        av_freep(&sc->luma_mv_base);
+        av_freep(&sc->sc.edge_emu_buffer);
+        av_freep(&sc->scratchpad);
+    }
+    av_freep(&v->slice_ctx);
+    v->nb_slice_ctx = 0;
+}
+
+static int vc1_alloc_slice_contexts(AVCodecContext *avctx)
+{
+    VC1Context *v     = avctx->priv_data;
+    MpegEncContext *s = &v->s;
+    int i, ret;
+
+    if (v->slice_ctx)
+        return 0;
+
+    v->slice_ctx = av_mallocz_array(avctx->thread_count, sizeof(*v->slice_ctx));
+    if (!v->slice_ctx)
+        return AVERROR(ENOMEM);
+    v->nb_slice_ctx = avctx->thread_count;
+
+    for (i = 0; i < v->nb_slice_ctx; i++) {
+        VC1SliceContext *sc = &v->slice_ctx[i];
+
+        sc->block         = av_malloc_array(v->n_allocated_blks, sizeof(*sc->block));
+        sc->cbp_base      = av_malloc_array(3 * s->mb_stride, sizeof(*sc->cbp_base));
+        sc->ttblk_base    = av_malloc_array(3 * s->mb_stride, sizeof(*sc->ttblk_base));
+        sc->is_intra_base = av_mallocz_array(3 * s->mb_stride, sizeof(*sc->is_intra_base));
+        sc->luma_mv_base  = av_mallocz_array(3 * s->mb_stride, sizeof(*sc->luma_mv_base));
+        if (!sc->block || !sc->cbp_base || !sc->ttblk_base ||
+            !sc->is_intra_base || !sc->luma_mv_base) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+
+        ret = ff_mpeg_framesize_alloc(avctx, &sc->v.s.me, &sc->v.s.sc, s->linesize);
+        if (ret < 0)
+            goto fail;
+        sc->sc         = sc->v.s.sc;
+        sc->scratchpad = sc->v.s.me.scratchpad;
+    }
+
+    return 0;
+fail:
+    vc1_free_slice_contexts(v);
+    return ret;
+}
+
+static int vc1_decode_slice_thread(AVCodecContext *avctx, void *arg,
+                                   int jobnr, int threadnr)
+{
+    VC1Context *v        = avctx->priv_data;
+    VC1SliceContext *sc  = &v->slice_ctx[threadnr];
+    VC1Context *sv       = &sc->v;
+    VC1SliceJob *job     = (VC1SliceJob *)arg + jobnr;
+    int mb_stride        = v->s.mb_stride;
+
+    memcpy(sv, v, sizeof(*sv));
+    sv->block            = sc->block;
+    sv->cbp_base         = sc->cbp_base;
+    sv->cbp              = sc->cbp_base      + 2 * mb_stride;
+    sv->ttblk_base       = sc->ttblk_base;
+    sv->ttblk            = sc->ttblk_base    + 2 * mb_stride;
+    sv->is_intra_base    = sc->is_intra_base;
+    sv->is_intra         = sc->is_intra_base + 2 * mb_stride;
+    sv->luma_mv_base     = sc->luma_mv_base;
+    sv->luma_mv          = sc->luma_mv_base  + 2 * mb_stride;
+    sv->s.sc             = sc->sc;
+
+    sv->s.gb             = job->gb;
+    sv->s.start_mb_y     = job->start_mb_y;
+    sv->s.end_mb_y       = job->end_mb_y;
+    sv->second_field     = job->second_field;
+    sv->blocks_off       = job->blocks_off;
+    sv->mb_off           = job->mb_off;
+
+    ff_vc1_decode_blocks(sv);
+
+    job->error_occurred  = sv->s.er.error_occurred;
+    job->error_count     = atomic_load(&sv->s.er.error_count);
+    return 0;
+}
+
+/**
+ * Decode the queued slices of one field or frame in parallel and merge their
+ * error resilience state back into the main context.
+ */
+static void vc1_execute_slices(AVCodecContext *avctx, VC1SliceJob *jobs, int nb_jobs)
+{
+    VC1Context *v     = avctx->priv_data;
+    ERContext *er     = &v->s.er;
+    int error_count   = atomic_load(&er->error_count);
+    int i;
+
+    if (!nb_jobs)
+        return;
+
+    avctx->execute2(avctx, vc1_decode_slice_thread, jobs, NULL, nb_jobs);
+
+    for (i = 0; i < nb_jobs; i++) {
+        er->error_occurred |= jobs[i].error_occurred;
+        if (jobs[i].error_count == INT_MAX)
+            atomic_store(&er->error_count, INT_MAX);
+        else if (atomic_load(&er->error_count) != INT_MAX)
+            atomic_fetch_add(&er->error_count, jobs[i].error_count - error_count);
+    }
+}
+
 av_cold int ff_vc1_decode_init_alloc_tables(VC1Context *v)
 {
     MpegEncContext *s = &v->s;
@@ -612,11 +756,100 @@ av_cold int ff_vc1_decode_end(AVCodecContext *avctx)
     av_freep(&v->ttblk_base);
     av_freep(&v->is_intra_base); // FIXME use v->mb_type[]
     av_freep(&v->luma_mv_base);
+    vc1_free_slice_contexts(v);
     ff_intrax8_common_end(&v->x8);
     return 0;
 }
 
 
+static int vc1_decode_init_context(AVCodecContext *avctx)
+{
+    VC1Context *v = avctx->priv_data;
+    MpegEncContext *s = &v->s;
+    int ret;
+
+    if ((ret = ff_msmpeg4_decode_init(avctx)) < 0)
+        return ret;
+    if ((ret = ff_vc1_decode_init_alloc_tables(v)) < 0) {
+        ff_mpv_common_end(s);
+        return ret;
+    }
+
+    s->low_delay = !avctx->has_b_frames || v->res_sprite;
+
+    if (v->profile == PROFILE_ADVANCED) {
+        if(avctx->coded_width<=1 || avctx->coded_height<=1)
+            return AVERROR_INVALIDDATA;
+        s->h_edge_pos = avctx->coded_width;
+        s->v_edge_pos = avctx->coded_height;
+    }
+
+    return 0;
+}
+
+#if HAVE_THREADS
+#define copy_fields(to, from, start_field, end_field)                   \
+    memcpy(&(to)->start_field, &(from)->start_field,                   \
+           (char *)&(to)->end_field - (char *)&(to)->start_field)
+
+static int vc1_update_thread_context(AVCodecContext *dst,
+                                     const AVCodecContext *src)
+{
+    VC1Context *v = dst->priv_data, *v1 = src->priv_data;
+    MpegEncContext *s = &v->s, *s1 = &v1->s;
+    int ret;
+
+    if (dst == src || !s1->context_initialized)
+        return 0;
+
+    /* sequence and entry point level state */
+    copy_fields(v, v1, res_sprite, mv_mode);
+    v->broken_link      = v1->broken_link;
+    v->closed_entry     = v1->closed_entry;
+    v->range_mapy_flag  = v1->range_mapy_flag;
+    v->range_mapuv_flag = v1->range_mapuv_flag;
+    v->range_mapy       = v1->range_mapy;
+    v->range_mapuv      = v1->range_mapuv;
+    v->resync_marker    = v1->resync_marker;
+    s->loop_filter      = s1->loop_filter;
+
+    if (s->context_initialized &&
+        (s->width  != s1->width || s->height != s1->height))
+        ff_vc1_decode_end(dst);
+
+    if (!s->context_initialized) {
+        if ((ret = vc1_decode_init_context(dst)) < 0)
+            return ret;
+    }
+
+    if ((ret = ff_mpeg_update_thread_context(dst, src)) < 0)
+        return ret;
+
+    /* state carried over from the previous pictures */
+    copy_fields(v, v1, last_luty, curr_luty);
+    v->curr_luty   = v1->curr_luty  == v1->aux_luty  ? v->aux_luty  : v->next_luty;
+    v->curr_lutuv  = v1->curr_lutuv == v1->aux_lutuv ? v->aux_lutuv : v->next_lutuv;
+    v->last_use_ic = v1->last_use_ic;
+    v->next_use_ic = v1->next_use_ic;
+    v->aux_use_ic  = v1->aux_use_ic;
+    v->curr_use_ic = v1->curr_use_ic == &v1->aux_use_ic ? &v->aux_use_ic : &v->next_use_ic;
+    v->rnd         = v1->rnd;
+    v->refdist     = v1->refdist;
+    v->qs_last     = v1->qs_last;
+
+    /* B field pictures need the field flags of their backward anchor */
+    if (s1->next_picture_ptr && s1->next_picture_ptr->field_picture) {
+        int mb_height = FFALIGN(s->mb_height, 2);
+        int size      = s->b8_stride * (mb_height * 2 + 1) + s->mb_stride * (mb_height + 1) * 2;
+
+        memcpy(v->mv_f_next[0] - s->b8_stride - 1,
+               v1->mv_f_next[0] - s1->b8_stride - 1, 2 * size);
+    }
+
+    return 0;
+}
+#endif
+
 /** Decode a VC1/WMV3 frame
  * @todo TODO: Handle VC-1 IDUs (Transport level?)
  */
@@ -631,6 +864,9 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     uint8_t *buf2 = NULL;
     const uint8_t *buf_start = buf, *buf_start_second_field = NULL;
     int mb_height, n_slices1=-1;
+    int slice_headers = 0, frame_started = 0;
+    VC1SliceJob *jobs = NULL;
+    int nb_jobs = 0;
     struct {
         uint8_t *buf;
         GetBitContext gb;
@@ -729,6 +965,8 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
                     init_get_bits(&slices[n_slices].gb, slices[n_slices].buf,
                                   buf_size3 << 3);
                     slices[n_slices].mby_start = get_bits(&slices[n_slices].gb, 9);
+                    if (show_bits1(&slices[n_slices].gb))
+                        slice_headers = 1;
                     slices[n_slices].rawbuf = start;
                     slices[n_slices].raw_size = size + 4;
                     n_slices++;
@@ -801,23 +1039,8 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     }
 
     if (!s->context_initialized) {
-        if ((ret = ff_msmpeg4_decode_init(avctx)) < 0)
-            goto err;
-        if ((ret = ff_vc1_decode_init_alloc_tables(v)) < 0) {
-            ff_mpv_common_end(s);
+        if ((ret = vc1_decode_init_context(avctx)) < 0)
             goto err;
-        }
-
-        s->low_delay = !avctx->has_b_frames || v->res_sprite;
-
-        if (v->profile == PROFILE_ADVANCED) {
-            if(avctx->coded_width<=1 || avctx->coded_height<=1) {
-                ret = AVERROR_INVALIDDATA;
-                goto err;
-            }
-            s->h_edge_pos = avctx->coded_width;
-            s->v_edge_pos = avctx->coded_height;
-        }
     }
 
     // do parse frame header
@@ -880,6 +1103,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     if ((ret = ff_mpv_frame_start(s, avctx)) < 0) {
         goto err;
     }
+    frame_started = 1;
 
     v->s.current_picture_ptr->field_picture = v->field_mode;
     v->s.current_picture_ptr->f->interlaced_frame = (v->fcm != PROGRESSIVE);
@@ -900,6 +1124,11 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     s->me.qpel_put = s->qdsp.put_qpel_pixels_tab;
     s->me.qpel_avg = s->qdsp.avg_qpel_pixels_tab;
 
+    /* Headers carried in slices change the picture state while decoding and
+     * field pictures only complete their anchor state at the end. */
+    if (!v->field_mode && !slice_headers)
+        ff_thread_finish_setup(avctx);
+
     if (avctx->hwaccel) {
         s->mb_y = 0;
         if (v->field_mode && buf_start_second_field) {
@@ -1039,6 +1268,17 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
 
         av_assert0 (mb_height > 0);
 
+        if (avctx->active_thread_type & FF_THREAD_SLICE && avctx->thread_count > 1 &&
+            n_slices > 0 && !slice_headers && !avctx->draw_horiz_band) {
+            if ((ret = vc1_alloc_slice_contexts(avctx)) < 0)
+                goto err;
+            jobs = av_malloc_array(n_slices + 1, sizeof(*jobs));
+            if (!jobs) {
+                ret = AVERROR(ENOMEM);
+                goto err;
+            }
+        }
+
         for (i = 0; i <= n_slices; i++) {
             if (i > 0 &&  slices[i - 1].mby_start >= mb_height) {
                 if (v->field_mode <= 0) {
@@ -1059,6 +1299,8 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
             if (i) {
                 v->pic_header_flag = 0;
                 if (v->field_mode && i == n_slices1 + 2) {
+                    vc1_execute_slices(avctx, jobs, nb_jobs);
+                    nb_jobs = 0;
                     if ((header_ret = ff_vc1_parse_frame_header_adv(v, &s->gb)) < 0) {
                         av_log(v->s.avctx, AV_LOG_ERROR, "Field header damaged\n");
                         ret = AVERROR_INVALIDDATA;
@@ -1066,6 +1308,8 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
                             goto err;
                         continue;
                     }
+                    if (s->pict_type == AV_PICTURE_TYPE_B && !slice_headers)
+                        ff_thread_finish_setup(avctx);
                 } else if (get_bits1(&s->gb)) {
                     v->pic_header_flag = 1;
                     if ((header_ret = ff_vc1_parse_frame_header_adv(v, &s->gb)) < 0) {
@@ -1099,11 +1343,21 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
                 av_log(v->s.avctx, AV_LOG_ERROR, "missing cbpcy_vlc\n");
                 continue;
             }
-            ff_vc1_decode_blocks(v);
+            if (jobs) {
+                VC1SliceJob *job  = &jobs[nb_jobs++];
+                job->gb           = s->gb;
+                job->start_mb_y   = s->start_mb_y;
+                job->end_mb_y     = s->end_mb_y;
+                job->second_field = v->second_field;
+                job->blocks_off   = v->blocks_off;
+                job->mb_off       = v->mb_off;
+            } else
+                ff_vc1_decode_blocks(v);
             if (i != n_slices) {
                 s->gb = slices[i].gb;
             }
         }
+        vc1_execute_slices(avctx, jobs, nb_jobs);
         if (v->field_mode) {
             v->second_field = 0;
             s->current_picture.f->linesize[0] >>= 1;
@@ -1167,13 +1421,17 @@ end:
     for (i = 0; i < n_slices; i++)
         av_free(slices[i].buf);
     av_free(slices);
+    av_free(jobs);
     return buf_size;
 
 err:
+    if (frame_started)
+        ff_thread_report_progress(&s->current_picture_ptr->tf, INT_MAX, 0);
     av_free(buf2);
     for (i = 0; i < n_slices; i++)
         av_free(slices[i].buf);
     av_free(slices);
+    av_free(jobs);
     return ret;
 }
 
@@ -1208,8 +1466,10 @@ AVCodec ff_vc1_decoder = {
     .init           = vc1_decode_init,
     .close          = ff_vc1_decode_end,
     .decode         = vc1_decode_frame,
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
     .flush          = ff_mpeg_flush,
-    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
     .hw_configs     = (const AVCodecHWConfigInternal *const []) {
 #if CONFIG_VC1_DXVA2_HWACCEL
@@ -1245,8 +1505,10 @@ AVCodec ff_wmv3_decoder = {
     .init           = vc1_decode_init,
     .close          = ff_vc1_decode_end,
     .decode         = vc1_decode_frame,
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
     .flush          = ff_mpeg_flush,
-    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
     .hw_configs     = (const AVCodecHWConfigInternal *const []) {
 #if CONFIG_WMV3_DXVA2_HWACCEL
@@ -57,6 +57,7 @@
 #define SQUARE(x) ((x)*(x))
 
 #define NB_BANDS 22
+#define NB_BAND_BINS (100<<FRAME_SIZE_SHIFT)
 
 #define CEPS_MEM 8
 #define NB_DELTA_CEPS 6
@@ -145,6 +146,9 @@ typedef struct AudioRNNContext {
 
     DECLARE_ALIGNED(32, float, window)[WINDOW_SIZE];
     DECLARE_ALIGNED(32, float, dct_table)[FFALIGN(NB_BANDS, 4)][FFALIGN(NB_BANDS, 4)];
+    /* weights of each interleaved re/im value in its band and in the next one */
+    DECLARE_ALIGNED(32, float, band_ifrac)[2 * NB_BAND_BINS];
+    DECLARE_ALIGNED(32, float, band_frac)[2 * NB_BAND_BINS];
 
     RNNModel *model[2];
 
@@ -291,7 +295,7 @@ static int rnnoise_model_from_file(FILE *f, RNNModel **rnn)
     ret->name ## _size = name->nb_neurons; \
     INPUT_ACTIVATION(name->activation); \
     NEW_LINE(); \
-    INPUT_ARRAY(name->input_weights, name->nb_inputs * name->nb_neurons); \
+    INPUT_ARRAY3(name->input_weights, name->nb_inputs, name->nb_neurons, 1); \
     NEW_LINE(); \
     INPUT_ARRAY(name->bias, name->nb_neurons); \
     NEW_LINE(); \
@@ -458,54 +462,31 @@ static const uint8_t eband5ms[] = {
   0,  1,  2,  3,  4,   5, 6,  7,  8,  10, 12, 14, 16, 20, 24, 28, 34, 40, 48, 60, 78, 100
 };
 
-static void compute_band_energy(float *bandE, const AVComplexFloat *X)
+static void compute_band_corr(AudioRNNContext *s, float *bandE, const AVComplexFloat *X, const AVComplexFloat *P)
 {
-    float sum[NB_BANDS] = {0};
+    LOCAL_ALIGNED_32(float, tmp, [2 * NB_BAND_BINS]);
+    float sum[NB_BANDS] = { 0 };
 
-    for (int i = 0; i < NB_BANDS - 1; i++) {
-        int band_size;
+    s->fdsp->vector_fmul(tmp, (const float *)X, (const float *)P, 2 * NB_BAND_BINS);
 
-        band_size = (eband5ms[i + 1] - eband5ms[i]) << FRAME_SIZE_SHIFT;
-        for (int j = 0; j < band_size; j++) {
-            float tmp, frac = (float)j / band_size;
+    for (int i = 0; i < NB_BANDS - 1; i++) {
+        const int band_start = 2 * (eband5ms[i] << FRAME_SIZE_SHIFT);
+        const int band_size  = 2 * ((eband5ms[i + 1] - eband5ms[i]) << FRAME_SIZE_SHIFT);
 
-            tmp         = SQUARE(X[(eband5ms[i] << FRAME_SIZE_SHIFT) + j].re);
-            tmp        += SQUARE(X[(eband5ms[i] << FRAME_SIZE_SHIFT) + j].im);
-            sum[i]     += (1.f - frac) * tmp;
-            sum[i + 1] +=        frac  * tmp;
-        }
+        sum[i]     += s->fdsp->scalarproduct_float(tmp + band_start, s->band_ifrac + band_start, band_size);
+        sum[i + 1] += s->fdsp->scalarproduct_float(tmp + band_start, s->band_frac  + band_start, band_size);
     }
 
     sum[0] *= 2;
-    sum[NB_BANDS - 1] *= 2;
+    sum[NB_BANDS-1] *= 2;
 
     for (int i = 0; i < NB_BANDS; i++)
         bandE[i] = sum[i];
 }
 
-static void compute_band_corr(float *bandE, const AVComplexFloat *X, const AVComplexFloat *P)
+static void compute_band_energy(AudioRNNContext *s, float *bandE, const AVComplexFloat *X)
 {
-    float sum[NB_BANDS] = { 0 };
-
-    for (int i = 0; i < NB_BANDS - 1; i++) {
-        int band_size;
-
-        band_size = (eband5ms[i + 1] - eband5ms[i]) << FRAME_SIZE_SHIFT;
-        for (int j = 0; j < band_size; j++) {
-            float tmp, frac = (float)j / band_size;
-
-            tmp  = X[(eband5ms[i]<<FRAME_SIZE_SHIFT) + j].re * P[(eband5ms[i]<<FRAME_SIZE_SHIFT) + j].re;
-            tmp += X[(eband5ms[i]<<FRAME_SIZE_SHIFT) + j].im * P[(eband5ms[i]<<FRAME_SIZE_SHIFT) + j].im;
-            sum[i]     += (1 - frac) * tmp;
-            sum[i + 1] +=      frac  * tmp;
-        }
-    }
-
-    sum[0] *= 2;
-    sum[NB_BANDS-1] *= 2;
-
-    for (int i = 0; i < NB_BANDS; i++)
-        bandE[i] = sum[i];
+    compute_band_corr(s, bandE, X, X);
 }
 
 static void frame_analysis(AudioRNNContext *s, DenoiseState *st, AVComplexFloat *X, float *Ex, const float *in)
@@ -517,7 +498,7 @@ static void frame_analysis(AudioRNNContext *s, DenoiseState *st, AVComplexFloat
     RNN_COPY(st->analysis_mem, in, FRAME_SIZE);
     s->fdsp->vector_fmul(x, x, s->window, WINDOW_SIZE);
     forward_transform(st, X, x);
-    compute_band_energy(Ex, X);
+    compute_band_energy(s, Ex, X);
 }
 
 static void frame_synthesis(AudioRNNContext *s, DenoiseState *st, float *out, const AVComplexFloat *y)
@@ -1065,8 +1046,8 @@ static int compute_frame_features(AudioRNNContext *s, DenoiseState *st, AVComple
 
     s->fdsp->vector_fmul(p, p, s->window, WINDOW_SIZE);
     forward_transform(st, P, p);
-    compute_band_energy(Ep, P);
-    compute_band_corr(Exp, X, P);
+    compute_band_energy(s, Ep, P);
+    compute_band_corr(s, Exp, X, P);
 
     for (int i = 0; i < NB_BANDS; i++)
         Exp[i] = Exp[i] / sqrtf(.001f+Ex[i]*Ep[i]);
@@ -1154,8 +1135,8 @@ static void interp_band_gain(float *g, const float *bandE)
     }
 }
 
-static void pitch_filter(AVComplexFloat *X, const AVComplexFloat *P, const float *Ex, const float *Ep,
-                         const float *Exp, const float *g)
+static void pitch_filter(AudioRNNContext *s, AVComplexFloat *X, const AVComplexFloat *P,
+                         const float *Ex, const float *Ep, const float *Exp, const float *g)
 {
     float newE[NB_BANDS];
     float r[NB_BANDS];
@@ -1174,7 +1155,7 @@ static void pitch_filter(AVComplexFloat *X, const AVComplexFloat *P, const float
         X[i].re += rf[i]*P[i].re;
         X[i].im += rf[i]*P[i].im;
     }
-    compute_band_energy(newE, X);
+    compute_band_energy(s, newE, X);
     for (int i = 0; i < NB_BANDS; i++) {
         norm[i] = sqrtf(Ex[i] / (1e-8+newE[i]));
     }
@@ -1262,17 +1243,16 @@ static inline float sigmoid_approx(float x)
     return .5f + .5f*tansig_approx(.5f*x);
 }
 
-static void compute_dense(const DenseLayer *layer, float *output, const float *input)
+static void compute_dense(AudioRNNContext *s, const DenseLayer *layer, float *output, const float *input)
 {
-    const int N = layer->nb_neurons, M = layer->nb_inputs, stride = N;
+    const int N = layer->nb_neurons, M = layer->nb_inputs;
+    const int AM = FFALIGN(M, 4);
 
     for (int i = 0; i < N; i++) {
         /* Compute update gate. */
         float sum = layer->bias[i];
 
-        for (int j = 0; j < M; j++)
-            sum += layer->input_weights[j * stride + i] * input[j];
-
+        sum += s->fdsp->scalarproduct_float(layer->input_weights + i * AM, input, AM);
         output[i] = WEIGHTS_SCALE * sum;
     }
 
@@ -1295,6 +1275,7 @@ static void compute_gru(AudioRNNContext *s, const GRULayer *gru, float *state, c
     LOCAL_ALIGNED_32(float, z, [MAX_NEURONS]);
     LOCAL_ALIGNED_32(float, r, [MAX_NEURONS]);
     LOCAL_ALIGNED_32(float, h, [MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, rs, [MAX_NEURONS]);
     const int M = gru->nb_inputs;
     const int N = gru->nb_neurons;
     const int AN = FFALIGN(N, 4);
@@ -1319,13 +1300,15 @@ static void compute_gru(AudioRNNContext *s, const GRULayer *gru, float *state, c
         r[i] = sigmoid_approx(WEIGHTS_SCALE * sum);
     }
 
+    RNN_CLEAR(r + N, FFALIGN(N, 16) - N);
+    s->fdsp->vector_fmul(rs, state, r, FFALIGN(N, 16));
+
     for (int i = 0; i < N; i++) {
         /* Compute output. */
         float sum = gru->bias[2 * N + i];
 
         sum += s->fdsp->scalarproduct_float(gru->input_weights + 2 * AM + i * istride, input, AM);
-        for (int j = 0; j < N; j++)
-            sum += gru->recurrent_weights[2 * AN + i * stride + j] * state[j] * r[j];
+        sum += s->fdsp->scalarproduct_float(gru->recurrent_weights + 2 * AN + i * stride, rs, AN);
 
         if (gru->activation == ACTIVATION_SIGMOID)
             sum = sigmoid_approx(WEIGHTS_SCALE * sum);
@@ -1349,15 +1332,19 @@ static void compute_rnn(AudioRNNContext *s, RNNState *rnn, float *gains, float *
     LOCAL_ALIGNED_32(float, noise_input,   [MAX_NEURONS * 3]);
     LOCAL_ALIGNED_32(float, denoise_input, [MAX_NEURONS * 3]);
 
-    compute_dense(rnn->model->input_dense, dense_out, input);
+    compute_dense(s, rnn->model->input_dense, dense_out, input);
+    RNN_CLEAR(dense_out + rnn->model->input_dense_size,
+              FFALIGN(rnn->model->input_dense_size, 4) - rnn->model->input_dense_size);
     compute_gru(s, rnn->model->vad_gru, rnn->vad_gru_state, dense_out);
-    compute_dense(rnn->model->vad_output, vad, rnn->vad_gru_state);
+    compute_dense(s, rnn->model->vad_output, vad, rnn->vad_gru_state);
 
     memcpy(noise_input, dense_out, rnn->model->input_dense_size * sizeof(float));
     memcpy(noise_input + rnn->model->input_dense_size,
            rnn->vad_gru_state, rnn->model->vad_gru_size * sizeof(float));
     memcpy(noise_input + rnn->model->input_dense_size + rnn->model->vad_gru_size,
            input, INPUT_SIZE * sizeof(float));
+    RNN_CLEAR(noise_input + rnn->model->noise_gru->nb_inputs,
+              FFALIGN(rnn->model->noise_gru->nb_inputs, 4) - rnn->model->noise_gru->nb_inputs);
 
     compute_gru(s, rnn->model->noise_gru, rnn->noise_gru_state, noise_input);
 
@@ -1366,20 +1353,22 @@ static void compute_rnn(AudioRNNContext *s, RNNState *rnn, float *gains, float *
            rnn->noise_gru_state, rnn->model->noise_gru_size * sizeof(float));
     memcpy(denoise_input + rnn->model->vad_gru_size + rnn->model->noise_gru_size,
            input, INPUT_SIZE * sizeof(float));
+    RNN_CLEAR(denoise_input + rnn->model->denoise_gru->nb_inputs,
+              FFALIGN(rnn->model->denoise_gru->nb_inputs, 4) - rnn->model->denoise_gru->nb_inputs);
 
     compute_gru(s, rnn->model->denoise_gru, rnn->denoise_gru_state, denoise_input);
-    compute_dense(rnn->model->denoise_output, gains, rnn->denoise_gru_state);
+    compute_dense(s, rnn->model->denoise_output, gains, rnn->denoise_gru_state);
 }
 
 static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, const float *in,
                              int disabled)
 {
-    AVComplexFloat X[FREQ_SIZE];
-    AVComplexFloat P[WINDOW_SIZE];
+    LOCAL_ALIGNED_32(AVComplexFloat, X, [FREQ_SIZE]);
+    LOCAL_ALIGNED_32(AVComplexFloat, P, [WINDOW_SIZE]);
     float x[FRAME_SIZE];
     float Ex[NB_BANDS], Ep[NB_BANDS];
     LOCAL_ALIGNED_32(float, Exp, [NB_BANDS]);
-    float features[NB_FEATURES];
+    LOCAL_ALIGNED_32(float, features, [FFALIGN(NB_FEATURES, 4)]);
     float g[NB_BANDS];
     float gf[FREQ_SIZE];
     float vad_prob = 0;
@@ -1388,12 +1377,13 @@ static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, c
     static const float b_hp[2] = {-2, 1};
     int silence;
 
+    RNN_CLEAR(features + NB_FEATURES, FFALIGN(NB_FEATURES, 4) - NB_FEATURES);
     biquad(x, st->mem_hp_x, in, b_hp, a_hp, FRAME_SIZE);
     silence = compute_frame_features(s, st, X, P, Ex, Ep, Exp, features, x);
 
     if (!silence && !disabled) {
         compute_rnn(s, &st->rnn[0], g, &vad_prob, features);
-        pitch_filter(X, P, Ex, Ep, Exp, g);
+        pitch_filter(s, X, P, Ex, Ep, Exp, g);
         for (int i = 0; i < NB_BANDS; i++) {
             float alpha = .6f;
 
@@ -1522,6 +1512,18 @@ static av_cold int init(AVFilterContext *ctx)
         s->window[WINDOW_SIZE - 1 - i] = s->window[i];
     }
 
+    for (int i = 0; i < NB_BANDS - 1; i++) {
+        const int band_start = eband5ms[i] << FRAME_SIZE_SHIFT;
+        const int band_size  = (eband5ms[i + 1] - eband5ms[i]) << FRAME_SIZE_SHIFT;
+
+        for (int j = 0; j < band_size; j++) {
+            const float frac = (float)j / band_size;
+
+            s->band_frac [2 * (band_start + j)] = s->band_frac [2 * (band_start + j) + 1] = frac;
+            s->band_ifrac[2 * (band_start + j)] = s->band_ifrac[2 * (band_start + j) + 1] = 1.f - frac;
+        }
+    }
+
     for (int i = 0; i < NB_BANDS; i++) {
         for (int j = 0; j < NB_BANDS; j++) {
             s->dct_table[j][i] = cosf((i + .5f) * j * M_PI / NB_BANDS);
@@ -553,6 +553,10 @@ int avfilter_process_command(AVFilterContext *filter, const char *cmd, const cha
     }else if(!strcmp(cmd, "enable")) {
         return set_enable_expr(filter, arg);
     }else if(filter->filter->process_command) {
+        /* The pending frames must be filtered with the old parameters. */
+        int ret = ff_filter_frame_thread_output(filter, 2);
+        if (ret < 0)
+            return ret;
         return filter->filter->process_command(filter, cmd, arg, res, res_len, flags);
     }
     return AVERROR(ENOSYS);
@@ -624,8 +628,9 @@ static const AVClass *filter_child_class_iterate(void **iter)
 #define TFLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_RUNTIME_PARAM
 static const AVOption avfilter_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
-        { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, FLAGS, "thread_type" },
+        { .i64 = AVFILTER_THREAD_SLICE | AVFILTER_THREAD_FRAME }, 0, INT_MAX, FLAGS, "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = FLAGS, .unit = "thread_type" },
+        { "frame", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_FRAME }, .flags = FLAGS, .unit = "thread_type" },
     { "enable", "set enable expression", OFFSET(enable_str), AV_OPT_TYPE_STRING, {.str=NULL}, .flags = TFLAGS },
     { "threads", "Allowed number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
         { .i64 = 0 }, 0, INT_MAX, FLAGS },
@@ -764,6 +769,8 @@ void avfilter_free(AVFilterContext *filter)
     if (!filter)
         return;
 
+    ff_filter_frame_thread_free(filter);
+
     if (filter->graph)
         ff_filter_graph_remove_filter(filter->graph, filter);
 
@@ -894,7 +901,7 @@ int ff_filter_process_command(AVFilterContext *ctx, const char *cmd,
 
 int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
 {
-    int ret = 0;
+    int ret = 0, thread_type;
 
     ret = av_opt_set_dict(ctx, options);
     if (ret < 0) {
@@ -902,14 +909,19 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
         return ret;
     }
 
+    thread_type      = ctx->thread_type & ctx->graph->thread_type;
+    ctx->thread_type = 0;
     if (ctx->filter->flags & AVFILTER_FLAG_SLICE_THREADS &&
-        ctx->thread_type & ctx->graph->thread_type & AVFILTER_THREAD_SLICE &&
+        thread_type & AVFILTER_THREAD_SLICE &&
         ctx->graph->internal->thread_execute) {
         ctx->thread_type       = AVFILTER_THREAD_SLICE;
         ctx->internal->execute = ctx->graph->internal->thread_execute;
-    } else {
-        ctx->thread_type = 0;
     }
+    if (ctx->filter->flags & AVFILTER_FLAG_FRAME_THREADS &&
+        thread_type & AVFILTER_THREAD_FRAME &&
+        !ctx->filter->activate && ctx->nb_inputs == 1 && ctx->nb_outputs == 1 &&
+        ff_filter_get_nb_threads(ctx) > 1)
+        ctx->thread_type |= AVFILTER_THREAD_FRAME;
 
     if (ctx->filter->priv_class) {
         ret = av_opt_set_dict2(ctx->priv, options, AV_OPT_SEARCH_CHILDREN);
@@ -1082,7 +1094,10 @@ static int ff_filter_frame_framed(AVFilterLink *link, AVFrame *frame)
     if (dstctx->is_disabled &&
         (dstctx->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC))
         filter_frame = default_filter_frame;
-    ret = filter_frame(link, frame);
+    if (dstctx->thread_type & AVFILTER_THREAD_FRAME)
+        ret = ff_filter_frame_thread_submit(link, frame, filter_frame);
+    else
+        ret = filter_frame(link, frame);
     link->frame_count_out++;
     return ret;
 
@@ -1096,6 +1111,9 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
     int ret;
     FF_TPRINTF_START(NULL, filter_frame); ff_tlog_link(NULL, link, 1); ff_tlog(NULL, " "); ff_tlog_ref(NULL, frame, 1);
 
+    if (link->frame_thread_job)
+        return ff_filter_frame_thread_capture(link, frame);
+
     /* Consistency checks */
     if (link->type == AVMEDIA_TYPE_VIDEO) {
         if (strcmp(link->dst->filter->name, "buffersink") &&
@@ -1276,15 +1294,29 @@ static int forward_status_change(AVFilterContext *filter, AVFilterLink *in)
 static int ff_filter_activate_default(AVFilterContext *filter)
 {
     unsigned i;
+    int ret;
 
     for (i = 0; i < filter->nb_inputs; i++) {
         if (samples_ready(filter->inputs[i], filter->inputs[i]->min_samples)) {
+            if (ff_filter_frame_thread_busy(filter)) {
+                /* Make room for the queued frame first. */
+                ret = ff_filter_frame_thread_output(filter, 1);
+                if (ret > 0)
+                    ff_filter_set_ready(filter, 300);
+                return FFMIN(ret, 0);
+            }
             return ff_filter_frame_to_filter(filter->inputs[i]);
         }
     }
+    ret = ff_filter_frame_thread_output(filter, 0);
+    if (ret)
+        return FFMIN(ret, 0);
     for (i = 0; i < filter->nb_inputs; i++) {
         if (filter->inputs[i]->status_in && !filter->inputs[i]->status_out) {
             av_assert1(!ff_framequeue_queued_frames(&filter->inputs[i]->fifo));
+            ret = ff_filter_frame_thread_output(filter, 2);
+            if (ret < 0)
+                return ret;
             return forward_status_change(filter, filter->inputs[i]);
         }
     }
@@ -1294,6 +1326,14 @@ static int ff_filter_activate_default(AVFilterContext *filter)
             return ff_request_frame_to_filter(filter->outputs[i]);
         }
     }
+    /* Frames are wanted but no more input is available for now: wait for
+       the oldest frame being filtered instead of stalling. */
+    if (filter->thread_type & AVFILTER_THREAD_FRAME &&
+        filter->outputs[0]->frame_wanted_out) {
+        ret = ff_filter_frame_thread_output(filter, 1);
+        if (ret)
+            return FFMIN(ret, 0);
+    }
     return FFERROR_NOT_READY;
 }
 
@@ -115,6 +115,12 @@ enum AVMediaType avfilter_pad_get_type(const AVFilterPad *pads, int pad_idx);
  * and processing them concurrently.
  */
 #define AVFILTER_FLAG_SLICE_THREADS         (1 << 2)
+/**
+ * The filter is reentrant: its filter_frame() callback only reads the
+ * filter private context and can be run concurrently on several frames.
+ * Such filters can be frame threaded, see AVFILTER_THREAD_FRAME.
+ */
+#define AVFILTER_FLAG_FRAME_THREADS         (1 << 3)
 /**
  * Some filters support a generic "enable" expression option that can be used
  * to enable or disable a filter in the timeline. Filters supporting this
@@ -334,6 +340,12 @@ typedef struct AVFilter {
  * Process multiple parts of the frame concurrently.
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
+/**
+ * Process several frames concurrently, each in its own thread, for the
+ * filters flagged with AVFILTER_FLAG_FRAME_THREADS. The output frames are
+ * forwarded in order, but with a delay of up to one frame per thread.
+ */
+#define AVFILTER_THREAD_FRAME (1 << 1)
 
 typedef struct AVFilterInternal AVFilterInternal;
 
@@ -652,6 +664,12 @@ struct AVFilterLink {
      */
     int status_out;
 
+    /**
+     * If set, this link is a private copy used by a frame thread worker and
+     * the frames sent on it are queued in the corresponding job.
+     */
+    struct FFFrameThreadJob *frame_thread_job;
+
 #endif /* FF_INTERNAL_FIELDS */
 
 };
@@ -862,7 +880,8 @@ typedef struct AVFilterGraph {
      * of AVFILTER_THREAD_* flags.
      *
      * May be set by the caller at any point, the setting will apply to all
-     * filters initialized after that. The default is allowing everything.
+     * filters initialized after that. The default is AVFILTER_THREAD_SLICE,
+     * frame threading has to be enabled explicitly.
      *
      * When a filter in this graph is initialized, this field is combined using
      * bit AND with AVFilterContext.thread_type to get the final mask used for
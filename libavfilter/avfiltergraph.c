@@ -38,6 +38,7 @@
 
 #include "avfilter.h"
 #include "buffersink.h"
+#include "filters.h"
 #include "formats.h"
 #include "internal.h"
 #include "thread.h"
@@ -50,6 +51,7 @@ static const AVOption filtergraph_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, F|V|A, "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = F|V|A, .unit = "thread_type" },
+        { "frame", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_FRAME }, .flags = F|V|A, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads),
         AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX, F|V|A },
     {"scale_sws_opts"       , "default scale filter options"        , OFFSET(scale_sws_opts)        ,
@@ -78,6 +80,38 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     graph->nb_threads  = 1;
     return 0;
 }
+
+int ff_filter_frame_thread_submit(AVFilterLink *link, AVFrame *frame,
+                                  int (*filter_frame)(AVFilterLink *, AVFrame *))
+{
+    av_frame_free(&frame);
+    return AVERROR(ENOSYS);
+}
+
+int ff_filter_frame_thread_output(AVFilterContext *ctx, int wait)
+{
+    return 0;
+}
+
+int ff_filter_frame_thread_completed(AVFilterContext *ctx)
+{
+    return 0;
+}
+
+int ff_filter_frame_thread_busy(AVFilterContext *ctx)
+{
+    return 0;
+}
+
+int ff_filter_frame_thread_capture(AVFilterLink *link, AVFrame *frame)
+{
+    av_frame_free(&frame);
+    return AVERROR(ENOSYS);
+}
+
+void ff_filter_frame_thread_free(AVFilterContext *ctx)
+{
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -1394,6 +1428,9 @@ int ff_filter_graph_run_once(AVFilterGraph *graph)
     unsigned i;
 
     av_assert0(graph->nb_filters);
+    for (i = 0; i < graph->nb_filters; i++)
+        if (ff_filter_frame_thread_completed(graph->filters[i]))
+            ff_filter_set_ready(graph->filters[i], 300);
     filter = graph->filters[0];
     for (i = 1; i < graph->nb_filters; i++)
         if (graph->filters[i]->ready > filter->ready)
@@ -134,6 +134,8 @@ struct AVFilterGraphInternal {
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+    void *frame_thread;
+    int frame_job;      ///< 1 + index of the frame thread job using this copy, 0 if none
 };
 
 /**
@@ -365,6 +367,18 @@ static inline int ff_norm_qscale(int qscale, int type)
  */
 int ff_filter_get_nb_threads(AVFilterContext *ctx);
 
+/**
+ * Get the index of the per-thread scratch data a slice job may use.
+ *
+ * This is jobnr, except in frame thread workers: they run the slices of a
+ * frame one after the other, and the frames processed concurrently get
+ * distinct indexes below ff_filter_get_nb_threads().
+ */
+static inline int ff_filter_thread_slot(AVFilterContext *ctx, int jobnr)
+{
+    return ctx->internal->frame_job ? ctx->internal->frame_job - 1 : jobnr;
+}
+
 /**
  * Generic processing of user supplied commands that are set
  * in the same way as the filter options.
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2013 Clément Bœsch
+ * Copyright (c) 2018 Paul B Mahol
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_LUT3D_H
+#define AVFILTER_LUT3D_H
+
+#include <stdint.h>
+
+#include "config.h"
+#include "libavutil/pixdesc.h"
+#include "avfilter.h"
+#include "framesync.h"
+
+enum interp_mode {
+    INTERPOLATE_NEAREST,
+    INTERPOLATE_TRILINEAR,
+    INTERPOLATE_TETRAHEDRAL,
+    INTERPOLATE_PYRAMID,
+    INTERPOLATE_PRISM,
+    NB_INTERP_MODE
+};
+
+struct rgbvec {
+    float r, g, b;
+};
+
+/* 3D LUT don't often go up to level 32, but it is common to have a Hald CLUT
+ * of 512x512 (64x64x64) */
+#define MAX_LEVEL 256
+#define PRELUT_SIZE 65536
+
+typedef struct Lut3DPreLut {
+    int size;
+    float min[3];
+    float max[3];
+    float scale[3];
+    float* lut[3];
+} Lut3DPreLut;
+
+/**
+ * Constants of the planar row functions. Every value is replicated 8 times
+ * so that SIMD versions can use them as memory operands; the layout is
+ * mirrored in x86/vf_lut3d.asm.
+ */
+typedef struct LUT3DRowCoeffs {
+    float   scale[3][8];    ///< r, g, b: normalized input to LUT coordinates
+    float   lut_max[8];     ///< lutsize - 1
+    float   in_scale[8];    ///< 1 / ((1 << depth) - 1), unused for float
+    float   out_scale[8];   ///< (1 << depth) - 1, unused for float
+    int32_t lutsize[8];
+    int32_t lutsize2[8];
+    int32_t lut_last[8];    ///< lutsize - 1
+    int32_t out_max[8];     ///< (1 << depth) - 1, unused for float
+} LUT3DRowCoeffs;
+
+typedef struct LUT3DContext {
+    const AVClass *class;
+    int interpolation;          ///<interp_mode
+    char *file;
+    uint8_t rgba_map[4];
+    int step;
+    avfilter_action_func *interp;
+    struct rgbvec scale;
+    struct rgbvec *lut;
+    int lutsize;
+    int lutsize2;
+    Lut3DPreLut prelut;
+
+    /**
+     * Interpolate one row of planar pixels. dst and src hold the G, B and R
+     * planes. If shaper is not NULL, it holds the r, g and b tables mapping
+     * input samples to LUT coordinates, with the 1D pre-LUT and the input
+     * scale baked in (integer input only).
+     */
+    void (*interp_row)(uint8_t *const dst[3], const uint8_t *const src[3],
+                       const struct rgbvec *lut, const float *const *shaper,
+                       const LUT3DRowCoeffs *c, int width);
+    LUT3DRowCoeffs row_coeffs;
+    float *shaper[3];
+    int depth;
+#if CONFIG_HALDCLUT_FILTER
+    uint8_t clut_rgba_map[4];
+    int clut_step;
+    int clut_bits;
+    int clut_planar;
+    int clut_float;
+    int clut_width;
+    FFFrameSync fs;
+#endif
+} LUT3DContext;
+
+void ff_lut3d_init(LUT3DContext *s, const AVPixFmtDescriptor *desc);
+void ff_lut3d_init_x86(LUT3DContext *s, const AVPixFmtDescriptor *desc);
+
+#endif /* AVFILTER_LUT3D_H */
@@ -23,15 +23,24 @@
 
 #include "config.h"
 
+#include <stdatomic.h>
+
 #include "libavutil/common.h"
 #include "libavutil/cpu.h"
 #include "libavutil/mem.h"
 #include "libavutil/thread.h"
 #include "libavutil/slicethread.h"
 
+#define FF_INTERNAL_FIELDS 1
+#include "framequeue.h"
+
+#include "audio.h"
 #include "avfilter.h"
+#include "filters.h"
+#include "framepool.h"
 #include "internal.h"
 #include "thread.h"
+#include "video.h"
 
 typedef struct ThreadContext {
     AVFilterGraph *graph;
@@ -114,3 +123,342 @@ void ff_graph_thread_free(AVFilterGraph *graph)
         slice_thread_uninit(graph->internal->thread);
     av_freep(&graph->internal->thread);
 }
+
+typedef struct FrameThreadContext FrameThreadContext;
+
+typedef struct FFFrameThreadJob {
+    FrameThreadContext *ft;
+
+    /* Private copies of the filter context and its links, the filter sees
+     * those while running in the worker. */
+    AVFilterContext   ctx;
+    AVFilterInternal  internal;
+    AVFilterLink      inlink, outlink;
+    AVFilterLink     *inputs[1], *outputs[1];
+    AVFilterPad       outpad;
+
+    int (*filter_frame)(AVFilterLink *, AVFrame *);
+    AVFrame  *in;
+    AVFrame **out;
+    int       nb_out;
+    int       ret;
+    int       done;
+} FFFrameThreadJob;
+
+struct FrameThreadContext {
+    AVFilterContext *ctx;
+
+    pthread_t *threads;
+    int     nb_threads;
+
+    /* Ring of jobs, in submission order. first_job and nb_pending are only
+     * accessed by the filtering thread, next_job, nb_queued and the done
+     * field of the jobs are protected by lock. */
+    FFFrameThreadJob *jobs;
+    int            nb_jobs;
+    int            first_job;
+    int            nb_pending;
+    int            next_job;
+    int            nb_queued;
+    int            exit;
+
+    /* set by the workers when a job is done, cleared by the graph thread
+     * when it marks the filter ready */
+    atomic_int     completed;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  job_cond;
+    pthread_cond_t  done_cond;
+
+    /* serializes the allocations from the output link */
+    pthread_mutex_t buffer_lock;
+};
+
+static int frame_thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
+                                void *arg, int *ret, int nb_jobs)
+{
+    for (int i = 0; i < nb_jobs; i++) {
+        int r = func(ctx, arg, i, nb_jobs);
+        if (ret)
+            ret[i] = r;
+    }
+    return 0;
+}
+
+static AVFrame *frame_thread_get_video_buffer(AVFilterLink *link, int w, int h)
+{
+    FrameThreadContext *ft = link->frame_thread_job->ft;
+    AVFrame *frame;
+
+    pthread_mutex_lock(&ft->buffer_lock);
+    frame = ff_get_video_buffer(ft->ctx->outputs[0], w, h);
+    pthread_mutex_unlock(&ft->buffer_lock);
+
+    return frame;
+}
+
+static AVFrame *frame_thread_get_audio_buffer(AVFilterLink *link, int nb_samples)
+{
+    FrameThreadContext *ft = link->frame_thread_job->ft;
+    AVFrame *frame;
+
+    pthread_mutex_lock(&ft->buffer_lock);
+    frame = ff_get_audio_buffer(ft->ctx->outputs[0], nb_samples);
+    pthread_mutex_unlock(&ft->buffer_lock);
+
+    return frame;
+}
+
+static void *frame_worker(void *arg)
+{
+    FrameThreadContext *ft = arg;
+
+    pthread_mutex_lock(&ft->lock);
+    while (1) {
+        FFFrameThreadJob *job;
+
+        while (!ft->nb_queued && !ft->exit)
+            pthread_cond_wait(&ft->job_cond, &ft->lock);
+        if (ft->exit)
+            break;
+
+        job = &ft->jobs[ft->next_job];
+        ft->next_job = (ft->next_job + 1) % ft->nb_jobs;
+        ft->nb_queued--;
+        pthread_mutex_unlock(&ft->lock);
+
+        job->ret = job->filter_frame(&job->inlink, job->in);
+        job->in  = NULL;
+
+        pthread_mutex_lock(&ft->lock);
+        job->done = 1;
+        pthread_cond_signal(&ft->done_cond);
+        /* ready belongs to the graph thread, which polls this flag */
+        atomic_store(&ft->completed, 1);
+    }
+    pthread_mutex_unlock(&ft->lock);
+
+    return NULL;
+}
+
+static void frame_thread_job_reset(FFFrameThreadJob *job)
+{
+    for (int i = 0; i < job->nb_out; i++)
+        av_frame_free(&job->out[i]);
+    av_freep(&job->out);
+    job->nb_out = 0;
+    av_frame_free(&job->in);
+
+    /* only set if frames were allocated on the private links */
+    ff_frame_pool_uninit((FFFramePool **)&job->inlink.frame_pool);
+    ff_frame_pool_uninit((FFFramePool **)&job->outlink.frame_pool);
+}
+
+void ff_filter_frame_thread_free(AVFilterContext *ctx)
+{
+    FrameThreadContext *ft = ctx->internal->frame_thread;
+
+    if (!ft)
+        return;
+
+    pthread_mutex_lock(&ft->lock);
+    ft->exit = 1;
+    pthread_cond_broadcast(&ft->job_cond);
+    pthread_mutex_unlock(&ft->lock);
+
+    for (int i = 0; i < ft->nb_threads; i++)
+        pthread_join(ft->threads[i], NULL);
+    for (int i = 0; i < ft->nb_jobs; i++)
+        frame_thread_job_reset(&ft->jobs[i]);
+
+    pthread_mutex_destroy(&ft->lock);
+    pthread_mutex_destroy(&ft->buffer_lock);
+    pthread_cond_destroy(&ft->job_cond);
+    pthread_cond_destroy(&ft->done_cond);
+
+    av_freep(&ft->threads);
+    av_freep(&ft->jobs);
+    av_freep(&ctx->internal->frame_thread);
+}
+
+static int frame_thread_init(AVFilterContext *ctx)
+{
+    int nb_threads = ff_filter_get_nb_threads(ctx);
+    FrameThreadContext *ft;
+
+    ft = av_mallocz(sizeof(*ft));
+    if (!ft)
+        return AVERROR(ENOMEM);
+
+    ft->jobs    = av_calloc(nb_threads, sizeof(*ft->jobs));
+    ft->threads = av_calloc(nb_threads, sizeof(*ft->threads));
+    if (!ft->jobs || !ft->threads) {
+        av_freep(&ft->jobs);
+        av_freep(&ft->threads);
+        av_freep(&ft);
+        return AVERROR(ENOMEM);
+    }
+    ft->ctx     = ctx;
+    ft->nb_jobs = nb_threads;
+    for (int i = 0; i < nb_threads; i++)
+        ft->jobs[i].ft = ft;
+
+    pthread_mutex_init(&ft->lock, NULL);
+    pthread_mutex_init(&ft->buffer_lock, NULL);
+    pthread_cond_init(&ft->job_cond, NULL);
+    pthread_cond_init(&ft->done_cond, NULL);
+    ctx->internal->frame_thread = ft;
+
+    for (int i = 0; i < nb_threads; i++) {
+        int ret = pthread_create(&ft->threads[i], NULL, frame_worker, ft);
+        if (ret) {
+            av_log(ctx, AV_LOG_ERROR, "pthread_create() failed: %s\n",
+                   av_err2str(AVERROR(ret)));
+            ff_filter_frame_thread_free(ctx);
+            return AVERROR(ret);
+        }
+        ft->nb_threads++;
+    }
+
+    return 0;
+}
+
+static void frame_thread_setup_job(FFFrameThreadJob *job, AVFilterLink *link)
+{
+    AVFilterContext *ctx = link->dst;
+    AVFilterLink *outlink = ctx->outputs[0];
+
+    job->ctx                   = *ctx;
+    job->internal              = *ctx->internal;
+    job->internal.execute      = frame_thread_execute;
+    job->internal.frame_thread = NULL;
+    job->internal.frame_job    = job - job->ft->jobs + 1;
+    job->ctx.internal          = &job->internal;
+    job->ctx.inputs            = job->inputs;
+    job->ctx.outputs           = job->outputs;
+    job->ctx.command_queue     = NULL;
+
+    job->inlink                = *link;
+    job->inlink.dst            = &job->ctx;
+    job->inlink.frame_pool     = NULL;
+    job->inputs[0]             = &job->inlink;
+
+    /* Buffers for the output are allocated from the real output link. */
+    job->outpad                  = *outlink->dstpad;
+    job->outpad.get_video_buffer = frame_thread_get_video_buffer;
+    job->outpad.get_audio_buffer = frame_thread_get_audio_buffer;
+    job->outlink                  = *outlink;
+    job->outlink.src              = &job->ctx;
+    job->outlink.dstpad           = &job->outpad;
+    job->outlink.frame_pool       = NULL;
+    job->outlink.frame_thread_job = job;
+    job->outputs[0]               = &job->outlink;
+}
+
+int ff_filter_frame_thread_output(AVFilterContext *ctx, int wait)
+{
+    FrameThreadContext *ft = ctx->internal->frame_thread;
+    int forwarded = 0;
+
+    if (!ft)
+        return 0;
+
+    while (ft->nb_pending) {
+        FFFrameThreadJob *job = &ft->jobs[ft->first_job];
+        int ret, done;
+
+        /* Forward one frame at a time, once the downstream filter took the
+         * previous one, so that it sees the frames at the same pace as
+         * without frame threading. */
+        if (wait < 2 && (forwarded ||
+                         ff_framequeue_queued_frames(&ctx->outputs[0]->fifo)))
+            break;
+
+        pthread_mutex_lock(&ft->lock);
+        while (wait && !job->done)
+            pthread_cond_wait(&ft->done_cond, &ft->lock);
+        done = job->done;
+        pthread_mutex_unlock(&ft->lock);
+        if (!done)
+            break;
+
+        ret = job->ret;
+        for (int i = 0; i < job->nb_out && ret >= 0; i++) {
+            ret = ff_filter_frame(ctx->outputs[0], job->out[i]);
+            job->out[i] = NULL;
+        }
+        frame_thread_job_reset(job);
+        ft->first_job = (ft->first_job + 1) % ft->nb_jobs;
+        ft->nb_pending--;
+        forwarded = 1;
+
+        if (ret < 0)
+            return ret;
+    }
+
+    return forwarded;
+}
+
+int ff_filter_frame_thread_completed(AVFilterContext *ctx)
+{
+    FrameThreadContext *ft = ctx->internal->frame_thread;
+
+    return ft && atomic_exchange(&ft->completed, 0);
+}
+
+int ff_filter_frame_thread_busy(AVFilterContext *ctx)
+{
+    FrameThreadContext *ft = ctx->internal->frame_thread;
+
+    return ft && ft->nb_pending == ft->nb_jobs;
+}
+
+int ff_filter_frame_thread_submit(AVFilterLink *link, AVFrame *frame,
+                                  int (*filter_frame)(AVFilterLink *, AVFrame *))
+{
+    AVFilterContext *ctx = link->dst;
+    FrameThreadContext *ft = ctx->internal->frame_thread;
+    FFFrameThreadJob *job;
+    int ret;
+
+    if (!ft) {
+        ret = frame_thread_init(ctx);
+        if (ret < 0)
+            goto fail;
+        ft = ctx->internal->frame_thread;
+    }
+
+    if (ft->nb_pending == ft->nb_jobs) {
+        ret = ff_filter_frame_thread_output(ctx, 2);
+        if (ret < 0)
+            goto fail;
+    }
+
+    job = &ft->jobs[(ft->first_job + ft->nb_pending) % ft->nb_jobs];
+    frame_thread_setup_job(job, link);
+    job->filter_frame = filter_frame;
+    job->in           = frame;
+    ft->nb_pending++;
+
+    pthread_mutex_lock(&ft->lock);
+    job->done = 0;
+    ft->nb_queued++;
+    pthread_cond_signal(&ft->job_cond);
+    pthread_mutex_unlock(&ft->lock);
+
+    return 0;
+
+fail:
+    av_frame_free(&frame);
+    return ret;
+}
+
+int ff_filter_frame_thread_capture(AVFilterLink *link, AVFrame *frame)
+{
+    FFFrameThreadJob *job = link->frame_thread_job;
+    int ret = av_dynarray_add_nofree(&job->out, &job->nb_out, frame);
+
+    if (ret < 0)
+        av_frame_free(&frame);
+    return ret;
+}
@@ -25,4 +25,51 @@ int ff_graph_thread_init(AVFilterGraph *graph);
 
 void ff_graph_thread_free(AVFilterGraph *graph);
 
+/**
+ * Queue a frame for processing by a frame threaded filter. The frame is
+ * passed to filter_frame() in a worker thread, on private copies of the
+ * filter context and its links.
+ *
+ * If all the workers are busy, wait for the pending frames to be processed
+ * and forward their output first; ff_filter_frame_thread_busy() allows the
+ * caller to make room for the frame without flushing everything.
+ */
+int ff_filter_frame_thread_submit(AVFilterLink *link, AVFrame *frame,
+                                  int (*filter_frame)(AVFilterLink *, AVFrame *));
+
+/**
+ * Forward the output of the processed frames in submission order.
+ *
+ * Unless wait is 2, at most one frame is forwarded, and none while the
+ * previous one is still queued on the output link.
+ *
+ * @param wait 0 to forward the oldest frame if it is already processed,
+ *             1 to wait for the oldest frame and forward it,
+ *             2 to wait for all the pending frames and forward them
+ * @return 1 if some output was forwarded, 0 if not, or a negative error code
+ */
+int ff_filter_frame_thread_output(AVFilterContext *ctx, int wait);
+
+/**
+ * Called by the graph thread before picking the next filter to activate.
+ *
+ * @return 1 if a job was completed since the last call, so that the filter
+ *         has output to forward, 0 otherwise
+ */
+int ff_filter_frame_thread_completed(AVFilterContext *ctx);
+
+/**
+ * @return 1 if all the workers are busy and the next frame can only be
+ *         submitted after the oldest one is forwarded, 0 otherwise
+ */
+int ff_filter_frame_thread_busy(AVFilterContext *ctx);
+
+/**
+ * Called by ff_filter_frame() for the links private to a worker: store the
+ * frame to be forwarded later by ff_filter_frame_thread_output().
+ */
+int ff_filter_frame_thread_capture(AVFilterLink *link, AVFrame *frame);
+
+void ff_filter_frame_thread_free(AVFilterContext *ctx);
+
 #endif /* AVFILTER_THREAD_H */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2017 Vittorio Giovara <vittorio.giovara@gmail.com>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_TONEMAP_H
+#define AVFILTER_TONEMAP_H
+
+#include "libavutil/pixfmt.h"
+#include "avfilter.h"
+#include "colorspace.h"
+
+enum TonemapAlgorithm {
+    TONEMAP_NONE,
+    TONEMAP_LINEAR,
+    TONEMAP_GAMMA,
+    TONEMAP_CLIP,
+    TONEMAP_REINHARD,
+    TONEMAP_HABLE,
+    TONEMAP_MOBIUS,
+    TONEMAP_MAX,
+};
+
+/**
+ * Constants of the row functions. Every value is replicated 8 times so that
+ * SIMD versions can use them as memory operands; the layout is mirrored in
+ * x86/vf_tonemap.asm.
+ */
+typedef struct TonemapCoeffs {
+    float luma[3][8];   ///< r, g, b luma coefficients used for desaturation
+    float desat[8];     ///< desaturation strength, 0 to disable
+    float param[4][8];  ///< algorithm specific curve constants
+} TonemapCoeffs;
+
+typedef struct TonemapContext {
+    const AVClass *class;
+
+    enum TonemapAlgorithm tonemap;
+    double param;
+    double desat;
+    double peak;
+
+    const struct LumaCoefficients *coeffs;
+
+    /**
+     * Tone map one row of linear RGB pixels. src and dst hold the r, g and b
+     * rows, and may be equal. lut is the gain table of the curve, used by the
+     * algorithms which are not evaluated directly.
+     */
+    void (*tonemap_row)(float *const dst[3], const float *const src[3],
+                        const TonemapCoeffs *c, const float *lut, int width);
+    TonemapCoeffs row_coeffs;
+    float *curve_lut;
+    double lut_peak;
+
+    /* YUV input */
+    float *linearize_lut;   ///< PQ EOTF or HLG inverse OETF
+    float *ootf_lut;        ///< HLG OOTF scale factor, as a function of luma
+    float *delinearize_lut; ///< BT.1886 inverse EOTF
+    enum AVColorTransferCharacteristic lut_trc;
+    int linear_light;       ///< the input is not PQ or HLG and is taken as linear light
+    double ootf_peak;
+    float yuv2rgb[3][3];
+    float rgb2rgb[3][3];    ///< input primaries to BT.709
+    float rgb2yuv[3][3];
+    float luma_src[3];
+    float yuv_offset[2];    ///< luma, chroma
+    float yuv_scale[2];     ///< luma, chroma
+    float *buffer;          ///< 2 rows of r, g and b per job
+    int buffer_stride;
+} TonemapContext;
+
+void ff_tonemap_init(TonemapContext *s);
+void ff_tonemap_init_x86(TonemapContext *s);
+
+/**
+ * Fill row_coeffs and the curve gain table for the given signal peak.
+ */
+int ff_tonemap_set_peak(TonemapContext *s, double peak);
+
+#endif /* AVFILTER_TONEMAP_H */
@@ -51,6 +51,7 @@ typedef struct UnsharpContext {
     int bitdepth;
     int bps;
     int nb_threads;
+    int nb_slots;        ///< number of sets of sr and sc
     int opencl;
     int (* apply_unsharp)(AVFilterContext *ctx, AVFrame *in, AVFrame *out);
     int (* unsharp_slice)(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
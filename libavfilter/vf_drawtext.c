@@ -48,6 +48,7 @@
 #include "libavutil/common.h"
 #include "libavutil/file.h"
 #include "libavutil/eval.h"
+#include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/random_seed.h"
 #include "libavutil/parseutils.h"
@@ -134,6 +135,24 @@ enum var_name {
     VAR_VARS_NB
 };
 
+typedef struct TextMask {
+    uint8_t *data;                  ///< coverage of all the glyphs, with a linesize of w
+    unsigned int size;              ///< allocated size of data
+    int x, y;                       ///< position relative to the text origin
+    int w, h;
+} TextMask;
+
+typedef struct ThreadData {
+    AVFrame *frame;
+    int width;
+    int y0, y1;                     ///< rows covered by the box and the text
+    int box_w, box_h;
+    FFDrawColor fontcolor;
+    FFDrawColor shadowcolor;
+    FFDrawColor bordercolor;
+    FFDrawColor boxcolor;
+} ThreadData;
+
 enum expansion_mode {
     EXP_NONE,
     EXP_NORMAL,
@@ -203,6 +222,14 @@ typedef struct DrawTextContext {
     int text_shaping;               ///< 1 to shape the text before drawing it
 #endif
     AVDictionary *metadata;
+
+    AVBPrint layout_text;           ///< expanded text the cached layout was computed for
+    unsigned int layout_fontsize;   ///< font size the cached layout was computed for
+    int layout_valid;               ///< tells if the cached layout can be reused
+    int text_w, text_h;             ///< size of the laid out text
+    int ascent, descent;            ///< max glyph ascent and min glyph descent
+    TextMask text_mask;             ///< pre-rendered glyphs, used for text and shadow
+    TextMask border_mask;           ///< pre-rendered glyph borders
 } DrawTextContext;
 
 #define OFFSET(x) offsetof(DrawTextContext, x)
@@ -782,6 +809,7 @@ static av_cold int init(AVFilterContext *ctx)
 
     av_bprint_init(&s->expanded_text, 0, AV_BPRINT_SIZE_UNLIMITED);
     av_bprint_init(&s->expanded_fontcolor, 0, AV_BPRINT_SIZE_UNLIMITED);
+    av_bprint_init(&s->layout_text, 0, AV_BPRINT_SIZE_UNLIMITED);
 
     return 0;
 }
@@ -825,6 +853,11 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     av_bprint_finalize(&s->expanded_text, NULL);
     av_bprint_finalize(&s->expanded_fontcolor, NULL);
+    av_bprint_finalize(&s->layout_text, NULL);
+    av_freep(&s->text_mask.data);
+    av_freep(&s->border_mask.data);
+    s->text_mask.size = s->border_mask.size = 0;
+    s->layout_valid = 0;
 }
 
 static int config_input(AVFilterLink *inlink)
@@ -1215,14 +1248,15 @@ static int expand_text(AVFilterContext *ctx, char *text, AVBPrint *bp)
     return 0;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       int width, int height,
-                       FFDrawColor *color,
-                       int x, int y, int borderw)
+/**
+ * Render the coverage of all the glyphs of the expanded text, or of their
+ * borders, into a single mask.
+ */
+static int render_mask(DrawTextContext *s, TextMask *mask, int borderw)
 {
     char *text = s->expanded_text.str;
     uint32_t code = 0;
-    int i, x1, y1;
+    int i, x, y, x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
     uint8_t *p;
     Glyph *glyph = NULL;
 
@@ -1245,21 +1279,72 @@ continue_on_invalid:
         if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
             glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
             return AVERROR(EINVAL);
+        if (!bitmap.width || !bitmap.rows)
+            continue;
 
-        x1 = s->positions[i].x+s->x+x - borderw;
-        y1 = s->positions[i].y+s->y+y - borderw;
+        x0 = FFMIN(x0, s->positions[i].x - borderw);
+        y0 = FFMIN(y0, s->positions[i].y - borderw);
+        x1 = FFMAX(x1, s->positions[i].x - borderw + (int)bitmap.width);
+        y1 = FFMAX(y1, s->positions[i].y - borderw + (int)bitmap.rows);
+    }
+
+    mask->w = mask->h = 0;
+    if (x0 >= x1 || y0 >= y1)
+        return 0;
+    if (av_image_check_size(x1 - x0, y1 - y0, 0, NULL) < 0)
+        return AVERROR(EINVAL);
 
-        ff_blend_mask(&s->dc, color,
-                      frame->data, frame->linesize, width, height,
-                      bitmap.buffer, bitmap.pitch,
-                      bitmap.width, bitmap.rows,
-                      bitmap.pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
-                      0, x1, y1);
+    av_fast_malloc(&mask->data, &mask->size, (x1 - x0) * (y1 - y0));
+    if (!mask->data)
+        return AVERROR(ENOMEM);
+    mask->x = x0;
+    mask->y = y0;
+    mask->w = x1 - x0;
+    mask->h = y1 - y0;
+    memset(mask->data, 0, mask->w * mask->h);
+
+    for (i = 0, p = text; *p; i++) {
+        FT_Bitmap bitmap;
+        Glyph dummy = { 0 };
+        GET_UTF8(code, *p ? *p++ : 0, code = 0xfffd; goto continue_on_invalid2;);
+continue_on_invalid2:
+
+        if (code == '\n' || code == '\r' || code == '\t')
+            continue;
+
+        dummy.code = code;
+        dummy.fontsize = s->fontsize;
+        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+
+        bitmap = borderw ? glyph->border_bitmap : glyph->bitmap;
+
+        for (y = 0; y < bitmap.rows; y++) {
+            const uint8_t *src = bitmap.buffer + y * bitmap.pitch;
+            uint8_t *dst = mask->data + (s->positions[i].y - borderw - y0 + y) * mask->w +
+                           s->positions[i].x - borderw - x0;
+
+            /* overlapping glyphs are combined as if blended one after the other */
+            for (x = 0; x < bitmap.width; x++) {
+                int v = bitmap.pixel_mode == FT_PIXEL_MODE_MONO ?
+                        (src[x >> 3] >> (7 - (x & 7)) & 1) * 255 : src[x];
+                dst[x] = 255 - (255 - dst[x]) * (255 - v) / 255;
+            }
+        }
     }
 
     return 0;
 }
 
+static void blend_text_mask(DrawTextContext *s, const TextMask *mask, FFDrawColor *color,
+                            uint8_t *dst[], int dst_linesize[], int width, int height,
+                            int x, int y)
+{
+    if (!mask->w || !mask->h)
+        return;
+    ff_blend_mask(&s->dc, color, dst, dst_linesize, width, height,
+                  mask->data, mask->w, mask->w, mask->h, 3, 0,
+                  s->x + mask->x + x, s->y + mask->y + y);
+}
 
 static void update_color_with_alpha(DrawTextContext *s, FFDrawColor *color, const FFDrawColor incolor)
 {
@@ -1283,17 +1368,17 @@ static void update_alpha(DrawTextContext *s)
         s->alpha = 256 * alpha;
 }
 
-static int draw_text(AVFilterContext *ctx, AVFrame *frame,
-                     int width, int height)
+/**
+ * Load the glyphs of the expanded text, compute their positions and render
+ * them into the text masks.
+ */
+static int layout_text(AVFilterContext *ctx)
 {
     DrawTextContext *s = ctx->priv;
-    AVFilterLink *inlink = ctx->inputs[0];
-
     uint32_t code = 0, prev_code = 0;
     int x = 0, y = 0, i = 0, ret;
-    int max_text_line_w = 0, len;
-    int box_w, box_h;
-    char *text;
+    int max_text_line_w = 0;
+    char *text = s->expanded_text.str;
     uint8_t *p;
     int y_min = 32000, y_max = -32000;
     int x_min = 32000, x_max = -32000;
@@ -1301,71 +1386,6 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     Glyph *glyph = NULL, *prev_glyph = NULL;
     Glyph dummy = { 0 };
 
-    time_t now = time(0);
-    struct tm ltime;
-    AVBPrint *bp = &s->expanded_text;
-
-    FFDrawColor fontcolor;
-    FFDrawColor shadowcolor;
-    FFDrawColor bordercolor;
-    FFDrawColor boxcolor;
-
-    av_bprint_clear(bp);
-
-    if(s->basetime != AV_NOPTS_VALUE)
-        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
-
-    switch (s->exp_mode) {
-    case EXP_NONE:
-        av_bprintf(bp, "%s", s->text);
-        break;
-    case EXP_NORMAL:
-        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
-            return ret;
-        break;
-    case EXP_STRFTIME:
-        localtime_r(&now, &ltime);
-        av_bprint_strftime(bp, s->text, &ltime);
-        break;
-    }
-
-    if (s->tc_opt_string) {
-        char tcbuf[AV_TIMECODE_STR_SIZE];
-        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
-        av_bprint_clear(bp);
-        av_bprintf(bp, "%s%s", s->text, tcbuf);
-    }
-
-    if (!av_bprint_is_complete(bp))
-        return AVERROR(ENOMEM);
-    text = s->expanded_text.str;
-    if ((len = s->expanded_text.len) > s->nb_positions) {
-        if (!(s->positions =
-              av_realloc(s->positions, len*sizeof(*s->positions))))
-            return AVERROR(ENOMEM);
-        s->nb_positions = len;
-    }
-
-    if (s->fontcolor_expr[0]) {
-        /* If expression is set, evaluate and replace the static value */
-        av_bprint_clear(&s->expanded_fontcolor);
-        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
-            return ret;
-        if (!av_bprint_is_complete(&s->expanded_fontcolor))
-            return AVERROR(ENOMEM);
-        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
-        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
-        if (ret)
-            return ret;
-        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
-    }
-
-    x = 0;
-    y = 0;
-
-    if ((ret = update_fontsize(ctx)) < 0)
-        return ret;
-
     /* load and cache glyphs */
     for (i = 0, p = text; *p; i++) {
         GET_UTF8(code, *p ? *p++ : 0, code = 0xfffd; goto continue_on_invalid;);
@@ -1430,13 +1450,148 @@ continue_on_invalid2:
 
     max_text_line_w = FFMAX(x, max_text_line_w);
 
-    s->var_values[VAR_TW] = s->var_values[VAR_TEXT_W] = max_text_line_w;
-    s->var_values[VAR_TH] = s->var_values[VAR_TEXT_H] = y + s->max_glyph_h;
+    s->text_w  = max_text_line_w;
+    s->text_h  = y + s->max_glyph_h;
+    s->ascent  = y_max;
+    s->descent = y_min;
+
+    if ((ret = render_mask(s, &s->text_mask, 0)) < 0)
+        return ret;
+    if (s->borderw && (ret = render_mask(s, &s->border_mask, s->borderw)) < 0)
+        return ret;
+
+    return 0;
+}
+
+static int draw_text_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    const int align = 1 << s->dc.vsub_max;
+    const int nb_rows = (td->y1 - td->y0 + align - 1) / align;
+    const int slice_start = td->y0 + (nb_rows *  jobnr   ) / nb_jobs * align;
+    const int slice_end   = FFMIN(td->y0 + (nb_rows * (jobnr+1)) / nb_jobs * align, td->y1);
+    const int h = slice_end - slice_start;
+    uint8_t *data[MAX_PLANES] = { NULL };
+    int plane;
+
+    if (h <= 0)
+        return 0;
+
+    for (plane = 0; plane < s->dc.nb_planes; plane++)
+        data[plane] = frame->data[plane] + (slice_start >> s->dc.vsub[plane]) * frame->linesize[plane];
+
+    if (s->draw_box)
+        ff_blend_rectangle(&s->dc, &td->boxcolor,
+                           data, frame->linesize, td->width, h,
+                           s->x - s->boxborderw, s->y - s->boxborderw - slice_start,
+                           td->box_w + s->boxborderw * 2, td->box_h + s->boxborderw * 2);
+
+    if (s->shadowx || s->shadowy)
+        blend_text_mask(s, &s->text_mask, &td->shadowcolor, data, frame->linesize,
+                        td->width, h, s->shadowx, s->shadowy - slice_start);
+
+    if (s->borderw)
+        blend_text_mask(s, &s->border_mask, &td->bordercolor, data, frame->linesize,
+                        td->width, h, 0, -slice_start);
+
+    blend_text_mask(s, &s->text_mask, &td->fontcolor, data, frame->linesize,
+                    td->width, h, 0, -slice_start);
+
+    return 0;
+}
+
+static int draw_text(AVFilterContext *ctx, AVFrame *frame,
+                     int width, int height)
+{
+    DrawTextContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+
+    int ret, len, align, nb_jobs;
+    int box_w, box_h;
+    char *text;
+
+    time_t now = time(0);
+    struct tm ltime;
+    AVBPrint *bp = &s->expanded_text;
+    ThreadData td;
+
+    av_bprint_clear(bp);
+
+    if(s->basetime != AV_NOPTS_VALUE)
+        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
+
+    switch (s->exp_mode) {
+    case EXP_NONE:
+        av_bprintf(bp, "%s", s->text);
+        break;
+    case EXP_NORMAL:
+        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
+            return ret;
+        break;
+    case EXP_STRFTIME:
+        localtime_r(&now, &ltime);
+        av_bprint_strftime(bp, s->text, &ltime);
+        break;
+    }
+
+    if (s->tc_opt_string) {
+        char tcbuf[AV_TIMECODE_STR_SIZE];
+        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
+        av_bprint_clear(bp);
+        av_bprintf(bp, "%s%s", s->text, tcbuf);
+    }
+
+    if (!av_bprint_is_complete(bp))
+        return AVERROR(ENOMEM);
+    text = s->expanded_text.str;
+    if ((len = s->expanded_text.len) > s->nb_positions) {
+        if (!(s->positions =
+              av_realloc(s->positions, len*sizeof(*s->positions))))
+            return AVERROR(ENOMEM);
+        s->nb_positions = len;
+    }
+
+    if (s->fontcolor_expr[0]) {
+        /* If expression is set, evaluate and replace the static value */
+        av_bprint_clear(&s->expanded_fontcolor);
+        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
+            return ret;
+        if (!av_bprint_is_complete(&s->expanded_fontcolor))
+            return AVERROR(ENOMEM);
+        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
+        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
+        if (ret)
+            return ret;
+        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
+    }
+
+    if ((ret = update_fontsize(ctx)) < 0)
+        return ret;
+
+    /* only lay out and render the text again if it has changed */
+    if (!s->layout_valid || s->layout_fontsize != s->fontsize ||
+        s->layout_text.len != s->expanded_text.len ||
+        memcmp(s->layout_text.str, text, s->expanded_text.len)) {
+        s->layout_valid = 0;
+        if ((ret = layout_text(ctx)) < 0)
+            return ret;
+        av_bprint_clear(&s->layout_text);
+        av_bprint_append_data(&s->layout_text, text, s->expanded_text.len);
+        if (!av_bprint_is_complete(&s->layout_text))
+            return AVERROR(ENOMEM);
+        s->layout_fontsize = s->fontsize;
+        s->layout_valid = 1;
+    }
+
+    s->var_values[VAR_TW] = s->var_values[VAR_TEXT_W] = s->text_w;
+    s->var_values[VAR_TH] = s->var_values[VAR_TEXT_H] = s->text_h;
 
     s->var_values[VAR_MAX_GLYPH_W] = s->max_glyph_w;
     s->var_values[VAR_MAX_GLYPH_H] = s->max_glyph_h;
-    s->var_values[VAR_MAX_GLYPH_A] = s->var_values[VAR_ASCENT ] = y_max;
-    s->var_values[VAR_MAX_GLYPH_D] = s->var_values[VAR_DESCENT] = y_min;
+    s->var_values[VAR_MAX_GLYPH_A] = s->var_values[VAR_ASCENT ] = s->ascent;
+    s->var_values[VAR_MAX_GLYPH_D] = s->var_values[VAR_DESCENT] = s->descent;
 
     s->var_values[VAR_LINE_H] = s->var_values[VAR_LH] = s->max_glyph_h;
 
@@ -1446,13 +1601,13 @@ continue_on_invalid2:
     s->x = s->var_values[VAR_X] = av_expr_eval(s->x_pexpr, s->var_values, &s->prng);
 
     update_alpha(s);
-    update_color_with_alpha(s, &fontcolor  , s->fontcolor  );
-    update_color_with_alpha(s, &shadowcolor, s->shadowcolor);
-    update_color_with_alpha(s, &bordercolor, s->bordercolor);
-    update_color_with_alpha(s, &boxcolor   , s->boxcolor   );
+    update_color_with_alpha(s, &td.fontcolor  , s->fontcolor  );
+    update_color_with_alpha(s, &td.shadowcolor, s->shadowcolor);
+    update_color_with_alpha(s, &td.bordercolor, s->bordercolor);
+    update_color_with_alpha(s, &td.boxcolor   , s->boxcolor   );
 
-    box_w = max_text_line_w;
-    box_h = y + s->max_glyph_h;
+    box_w = s->text_w;
+    box_h = s->text_h;
 
     if (s->fix_bounds) {
 
@@ -1480,27 +1635,39 @@ continue_on_invalid2:
             s->y = FFMAX(height - box_h - offsetbottom, 0);
     }
 
-    /* draw box */
-    if (s->draw_box)
-        ff_blend_rectangle(&s->dc, &boxcolor,
-                           frame->data, frame->linesize, width, height,
-                           s->x - s->boxborderw, s->y - s->boxborderw,
-                           box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
-
-    if (s->shadowx || s->shadowy) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &shadowcolor, s->shadowx, s->shadowy, 0)) < 0)
-            return ret;
+    /* find the rows touched by the box, the shadow, the border and the text */
+    td.y0 = INT_MAX;
+    td.y1 = INT_MIN;
+    if (s->draw_box) {
+        td.y0 = FFMIN(td.y0, s->y - s->boxborderw);
+        td.y1 = FFMAX(td.y1, s->y + box_h + s->boxborderw);
     }
-
-    if (s->borderw) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &bordercolor, 0, 0, s->borderw)) < 0)
-            return ret;
+    if (s->text_mask.h) {
+        td.y0 = FFMIN(td.y0, s->y + s->text_mask.y);
+        td.y1 = FFMAX(td.y1, s->y + s->text_mask.y + s->text_mask.h);
+        if (s->shadowx || s->shadowy) {
+            td.y0 = FFMIN(td.y0, s->y + s->text_mask.y + s->shadowy);
+            td.y1 = FFMAX(td.y1, s->y + s->text_mask.y + s->text_mask.h + s->shadowy);
+        }
     }
-    if ((ret = draw_glyphs(s, frame, width, height,
-                           &fontcolor, 0, 0, 0)) < 0)
-        return ret;
+    if (s->borderw && s->border_mask.h) {
+        td.y0 = FFMIN(td.y0, s->y + s->border_mask.y);
+        td.y1 = FFMAX(td.y1, s->y + s->border_mask.y + s->border_mask.h);
+    }
+
+    /* slices must not split subsampled chroma rows */
+    align = 1 << s->dc.vsub_max;
+    td.y0 = FFMAX(td.y0, 0) & ~(align - 1);
+    td.y1 = FFMIN(td.y1, height);
+    if (td.y0 >= td.y1)
+        return 0;
+
+    td.frame  = frame;
+    td.width  = width;
+    td.box_w  = box_w;
+    td.box_h  = box_h;
+    nb_jobs = FFMIN((td.y1 - td.y0 + align - 1) / align, ff_filter_get_nb_threads(ctx));
+    ctx->internal->execute(ctx, draw_text_slice, &td, NULL, nb_jobs);
 
     return 0;
 }
@@ -1576,5 +1743,5 @@ AVFilter ff_vf_drawtext = {
     .inputs        = avfilter_vf_drawtext_inputs,
     .outputs       = avfilter_vf_drawtext_outputs,
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
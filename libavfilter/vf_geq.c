@@ -35,6 +35,7 @@
 
 #define MAX_NB_THREADS 32
 #define NB_PLANES 4
+#define GEQ_BLOCK_SIZE 256
 
 enum InterpolationMethods {
     INTERP_NEAREST,
@@ -377,7 +378,9 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     const int linesize = td->linesize;
     const int slice_start = (height *  jobnr) / nb_jobs;
     const int slice_end = (height * (jobnr+1)) / nb_jobs;
-    int x, y;
+    const double *const_arrays[VAR_VARS_NB] = { NULL };
+    double xs[GEQ_BLOCK_SIZE], res[GEQ_BLOCK_SIZE];
+    int x, y, i, ret;
 
     double values[VAR_VARS_NB];
     values[VAR_W] = geq->values[VAR_W];
@@ -386,27 +389,29 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     values[VAR_SW] = geq->values[VAR_SW];
     values[VAR_SH] = geq->values[VAR_SH];
     values[VAR_T] = geq->values[VAR_T];
+    const_arrays[VAR_X] = xs;
 
-    if (geq->bps == 8) {
-        uint8_t *ptr = geq->dst + linesize * slice_start;
-        for (y = slice_start; y < slice_end; y++) {
-            values[VAR_Y] = y;
+    for (y = slice_start; y < slice_end; y++) {
+        uint8_t  *ptr   = geq->dst   + linesize * y;
+        uint16_t *ptr16 = geq->dst16 + (linesize/2) * y;
+        values[VAR_Y] = y;
 
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
-            }
-            ptr += linesize;
-        }
-    } else {
-        uint16_t *ptr16 = geq->dst16 + (linesize/2) * slice_start;
-        for (y = slice_start; y < slice_end; y++) {
-            values[VAR_Y] = y;
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr16[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
+        for (x = 0; x < width; x += GEQ_BLOCK_SIZE) {
+            const int n = FFMIN(width - x, GEQ_BLOCK_SIZE);
+
+            for (i = 0; i < n; i++)
+                xs[i] = x + i;
+            ret = av_expr_eval_array(geq->e[plane][jobnr], res, n, values, const_arrays, geq);
+            if (ret < 0)
+                return ret;
+
+            if (geq->bps == 8) {
+                for (i = 0; i < n; i++)
+                    ptr[x + i] = res[i];
+            } else {
+                for (i = 0; i < n; i++)
+                    ptr16[x + i] = res[i];
             }
-            ptr16 += linesize/2;
         }
     }
 
@@ -437,6 +442,8 @@ static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
         const int width = (plane == 1 || plane == 2) ? AV_CEIL_RSHIFT(inlink->w, geq->hsub) : inlink->w;
         const int height = (plane == 1 || plane == 2) ? AV_CEIL_RSHIFT(inlink->h, geq->vsub) : inlink->h;
         const int linesize = out->linesize[plane];
+        const int nb_jobs = FFMIN(height, nb_threads);
+        int ret[MAX_NB_THREADS];
         ThreadData td;
 
         geq->dst = out->data[plane];
@@ -455,7 +462,15 @@ static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
         if (geq->needs_sum[plane])
             calculate_sums(geq, plane, width, height);
 
-        ctx->internal->execute(ctx, slice_geq_filter, &td, NULL, FFMIN(height, nb_threads));
+        ctx->internal->execute(ctx, slice_geq_filter, &td, ret, nb_jobs);
+        for (int i = 0; i < nb_jobs; i++) {
+            if (ret[i] < 0) {
+                int err = ret[i];
+                av_frame_free(&geq->picref);
+                av_frame_free(&out);
+                return err;
+            }
+        }
     }
 
     av_frame_free(&geq->picref);
@@ -604,7 +604,8 @@ static const AVFilterPad outputs[] = {
         .inputs        = inputs,                                        \
         .outputs       = outputs,                                       \
         .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |       \
-                         AVFILTER_FLAG_SLICE_THREADS,                   \
+                         AVFILTER_FLAG_SLICE_THREADS |                  \
+                         AVFILTER_FLAG_FRAME_THREADS,                   \
         .process_command = process_command,                             \
     }
 
@@ -33,11 +33,13 @@
 #include "libavutil/avassert.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/avstring.h"
+#include "libavutil/imgutils.h"
 #include "avfilter.h"
 #include "drawutils.h"
 #include "formats.h"
 #include "framesync.h"
 #include "internal.h"
+#include "lut3d.h"
 #include "video.h"
 
 #define R 0
@@ -45,55 +47,6 @@
 #define B 2
 #define A 3
 
-enum interp_mode {
-    INTERPOLATE_NEAREST,
-    INTERPOLATE_TRILINEAR,
-    INTERPOLATE_TETRAHEDRAL,
-    INTERPOLATE_PYRAMID,
-    INTERPOLATE_PRISM,
-    NB_INTERP_MODE
-};
-
-struct rgbvec {
-    float r, g, b;
-};
-
-/* 3D LUT don't often go up to level 32, but it is common to have a Hald CLUT
- * of 512x512 (64x64x64) */
-#define MAX_LEVEL 256
-#define PRELUT_SIZE 65536
-
-typedef struct Lut3DPreLut {
-    int size;
-    float min[3];
-    float max[3];
-    float scale[3];
-    float* lut[3];
-} Lut3DPreLut;
-
-typedef struct LUT3DContext {
-    const AVClass *class;
-    int interpolation;          ///<interp_mode
-    char *file;
-    uint8_t rgba_map[4];
-    int step;
-    avfilter_action_func *interp;
-    struct rgbvec scale;
-    struct rgbvec *lut;
-    int lutsize;
-    int lutsize2;
-    Lut3DPreLut prelut;
-#if CONFIG_HALDCLUT_FILTER
-    uint8_t clut_rgba_map[4];
-    int clut_step;
-    int clut_bits;
-    int clut_planar;
-    int clut_float;
-    int clut_width;
-    FFFrameSync fs;
-#endif
-} LUT3DContext;
-
 typedef struct ThreadData {
     AVFrame *in, *out;
 } ThreadData;
@@ -598,6 +551,207 @@ DEFINE_INTERP_FUNC(tetrahedral, 16)
 DEFINE_INTERP_FUNC(pyramid,     16)
 DEFINE_INTERP_FUNC(prism,       16)
 
+#define DEFINE_INTERP_ROW(name, nbits)                                                              \
+static void interp_row_##name##_##nbits(uint8_t *const dst[3], const uint8_t *const src[3],     \
+                                        const struct rgbvec *lut, const float *const *shaper,   \
+                                        const LUT3DRowCoeffs *c, int width)                     \
+{                                                                                               \
+    int x;                                                                                      \
+    LUT3DContext lut3d;                                                                         \
+    uint##nbits##_t *dstg = (uint##nbits##_t *)dst[0];                                          \
+    uint##nbits##_t *dstb = (uint##nbits##_t *)dst[1];                                          \
+    uint##nbits##_t *dstr = (uint##nbits##_t *)dst[2];                                          \
+    const uint##nbits##_t *srcg = (const uint##nbits##_t *)src[0];                              \
+    const uint##nbits##_t *srcb = (const uint##nbits##_t *)src[1];                              \
+    const uint##nbits##_t *srcr = (const uint##nbits##_t *)src[2];                              \
+    const float lut_max = c->lut_max[0];                                                        \
+    const float scale_f = c->in_scale[0];                                                       \
+    const float scale_r = c->scale[0][0];                                                       \
+    const float scale_g = c->scale[1][0];                                                       \
+    const float scale_b = c->scale[2][0];                                                       \
+    const float out_scale = c->out_scale[0];                                                    \
+    const int out_max = c->out_max[0];                                                          \
+                                                                                                \
+    lut3d.lut      = (struct rgbvec *)lut;                                                      \
+    lut3d.lutsize  = c->lutsize[0];                                                             \
+    lut3d.lutsize2 = c->lutsize2[0];                                                            \
+                                                                                                \
+    for (x = 0; x < width; x++) {                                                               \
+        struct rgbvec scaled_rgb, vec;                                                          \
+        if (shaper) {                                                                           \
+            scaled_rgb.r = shaper[0][srcr[x]];                                                  \
+            scaled_rgb.g = shaper[1][srcg[x]];                                                  \
+            scaled_rgb.b = shaper[2][srcb[x]];                                                  \
+        } else {                                                                                \
+            const struct rgbvec rgb = {srcr[x] * scale_f,                                       \
+                                       srcg[x] * scale_f,                                       \
+                                       srcb[x] * scale_f};                                      \
+            scaled_rgb.r = av_clipf(rgb.r * scale_r, 0, lut_max);                               \
+            scaled_rgb.g = av_clipf(rgb.g * scale_g, 0, lut_max);                               \
+            scaled_rgb.b = av_clipf(rgb.b * scale_b, 0, lut_max);                               \
+        }                                                                                       \
+        vec = interp_##name(&lut3d, &scaled_rgb);                                               \
+        dstr[x] = av_clip((int)(vec.r * out_scale), 0, out_max);                                \
+        dstg[x] = av_clip((int)(vec.g * out_scale), 0, out_max);                                \
+        dstb[x] = av_clip((int)(vec.b * out_scale), 0, out_max);                                \
+    }                                                                                           \
+}
+
+DEFINE_INTERP_ROW(trilinear,   8)
+DEFINE_INTERP_ROW(tetrahedral, 8)
+DEFINE_INTERP_ROW(trilinear,   16)
+DEFINE_INTERP_ROW(tetrahedral, 16)
+
+#define DEFINE_INTERP_ROW_FLOAT(name)                                                           \
+static void interp_row_##name##_f32(uint8_t *const dst[3], const uint8_t *const src[3],         \
+                                    const struct rgbvec *lut, const float *const *shaper,       \
+                                    const LUT3DRowCoeffs *c, int width)                         \
+{                                                                                               \
+    int x;                                                                                      \
+    LUT3DContext lut3d;                                                                         \
+    float *dstg = (float *)dst[0];                                                              \
+    float *dstb = (float *)dst[1];                                                              \
+    float *dstr = (float *)dst[2];                                                              \
+    const float *srcg = (const float *)src[0];                                                  \
+    const float *srcb = (const float *)src[1];                                                  \
+    const float *srcr = (const float *)src[2];                                                  \
+    const float lut_max = c->lut_max[0];                                                        \
+    const float scale_r = c->scale[0][0];                                                       \
+    const float scale_g = c->scale[1][0];                                                       \
+    const float scale_b = c->scale[2][0];                                                       \
+                                                                                                \
+    lut3d.lut      = (struct rgbvec *)lut;                                                      \
+    lut3d.lutsize  = c->lutsize[0];                                                             \
+    lut3d.lutsize2 = c->lutsize2[0];                                                            \
+                                                                                                \
+    for (x = 0; x < width; x++) {                                                               \
+        const struct rgbvec rgb = {sanitizef(srcr[x]),                                          \
+                                   sanitizef(srcg[x]),                                          \
+                                   sanitizef(srcb[x])};                                         \
+        const struct rgbvec scaled_rgb = {av_clipf(rgb.r * scale_r, 0, lut_max),                \
+                                          av_clipf(rgb.g * scale_g, 0, lut_max),                \
+                                          av_clipf(rgb.b * scale_b, 0, lut_max)};               \
+        struct rgbvec vec = interp_##name(&lut3d, &scaled_rgb);                                 \
+        dstr[x] = vec.r;                                                                        \
+        dstg[x] = vec.g;                                                                        \
+        dstb[x] = vec.b;                                                                        \
+    }                                                                                           \
+}
+
+DEFINE_INTERP_ROW_FLOAT(trilinear)
+DEFINE_INTERP_ROW_FLOAT(tetrahedral)
+
+static int interp_planar_rows(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    int y, i;
+    const LUT3DContext *lut3d = ctx->priv;
+    const ThreadData *td = arg;
+    const AVFrame *in  = td->in;
+    const AVFrame *out = td->out;
+    const int direct = out == in;
+    const int slice_start = (in->height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (in->height * (jobnr+1)) / nb_jobs;
+    const float *const *shaper = lut3d->shaper[0] ? (const float *const *)lut3d->shaper : NULL;
+    const uint8_t *src[3];
+    uint8_t *dst[3];
+
+    for (i = 0; i < 3; i++) {
+        src[i] = in ->data[i] + slice_start * in ->linesize[i];
+        dst[i] = out->data[i] + slice_start * out->linesize[i];
+    }
+
+    for (y = slice_start; y < slice_end; y++) {
+        lut3d->interp_row(dst, src, lut3d->lut, shaper, &lut3d->row_coeffs, in->width);
+        for (i = 0; i < 3; i++) {
+            src[i] += in ->linesize[i];
+            dst[i] += out->linesize[i];
+        }
+    }
+
+    if (!direct && in->linesize[3]) {
+        const int bytes = av_pix_fmt_desc_get(in->format)->comp[3].step;
+        av_image_copy_plane(out->data[3] + slice_start * out->linesize[3], out->linesize[3],
+                            in ->data[3] + slice_start * in ->linesize[3], in ->linesize[3],
+                            in->width * bytes, slice_end - slice_start);
+    }
+    return 0;
+}
+
+static void set_row_coeffs(LUT3DContext *lut3d)
+{
+    LUT3DRowCoeffs *c = &lut3d->row_coeffs;
+    const float lut_max = lut3d->lutsize - 1;
+    const int max = lut3d->depth <= 16 ? (1 << lut3d->depth) - 1 : 1;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        c->scale[0][i]  = lut3d->scale.r * lut_max;
+        c->scale[1][i]  = lut3d->scale.g * lut_max;
+        c->scale[2][i]  = lut3d->scale.b * lut_max;
+        c->lut_max[i]   = lut_max;
+        c->in_scale[i]  = 1.0f / max;
+        c->out_scale[i] = max;
+        c->lutsize[i]   = lut3d->lutsize;
+        c->lutsize2[i]  = lut3d->lutsize2;
+        c->lut_last[i]  = lut3d->lutsize - 1;
+        c->out_max[i]   = max;
+    }
+}
+
+/**
+ * Bake the 1D pre-LUT and the input scaling into one table per component,
+ * indexed by the integer input sample.
+ */
+static int build_shaper(LUT3DContext *lut3d, int nbits)
+{
+    const Lut3DPreLut *prelut = &lut3d->prelut;
+    const int size = 1 << nbits;
+    const float lut_max = lut3d->lutsize - 1;
+    const float scale_f = 1.0f / ((1 << lut3d->depth) - 1);
+    const float scale[3] = { lut3d->scale.r * lut_max,
+                             lut3d->scale.g * lut_max,
+                             lut3d->scale.b * lut_max };
+    int i, j;
+
+    for (i = 0; i < 3; i++) {
+        float *shaper = av_realloc_array(lut3d->shaper[i], size, sizeof(*shaper));
+        if (!shaper)
+            return AVERROR(ENOMEM);
+        lut3d->shaper[i] = shaper;
+        for (j = 0; j < size; j++)
+            shaper[j] = av_clipf(prelut_interp_1d_linear(prelut, i, j * scale_f) * scale[i],
+                                 0, lut_max);
+    }
+    return 0;
+}
+
+void ff_lut3d_init(LUT3DContext *s, const AVPixFmtDescriptor *desc)
+{
+    const int planar  = desc->flags & AV_PIX_FMT_FLAG_PLANAR;
+    const int isfloat = desc->flags & AV_PIX_FMT_FLAG_FLOAT;
+    const int depth   = desc->comp[0].depth;
+
+    s->interp_row = NULL;
+    if (!planar || (isfloat && s->prelut.size > 0))
+        return;
+
+    switch (s->interpolation) {
+    case INTERPOLATE_TRILINEAR:
+        s->interp_row = isfloat ? interp_row_trilinear_f32 :
+                        depth > 8 ? interp_row_trilinear_16 : interp_row_trilinear_8;
+        break;
+    case INTERPOLATE_TETRAHEDRAL:
+        s->interp_row = isfloat ? interp_row_tetrahedral_f32 :
+                        depth > 8 ? interp_row_tetrahedral_16 : interp_row_tetrahedral_8;
+        break;
+    default:
+        return;
+    }
+
+    if (ARCH_X86)
+        ff_lut3d_init_x86(s, desc);
+}
+
 #define MAX_LINE_SIZE 512
 
 static int skip_line(const char *p)
@@ -1210,6 +1364,14 @@ static int config_input(AVFilterLink *inlink)
         av_assert0(0);
     }
 
+    lut3d->depth = depth;
+    ff_lut3d_init(lut3d, desc);
+    if (lut3d->interp_row) {
+        lut3d->interp = interp_planar_rows;
+        if (!isfloat && lut3d->prelut.size > 0)
+            return build_shaper(lut3d, is16bit ? 16 : 8);
+    }
+
     return 0;
 }
 
@@ -1234,6 +1396,8 @@ static AVFrame *apply_lut(AVFilterLink *inlink, AVFrame *in)
 
     td.in  = in;
     td.out = out;
+    if (lut3d->interp_row)
+        set_row_coeffs(lut3d);
     ctx->internal->execute(ctx, lut3d->interp, &td, NULL, FFMIN(outlink->h, ff_filter_get_nb_threads(ctx)));
 
     if (out != in)
@@ -1332,6 +1496,7 @@ static av_cold void lut3d_uninit(AVFilterContext *ctx)
 
     for (i = 0; i < 3; i++) {
         av_freep(&lut3d->prelut.lut[i]);
+        av_freep(&lut3d->shaper[i]);
     }
 }
 
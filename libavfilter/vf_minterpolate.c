@@ -26,6 +26,7 @@
 #include "libavutil/motion_vector.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/thread.h"
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
@@ -163,9 +164,17 @@ typedef struct Frame {
     Block *blocks;
 } Frame;
 
+typedef struct ThreadData {
+    Block *blocks;
+    int dir;
+    int alpha;
+    AVFrame *out;
+} ThreadData;
+
 typedef struct MIContext {
     const AVClass *class;
     AVMotionEstContext me_ctx;
+    AVMotionEstContext *me_ctxs;    ///< per job copies of me_ctx
     AVRational frame_rate;
     enum MIMode mi_mode;
     int mc_mode;
@@ -196,6 +205,13 @@ typedef struct MIContext {
     int log2_chroma_w;
     int log2_chroma_h;
     int nb_planes;
+
+    int nb_threads;
+    int *mb_progress;               ///< searched blocks of each row
+#if HAVE_THREADS
+    pthread_mutex_t *progress_mutex;
+    pthread_cond_t *progress_cond;
+#endif
 } MIContext;
 
 #define OFFSET(x) offsetof(MIContext, x)
@@ -263,20 +279,16 @@ static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int
     int linesize = me_ctx->linesize;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, me_ctx->x_min, me_ctx->x_max);
     y = av_clip(y, me_ctx->y_min, me_ctx->y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - me_ctx->x_min, me_ctx->x_max - x), FFMIN(x - me_ctx->x_min, me_ctx->x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - me_ctx->y_min, me_ctx->y_max - y), FFMIN(y - me_ctx->y_min, me_ctx->y_max - y));
 
-    data_cur += (y + mv_y) * linesize;
-    data_next += (y - mv_y) * linesize;
-
-    for (j = 0; j < me_ctx->mb_size; j++)
-        for (i = 0; i < me_ctx->mb_size; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + j * linesize] - data_next[x - mv_x + i + j * linesize]);
+    sbad = ff_me_sad(me_ctx, data_cur + x + mv_x + (y + mv_y) * linesize,
+                     data_next + x - mv_x + (y - mv_y) * linesize, me_ctx->mb_size);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -290,19 +302,20 @@ static uint64_t get_sbad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv,
     int x_max = me_ctx->x_max - me_ctx->mb_size / 2;
     int y_min = me_ctx->y_min + me_ctx->mb_size / 2;
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
+    int r = me_ctx->mb_size / 2;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - x_min, x_max - x), FFMIN(x - x_min, x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - y_min, y_max - y), FFMIN(y - y_min, y_max - y));
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + (y + mv_y + j) * linesize] - data_next[x - mv_x + i + (y - mv_y + j) * linesize]);
+    sbad = ff_me_sad(me_ctx, data_cur + x + mv_x - r + (y + mv_y - r) * linesize,
+                     data_next + x - mv_x - r + (y - mv_y - r) * linesize,
+                     me_ctx->mb_size * 3 / 2 + r);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -316,19 +329,19 @@ static uint64_t get_sad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv, i
     int x_max = me_ctx->x_max - me_ctx->mb_size / 2;
     int y_min = me_ctx->y_min + me_ctx->mb_size / 2;
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
+    int r = me_ctx->mb_size / 2;
     int mv_x = x_mv - x;
     int mv_y = y_mv - y;
-    int i, j;
-    uint64_t sad = 0;
+    uint64_t sad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     x_mv = av_clip(x_mv, x_min, x_max);
     y_mv = av_clip(y_mv, y_min, y_max);
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sad += FFABS(data_ref[x_mv + i + (y_mv + j) * linesize] - data_cur[x + i + (y + j) * linesize]);
+    sad = ff_me_sad(me_ctx, data_ref + x_mv - r + (y_mv - r) * linesize,
+                    data_cur + x - r + (y - r) * linesize,
+                    me_ctx->mb_size * 3 / 2 + r);
 
     return sad + (FFABS(mv_x - me_ctx->pred_x) + FFABS(mv_y - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -394,6 +407,31 @@ static int config_input(AVFilterLink *inlink)
                     return AVERROR(ENOMEM);
             }
         }
+
+        /* the rows of the predictive searches wait for each other, so all
+         * jobs have to run concurrently */
+        if (inlink->dst->thread_type & AVFILTER_THREAD_SLICE)
+            mi_ctx->nb_threads = FFMIN(ff_filter_get_nb_threads(inlink->dst), mi_ctx->b_height);
+        else
+            mi_ctx->nb_threads = 1;
+        mi_ctx->me_ctxs = av_mallocz_array(mi_ctx->nb_threads, sizeof(*mi_ctx->me_ctxs));
+        mi_ctx->mb_progress = av_mallocz_array(mi_ctx->b_height, sizeof(*mi_ctx->mb_progress));
+        if (!mi_ctx->me_ctxs || !mi_ctx->mb_progress)
+            return AVERROR(ENOMEM);
+
+#if HAVE_THREADS
+        mi_ctx->progress_mutex = av_mallocz_array(mi_ctx->nb_threads, sizeof(*mi_ctx->progress_mutex));
+        mi_ctx->progress_cond = av_mallocz_array(mi_ctx->nb_threads, sizeof(*mi_ctx->progress_cond));
+        if (!mi_ctx->progress_mutex || !mi_ctx->progress_cond) {
+            av_freep(&mi_ctx->progress_mutex);
+            av_freep(&mi_ctx->progress_cond);
+            return AVERROR(ENOMEM);
+        }
+        for (i = 0; i < mi_ctx->nb_threads; i++) {
+            pthread_mutex_init(&mi_ctx->progress_mutex[i], NULL);
+            pthread_cond_init(&mi_ctx->progress_cond[i], NULL);
+        }
+#endif
     }
 
     if (mi_ctx->scd_method == SCD_METHOD_FDIFF) {
@@ -422,9 +460,9 @@ static int config_output(AVFilterLink *outlink)
         preds.nb++;\
     } while(0)
 
-static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int dir)
+static void search_mv(MIContext *mi_ctx, AVMotionEstContext *me_ctx,
+                      Block *blocks, int mb_x, int mb_y, int dir)
 {
-    AVMotionEstContext *me_ctx = &mi_ctx->me_ctx;
     AVMotionEstPredictor *preds = me_ctx->preds;
     Block *block = &blocks[mb_x + mb_y * mi_ctx->b_width];
 
@@ -564,8 +602,80 @@ static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int
     block->mvs[dir][1] = mv[1] - y_mb;
 }
 
-static void bilateral_me(MIContext *mi_ctx)
+/**
+ * Wait until the first n blocks of row mb_y have been searched. Rows are
+ * interleaved between the jobs, so row mb_y is the one of the previous job.
+ */
+static void await_progress(MIContext *mi_ctx, int jobnr, int mb_y, int n)
+{
+#if HAVE_THREADS
+    pthread_mutex_lock(&mi_ctx->progress_mutex[jobnr]);
+    while (mi_ctx->mb_progress[mb_y] < n)
+        pthread_cond_wait(&mi_ctx->progress_cond[jobnr], &mi_ctx->progress_mutex[jobnr]);
+    pthread_mutex_unlock(&mi_ctx->progress_mutex[jobnr]);
+#endif
+}
+
+static void report_progress(MIContext *mi_ctx, int jobnr, int nb_jobs, int mb_y, int n)
+{
+#if HAVE_THREADS
+    int next = (jobnr + 1) % nb_jobs;
+
+    pthread_mutex_lock(&mi_ctx->progress_mutex[next]);
+    mi_ctx->mb_progress[mb_y] = n;
+    pthread_cond_signal(&mi_ctx->progress_cond[next]);
+    pthread_mutex_unlock(&mi_ctx->progress_mutex[next]);
+#endif
+}
+
+static int search_mv_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    AVMotionEstContext *me_ctx = &mi_ctx->me_ctxs[jobnr];
+    /* the predictive methods use the vectors of the left, top and top-right
+     * blocks, so every row has to trail the one above by two blocks */
+    const int wavefront = nb_jobs > 1 && (mi_ctx->me_method == AV_ME_METHOD_EPZS ||
+                                          mi_ctx->me_method == AV_ME_METHOD_UMH);
+    int mb_x, mb_y;
+
+    *me_ctx = mi_ctx->me_ctx;
+
+    for (mb_y = jobnr; mb_y < mi_ctx->b_height; mb_y += nb_jobs)
+        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+            if (wavefront && mb_y > 0)
+                await_progress(mi_ctx, jobnr, mb_y - 1, FFMIN(mb_x + 2, mi_ctx->b_width));
+
+            search_mv(mi_ctx, me_ctx, td->blocks, mb_x, mb_y, td->dir);
+
+            if (wavefront)
+                report_progress(mi_ctx, jobnr, nb_jobs, mb_y, mb_x + 1);
+        }
+
+    emms_c();
+    return 0;
+}
+
+static void search_mvs(AVFilterContext *ctx, Block *blocks, int dir)
 {
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData td;
+
+    td.blocks = blocks;
+    td.dir = dir;
+
+    memset(mi_ctx->mb_progress, 0, mi_ctx->b_height * sizeof(*mi_ctx->mb_progress));
+    ctx->internal->execute(ctx, search_mv_slice, &td, NULL, mi_ctx->nb_threads);
+
+    /* keep the predictor of the last block, as the later cost
+     * computations of the single threaded search used to */
+    mi_ctx->me_ctx.pred_x = mi_ctx->me_ctxs[(mi_ctx->b_height - 1) % mi_ctx->nb_threads].pred_x;
+    mi_ctx->me_ctx.pred_y = mi_ctx->me_ctxs[(mi_ctx->b_height - 1) % mi_ctx->nb_threads].pred_y;
+}
+
+static void bilateral_me(AVFilterContext *ctx)
+{
+    MIContext *mi_ctx = ctx->priv;
     Block *block;
     int mb_x, mb_y;
 
@@ -580,9 +690,27 @@ static void bilateral_me(MIContext *mi_ctx)
             block->mvs[0][1] = 0;
         }
 
-    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-            search_mv(mi_ctx, mi_ctx->int_blocks, mb_x, mb_y, 0);
+    search_mvs(ctx, mi_ctx->int_blocks, 0);
+}
+
+static int block_sbad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    const int slice_start = (mi_ctx->b_height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (mi_ctx->b_height * (jobnr + 1)) / nb_jobs;
+    int mb_x, mb_y;
+
+    for (mb_y = slice_start; mb_y < slice_end; mb_y++)
+        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+            int x_mb = mb_x << mi_ctx->log2_mb_size;
+            int y_mb = mb_y << mi_ctx->log2_mb_size;
+            Block *block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+            block->sbad = get_sbad(&mi_ctx->me_ctx, x_mb, y_mb, x_mb + block->mvs[0][0], y_mb + block->mvs[0][1]);
+        }
+
+    emms_c();
+    return 0;
 }
 
 static int var_size_bme(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n)
@@ -765,9 +893,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
                     mi_ctx->me_ctx.data_cur = mi_ctx->frames[2].avf->data[0];
                     mi_ctx->me_ctx.data_ref = mi_ctx->frames[dir ? 3 : 1].avf->data[0];
 
-                    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-                            search_mv(mi_ctx, mi_ctx->frames[2].blocks, mb_x, mb_y, dir);
+                    search_mvs(ctx, mi_ctx->frames[2].blocks, dir);
                 }
             }
 
@@ -782,19 +908,10 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
             mi_ctx->me_ctx.data_cur = mi_ctx->frames[1].avf->data[0];
             mi_ctx->me_ctx.data_ref = mi_ctx->frames[2].avf->data[0];
 
-            bilateral_me(mi_ctx);
-
-            if (mi_ctx->mc_mode == MC_MODE_AOBMC) {
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        int x_mb = mb_x << mi_ctx->log2_mb_size;
-                        int y_mb = mb_y << mi_ctx->log2_mb_size;
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+            bilateral_me(ctx);
 
-                        block->sbad = get_sbad(&mi_ctx->me_ctx, x_mb, y_mb, x_mb + block->mvs[0][0], y_mb + block->mvs[0][1]);
-                    }
-            }
+            if (mi_ctx->mc_mode == MC_MODE_AOBMC)
+                ctx->internal->execute(ctx, block_sbad_slice, NULL, NULL, mi_ctx->nb_threads);
 
             if (mi_ctx->vsbmc) {
 
@@ -814,7 +931,9 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
 
                 mi_ctx->clusters[0].nb = mi_ctx->b_count;
 
-                if (ret = cluster_mvs(mi_ctx))
+                ret = cluster_mvs(mi_ctx);
+                emms_c();
+                if (ret)
                     return ret;
             }
         }
@@ -864,17 +983,13 @@ static int detect_scene_change(AVFilterContext *ctx)
         pixel_refs->nb++;\
     } while(0)
 
-static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
+static void bidirectional_obmc(MIContext *mi_ctx, int alpha, int slice_start, int slice_end)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
     int height = mi_ctx->frames[0].avf->height;
     int mb_y, mb_x, dir;
 
-    for (y = 0; y < height; y++)
-        for (x = 0; x < width; x++)
-            mi_ctx->pixel_refs[x + y * width].nb = 0;
-
     for (dir = 0; dir < 2; dir++)
         for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
             for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
@@ -888,9 +1003,9 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
                 start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2 + mv_y * a / ALPHA_MAX;
 
                 startc_x = av_clip(start_x, 0, width - 1);
-                startc_y = av_clip(start_y, 0, height - 1);
+                startc_y = FFMAX(av_clip(start_y, 0, height - 1), slice_start);
                 endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
-                endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
+                endc_y = FFMIN(av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1), slice_end);
 
                 if (dir) {
                     mv_x = -mv_x;
@@ -914,7 +1029,8 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
             }
 }
 
-static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
+static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out,
+                           int slice_start, int slice_end)
 {
     int x, y, plane;
 
@@ -922,8 +1038,15 @@ static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
         int width = avf_out->width;
         int height = avf_out->height;
         int chroma = plane == 1 || plane == 2;
+        /* a chroma sample is set by each of its luma pixels in turn, so only
+         * the last one has to be computed */
+        int mask_w = chroma ? (1 << mi_ctx->log2_chroma_w) - 1 : 0;
+        int mask_h = chroma ? (1 << mi_ctx->log2_chroma_h) - 1 : 0;
+
+        for (y = slice_start; y < slice_end; y++) {
+            if ((y + 1) & mask_h && y != height - 1)
+                continue;
 
-        for (y = 0; y < height; y++)
             for (x = 0; x < width; x++) {
                 int x_mv, y_mv;
                 int weight_sum = 0;
@@ -932,6 +1055,9 @@ static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
                 PixelWeights *pixel_weights = &mi_ctx->pixel_weights[x + y * avf_out->width];
                 PixelRefs *pixel_refs = &mi_ctx->pixel_refs[x + y * avf_out->width];
 
+                if ((x + 1) & mask_w && x != width - 1)
+                    continue;
+
                 for (i = 0; i < pixel_refs->nb; i++)
                     weight_sum += pixel_weights->weights[i];
 
@@ -969,10 +1095,12 @@ static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
                 else
                     avf_out->data[plane][x + y * avf_out->linesize[plane]] = val;
             }
+        }
     }
 }
 
-static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha)
+static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha,
+                         int slice_start, int slice_end)
 {
     int sb_x, sb_y;
     int width = mi_ctx->frames[0].avf->width;
@@ -983,7 +1111,8 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
             Block *sb = &block->subs[sb_x + sb_y * 2];
 
             if (sb->sb)
-                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha);
+                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha,
+                             slice_start, slice_end);
             else {
                 int x, y;
                 int mv_x = sb->mvs[0][0] * 2;
@@ -994,7 +1123,7 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
                 int end_x = start_x + (1 << (n - 1));
                 int end_y = start_y + (1 << (n - 1));
 
-                for (y = start_y; y < end_y; y++)  {
+                for (y = FFMAX(start_y, slice_start); y < FFMIN(end_y, slice_end); y++)  {
                     int y_min = -y;
                     int y_max = height - y - 1;
                     for (x = start_x; x < end_x; x++) {
@@ -1011,7 +1140,8 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
         }
 }
 
-static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha)
+static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha,
+                           int slice_start, int slice_end)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
@@ -1019,13 +1149,24 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
 
     Block *nb;
     int nb_x, nb_y;
-    uint64_t sbads[9];
+    uint64_t sbads[9] = { 0 };
 
     int mv_x = block->mvs[0][0] * 2;
     int mv_y = block->mvs[0][1] * 2;
     int start_x, start_y;
     int startc_x, startc_y, endc_x, endc_y;
 
+    start_x = (mb_x << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
+    start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
+
+    startc_x = av_clip(start_x, 0, width - 1);
+    startc_y = FFMAX(av_clip(start_y, 0, height - 1), slice_start);
+    endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
+    endc_y = FFMIN(av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1), slice_end);
+
+    if (startc_y >= endc_y)
+        return;
+
     if (mi_ctx->mc_mode == MC_MODE_AOBMC)
         for (nb_y = FFMAX(0, mb_y - 1); nb_y < FFMIN(mb_y + 2, mi_ctx->b_height); nb_y++)
             for (nb_x = FFMAX(0, mb_x - 1); nb_x < FFMIN(mb_x + 2, mi_ctx->b_width); nb_x++) {
@@ -1036,14 +1177,6 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
                     sbads[nb_x - mb_x + 1 + (nb_y - mb_y + 1) * 3] = get_sbad(&mi_ctx->me_ctx, x_nb, y_nb, x_nb + block->mvs[0][0], y_nb + block->mvs[0][1]);
             }
 
-    start_x = (mb_x << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
-    start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
-
-    startc_x = av_clip(start_x, 0, width - 1);
-    startc_y = av_clip(start_y, 0, height - 1);
-    endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
-    endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
-
     for (y = startc_y; y < endc_y; y++) {
         int y_min = -y;
         int y_max = height - y - 1;
@@ -1075,6 +1208,45 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     }
 }
 
+static int interpolate_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    const int width  = td->out->width;
+    const int height = td->out->height;
+    /* keep all luma rows of a chroma row in the same job */
+    const int rows = AV_CEIL_RSHIFT(height, mi_ctx->log2_chroma_h);
+    const int slice_start = ((rows *  jobnr     ) / nb_jobs) << mi_ctx->log2_chroma_h;
+    const int slice_end   = FFMIN(((rows * (jobnr + 1)) / nb_jobs) << mi_ctx->log2_chroma_h, height);
+    int x, y, mb_x, mb_y;
+
+    for (y = slice_start; y < slice_end; y++)
+        for (x = 0; x < width; x++)
+            mi_ctx->pixel_refs[x + y * width].nb = 0;
+
+    /* every job goes through all blocks in the same order, so that the
+     * vectors of each pixel are collected as in a single pass */
+    if (mi_ctx->me_mode == ME_MODE_BIDIR) {
+        bidirectional_obmc(mi_ctx, td->alpha, slice_start, slice_end);
+    } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
+        for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
+            for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+                Block *block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+                if (block->sb)
+                    var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size,
+                                 mi_ctx->log2_mb_size, td->alpha, slice_start, slice_end);
+
+                bilateral_obmc(mi_ctx, block, mb_x, mb_y, td->alpha, slice_start, slice_end);
+            }
+    }
+
+    set_frame_data(mi_ctx, td->alpha, td->out, slice_start, slice_end);
+
+    emms_c();
+    return 0;
+}
+
 static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -1127,34 +1299,17 @@ static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
             }
 
             break;
-        case MI_MODE_MCI:
-            if (mi_ctx->me_mode == ME_MODE_BIDIR) {
-                bidirectional_obmc(mi_ctx, alpha);
-                set_frame_data(mi_ctx, alpha, avf_out);
-
-            } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
-                int mb_x, mb_y;
-                Block *block;
+        case MI_MODE_MCI: {
+            ThreadData td;
 
-                for (y = 0; y < mi_ctx->frames[0].avf->height; y++)
-                    for (x = 0; x < mi_ctx->frames[0].avf->width; x++)
-                        mi_ctx->pixel_refs[x + y * mi_ctx->frames[0].avf->width].nb = 0;
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
-
-                        if (block->sb)
-                            var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size, mi_ctx->log2_mb_size, alpha);
-
-                        bilateral_obmc(mi_ctx, block, mb_x, mb_y, alpha);
-
-                    }
-
-                set_frame_data(mi_ctx, alpha, avf_out);
-            }
+            td.alpha = alpha;
+            td.out = avf_out;
+            ctx->internal->execute(ctx, interpolate_slice, &td, NULL,
+                                   FFMIN(AV_CEIL_RSHIFT(avf_out->height, mi_ctx->log2_chroma_h),
+                                         ff_filter_get_nb_threads(ctx)));
 
             break;
+        }
     }
 }
 
@@ -1237,6 +1392,19 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     for (i = 0; i < 3; i++)
         av_freep(&mi_ctx->mv_table[i]);
+
+    av_freep(&mi_ctx->me_ctxs);
+    av_freep(&mi_ctx->mb_progress);
+#if HAVE_THREADS
+    if (mi_ctx->progress_mutex && mi_ctx->progress_cond) {
+        for (i = 0; i < mi_ctx->nb_threads; i++) {
+            pthread_mutex_destroy(&mi_ctx->progress_mutex[i]);
+            pthread_cond_destroy(&mi_ctx->progress_cond[i]);
+        }
+    }
+    av_freep(&mi_ctx->progress_mutex);
+    av_freep(&mi_ctx->progress_cond);
+#endif
 }
 
 static const AVFilterPad minterpolate_inputs[] = {
@@ -1267,4 +1435,5 @@ AVFilter ff_vf_minterpolate = {
     .query_formats = query_formats,
     .inputs        = minterpolate_inputs,
     .outputs       = minterpolate_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -27,6 +27,7 @@
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
 #include "libavutil/qsort.h"
+#include "libavutil/thread.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "framesync.h"
@@ -46,6 +47,7 @@ enum color_search_method {
     COLOR_SEARCH_NNS_ITERATIVE,
     COLOR_SEARCH_NNS_RECURSIVE,
     COLOR_SEARCH_BRUTEFORCE,
+    COLOR_SEARCH_LUT,
     NB_COLOR_SEARCHES
 };
 
@@ -64,6 +66,10 @@ struct color_node {
 
 #define NBITS 5
 #define CACHE_SIZE (1<<(3*NBITS))
+#define LUT_SIZE (1<<(3*NBITS))
+
+/* number of pixels between two progress reports of the error diffusion rows */
+#define PROGRESS_STEP 32
 
 struct cached_color {
     uint32_t color;
@@ -78,13 +84,20 @@ struct cache_node {
 struct PaletteUseContext;
 
 typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
-                              int x_start, int y_start, int width, int height);
+                              int x_start, int y_start, int width, int height,
+                              int jobnr, int nb_jobs);
+
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int x, y, w, h;
+} ThreadData;
 
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFFrameSync fs;
-    struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node (*cache)[CACHE_SIZE]; /* lookup cache of each job */
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
+    uint8_t lut[LUT_SIZE];                  /* palette entry of each quantized color */
     uint32_t palette[AVPALETTE_COUNT];
     int transparency_index; /* index in the palette of transparency. -1 if there is no transparency in the palette. */
     int trans_thresh;
@@ -98,9 +111,18 @@ typedef struct PaletteUseContext {
     AVFrame *last_in;
     AVFrame *last_out;
 
+    int nb_threads;
+    int *slice_ret;
+    int *row_progress;                      /* processed pixels of each row */
+#if HAVE_THREADS
+    pthread_mutex_t *progress_mutex;
+    pthread_cond_t *progress_cond;
+#endif
+
     /* debug options */
     char *dot_filename;
     int color_search_method;
+    int use_lut;
     int calc_mean_err;
     uint64_t total_mean_err;
     int debug_accuracy;
@@ -120,6 +142,7 @@ static const AVOption paletteuse_options[] = {
         { "rectangle", "process smallest different rectangle", 0, AV_OPT_TYPE_CONST, {.i64=DIFF_MODE_RECTANGLE}, INT_MIN, INT_MAX, FLAGS, "diff_mode" },
     { "new", "take new palette for each output frame", OFFSET(new), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, FLAGS },
     { "alpha_threshold", "set the alpha threshold for transparency", OFFSET(trans_thresh), AV_OPT_TYPE_INT, {.i64=128}, 0, 255, FLAGS },
+    { "lut", "look up the colors quantized to 5 bits per component in a table", OFFSET(use_lut), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, FLAGS },
 
     /* following are the debug options, not part of the official API */
     { "debug_kdtree", "save Graphviz graph of the kdtree in specified file", OFFSET(dot_filename), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
@@ -323,9 +346,9 @@ end:
 }
 
 #define COLORMAP_NEAREST(search, palette, root, target, trans_thresh)                                    \
-    search == COLOR_SEARCH_NNS_ITERATIVE ? colormap_nearest_iterative(root, target, trans_thresh) :      \
     search == COLOR_SEARCH_NNS_RECURSIVE ? colormap_nearest_recursive(root, target, trans_thresh) :      \
-                                           colormap_nearest_bruteforce(palette, target, trans_thresh)
+    search == COLOR_SEARCH_BRUTEFORCE    ? colormap_nearest_bruteforce(palette, target, trans_thresh) :  \
+                                           colormap_nearest_iterative(root, target, trans_thresh)
 
 /**
  * Check if the requested color is in the cache already. If not, find it in the
@@ -333,7 +356,8 @@ end:
  * Note: a, r, g, and b are the components of color, but are passed as well to avoid
  * recomputing them (they are generally computed by the caller for other uses).
  */
-static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
+static av_always_inline int color_get(PaletteUseContext *s, struct cache_node *cache,
+                                      uint32_t color,
                                       uint8_t a, uint8_t r, uint8_t g, uint8_t b,
                                       const enum color_search_method search_method)
 {
@@ -343,7 +367,7 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     const uint8_t ghash = g & ((1<<NBITS)-1);
     const uint8_t bhash = b & ((1<<NBITS)-1);
     const unsigned hash = rhash<<(NBITS*2) | ghash<<NBITS | bhash;
-    struct cache_node *node = &s->cache[hash];
+    struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
     // first, check for transparency
@@ -351,6 +375,9 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
         return s->transparency_index;
     }
 
+    if (search_method == COLOR_SEARCH_LUT)
+        return s->lut[(r >> (8-NBITS)) << (NBITS*2) | (g >> (8-NBITS)) << NBITS | b >> (8-NBITS)];
+
     for (i = 0; i < node->nb_entries; i++) {
         e = &node->entries[i];
         if (e->color == color)
@@ -367,7 +394,7 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(PaletteUseContext *s,
+static av_always_inline int get_dst_color_err(PaletteUseContext *s, struct cache_node *cache,
                                               uint32_t c, int *er, int *eg, int *eb,
                                               const enum color_search_method search_method)
 {
@@ -376,7 +403,7 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     const uint8_t g = c >>  8 & 0xff;
     const uint8_t b = c       & 0xff;
     uint32_t dstc;
-    const int dstx = color_get(s, c, a, r, g, b, search_method);
+    const int dstx = color_get(s, cache, c, a, r, g, b, search_method);
     if (dstx < 0)
         return dstx;
     dstc = s->palette[dstx];
@@ -386,24 +413,64 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     return dstx;
 }
 
+static void await_progress(PaletteUseContext *s, int jobnr, int y, int n)
+{
+#if HAVE_THREADS
+    pthread_mutex_lock(&s->progress_mutex[jobnr]);
+    while (s->row_progress[y] < n)
+        pthread_cond_wait(&s->progress_cond[jobnr], &s->progress_mutex[jobnr]);
+    pthread_mutex_unlock(&s->progress_mutex[jobnr]);
+#endif
+}
+
+static void report_progress(PaletteUseContext *s, int jobnr, int nb_jobs, int y, int n)
+{
+#if HAVE_THREADS
+    int next = (jobnr + 1) % nb_jobs;
+
+    pthread_mutex_lock(&s->progress_mutex[next]);
+    s->row_progress[y] = n;
+    pthread_cond_signal(&s->progress_cond[next]);
+    pthread_mutex_unlock(&s->progress_mutex[next]);
+#endif
+}
+
 static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
                                       int x_start, int y_start, int w, int h,
+                                      int jobnr, int nb_jobs,
                                       enum dithering_mode dither,
                                       const enum color_search_method search_method)
 {
-    int x, y;
+    int x, y, ret = 0;
+    struct cache_node *cache = s->cache[jobnr];
     const int src_linesize = in ->linesize[0] >> 2;
     const int dst_linesize = out->linesize[0];
-    uint32_t *src = ((uint32_t *)in ->data[0]) + y_start*src_linesize;
-    uint8_t  *dst =              out->data[0]  + y_start*dst_linesize;
+    /* the error diffusion spreads into the next row, so the jobs take
+     * interleaved rows, each one trailing the row above by enough pixels to
+     * receive its whole error and to never write the same pixels */
+    const int diffusion = dither != DITHERING_NONE && dither != DITHERING_BAYER;
+    const int wavefront = diffusion && nb_jobs > 1;
+    const int y_step    = diffusion ? nb_jobs : 1;
+    const int slice_start = diffusion ? y_start + jobnr : y_start + (h *  jobnr   ) / nb_jobs;
+    const int slice_end   = diffusion ? y_start + h     : y_start + (h * (jobnr+1)) / nb_jobs;
 
     w += x_start;
     h += y_start;
 
-    for (y = y_start; y < h; y++) {
+    for (y = slice_start; y < slice_end; y += y_step) {
+        uint32_t *src = ((uint32_t *)in ->data[0]) + y*src_linesize;
+        uint8_t  *dst =              out->data[0]  + y*dst_linesize;
+
         for (x = x_start; x < w; x++) {
             int er, eg, eb;
 
+            if (wavefront && !((x - x_start) % PROGRESS_STEP)) {
+                if (x > x_start)
+                    report_progress(s, jobnr, nb_jobs, y, x - x_start);
+                if (y > y_start)
+                    await_progress(s, jobnr, y - 1, FFMIN(x - x_start + PROGRESS_STEP + 4, w - x_start));
+            }
+
             if (dither == DITHERING_BAYER) {
                 const int d = s->ordered_dither[(y & 7)<<3 | (x & 7)];
                 const uint8_t a8 = src[x] >> 24 & 0xff;
@@ -413,18 +480,22 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = av_clip_uint8(r8 + d);
                 const uint8_t g = av_clip_uint8(g8 + d);
                 const uint8_t b = av_clip_uint8(b8 + d);
-                const int color = color_get(s, src[x], a8, r, g, b, search_method);
+                const int color = color_get(s, cache, src[x], a8, r, g, b, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
 
             } else if (dither == DITHERING_HECKBERT) {
                 const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
 
                 if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 3, 3);
@@ -433,10 +504,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_FLOYD_STEINBERG) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
 
                 if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 7, 4);
@@ -447,10 +520,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA2) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
 
                 if (right)          src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 4, 4);
@@ -466,10 +541,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_SIERRA2_4A) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
 
                 if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 2, 2);
@@ -481,16 +558,34 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = src[x] >> 16 & 0xff;
                 const uint8_t g = src[x] >>  8 & 0xff;
                 const uint8_t b = src[x]       & 0xff;
-                const int color = color_get(s, src[x], a, r, g, b, search_method);
+                const int color = color_get(s, cache, src[x], a, r, g, b, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
             }
         }
-        src += src_linesize;
-        dst += dst_linesize;
+        if (wavefront)
+            report_progress(s, jobnr, nb_jobs, y, w - x_start);
     }
+
+end:
+    /* do not leave the jobs of the next rows waiting after a failure */
+    if (wavefront)
+        for (; y < slice_end; y += y_step)
+            report_progress(s, jobnr, nb_jobs, y, w - x_start);
+    return ret;
+}
+
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    ThreadData *td = arg;
+
+    s->slice_ret[jobnr] = s->set_frame(s, td->out, td->in, td->x, td->y, td->w, td->h,
+                                       jobnr, nb_jobs);
     return 0;
 }
 
@@ -761,6 +856,21 @@ static void load_colormap(PaletteUseContext *s)
 
     colormap_insert(s->map, color_used, &nb_used, s->palette, s->trans_thresh, &box);
 
+    if (s->color_search_method == COLOR_SEARCH_LUT) {
+        /* nearest palette entry of the center of each quantized color cell */
+        const int mask = (1<<NBITS) - 1, center = 1 << (7-NBITS);
+
+        for (i = 0; i < LUT_SIZE; i++) {
+            const uint8_t target[] = {
+                0xff,
+                (i >> (NBITS*2) & mask) << (8-NBITS) | center,
+                (i >>  NBITS    & mask) << (8-NBITS) | center,
+                (i              & mask) << (8-NBITS) | center,
+            };
+            s->lut[i] = colormap_nearest_iterative(s->map, target, s->trans_thresh);
+        }
+    }
+
     if (s->dot_filename)
         disp_tree(s->map, s->dot_filename);
 
@@ -891,7 +1001,7 @@ static void set_processing_window(enum diff_mode diff_mode,
 
 static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
 {
-    int x, y, w, h, ret;
+    int i, x, y, w, h, ret;
     AVFilterContext *ctx = inlink->dst;
     PaletteUseContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
@@ -918,7 +1028,15 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    ret = s->set_frame(s, out, in, x, y, w, h);
+    if (w > 0 && h > 0) {
+        ThreadData td = { .in = in, .out = out, .x = x, .y = y, .w = w, .h = h };
+        const int nb_jobs = FFMIN(h, s->nb_threads);
+
+        memset(s->row_progress, 0, inlink->h * sizeof(*s->row_progress));
+        ctx->internal->execute(ctx, set_frame_slice, &td, NULL, nb_jobs);
+        for (i = 0; i < nb_jobs && ret >= 0; i++)
+            ret = s->slice_ret[i];
+    }
     if (ret < 0) {
         av_frame_free(&out);
         *outf = NULL;
@@ -931,6 +1049,41 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     return 0;
 }
 
+static void free_caches(PaletteUseContext *s)
+{
+    int i, j;
+
+    if (!s->cache)
+        return;
+    for (j = 0; j < s->nb_threads; j++) {
+        for (i = 0; i < CACHE_SIZE; i++)
+            av_freep(&s->cache[j][i].entries);
+        memset(s->cache[j], 0, sizeof(s->cache[j]));
+    }
+}
+
+static void free_slice_data(PaletteUseContext *s)
+{
+#if HAVE_THREADS
+    int i;
+#endif
+
+    free_caches(s);
+    av_freep(&s->cache);
+    av_freep(&s->slice_ret);
+    av_freep(&s->row_progress);
+#if HAVE_THREADS
+    if (s->progress_mutex && s->progress_cond) {
+        for (i = 0; i < s->nb_threads; i++) {
+            pthread_mutex_destroy(&s->progress_mutex[i]);
+            pthread_cond_destroy(&s->progress_cond[i]);
+        }
+    }
+    av_freep(&s->progress_mutex);
+    av_freep(&s->progress_cond);
+#endif
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     int ret;
@@ -947,6 +1100,33 @@ static int config_output(AVFilterLink *outlink)
     outlink->w = ctx->inputs[0]->w;
     outlink->h = ctx->inputs[0]->h;
 
+    free_slice_data(s);
+    /* all jobs have to run concurrently for the error diffusion wavefront */
+    s->nb_threads = ctx->thread_type & AVFILTER_THREAD_SLICE ?
+                    FFMIN(ff_filter_get_nb_threads(ctx), outlink->h) : 1;
+    s->cache = av_mallocz_array(s->nb_threads, sizeof(*s->cache));
+    s->slice_ret = av_mallocz_array(s->nb_threads, sizeof(*s->slice_ret));
+    s->row_progress = av_mallocz_array(outlink->h, sizeof(*s->row_progress));
+    if (!s->cache || !s->slice_ret || !s->row_progress)
+        return AVERROR(ENOMEM);
+#if HAVE_THREADS
+    if (s->nb_threads > 1) {
+        int i;
+
+        s->progress_mutex = av_mallocz_array(s->nb_threads, sizeof(*s->progress_mutex));
+        s->progress_cond = av_mallocz_array(s->nb_threads, sizeof(*s->progress_cond));
+        if (!s->progress_mutex || !s->progress_cond) {
+            av_freep(&s->progress_mutex);
+            av_freep(&s->progress_cond);
+            return AVERROR(ENOMEM);
+        }
+        for (i = 0; i < s->nb_threads; i++) {
+            pthread_mutex_init(&s->progress_mutex[i], NULL);
+            pthread_cond_init(&s->progress_cond[i], NULL);
+        }
+    }
+#endif
+
     outlink->time_base = ctx->inputs[0]->time_base;
     if ((ret = ff_framesync_configure(&s->fs)) < 0)
         return ret;
@@ -979,9 +1159,7 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
-            av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+        free_caches(s);
     }
 
     i = 0;
@@ -1030,9 +1208,11 @@ static int load_apply_palette(FFFrameSync *fs)
 
 #define DEFINE_SET_FRAME(color_search, name, value)                             \
 static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
-                            int x_start, int y_start, int w, int h)             \
+                            int x_start, int y_start, int w, int h,             \
+                            int jobnr, int nb_jobs)                             \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value, color_search);  \
+    return set_frame(s, out, in, x_start, y_start, w, h,                        \
+                     jobnr, nb_jobs, value, color_search);                      \
 }
 
 #define DEFINE_SET_FRAME_COLOR_SEARCH(color_search, color_search_macro)                                 \
@@ -1046,6 +1226,7 @@ static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,
 DEFINE_SET_FRAME_COLOR_SEARCH(nns_iterative, COLOR_SEARCH_NNS_ITERATIVE)
 DEFINE_SET_FRAME_COLOR_SEARCH(nns_recursive, COLOR_SEARCH_NNS_RECURSIVE)
 DEFINE_SET_FRAME_COLOR_SEARCH(bruteforce,    COLOR_SEARCH_BRUTEFORCE)
+DEFINE_SET_FRAME_COLOR_SEARCH(lut,           COLOR_SEARCH_LUT)
 
 #define DITHERING_ENTRIES(color_search) {       \
     set_frame_##color_search##_none,            \
@@ -1060,6 +1241,7 @@ static const set_frame_func set_frame_lut[NB_COLOR_SEARCHES][NB_DITHERING] = {
     DITHERING_ENTRIES(nns_iterative),
     DITHERING_ENTRIES(nns_recursive),
     DITHERING_ENTRIES(bruteforce),
+    DITHERING_ENTRIES(lut),
 };
 
 static int dither_value(int p)
@@ -1082,6 +1264,8 @@ static av_cold int init(AVFilterContext *ctx)
         return AVERROR(ENOMEM);
     }
 
+    if (s->use_lut)
+        s->color_search_method = COLOR_SEARCH_LUT;
     s->set_frame = set_frame_lut[s->color_search_method][s->dither];
 
     if (s->dither == DITHERING_BAYER) {
@@ -1103,12 +1287,10 @@ static int activate(AVFilterContext *ctx)
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
-    int i;
     PaletteUseContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
-    for (i = 0; i < CACHE_SIZE; i++)
-        av_freep(&s->cache[i].entries);
+    free_slice_data(s);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
 }
@@ -1145,4 +1327,5 @@ AVFilter ff_vf_paletteuse = {
     .inputs        = paletteuse_inputs,
     .outputs       = paletteuse_outputs,
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
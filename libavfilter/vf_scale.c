@@ -108,6 +108,9 @@ typedef struct ScaleContext {
     const AVClass *class;
     struct SwsContext *sws;     ///< software scaler context
     struct SwsContext *isws[2]; ///< software scaler context for interlaced material
+    struct SwsContext **slice_sws; ///< one context per band of output lines for slice threading
+    int *slice_ret;             ///< return value of each band
+    int nb_slice_sws;
     AVDictionary *opts;
 
     /**
@@ -155,6 +158,10 @@ typedef struct ScaleContext {
 
 } ScaleContext;
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
 AVFilter ff_vf_scale2ref;
 
 static int config_props(AVFilterLink *outlink);
@@ -328,6 +335,43 @@ static av_cold int init_dict(AVFilterContext *ctx, AVDictionary **opts)
     return 0;
 }
 
+static void free_slice_contexts(ScaleContext *scale)
+{
+    int i;
+
+    for (i = 0; i < scale->nb_slice_sws; i++)
+        sws_freeContext(scale->slice_sws[i]);
+    av_freep(&scale->slice_sws);
+    av_freep(&scale->slice_ret);
+    scale->nb_slice_sws = 0;
+}
+
+static int alloc_slice_contexts(AVFilterContext *ctx)
+{
+    ScaleContext *scale = ctx->priv;
+    const int nb_threads = FFMIN(ff_filter_get_nb_threads(ctx),
+                                 ctx->outputs[0]->h);
+    int i, ret;
+
+    if (nb_threads <= 1)
+        return 0;
+
+    scale->slice_sws = av_mallocz_array(nb_threads, sizeof(*scale->slice_sws));
+    scale->slice_ret = av_mallocz_array(nb_threads, sizeof(*scale->slice_ret));
+    if (!scale->slice_sws || !scale->slice_ret)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < nb_threads; i++) {
+        struct SwsContext *s = sws_alloc_context();
+        if (!s)
+            return AVERROR(ENOMEM);
+        scale->slice_sws[scale->nb_slice_sws++] = s;
+        if ((ret = av_opt_copy(s, scale->sws)) < 0)
+            return ret;
+        av_opt_set_int(s, "threads", 1, 0);
+    }
+    return 0;
+}
+
 static av_cold void uninit(AVFilterContext *ctx)
 {
     ScaleContext *scale = ctx->priv;
@@ -338,6 +382,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     sws_freeContext(scale->isws[0]);
     sws_freeContext(scale->isws[1]);
     scale->sws = NULL;
+    free_slice_contexts(scale);
     av_dict_free(&scale->opts);
 }
 
@@ -520,6 +565,7 @@ static int config_props(AVFilterLink *outlink)
     if (scale->isws[1])
         sws_freeContext(scale->isws[1]);
     scale->isws[0] = scale->isws[1] = scale->sws = NULL;
+    free_slice_contexts(scale);
     if (inlink0->w == outlink->w &&
         inlink0->h == outlink->h &&
         !scale->out_color_matrix &&
@@ -546,6 +592,7 @@ static int config_props(AVFilterLink *outlink)
             av_opt_set_int(*s, "sws_flags", scale->flags, 0);
             av_opt_set_int(*s, "param0", scale->param[0], 0);
             av_opt_set_int(*s, "param1", scale->param[1], 0);
+            av_opt_set_int(*s, "threads", ff_filter_get_nb_threads(ctx), 0);
             if (scale->in_range != AVCOL_RANGE_UNSPECIFIED)
                 av_opt_set_int(*s, "src_range",
                                scale->in_range == AVCOL_RANGE_JPEG, 0);
@@ -576,11 +623,34 @@ static int config_props(AVFilterLink *outlink)
             av_opt_set_int(*s, "dst_h_chr_pos", scale->out_h_chr_pos, 0);
             av_opt_set_int(*s, "dst_v_chr_pos", out_v_chr_pos, 0);
 
+            /* Progressive frames are split into bands of output lines,
+             * each scaled from the complete input by its own copy of the
+             * context on the filter graph threads. The contexts then do
+             * not need threads of their own; otherwise the scaler gets
+             * the filter thread count. */
+            if (!i && !scale->interlaced && !scale->nb_slices &&
+                ctx->thread_type & AVFILTER_THREAD_SLICE) {
+                if ((ret = alloc_slice_contexts(ctx)) < 0)
+                    return ret;
+                if (scale->nb_slice_sws)
+                    av_opt_set_int(*s, "threads", 1, 0);
+            }
+
             if ((ret = sws_init_context(*s, NULL, NULL)) < 0)
                 return ret;
             if (!scale->interlaced)
                 break;
         }
+
+        if (scale->nb_slice_sws) {
+            if (!sws_dst_slice_alignment(scale->sws)) {
+                free_slice_contexts(scale);
+            } else {
+                for (i = 0; i < scale->nb_slice_sws; i++)
+                    if ((ret = sws_init_context(scale->slice_sws[i], NULL, NULL)) < 0)
+                        return ret;
+            }
+        }
     }
 
     if (inlink0->sample_aspect_ratio.num){
@@ -647,6 +717,47 @@ static int scale_slice(AVFilterLink *link, AVFrame *out_buf, AVFrame *cur_pic, s
                          out,out_stride);
 }
 
+static int scale_band(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ScaleContext *scale = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *cur_pic = td->in, *out_buf = td->out;
+    struct SwsContext *sws = scale->slice_sws[jobnr];
+    const int h = out_buf->height;
+    const int slice_h = FFALIGN((h + nb_jobs - 1) / nb_jobs,
+                                sws_dst_slice_alignment(sws));
+    const int slice_start = FFMIN(slice_h * jobnr, h);
+    const int slice_end   = FFMIN(slice_start + slice_h, h);
+    const uint8_t *in[4];
+    uint8_t *out[4];
+    int i;
+
+    if (slice_start >= slice_end)
+        return 0;
+
+    for (i = 0; i < 4; i++) {
+        in[i]  = cur_pic->data[i];
+        out[i] = out_buf->data[i];
+    }
+
+    return sws_scale_dst_slice(sws, in, cur_pic->linesize, out, out_buf->linesize,
+                               slice_start, slice_end - slice_start);
+}
+
+/**
+ * Changing the colorspace details can make a context cascaded, and cascaded
+ * contexts cannot scale bands of output lines.
+ */
+static int slice_contexts_usable(ScaleContext *scale)
+{
+    int i;
+
+    for (i = 0; i < scale->nb_slice_sws; i++)
+        if (!sws_dst_slice_alignment(scale->slice_sws[i]))
+            return 0;
+    return scale->nb_slice_sws > 0;
+}
+
 static int scale_frame(AVFilterLink *link, AVFrame *in, AVFrame **frame_out)
 {
     AVFilterContext *ctx = link->dst;
@@ -657,6 +768,7 @@ static int scale_frame(AVFilterLink *link, AVFrame *in, AVFrame **frame_out)
     char buf[32];
     int in_range;
     int frame_changed;
+    int i;
 
     *frame_out = NULL;
     if (in->colorspace == AVCOL_SPC_YCGCO)
@@ -781,6 +893,10 @@ scale:
             sws_setColorspaceDetails(scale->isws[1], inv_table, in_full,
                                      table, out_full,
                                      brightness, contrast, saturation);
+        for (i = 0; i < scale->nb_slice_sws; i++)
+            sws_setColorspaceDetails(scale->slice_sws[i], inv_table, in_full,
+                                     table, out_full,
+                                     brightness, contrast, saturation);
 
         out->color_range = out_full ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
     }
@@ -802,6 +918,18 @@ scale:
             slice_h     = slice_end - slice_start;
             scale_slice(link, out, in, scale->sws, slice_start, slice_h, 1, 0);
         }
+    } else if (slice_contexts_usable(scale)) {
+        ThreadData td = { .in = in, .out = out };
+        ctx->internal->execute(ctx, scale_band, &td, scale->slice_ret,
+                               scale->nb_slice_sws);
+        for (i = 0; i < scale->nb_slice_sws; i++) {
+            if (scale->slice_ret[i] < 0) {
+                int ret = scale->slice_ret[i];
+                av_frame_free(&in);
+                av_frame_free(frame_out);
+                return ret;
+            }
+        }
     } else {
         scale_slice(link, out, in, scale->sws, 0, link->h, 1, 0);
     }
@@ -986,6 +1114,7 @@ AVFilter ff_vf_scale = {
     .inputs          = avfilter_vf_scale_inputs,
     .outputs         = avfilter_vf_scale_outputs,
     .process_command = process_command,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
 
 static const AVClass scale2ref_class = {
@@ -1041,4 +1170,5 @@ AVFilter ff_vf_scale2ref = {
     .inputs          = avfilter_vf_scale2ref_inputs,
     .outputs         = avfilter_vf_scale2ref_outputs,
     .process_command = process_command,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -29,6 +29,7 @@
 
 #include "libavutil/imgutils.h"
 #include "libavutil/internal.h"
+#include "libavutil/intfloat.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
@@ -37,18 +38,28 @@
 #include "colorspace.h"
 #include "formats.h"
 #include "internal.h"
+#include "tonemap.h"
 #include "video.h"
 
-enum TonemapAlgorithm {
-    TONEMAP_NONE,
-    TONEMAP_LINEAR,
-    TONEMAP_GAMMA,
-    TONEMAP_CLIP,
-    TONEMAP_REINHARD,
-    TONEMAP_HABLE,
-    TONEMAP_MOBIUS,
-    TONEMAP_MAX,
-};
+/* The gain tables hold f(x) / x for 1 << LUT_BITS linearly interpolated
+ * segments per octave of x, covering [2^LUT_MIN_EXP, 2^LUT_MAX_EXP). They are
+ * indexed directly with the exponent and the top mantissa bits of x. */
+#define LUT_BITS     7
+#define LUT_MIN_EXP  -20
+#define LUT_MAX_EXP  12
+#define LUT_SIZE     ((LUT_MAX_EXP - LUT_MIN_EXP) << LUT_BITS)
+#define LUT_SHIFT    (23 - LUT_BITS)
+
+#define ST2084_MAX_LUMINANCE 10000.0f
+#define ST2084_M1 0.1593017578125f
+#define ST2084_M2 78.84375f
+#define ST2084_C1 0.8359375f
+#define ST2084_C2 18.8515625f
+#define ST2084_C3 18.6875f
+
+#define HLG_A 0.17883277f
+#define HLG_B 0.28466892f
+#define HLG_C 0.55991073f
 
 static const struct LumaCoefficients luma_coefficients[AVCOL_SPC_NB] = {
     [AVCOL_SPC_FCC]        = { 0.30,   0.59,   0.11   },
@@ -60,20 +71,21 @@ static const struct LumaCoefficients luma_coefficients[AVCOL_SPC_NB] = {
     [AVCOL_SPC_BT2020_CL]  = { 0.2627, 0.6780, 0.0593 },
 };
 
-typedef struct TonemapContext {
-    const AVClass *class;
-
-    enum TonemapAlgorithm tonemap;
-    double param;
-    double desat;
-    double peak;
+static const struct PrimaryCoefficients primaries_table[AVCOL_PRI_NB] = {
+    [AVCOL_PRI_BT709]  = { 0.640, 0.330, 0.300, 0.600, 0.150, 0.060 },
+    [AVCOL_PRI_BT2020] = { 0.708, 0.292, 0.170, 0.797, 0.131, 0.046 },
+};
 
-    const struct LumaCoefficients *coeffs;
-} TonemapContext;
+static const struct WhitepointCoefficients whitepoint_table[AVCOL_PRI_NB] = {
+    [AVCOL_PRI_BT709]  = { 0.3127, 0.3290 },
+    [AVCOL_PRI_BT2020] = { 0.3127, 0.3290 },
+};
 
 static const enum AVPixelFormat pix_fmts[] = {
     AV_PIX_FMT_GBRPF32,
     AV_PIX_FMT_GBRAPF32,
+    AV_PIX_FMT_YUV420P10,
+    AV_PIX_FMT_P010,
     AV_PIX_FMT_NONE,
 };
 
@@ -104,6 +116,9 @@ static av_cold int init(AVFilterContext *ctx)
     if (isnan(s->param))
         s->param = 1.0f;
 
+    s->lut_trc = AVCOL_TRC_UNSPECIFIED;
+    ff_tonemap_init(s);
+
     return 0;
 }
 
@@ -126,38 +141,8 @@ static float mobius(float in, float j, double peak)
     return (b * b + 2.0f * b * j + j * j) / (b - a) * (in + a) / (in + b);
 }
 
-#define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
-static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
-                    const AVPixFmtDescriptor *desc, int x, int y, double peak)
+static float tone_curve(const TonemapContext *s, float sig, double peak)
 {
-    const float *r_in = (const float *)(in->data[0] + x * desc->comp[0].step + y * in->linesize[0]);
-    const float *b_in = (const float *)(in->data[1] + x * desc->comp[1].step + y * in->linesize[1]);
-    const float *g_in = (const float *)(in->data[2] + x * desc->comp[2].step + y * in->linesize[2]);
-    float *r_out = (float *)(out->data[0] + x * desc->comp[0].step + y * out->linesize[0]);
-    float *b_out = (float *)(out->data[1] + x * desc->comp[1].step + y * out->linesize[1]);
-    float *g_out = (float *)(out->data[2] + x * desc->comp[2].step + y * out->linesize[2]);
-    float sig, sig_orig;
-
-    /* load values */
-    *r_out = *r_in;
-    *b_out = *b_in;
-    *g_out = *g_in;
-
-    /* desaturate to prevent unnatural colors */
-    if (s->desat > 0) {
-        float luma = s->coeffs->cr * *r_in + s->coeffs->cg * *g_in + s->coeffs->cb * *b_in;
-        float overbright = FFMAX(luma - s->desat, 1e-6) / FFMAX(luma, 1e-6);
-        *r_out = MIX(*r_in, luma, overbright);
-        *g_out = MIX(*g_in, luma, overbright);
-        *b_out = MIX(*b_in, luma, overbright);
-    }
-
-    /* pick the brightest component, reducing the value range as necessary
-     * to keep the entire signal in range and preventing discoloration due to
-     * out-of-bounds clipping */
-    sig = FFMAX(FFMAX3(*r_out, *g_out, *b_out), 1e-6);
-    sig_orig = sig;
-
     switch(s->tonemap) {
     default:
     case TONEMAP_NONE:
@@ -184,11 +169,315 @@ static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
         break;
     }
 
-    /* apply the computed scale factor to the color,
-     * linearly to prevent discoloration */
-    *r_out *= sig / sig_orig;
-    *g_out *= sig / sig_orig;
-    *b_out *= sig / sig_orig;
+    return sig;
+}
+
+static float eotf_st2084(const TonemapContext *s, float x, double peak)
+{
+    const float p = powf(x, 1.0f / ST2084_M2);
+    const float a = FFMAX(p - ST2084_C1, 0.0f);
+    const float b = FFMAX(ST2084_C2 - ST2084_C3 * p, 1e-6f);
+    return powf(a / b, 1.0f / ST2084_M1) * ST2084_MAX_LUMINANCE / REFERENCE_WHITE;
+}
+
+static float inverse_oetf_hlg(const TonemapContext *s, float x, double peak)
+{
+    return x < 0.5f ? 4.0f * x * x : expf((x - HLG_C) / HLG_A) + HLG_B;
+}
+
+/* scale factor of the HLG OOTF as a function of the scene luma */
+static float ootf_hlg_factor(const TonemapContext *s, float luma, double peak)
+{
+    const float gamma = FFMAX(1.2f + 0.42f * log10f(peak * REFERENCE_WHITE / 1000.0f), 1.0f);
+    return peak * powf(luma, gamma - 1.0f) / powf(12.0f, gamma);
+}
+
+static float inverse_eotf_bt1886(const TonemapContext *s, float x, double peak)
+{
+    return powf(x, 1.0f / 2.4f);
+}
+
+static float lut_input(int i)
+{
+    return av_int2float(((127 + LUT_MIN_EXP) << 23) + (i << LUT_SHIFT));
+}
+
+static int fill_lut(const TonemapContext *s, float **lut,
+                    float (*func)(const TonemapContext *s, float x, double peak),
+                    double peak)
+{
+    int i;
+
+    if (!*lut) {
+        *lut = av_malloc_array(LUT_SIZE + 1, sizeof(**lut));
+        if (!*lut)
+            return AVERROR(ENOMEM);
+    }
+
+    for (i = 0; i <= LUT_SIZE; i++) {
+        const float x = lut_input(i);
+        (*lut)[i] = func(s, x, peak) / x;
+    }
+    return 0;
+}
+
+/* Interpolated gain at x, which must not be negative. Values outside of the
+ * table range use the gain of the nearest end. */
+static av_always_inline float lut_gain(const float *lut, float x)
+{
+    const uint32_t bits = av_float2int(x);
+    const int idx = (int)(bits >> LUT_SHIFT) - ((127 + LUT_MIN_EXP) << LUT_BITS);
+    float frac;
+
+    if (idx < 0)
+        return lut[0];
+    if (idx >= LUT_SIZE)
+        return lut[LUT_SIZE];
+
+    frac = (bits & ((1 << LUT_SHIFT) - 1)) * (1.0f / (1 << LUT_SHIFT));
+    return lut[idx] + (lut[idx + 1] - lut[idx]) * frac;
+}
+
+#define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
+static av_always_inline void tonemap_row(float *const dst[3], const float *const src[3],
+                                         const TonemapCoeffs *c, const float *lut,
+                                         int width, enum TonemapAlgorithm algorithm)
+{
+    const float cr = c->luma[0][0], cg = c->luma[1][0], cb = c->luma[2][0];
+    const float desat = c->desat[0];
+    const float param = c->param[0][0];
+    int x;
+
+    for (x = 0; x < width; x++) {
+        float r = src[0][x], g = src[1][x], b = src[2][x];
+        float sig, sig_orig;
+
+        /* desaturate to prevent unnatural colors */
+        if (desat > 0) {
+            const float luma = cr * r + cg * g + cb * b;
+            const float overbright = FFMAX(luma - desat, 1e-6f) / FFMAX(luma, 1e-6f);
+            r = MIX(r, luma, overbright);
+            g = MIX(g, luma, overbright);
+            b = MIX(b, luma, overbright);
+        }
+
+        /* pick the brightest component, reducing the value range as necessary
+         * to keep the entire signal in range and preventing discoloration due to
+         * out-of-bounds clipping */
+        sig = FFMAX(FFMAX3(r, g, b), 1e-6f);
+        sig_orig = sig;
+
+        switch (algorithm) {
+        case TONEMAP_NONE:
+            break;
+        case TONEMAP_LINEAR:
+            sig = sig * param;
+            break;
+        case TONEMAP_CLIP:
+            sig = av_clipf(sig * param, 0, 1.0f);
+            break;
+        default:
+            /* all the other curves go through the gain table */
+            sig = sig * lut_gain(lut, sig);
+            break;
+        }
+
+        /* apply the computed scale factor to the color,
+         * linearly to prevent discoloration */
+        dst[0][x] = r * (sig / sig_orig);
+        dst[1][x] = g * (sig / sig_orig);
+        dst[2][x] = b * (sig / sig_orig);
+    }
+}
+
+#define DEFINE_TONEMAP_ROW(name, algorithm)                                                   \
+static void tonemap_row_##name##_c(float *const dst[3], const float *const src[3],          \
+                                   const TonemapCoeffs *c, const float *lut, int width)     \
+{                                                                                           \
+    tonemap_row(dst, src, c, lut, width, algorithm);                                        \
+}
+
+DEFINE_TONEMAP_ROW(none,   TONEMAP_NONE)
+DEFINE_TONEMAP_ROW(linear, TONEMAP_LINEAR)
+DEFINE_TONEMAP_ROW(clip,   TONEMAP_CLIP)
+DEFINE_TONEMAP_ROW(lut,    TONEMAP_GAMMA)
+
+av_cold void ff_tonemap_init(TonemapContext *s)
+{
+    switch (s->tonemap) {
+    case TONEMAP_NONE:   s->tonemap_row = tonemap_row_none_c;   break;
+    case TONEMAP_LINEAR: s->tonemap_row = tonemap_row_linear_c; break;
+    case TONEMAP_CLIP:   s->tonemap_row = tonemap_row_clip_c;   break;
+    default:             s->tonemap_row = tonemap_row_lut_c;    break;
+    }
+
+    if (ARCH_X86)
+        ff_tonemap_init_x86(s);
+}
+
+int ff_tonemap_set_peak(TonemapContext *s, double peak)
+{
+    TonemapCoeffs *c = &s->row_coeffs;
+    const float j = s->param;
+    float param[4] = { 0 };
+    int i, k, ret;
+
+    switch (s->tonemap) {
+    case TONEMAP_LINEAR:
+        param[0] = s->param / peak;
+        break;
+    case TONEMAP_CLIP:
+        param[0] = s->param;
+        break;
+    case TONEMAP_REINHARD:
+        param[0] = s->param;
+        param[1] = (peak + s->param) / peak;
+        break;
+    case TONEMAP_HABLE:
+        param[0] = hable(peak);
+        break;
+    case TONEMAP_MOBIUS: {
+        const double a = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
+        const double b = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
+        param[0] = j;
+        param[1] = a;
+        param[2] = b;
+        param[3] = (b * b + 2.0f * b * j + j * j) / (b - a);
+        break;
+    }
+    }
+
+    for (i = 0; i < 8; i++) {
+        c->luma[0][i] = s->coeffs ? s->coeffs->cr : 0.0f;
+        c->luma[1][i] = s->coeffs ? s->coeffs->cg : 0.0f;
+        c->luma[2][i] = s->coeffs ? s->coeffs->cb : 0.0f;
+        c->desat[i]   = s->desat;
+        for (k = 0; k < 4; k++)
+            c->param[k][i] = param[k];
+    }
+
+    if (s->tonemap == TONEMAP_NONE || s->tonemap == TONEMAP_LINEAR ||
+        s->tonemap == TONEMAP_CLIP || (s->curve_lut && s->lut_peak == peak))
+        return 0;
+
+    ret = fill_lut(s, &s->curve_lut, tone_curve, peak);
+    if (ret < 0)
+        return ret;
+    s->lut_peak = peak;
+    return 0;
+}
+
+static void get_rgb2rgb_matrix(enum AVColorPrimaries in, enum AVColorPrimaries out,
+                               double rgb2rgb[3][3]) {
+    double rgb2xyz[3][3], xyz2rgb[3][3];
+
+    ff_fill_rgb2xyz_table(&primaries_table[out], &whitepoint_table[out], rgb2xyz);
+    ff_matrix_invert_3x3(rgb2xyz, xyz2rgb);
+    ff_fill_rgb2xyz_table(&primaries_table[in], &whitepoint_table[in], rgb2xyz);
+    ff_matrix_mul_3x3(rgb2rgb, rgb2xyz, xyz2rgb);
+}
+
+static void copy_matrix(float dst[3][3], const double src[3][3])
+{
+    int i, j;
+
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+            dst[i][j] = src[i][j];
+}
+
+/**
+ * Set up the conversion of a YUV frame to linear BT.709 RGB and back.
+ * Frames with another transfer than PQ or HLG are taken as linear light,
+ * as in the GBR path, and keep their primaries and transfer.
+ */
+static int setup_yuv(AVFilterContext *ctx, const AVFrame *in, AVFrame *out, double peak)
+{
+    TonemapContext *s = ctx->priv;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(in->format);
+    const int depth = desc->comp[0].depth;
+    enum AVColorPrimaries prim = in->color_primaries;
+    const struct LumaCoefficients *luma_src = ff_get_luma_coefficients(in->colorspace);
+    double rgb2yuv[3][3], yuv2rgb[3][3], rgb2rgb[3][3];
+    int ret;
+
+    s->linear_light = in->color_trc != AVCOL_TRC_SMPTE2084 &&
+                      in->color_trc != AVCOL_TRC_ARIB_STD_B67;
+    if (s->linear_light) {
+        if (in->color_trc == AVCOL_TRC_UNSPECIFIED) {
+            av_log(s, AV_LOG_WARNING, "Untagged transfer, assuming linear light\n");
+            out->color_trc = AVCOL_TRC_LINEAR;
+        } else if (in->color_trc != AVCOL_TRC_LINEAR)
+            av_log(s, AV_LOG_WARNING, "Tonemapping works on linear light only\n");
+    } else if (prim == AVCOL_PRI_UNSPECIFIED) {
+        av_log(s, AV_LOG_WARNING, "Untagged primaries, assuming bt2020\n");
+        prim = AVCOL_PRI_BT2020;
+    } else if (prim != AVCOL_PRI_BT2020 && prim != AVCOL_PRI_BT709) {
+        av_log(s, AV_LOG_ERROR, "Unsupported primaries '%s' for YUV input\n",
+               av_color_primaries_name(prim));
+        return AVERROR(EINVAL);
+    }
+
+    if (!luma_src) {
+        av_log(s, AV_LOG_WARNING, "Unsupported color space '%s', assuming bt2020nc\n",
+               av_color_space_name(in->colorspace));
+        luma_src = &luma_coefficients[AVCOL_SPC_BT2020_NCL];
+    }
+
+    ff_fill_rgb2yuv_table(luma_src, rgb2yuv);
+    ff_matrix_invert_3x3(rgb2yuv, yuv2rgb);
+    copy_matrix(s->yuv2rgb, yuv2rgb);
+    s->luma_src[0] = luma_src->cr;
+    s->luma_src[1] = luma_src->cg;
+    s->luma_src[2] = luma_src->cb;
+
+    if (!s->linear_light) {
+        get_rgb2rgb_matrix(prim, AVCOL_PRI_BT709, rgb2rgb);
+        copy_matrix(s->rgb2rgb, rgb2rgb);
+    }
+
+    /* the tone mapping and the output of PQ and HLG are done in BT.709 */
+    s->coeffs = s->linear_light ? luma_src : &luma_coefficients[AVCOL_SPC_BT709];
+    ff_fill_rgb2yuv_table(s->coeffs, rgb2yuv);
+    copy_matrix(s->rgb2yuv, rgb2yuv);
+
+    if (in->color_range == AVCOL_RANGE_JPEG) {
+        s->yuv_offset[0] = 0;
+        s->yuv_offset[1] = 1 << (depth - 1);
+        s->yuv_scale[0]  = s->yuv_scale[1] = (1 << depth) - 1;
+    } else {
+        s->yuv_offset[0] =  16 << (depth - 8);
+        s->yuv_offset[1] = 128 << (depth - 8);
+        s->yuv_scale[0]  = 219 << (depth - 8);
+        s->yuv_scale[1]  = 224 << (depth - 8);
+    }
+
+    if (s->linear_light)
+        return 0;
+
+    if (s->lut_trc != in->color_trc) {
+        ret = fill_lut(s, &s->linearize_lut, in->color_trc == AVCOL_TRC_SMPTE2084 ?
+                       eotf_st2084 : inverse_oetf_hlg, peak);
+        if (ret < 0)
+            return ret;
+        s->lut_trc = in->color_trc;
+    }
+    if (in->color_trc == AVCOL_TRC_ARIB_STD_B67 && (!s->ootf_lut || s->ootf_peak != peak)) {
+        ret = fill_lut(s, &s->ootf_lut, ootf_hlg_factor, peak);
+        if (ret < 0)
+            return ret;
+        s->ootf_peak = peak;
+    }
+    if (!s->delinearize_lut) {
+        ret = fill_lut(s, &s->delinearize_lut, inverse_eotf_bt1886, 1.0);
+        if (ret < 0)
+            return ret;
+    }
+
+    out->color_trc       = AVCOL_TRC_BT709;
+    out->color_primaries = AVCOL_PRI_BT709;
+    out->colorspace      = AVCOL_SPC_BT709;
+    return 0;
 }
 
 typedef struct ThreadData {
@@ -206,15 +495,160 @@ static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs
     const AVPixFmtDescriptor *desc = td->desc;
     const int slice_start = (in->height * jobnr) / nb_jobs;
     const int slice_end = (in->height * (jobnr+1)) / nb_jobs;
-    double peak = td->peak;
+    const float *src[3];
+    float *dst[3];
+
+    for (int y = slice_start; y < slice_end; y++) {
+        for (int i = 0; i < 3; i++) {
+            const int plane = desc->comp[i].plane;
+            src[i] = (const float *)(in->data[plane] + y * in->linesize[plane]);
+            dst[i] = (float *)(out->data[plane] + y * out->linesize[plane]);
+        }
+        s->tonemap_row(dst, src, &s->row_coeffs, s->curve_lut, out->width);
+    }
+
+    return 0;
+}
+
+static av_always_inline int read_sample(const AVFrame *frame, const AVComponentDescriptor *comp,
+                                        int x, int y)
+{
+    return AV_RN16(frame->data[comp->plane] + y * frame->linesize[comp->plane] +
+                   x * comp->step + comp->offset) >> comp->shift;
+}
+
+static av_always_inline void write_sample(AVFrame *frame, const AVComponentDescriptor *comp,
+                                          int x, int y, float v, float scale, float offset)
+{
+    AV_WN16(frame->data[comp->plane] + y * frame->linesize[comp->plane] +
+            x * comp->step + comp->offset,
+            av_clip_uintp2(lrintf(v * scale + offset), comp->depth) << comp->shift);
+}
+
+/* convert one row of Y'CbCr to linear BT.709 RGB */
+static void linearize_row(const TonemapContext *s, float *const rgb[3], const AVFrame *in,
+                          const AVPixFmtDescriptor *desc, int y)
+{
+    const float yscale = 1.0f / s->yuv_scale[0];
+    const float cscale = 1.0f / s->yuv_scale[1];
+    int x, i;
+
+    for (x = 0; x < in->width; x++) {
+        const float luma = (read_sample(in, &desc->comp[0], x, y) - s->yuv_offset[0]) * yscale;
+        const float cb = (read_sample(in, &desc->comp[1], x >> 1, y >> 1) - s->yuv_offset[1]) * cscale;
+        const float cr = (read_sample(in, &desc->comp[2], x >> 1, y >> 1) - s->yuv_offset[1]) * cscale;
+        float c[3];
+
+        for (i = 0; i < 3; i++) {
+            c[i] = av_clipf(s->yuv2rgb[i][0] * luma + s->yuv2rgb[i][1] * cb +
+                            s->yuv2rgb[i][2] * cr, 0.0f, 1.0f);
+            if (!s->linear_light)
+                c[i] *= lut_gain(s->linearize_lut, c[i]);
+        }
+
+        if (s->linear_light) {
+            for (i = 0; i < 3; i++)
+                rgb[i][x] = c[i];
+            continue;
+        }
+
+        if (s->lut_trc == AVCOL_TRC_ARIB_STD_B67) {
+            const float l = s->luma_src[0] * c[0] + s->luma_src[1] * c[1] + s->luma_src[2] * c[2];
+            const float factor = l * lut_gain(s->ootf_lut, l);
+            for (i = 0; i < 3; i++)
+                c[i] *= factor;
+        }
+
+        for (i = 0; i < 3; i++)
+            rgb[i][x] = s->rgb2rgb[i][0] * c[0] + s->rgb2rgb[i][1] * c[1] +
+                        s->rgb2rgb[i][2] * c[2];
+    }
+}
+
+/* convert one row of linear RGB to R'G'B' in place and write its luma,
+ * linear light input stays linear */
+static void delinearize_row(const TonemapContext *s, float *const rgb[3], AVFrame *out,
+                            const AVPixFmtDescriptor *desc, int y)
+{
+    int x, i;
+
+    for (x = 0; x < out->width; x++) {
+        for (i = 0; i < 3; i++) {
+            const float c = av_clipf(rgb[i][x], 0.0f, 1.0f);
+            rgb[i][x] = s->linear_light ? c : c * lut_gain(s->delinearize_lut, c);
+        }
+        write_sample(out, &desc->comp[0], x, y,
+                     s->rgb2yuv[0][0] * rgb[0][x] + s->rgb2yuv[0][1] * rgb[1][x] +
+                     s->rgb2yuv[0][2] * rgb[2][x], s->yuv_scale[0], s->yuv_offset[0]);
+    }
+}
+
+static int tonemap_yuv_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    TonemapContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in = td->in;
+    AVFrame *out = td->out;
+    const AVPixFmtDescriptor *desc = td->desc;
+    const int w = in->width, h = in->height;
+    const int cw = AV_CEIL_RSHIFT(w, 1);
+    const int ch = AV_CEIL_RSHIFT(h, 1);
+    const int slice_start = (ch * jobnr) / nb_jobs;
+    const int slice_end = (ch * (jobnr+1)) / nb_jobs;
+    float *buf = s->buffer + jobnr * 6 * s->buffer_stride;
+    float *rows[2][3];
+    int i, j;
+
+    for (i = 0; i < 2; i++)
+        for (j = 0; j < 3; j++)
+            rows[i][j] = buf + (i * 3 + j) * s->buffer_stride;
+
+    for (int cy = slice_start; cy < slice_end; cy++) {
+        const int nb_rows = FFMIN(2, h - 2 * cy);
+        float *const *bot = rows[nb_rows - 1];
+
+        for (i = 0; i < nb_rows; i++) {
+            linearize_row(s, rows[i], in, desc, 2 * cy + i);
+            s->tonemap_row(rows[i], (const float *const *)rows[i],
+                           &s->row_coeffs, s->curve_lut, w);
+            delinearize_row(s, rows[i], out, desc, 2 * cy + i);
+        }
 
-    for (int y = slice_start; y < slice_end; y++)
-        for (int x = 0; x < out->width; x++)
-            tonemap(s, out, in, desc, x, y, peak);
+        /* chroma of the average R'G'B' of each 2x2 block */
+        for (int cx = 0; cx < cw; cx++) {
+            const int x0 = 2 * cx, x1 = FFMIN(2 * cx + 1, w - 1);
+            float c[3];
+
+            for (i = 0; i < 3; i++)
+                c[i] = (rows[0][i][x0] + rows[0][i][x1] + bot[i][x0] + bot[i][x1]) * 0.25f;
+            for (i = 1; i < 3; i++)
+                write_sample(out, &desc->comp[i], cx, cy,
+                             s->rgb2yuv[i][0] * c[0] + s->rgb2yuv[i][1] * c[1] +
+                             s->rgb2yuv[i][2] * c[2], s->yuv_scale[1], s->yuv_offset[1]);
+        }
+    }
 
     return 0;
 }
 
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    TonemapContext *s = ctx->priv;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+
+    av_freep(&s->buffer);
+    if (desc->flags & AV_PIX_FMT_FLAG_RGB)
+        return 0;
+
+    s->buffer_stride = FFALIGN(inlink->w, 16);
+    s->buffer = av_malloc_array(ff_filter_get_nb_threads(ctx) * 6,
+                                s->buffer_stride * sizeof(*s->buffer));
+    if (!s->buffer)
+        return AVERROR(ENOMEM);
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
     AVFilterContext *ctx = link->dst;
@@ -245,6 +679,38 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         return ret;
     }
 
+    /* read peak from side data if not passed in */
+    if (!peak) {
+        peak = ff_determine_signal_peak(in);
+        av_log(s, AV_LOG_DEBUG, "Computed signal peak: %f\n", peak);
+    }
+
+    if (!(desc->flags & AV_PIX_FMT_FLAG_RGB)) {
+        /* YUV input is linearized, tone mapped and converted back to BT.709
+         * one row at a time */
+        ret = setup_yuv(ctx, in, out, peak);
+        if (ret >= 0)
+            ret = ff_tonemap_set_peak(s, peak);
+        if (ret < 0) {
+            av_frame_free(&in);
+            av_frame_free(&out);
+            return ret;
+        }
+
+        td.out = out;
+        td.in = in;
+        td.desc = desc;
+        td.peak = peak;
+        ctx->internal->execute(ctx, tonemap_yuv_slice, &td, NULL,
+                               FFMIN(AV_CEIL_RSHIFT(in->height, 1), ff_filter_get_nb_threads(ctx)));
+
+        av_frame_free(&in);
+
+        ff_update_hdr_metadata(out, s->linear_light ? peak : 1.0);
+
+        return ff_filter_frame(outlink, out);
+    }
+
     /* input and output transfer will be linear */
     if (in->color_trc == AVCOL_TRC_UNSPECIFIED) {
         av_log(s, AV_LOG_WARNING, "Untagged transfer, assuming linear light\n");
@@ -252,12 +718,6 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     } else if (in->color_trc != AVCOL_TRC_LINEAR)
         av_log(s, AV_LOG_WARNING, "Tonemapping works on linear light only\n");
 
-    /* read peak from side data if not passed in */
-    if (!peak) {
-        peak = ff_determine_signal_peak(in);
-        av_log(s, AV_LOG_DEBUG, "Computed signal peak: %f\n", peak);
-    }
-
     /* load original color space even if pixel format is RGB to compute overbrights */
     s->coeffs = &luma_coefficients[in->colorspace];
     if (s->desat > 0 && (in->colorspace == AVCOL_SPC_UNSPECIFIED || !s->coeffs)) {
@@ -270,6 +730,13 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         s->desat = 0;
     }
 
+    ret = ff_tonemap_set_peak(s, peak);
+    if (ret < 0) {
+        av_frame_free(&in);
+        av_frame_free(&out);
+        return ret;
+    }
+
     /* do the tone map */
     td.out = out;
     td.in = in;
@@ -298,6 +765,17 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     return ff_filter_frame(outlink, out);
 }
 
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    TonemapContext *s = ctx->priv;
+
+    av_freep(&s->curve_lut);
+    av_freep(&s->linearize_lut);
+    av_freep(&s->ootf_lut);
+    av_freep(&s->delinearize_lut);
+    av_freep(&s->buffer);
+}
+
 #define OFFSET(x) offsetof(TonemapContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_FILTERING_PARAM
 static const AVOption tonemap_options[] = {
@@ -321,6 +799,7 @@ static const AVFilterPad tonemap_inputs[] = {
     {
         .name         = "default",
         .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
         .filter_frame = filter_frame,
     },
     { NULL }
@@ -338,6 +817,7 @@ AVFilter ff_vf_tonemap = {
     .name            = "tonemap",
     .description     = NULL_IF_CONFIG_SMALL("Conversion to/from different dynamic ranges."),
     .init            = init,
+    .uninit          = uninit,
     .query_formats   = query_formats,
     .priv_size       = sizeof(TonemapContext),
     .priv_class      = &tonemap_class,
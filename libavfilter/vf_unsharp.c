@@ -78,8 +78,9 @@ static int name##_##nbits(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
     int src_stride = td->src_stride;                                                                  \
     const int width = td->width;                                                                      \
     const int height = td->height;                                                                    \
-    const int sc_offset = jobnr * 2 * steps_y;                                                        \
-    const int sr_offset = jobnr * (MAX_MATRIX_SIZE - 1);                                              \
+    const int slot = ff_filter_thread_slot(ctx, jobnr);                                               \
+    const int sc_offset = slot * 2 * steps_y;                                                         \
+    const int sr_offset = slot * (MAX_MATRIX_SIZE - 1);                                               \
     const int slice_start = (height * jobnr) / nb_jobs;                                               \
     const int slice_end = (height * (jobnr+1)) / nb_jobs;                                             \
                                                                                                       \
@@ -230,12 +231,12 @@ static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const
     av_log(ctx, AV_LOG_VERBOSE, "effect:%s type:%s msize_x:%d msize_y:%d amount:%0.2f\n",
            effect, effect_type, fp->msize_x, fp->msize_y, fp->amount / 65535.0);
 
-    fp->sr = av_malloc_array((MAX_MATRIX_SIZE - 1) * s->nb_threads, sizeof(uint32_t));
-    fp->sc = av_mallocz_array(2 * fp->steps_y * s->nb_threads, sizeof(uint32_t *));
+    fp->sr = av_malloc_array((MAX_MATRIX_SIZE - 1) * s->nb_slots, sizeof(uint32_t));
+    fp->sc = av_mallocz_array(2 * fp->steps_y * s->nb_slots, sizeof(uint32_t *));
     if (!fp->sr || !fp->sc)
         return AVERROR(ENOMEM);
 
-    for (z = 0; z < 2 * fp->steps_y * s->nb_threads; z++)
+    for (z = 0; z < 2 * fp->steps_y * s->nb_slots; z++)
         if (!(fp->sc[z] = av_malloc_array(width + 2 * fp->steps_x,
                                           sizeof(*(fp->sc[z])))))
             return AVERROR(ENOMEM);
@@ -259,6 +260,8 @@ static int config_input(AVFilterLink *inlink)
     // so that we don't have too much overlap between two threads
     s->nb_threads = FFMIN(ff_filter_get_nb_threads(inlink->dst),
                           inlink->h / (4 * s->luma.steps_y));
+    // frame threads need a set of scratch buffers each
+    s->nb_slots = FFMAX(s->nb_threads, ff_filter_get_nb_threads(inlink->dst));
 
     ret = init_filter_param(inlink->dst, &s->luma,   "luma",   inlink->w);
     if (ret < 0)
@@ -270,12 +273,12 @@ static int config_input(AVFilterLink *inlink)
     return 0;
 }
 
-static void free_filter_param(UnsharpFilterParam *fp, int nb_threads)
+static void free_filter_param(UnsharpFilterParam *fp, int nb_slots)
 {
     int z;
 
     if (fp->sc) {
-        for (z = 0; z < 2 * fp->steps_y * nb_threads; z++)
+        for (z = 0; z < 2 * fp->steps_y * nb_slots; z++)
             av_freep(&fp->sc[z]);
         av_freep(&fp->sc);
     }
@@ -286,8 +289,8 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     UnsharpContext *s = ctx->priv;
 
-    free_filter_param(&s->luma, s->nb_threads);
-    free_filter_param(&s->chroma, s->nb_threads);
+    free_filter_param(&s->luma, s->nb_slots);
+    free_filter_param(&s->chroma, s->nb_slots);
 }
 
 static int filter_frame(AVFilterLink *link, AVFrame *in)
@@ -366,5 +369,6 @@ AVFilter ff_vf_unsharp = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_unsharp_inputs,
     .outputs       = avfilter_vf_unsharp_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS |
+                     AVFILTER_FLAG_FRAME_THREADS,
 };
@@ -0,0 +1,402 @@
+;*****************************************************************************
+;* x86-optimized functions for lut3d filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+
+SECTION_RODATA 32
+
+ps_1:           times 8 dd 1.0
+ps_flt_max:     times 8 dd 0x7f7fffff
+ps_neg_flt_max: times 8 dd 0xff7fffff
+
+; must match LUT3DRowCoeffs in libavfilter/lut3d.h
+struc Coeffs
+    .scale:     resd 3 * 8
+    .lut_max:   resd 8
+    .in_scale:  resd 8
+    .out_scale: resd 8
+    .lutsize:   resd 8
+    .lutsize2:  resd 8
+    .lut_last:  resd 8
+    .out_max:   resd 8
+endstruc
+
+SECTION .text
+
+; The interpolation is done on 8 pixels at a time, with the same operation
+; order as the C code so that the results are bitexact. The LUT is an array
+; of struct rgbvec, so entry i starts at float index 3 * i.
+
+; %1 = dst reg number, %2 = src address, %3 = component (0 = r, 1 = g, 2 = b),
+; %4 = use the shaper tables
+; out: m%1 = LUT coordinate, clipped to [0, lut_max]; clobbers m6, m7
+%macro LOAD_COORD 4
+%if BPP == 4
+    movu            m%1, %2
+    cmpordps         m7, m%1, m%1
+    andps           m%1, m7
+    minps           m%1, [ps_flt_max]
+    maxps           m%1, [ps_neg_flt_max]
+    mulps           m%1, [cq + Coeffs.scale + %3 * mmsize]
+    minps           m%1, [cq + Coeffs.lut_max]
+    maxps           m%1, m15
+%else
+%if BPP == 1
+    pmovzxbd         m6, %2
+%else
+    pmovzxwd         m6, %2
+%endif
+%if %4
+    pcmpeqd          m7, m7
+%if %3 == 0
+    vgatherdps      m%1, [shrq + m6 * 4], m7
+%elif %3 == 1
+    vgatherdps      m%1, [shgq + m6 * 4], m7
+%else
+    vgatherdps      m%1, [shbq + m6 * 4], m7
+%endif
+%else
+    cvtdq2ps        m%1, m6
+    mulps           m%1, [cq + Coeffs.in_scale]
+    mulps           m%1, [cq + Coeffs.scale + %3 * mmsize]
+    minps           m%1, [cq + Coeffs.lut_max]
+    maxps           m%1, m15
+%endif
+%endif
+%endmacro
+
+; %1 = src reg number, %2 = dst address; clobbers m%1 and m7
+%macro STORE_COMP 2
+%if BPP == 4
+    movu             %2, m%1
+%else
+    mulps           m%1, [cq + Coeffs.out_scale]
+    cvttps2dq       m%1, m%1
+    pmaxsd          m%1, m15
+    pminsd          m%1, [cq + Coeffs.out_max]
+    vextracti128    xm7, m%1, 1
+    packusdw       xm%1, xm7
+%if BPP == 1
+    packuswb       xm%1, xm%1
+    movq             %2, xm%1
+%else
+    movu             %2, xm%1
+%endif
+%endif
+%endmacro
+
+; in: m0-m2 = r, g, b coordinates
+; out: m0-m2 = fractional parts, m3-m5 = r, g, b steps to the next entry,
+;      m6 = index of the base entry
+%macro SPLIT_COORDS 0
+    cvttps2dq        m3, m0
+    cvtdq2ps         m7, m3
+    subps            m0, m7
+    cvttps2dq        m4, m1
+    cvtdq2ps         m7, m4
+    subps            m1, m7
+    cvttps2dq        m5, m2
+    cvtdq2ps         m7, m5
+    subps            m2, m7
+
+    movu             m7, [cq + Coeffs.lutsize]
+    pmulld           m6, m3, m7
+    paddd            m6, m4
+    pmulld           m6, m7
+    paddd            m6, m5
+
+    movu             m7, [cq + Coeffs.lut_last]
+    pcmpgtd          m3, m7, m3
+    pcmpgtd          m4, m7, m4
+    pcmpgtd          m5, m7, m5
+    pand             m3, [cq + Coeffs.lutsize2]
+    pand             m4, [cq + Coeffs.lutsize]
+    psrld            m5, 31
+%endmacro
+
+; m%1 *= 3
+%macro MUL3 1
+    paddd            m7, m%1, m%1
+    paddd           m%1, m7
+%endmacro
+
+; %1 = dst reg number, %2 = index reg number, %3 = component
+; clobbers m8
+%macro GATHER 3
+    pcmpeqd          m8, m8
+    vgatherdps      m%1, [lutq + m%2 * 4 + %3 * 4], m8
+%endmacro
+
+; %1-%3 = src r, g, b addresses, %4-%6 = dst r, g, b addresses, %7 = shaper
+%macro TRILINEAR 7
+    LOAD_COORD 0, %1, 0, %7
+    LOAD_COORD 1, %2, 1, %7
+    LOAD_COORD 2, %3, 2, %7
+    SPLIT_COORDS
+    MUL3 3
+    MUL3 4
+    MUL3 5
+    MUL3 6
+
+%assign %%i 0
+%rep 3
+    ; c0 = lerp(lerp(c000, c100, r), lerp(c010, c110, r), g)
+    GATHER            9, 6, %%i
+    paddd            m7, m6, m3
+    GATHER           10, 7, %%i
+    subps           m10, m9
+    mulps           m10, m0
+    addps            m9, m10
+    paddd            m7, m6, m4
+    GATHER           10, 7, %%i
+    paddd            m7, m3
+    GATHER           11, 7, %%i
+    subps           m11, m10
+    mulps           m11, m0
+    addps           m10, m11
+    subps           m10, m9
+    mulps           m10, m1
+    addps            m9, m10
+
+    ; c1 = lerp(lerp(c001, c101, r), lerp(c011, c111, r), g)
+    paddd            m7, m6, m5
+    GATHER           10, 7, %%i
+    paddd            m7, m3
+    GATHER           11, 7, %%i
+    subps           m11, m10
+    mulps           m11, m0
+    addps           m10, m11
+    paddd            m7, m6, m4
+    paddd            m7, m5
+    GATHER           11, 7, %%i
+    paddd            m7, m3
+    GATHER           12, 7, %%i
+    subps           m12, m11
+    mulps           m12, m0
+    addps           m11, m12
+    subps           m11, m10
+    mulps           m11, m1
+    addps           m10, m11
+
+    ; lerp(c0, c1, b)
+    subps           m10, m9
+    mulps           m10, m2
+    addps            m9, m10
+%if %%i == 0
+    STORE_COMP        9, %4
+%elif %%i == 1
+    STORE_COMP        9, %5
+%else
+    STORE_COMP        9, %6
+%endif
+%assign %%i %%i+1
+%endrep
+%endmacro
+
+; accumulate the r, g, b values of one vertex into m10, m11, m14
+; %1 = index reg number, %2 = weight reg number, %3 = first vertex
+%macro TETRA_VERTEX 3
+%assign %%i 0
+%rep 3
+%if %%i == 0
+    %define %%acc m10
+%elif %%i == 1
+    %define %%acc m11
+%else
+    %define %%acc m14
+%endif
+    pcmpeqd          m2, m2
+    vgatherdps       m1, [lutq + m%1 * 4 + %%i * 4], m2
+%if %3
+    mulps        %%acc, m1, m%2
+%else
+    mulps            m1, m%2
+    addps        %%acc, m1
+%endif
+%assign %%i %%i+1
+%endrep
+%endmacro
+
+; %1-%3 = src r, g, b addresses, %4-%6 = dst r, g, b addresses, %7 = shaper
+%macro TETRAHEDRAL 7
+    LOAD_COORD 0, %1, 0, %7
+    LOAD_COORD 1, %2, 1, %7
+    LOAD_COORD 2, %3, 2, %7
+    SPLIT_COORDS
+
+    ; sort the fractional parts: m7 = max, m9 = mid, m8 = min
+    maxps            m7, m1, m2
+    maxps            m7, m0
+    minps            m8, m1, m2
+    minps            m8, m0
+    minps            m9, m0, m1
+    maxps           m10, m0, m1
+    minps           m10, m2
+    maxps            m9, m10
+
+    ; the second vertex steps along the largest component, the third one
+    ; along all but the smallest one
+    cmpeqps         m10, m0, m7
+    cmpeqps         m11, m1, m7
+    vblendvps       m12, m5, m4, m11
+    vblendvps       m12, m12, m3, m10
+    cmpeqps         m10, m0, m8
+    cmpeqps         m11, m1, m8
+    vblendvps       m13, m5, m4, m11
+    vblendvps       m13, m13, m3, m10
+    paddd            m3, m4
+    paddd            m3, m5
+    paddd            m3, m6
+    paddd           m12, m6
+    psubd           m13, m3, m13
+
+    ; weights: 1 - max, max - mid, mid - min, min
+    mova             m0, [ps_1]
+    subps            m0, m7
+    subps            m7, m9
+    subps            m9, m8
+
+    paddd            m1, m6, m6
+    paddd            m6, m1
+    paddd            m1, m12, m12
+    paddd           m12, m1
+    paddd            m1, m13, m13
+    paddd           m13, m1
+    paddd            m1, m3, m3
+    paddd            m3, m1
+
+    TETRA_VERTEX      6,  0, 1
+    TETRA_VERTEX     12,  7, 0
+    TETRA_VERTEX     13,  9, 0
+    TETRA_VERTEX      3,  8, 0
+
+    STORE_COMP       10, %4
+    STORE_COMP       11, %5
+    STORE_COMP       14, %6
+%endmacro
+
+; %1 = interpolation, %2 = use the shaper tables
+%macro LUT3D_ROWS 2
+    sub              wq, 7
+    jmp %%cond
+%%loop:
+    %1 [srcrq + xq * BPP], [srcgq + xq * BPP], [srcbq + xq * BPP], \
+       [dstrq + xq * BPP], [dstgq + xq * BPP], [dstbq + xq * BPP], %2
+    add              xq, mmsize / 4
+%%cond:
+    cmp              xq, wq
+    jl %%loop
+
+    ; the remaining pixels go through a zeroed buffer on the stack, so that
+    ; nothing is read or written past the end of the rows
+    add              wq, 7
+    sub              wq, xq
+    jz %%end
+    mova   [rsp + 0 * mmsize], m15
+    mova   [rsp + 1 * mmsize], m15
+    mova   [rsp + 2 * mmsize], m15
+    lea           srcrq, [srcrq + xq * BPP]
+    lea           srcgq, [srcgq + xq * BPP]
+    lea           srcbq, [srcbq + xq * BPP]
+    lea           dstrq, [dstrq + xq * BPP]
+    lea           dstgq, [dstgq + xq * BPP]
+    lea           dstbq, [dstbq + xq * BPP]
+    imul             wq, BPP
+    xor              xq, xq
+%%copy_in:
+    movzx          tmpd, byte [srcrq + xq]
+    mov  [rsp + 0 * mmsize + xq], tmpb
+    movzx          tmpd, byte [srcgq + xq]
+    mov  [rsp + 1 * mmsize + xq], tmpb
+    movzx          tmpd, byte [srcbq + xq]
+    mov  [rsp + 2 * mmsize + xq], tmpb
+    inc              xq
+    cmp              xq, wq
+    jl %%copy_in
+
+    %1 [rsp + 0 * mmsize], [rsp + 1 * mmsize], [rsp + 2 * mmsize], \
+       [rsp + 0 * mmsize], [rsp + 1 * mmsize], [rsp + 2 * mmsize], %2
+
+    xor              xq, xq
+%%copy_out:
+    mov            tmpb, [rsp + 0 * mmsize + xq]
+    mov  [dstrq + xq], tmpb
+    mov            tmpb, [rsp + 1 * mmsize + xq]
+    mov  [dstgq + xq], tmpb
+    mov            tmpb, [rsp + 2 * mmsize + xq]
+    mov  [dstbq + xq], tmpb
+    inc              xq
+    cmp              xq, wq
+    jl %%copy_out
+%%end:
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_lut3d_<interp>_<type>(uint8_t *const dst[3], const uint8_t *const src[3],
+;                               const struct rgbvec *lut, const float *const *shaper,
+;                               const LUT3DRowCoeffs *c, int width)
+;------------------------------------------------------------------------------
+; %1 = interpolation, %2 = 8/16/f32, %3 = interpolation macro
+%macro LUT3D_FUNC 3
+%ifidn %2, 8
+    %define BPP 1
+%elifidn %2, 16
+    %define BPP 2
+%else
+    %define BPP 4
+%endif
+; dstg and srcg point to the plane arrays on entry
+cglobal lut3d_%1_%2, 6, 14, 16, 0-3*mmsize, dstg, srcg, lut, shr, c, w, dstb, dstr, srcb, srcr, shg, shb, x, tmp
+    mov           dstbq, [dstgq + gprsize]
+    mov           dstrq, [dstgq + 2 * gprsize]
+    mov           dstgq, [dstgq]
+    mov           srcbq, [srcgq + gprsize]
+    mov           srcrq, [srcgq + 2 * gprsize]
+    mov           srcgq, [srcgq]
+    movsxdifnidn     wq, wd
+    pxor            m15, m15
+    xor              xq, xq
+%if BPP == 4
+    LUT3D_ROWS %3, 0
+%else
+    test           shrq, shrq
+    jnz .shaper
+    LUT3D_ROWS %3, 0
+.shaper:
+    mov            shgq, [shrq + gprsize]
+    mov            shbq, [shrq + 2 * gprsize]
+    mov            shrq, [shrq]
+    LUT3D_ROWS %3, 1
+%endif
+%undef BPP
+%endmacro
+
+INIT_YMM avx2
+LUT3D_FUNC trilinear,   8,   TRILINEAR
+LUT3D_FUNC trilinear,   16,  TRILINEAR
+LUT3D_FUNC trilinear,   f32, TRILINEAR
+LUT3D_FUNC tetrahedral, 8,   TETRAHEDRAL
+LUT3D_FUNC tetrahedral, 16,  TETRAHEDRAL
+LUT3D_FUNC tetrahedral, f32, TETRAHEDRAL
+
+%endif
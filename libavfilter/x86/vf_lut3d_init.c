@@ -0,0 +1,52 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/lut3d.h"
+
+#define INTERP_ROW_FUNC(name, type, opt)                                                   \
+void ff_lut3d_##name##_##type##_##opt(uint8_t *const dst[3], const uint8_t *const src[3], \
+                                      const struct rgbvec *lut, const float *const *shaper, \
+                                      const LUT3DRowCoeffs *c, int width);
+
+INTERP_ROW_FUNC(trilinear,   8,   avx2)
+INTERP_ROW_FUNC(trilinear,   16,  avx2)
+INTERP_ROW_FUNC(trilinear,   f32, avx2)
+INTERP_ROW_FUNC(tetrahedral, 8,   avx2)
+INTERP_ROW_FUNC(tetrahedral, 16,  avx2)
+INTERP_ROW_FUNC(tetrahedral, f32, avx2)
+
+av_cold void ff_lut3d_init_x86(LUT3DContext *s, const AVPixFmtDescriptor *desc)
+{
+    int cpu_flags = av_get_cpu_flags();
+    int isfloat = desc->flags & AV_PIX_FMT_FLAG_FLOAT;
+    int depth = desc->comp[0].depth;
+
+#if ARCH_X86_64
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        if (s->interpolation == INTERPOLATE_TRILINEAR)
+            s->interp_row = isfloat ? ff_lut3d_trilinear_f32_avx2 :
+                            depth > 8 ? ff_lut3d_trilinear_16_avx2 : ff_lut3d_trilinear_8_avx2;
+        else if (s->interpolation == INTERPOLATE_TETRAHEDRAL)
+            s->interp_row = isfloat ? ff_lut3d_tetrahedral_f32_avx2 :
+                            depth > 8 ? ff_lut3d_tetrahedral_16_avx2 : ff_lut3d_tetrahedral_8_avx2;
+    }
+#endif
+}
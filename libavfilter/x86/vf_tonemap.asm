@@ -0,0 +1,197 @@
+;*****************************************************************************
+;* x86-optimized functions for tonemap filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+
+SECTION_RODATA 32
+
+ps_1:        times 8 dd 1.0
+ps_1e_6:     times 8 dd 1.0e-6
+ps_hable_a:  times 8 dd 0.15
+ps_hable_b:  times 8 dd 0.50
+ps_hable_bc: times 8 dd 0.05
+ps_hable_de: times 8 dd 0.004
+ps_hable_df: times 8 dd 0.06
+ps_hable_ef: times 8 dd 0.066666667
+pd_0to7:     dd 0, 1, 2, 3, 4, 5, 6, 7
+
+; must match TonemapCoeffs in libavfilter/tonemap.h
+struc Coeffs
+    .luma:  resd 3 * 8
+    .desat: resd 8
+    .param: resd 4 * 8
+endstruc
+
+SECTION .text
+
+; The curves are evaluated directly, without the gain table of the C code.
+
+; %1 = dst, %2 = src, %3 = masked by m15
+%macro LOADU 3
+%if %3
+    vmaskmovps       %1, m15, %2
+%else
+    movu             %1, %2
+%endif
+%endmacro
+
+; %1 = dst, %2 = src, %3 = masked by m15
+%macro STOREU 3
+%if %3
+    vmaskmovps       %1, m15, %2
+%else
+    movu             %1, %2
+%endif
+%endmacro
+
+; %1 = algorithm, %2 = desaturate, %3 = masked
+; in: m14 = zero
+%macro TONEMAP 3
+    LOADU            m0, [srcrq + xq * 4], %3
+    LOADU            m1, [srcgq + xq * 4], %3
+    LOADU            m2, [srcbq + xq * 4], %3
+%if %2
+    ; overbright = max(luma - desat, 1e-6) / max(luma, 1e-6)
+    mulps            m3, m0, [cq + Coeffs.luma]
+    mulps            m4, m1, [cq + Coeffs.luma + mmsize]
+    addps            m3, m4
+    mulps            m4, m2, [cq + Coeffs.luma + 2 * mmsize]
+    addps            m3, m4
+    subps            m4, m3, [cq + Coeffs.desat]
+    maxps            m4, [ps_1e_6]
+    maxps            m5, m3, [ps_1e_6]
+    divps            m4, m5
+
+    ; x = x * (1 - overbright) + luma * overbright
+    mova             m5, [ps_1]
+    subps            m5, m4
+    mulps            m3, m4
+    mulps            m0, m5
+    addps            m0, m3
+    mulps            m1, m5
+    addps            m1, m3
+    mulps            m2, m5
+    addps            m2, m3
+%endif
+
+%ifnidn %1, none
+    ; sig = max(r, g, b, 1e-6), m4 = curve(sig)
+    maxps            m3, m0, m1
+    maxps            m3, m2
+    maxps            m3, [ps_1e_6]
+%ifidn %1, linear
+    mulps            m4, m3, [cq + Coeffs.param]
+%elifidn %1, clip
+    mulps            m4, m3, [cq + Coeffs.param]
+    minps            m4, [ps_1]
+    maxps            m4, m14
+%elifidn %1, reinhard
+    addps            m5, m3, [cq + Coeffs.param]
+    divps            m4, m3, m5
+    mulps            m4, [cq + Coeffs.param + mmsize]
+%elifidn %1, hable
+    mulps            m5, m3, [ps_hable_a]
+    addps            m4, m5, [ps_hable_bc]
+    mulps            m4, m3
+    addps            m4, [ps_hable_de]
+    addps            m5, [ps_hable_b]
+    mulps            m5, m3
+    addps            m5, [ps_hable_df]
+    divps            m4, m5
+    subps            m4, [ps_hable_ef]
+    divps            m4, [cq + Coeffs.param]
+%elifidn %1, mobius
+    addps            m4, m3, [cq + Coeffs.param + mmsize]
+    mulps            m4, [cq + Coeffs.param + 3 * mmsize]
+    addps            m5, m3, [cq + Coeffs.param + 2 * mmsize]
+    divps            m4, m5
+    cmpleps          m5, m3, [cq + Coeffs.param]
+    vblendvps        m4, m4, m3, m5
+%endif
+
+    ; scale the color linearly by curve(sig) / sig
+    divps            m4, m3
+    mulps            m0, m4
+    mulps            m1, m4
+    mulps            m2, m4
+%endif
+    STOREU [dstrq + xq * 4], m0, %3
+    STOREU [dstgq + xq * 4], m1, %3
+    STOREU [dstbq + xq * 4], m2, %3
+%endmacro
+
+; %1 = algorithm, %2 = desaturate
+%macro TONEMAP_ROW 2
+    sub              wq, 7
+    jmp %%cond
+%%loop:
+    TONEMAP          %1, %2, 0
+    add              xq, mmsize / 4
+%%cond:
+    cmp              xq, wq
+    jl %%loop
+
+    ; the last pixels are loaded and stored through a mask, so that nothing
+    ; is accessed past the end of the rows
+    add              wq, 7
+    sub              wq, xq
+    jz %%end
+    movd           xm15, wd
+    vpbroadcastd    m15, xm15
+    pcmpgtd         m15, [pd_0to7]
+    TONEMAP          %1, %2, 1
+%%end:
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_tonemap_<algorithm>(float *const dst[3], const float *const src[3],
+;                             const TonemapCoeffs *c, const float *lut, int width)
+;------------------------------------------------------------------------------
+%macro TONEMAP_FUNC 1
+; dstr and srcr point to the row arrays on entry
+cglobal tonemap_%1, 5, 10, 16, dstr, srcr, c, lut, w, dstg, dstb, srcg, srcb, x
+    mov           dstgq, [dstrq + gprsize]
+    mov           dstbq, [dstrq + 2 * gprsize]
+    mov           dstrq, [dstrq]
+    mov           srcgq, [srcrq + gprsize]
+    mov           srcbq, [srcrq + 2 * gprsize]
+    mov           srcrq, [srcrq]
+    movsxdifnidn     wq, wd
+    pxor            m14, m14
+    xor              xq, xq
+    cmp dword [cq + Coeffs.desat], 0
+    je .no_desat
+    TONEMAP_ROW      %1, 1
+.no_desat:
+    TONEMAP_ROW      %1, 0
+%endmacro
+
+INIT_YMM avx2
+TONEMAP_FUNC none
+TONEMAP_FUNC linear
+TONEMAP_FUNC clip
+TONEMAP_FUNC reinhard
+TONEMAP_FUNC hable
+TONEMAP_FUNC mobius
+
+%endif
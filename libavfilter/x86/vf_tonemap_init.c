@@ -0,0 +1,51 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/tonemap.h"
+
+#define TONEMAP_ROW_FUNC(name, opt)                                                     \
+void ff_tonemap_##name##_##opt(float *const dst[3], const float *const src[3],        \
+                               const TonemapCoeffs *c, const float *lut, int width);
+
+TONEMAP_ROW_FUNC(none,     avx2)
+TONEMAP_ROW_FUNC(linear,   avx2)
+TONEMAP_ROW_FUNC(clip,     avx2)
+TONEMAP_ROW_FUNC(reinhard, avx2)
+TONEMAP_ROW_FUNC(hable,    avx2)
+TONEMAP_ROW_FUNC(mobius,   avx2)
+
+av_cold void ff_tonemap_init_x86(TonemapContext *s)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+#if ARCH_X86_64
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        switch (s->tonemap) {
+        case TONEMAP_NONE:     s->tonemap_row = ff_tonemap_none_avx2;     break;
+        case TONEMAP_LINEAR:   s->tonemap_row = ff_tonemap_linear_avx2;   break;
+        case TONEMAP_CLIP:     s->tonemap_row = ff_tonemap_clip_avx2;     break;
+        case TONEMAP_REINHARD: s->tonemap_row = ff_tonemap_reinhard_avx2; break;
+        case TONEMAP_HABLE:    s->tonemap_row = ff_tonemap_hable_avx2;    break;
+        case TONEMAP_MOBIUS:   s->tonemap_row = ff_tonemap_mobius_avx2;   break;
+        }
+    }
+#endif
+}
@@ -648,6 +648,14 @@ int ffurl_get_short_seek(URLContext *h)
     return h->prot->url_get_short_seek(h);
 }
 
+int ffurl_get_mapped_buffer(URLContext *h, int64_t pos, int size,
+                            AVBufferRef **buf)
+{
+    if (!h || !h->prot || !h->prot->url_get_mapped_buffer)
+        return AVERROR(ENOSYS);
+    return h->prot->url_get_mapped_buffer(h, pos, size, buf);
+}
+
 int ffurl_shutdown(URLContext *h, int flags)
 {
     if (!h || !h->prot || !h->prot->url_shutdown)
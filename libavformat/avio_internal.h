@@ -156,6 +156,15 @@ int ffio_fdopen(AVIOContext **s, URLContext *h);
  */
 URLContext *ffio_geturlcontext(AVIOContext *s);
 
+/**
+ * Read size bytes as a reference to the data of the underlying protocol,
+ * without copying them, if it supports it (see ffurl_get_mapped_buffer()).
+ *
+ * @return size on success, AVERROR(ENOSYS) if the data has to be read with
+ *         avio_read(), or another negative error code
+ */
+int ffio_read_mapped_buffer(AVIOContext *s, int size, AVBufferRef **buf);
+
 /**
  * Open a write-only fake memory stream. The written data is not stored
  * anywhere - this is only used for measuring the amount of data
@@ -987,6 +987,24 @@ URLContext* ffio_geturlcontext(AVIOContext *s)
         return NULL;
 }
 
+int ffio_read_mapped_buffer(AVIOContext *s, int size, AVBufferRef **buf)
+{
+    URLContext *h = ffio_geturlcontext(s);
+    int64_t ret;
+
+    if (!h || s->write_flag || s->update_checksum)
+        return AVERROR(ENOSYS);
+
+    ret = ffurl_get_mapped_buffer(h, avio_tell(s), size, buf);
+    if (ret < 0)
+        return ret;
+    if ((ret = avio_skip(s, size)) < 0) {
+        av_buffer_unref(buf);
+        return ret;
+    }
+    return size;
+}
+
 static void update_checksum(AVIOContext *s)
 {
     if (s->update_checksum && s->buf_ptr > s->checksum_ptr) {
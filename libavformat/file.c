@@ -19,6 +19,9 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#define _DEFAULT_SOURCE
+#define _SVID_SOURCE // needed for MAP_ANONYMOUS
+#define _DARWIN_C_SOURCE // needed for MAP_ANON
 #include "libavutil/avstring.h"
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
@@ -30,6 +33,12 @@
 #if HAVE_IO_H
 #include <io.h>
 #endif
+#if HAVE_MMAP
+#include <sys/mman.h>
+#if defined(MAP_ANON) && !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
 #if HAVE_UNISTD_H
 #include <unistd.h>
 #endif
@@ -74,6 +83,9 @@ typedef struct FileContext {
     int blocksize;
     int follow;
     int seekable;
+    int use_mmap;
+    AVBufferRef *map;
+    int64_t map_size;
 #if HAVE_DIRENT_H
     DIR *dir;
 #endif
@@ -84,6 +96,7 @@ static const AVOption file_options[] = {
     { "blocksize", "set I/O operation maximum block size", offsetof(FileContext, blocksize), AV_OPT_TYPE_INT, { .i64 = INT_MAX }, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
     { "follow", "Follow a file as it is being written", offsetof(FileContext, follow), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { "seekable", "Sets if the file is seekable", offsetof(FileContext, seekable), AV_OPT_TYPE_INT, { .i64 = -1 }, -1, 0, AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_ENCODING_PARAM },
+    { "mmap", "Return packets pointing into a memory mapping of the file", offsetof(FileContext, use_mmap), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { NULL }
 };
 
@@ -205,6 +218,100 @@ static int file_move(URLContext *h_src, URLContext *h_dst)
 
 #if CONFIG_FILE_PROTOCOL
 
+#if HAVE_MMAP
+typedef struct FileMapping {
+    uint8_t *addr;
+    size_t size;
+} FileMapping;
+
+static void file_unmap(void *opaque, uint8_t *data)
+{
+    FileMapping *m = (FileMapping *)data;
+    munmap(m->addr, m->size);
+    av_free(m);
+}
+
+static void file_unref_mapping(void *opaque, uint8_t *data)
+{
+    AVBufferRef *map = opaque;
+    av_buffer_unref(&map);
+}
+
+/**
+ * Map the whole file privately, so that the packets referencing it can be
+ * modified in place without affecting the file or each other.
+ *
+ * The file is mapped over an anonymous mapping AV_INPUT_BUFFER_PADDING_SIZE
+ * bytes larger, so that the mapping ends with at least that many zeros
+ * whatever the file size. Every packet can then reference the mapping, its
+ * padding being the file data that follows it, and a bitstream reader
+ * running past it stops at the zeros instead of leaving the mapping.
+ */
+static int file_map(URLContext *h, int64_t size)
+{
+#ifdef MAP_ANONYMOUS
+    FileContext *c = h->priv_data;
+    const size_t map_size = size + AV_INPUT_BUFFER_PADDING_SIZE;
+    FileMapping *m;
+    void *addr;
+
+    if (size <= 0 || size > SIZE_MAX - AV_INPUT_BUFFER_PADDING_SIZE)
+        return AVERROR(EINVAL);
+    addr = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+        return AVERROR(errno);
+    if (mmap(addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+             c->fd, 0) == MAP_FAILED) {
+        int err = AVERROR(errno);
+        munmap(addr, map_size);
+        return err;
+    }
+
+    m = av_mallocz(sizeof(*m));
+    if (m) {
+        m->addr = addr;
+        m->size = map_size;
+        c->map  = av_buffer_create((uint8_t *)m, sizeof(*m), file_unmap, NULL, 0);
+    }
+    if (!c->map) {
+        av_free(m);
+        munmap(addr, map_size);
+        return AVERROR(ENOMEM);
+    }
+    c->map_size = size;
+    return 0;
+#else
+    return AVERROR(ENOSYS);
+#endif
+}
+
+static int file_get_mapped_buffer(URLContext *h, int64_t pos, int size,
+                                  AVBufferRef **buf)
+{
+    FileContext *c = h->priv_data;
+    const FileMapping *m;
+    AVBufferRef *map;
+
+    if (!c->map)
+        return AVERROR(ENOSYS);
+    if (pos < 0 || size <= 0 || pos > c->map_size - size)
+        return AVERROR(EINVAL);
+    m = (const FileMapping *)c->map->data;
+
+    map = av_buffer_ref(c->map);
+    if (!map)
+        return AVERROR(ENOMEM);
+    *buf = av_buffer_create(m->addr + pos, size + AV_INPUT_BUFFER_PADDING_SIZE,
+                            file_unref_mapping, map, AV_BUFFER_FLAG_READONLY);
+    if (!*buf) {
+        av_buffer_unref(&map);
+        return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+#endif
+
 static int file_open(URLContext *h, const char *filename, int flags)
 {
     FileContext *c = h->priv_data;
@@ -243,6 +350,15 @@ static int file_open(URLContext *h, const char *filename, int flags)
     if (c->seekable >= 0)
         h->is_streamed = !c->seekable;
 
+#if HAVE_MMAP
+    if (c->use_mmap && !(flags & AVIO_FLAG_WRITE) && !c->follow &&
+        !fstat(fd, &st) && S_ISREG(st.st_mode)) {
+        int ret = file_map(h, st.st_size);
+        if (ret < 0)
+            av_log(h, AV_LOG_VERBOSE, "Cannot map the file: %s\n", av_err2str(ret));
+    }
+#endif
+
     return 0;
 }
 
@@ -266,6 +382,7 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
 static int file_close(URLContext *h)
 {
     FileContext *c = h->priv_data;
+    av_buffer_unref(&c->map);
     return close(c->fd);
 }
 
@@ -361,6 +478,9 @@ const URLProtocol ff_file_protocol = {
     .url_seek            = file_seek,
     .url_close           = file_close,
     .url_get_file_handle = file_get_handle,
+#if HAVE_MMAP
+    .url_get_mapped_buffer = file_get_mapped_buffer,
+#endif
     .url_check           = file_check,
     .url_delete          = file_delete,
     .url_move            = file_move,
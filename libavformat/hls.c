@@ -33,6 +33,7 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/dict.h"
+#include "libavutil/thread.h"
 #include "libavutil/time.h"
 #include "avformat.h"
 #include "internal.h"
@@ -40,6 +41,8 @@
 #include "id3v2.h"
 
 #define INITIAL_BUFFER_SIZE 32768
+#define PREFETCH_CHUNK_SIZE 65536
+#define PREFETCH_POLL_INTERVAL 100000 /* microseconds between interrupt checks */
 
 #define MAX_FIELD_LEN 64
 #define MAX_CHARACTERISTICS_LEN 512
@@ -79,6 +82,51 @@ struct segment {
 
 struct rendition;
 
+#if HAVE_THREADS
+enum PrefetchState {
+    PREFETCH_QUEUED,
+    PREFETCH_RUNNING,
+    PREFETCH_DONE
+};
+
+/*
+ * A segment downloaded ahead of playback by the prefetch workers. The
+ * fields below are protected by the pool mutex, except the URL and options
+ * which are only changed while the segment is not running.
+ */
+struct prefetch_segment {
+    struct prefetch_pool *pool;
+    int64_t seq_no; /* -1 if the slot is unused */
+    enum PrefetchState state;
+    int abort;
+    char *url;
+    AVDictionary *opts;
+    int64_t url_offset;
+    int64_t size;
+    int seek;
+    uint8_t *buf;
+    unsigned int buf_size;
+    unsigned int data_len;
+    unsigned int read_offset;
+    int error; /* result of the download once done */
+    char *cookies; /* set by the HTTP response, passed on to the next requests */
+};
+
+struct prefetch_pool {
+    AVFormatContext *parent;
+    pthread_t *threads;
+    int nb_threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    struct prefetch_segment *segments;
+    int nb_segments;
+    int64_t cur_seq_no; /* segment being read, not limited by max_bytes */
+    int64_t bytes;
+    int64_t max_bytes;
+    int abort;
+};
+#endif
+
 enum PlaylistType {
     PLS_TYPE_UNSPECIFIED,
     PLS_TYPE_EVENT,
@@ -98,6 +146,8 @@ struct playlist {
     int input_read_done;
     AVIOContext *input_next;
     int input_next_requested;
+    struct prefetch_pool *prefetch;
+    struct prefetch_segment *prefetch_seg; /* prefetched data being read */
     AVFormatContext *parent;
     int index;
     AVFormatContext *ctx;
@@ -212,6 +262,8 @@ typedef struct HLSContext {
     int http_persistent;
     int http_multiple;
     int http_seekable;
+    int prefetch_segments;
+    int64_t prefetch_bytes;
     AVIOContext *playlist_pb;
 } HLSContext;
 
@@ -243,6 +295,242 @@ static void free_init_section_list(struct playlist *pls)
     pls->n_init_sections = 0;
 }
 
+#if HAVE_THREADS
+static void prefetch_segment_reset(struct prefetch_pool *pool,
+                                   struct prefetch_segment *ps)
+{
+    pool->bytes -= ps->data_len;
+    av_freep(&ps->buf);
+    av_freep(&ps->url);
+    av_dict_free(&ps->opts);
+    av_freep(&ps->cookies);
+    ps->buf_size    = 0;
+    ps->data_len    = 0;
+    ps->read_offset = 0;
+    ps->error       = 0;
+    ps->abort       = 0;
+    ps->seq_no      = -1;
+}
+
+static int prefetch_check_interrupt(struct prefetch_segment *ps)
+{
+    return ps->abort || ps->pool->abort ||
+           ff_check_interrupt(&ps->pool->parent->interrupt_callback);
+}
+
+/**
+ * Wait for a change of the pool state, with the pool mutex locked. The wait
+ * is bounded, so that the caller gets to check its interrupt callback even
+ * if nothing signals the pool.
+ */
+static void prefetch_wait(struct prefetch_pool *pool)
+{
+    /* FIXME: using the monotonic clock would be better,
+       but it does not exist on all supported platforms. */
+    int64_t t = av_gettime() + PREFETCH_POLL_INTERVAL;
+    struct timespec tv = { .tv_sec  =  t / 1000000,
+                           .tv_nsec = (t % 1000000) * 1000 };
+    pthread_cond_timedwait(&pool->cond, &pool->mutex, &tv);
+}
+
+static int prefetch_download(struct prefetch_pool *pool, struct prefetch_segment *ps)
+{
+    AVFormatContext *s = pool->parent;
+    AVDictionary *opts = NULL;
+    AVIOContext *pb = NULL;
+    char *cookies = NULL;
+    int64_t remaining = ps->size >= 0 ? ps->size : INT64_MAX;
+    uint8_t *chunk;
+    int ret;
+
+    av_dict_copy(&opts, ps->opts, 0);
+    ret = s->io_open(s, &pb, ps->url, AVIO_FLAG_READ, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+        return ret;
+
+    /* the reader passes the cookies on once it gets to this segment,
+     * as open_url() does */
+    if (!(s->flags & AVFMT_FLAG_CUSTOM_IO))
+        av_opt_get(pb, "cookies", AV_OPT_SEARCH_CHILDREN, (uint8_t**)&cookies);
+    if (cookies) {
+        pthread_mutex_lock(&pool->mutex);
+        ps->cookies = cookies;
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    if (ps->seek && (ret = avio_seek(pb, ps->url_offset, SEEK_SET)) < 0)
+        goto end;
+
+    chunk = av_malloc(PREFETCH_CHUNK_SIZE);
+    if (!chunk) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    while (remaining > 0) {
+        /* the segment being read is never held back by the memory limit */
+        pthread_mutex_lock(&pool->mutex);
+        while (!prefetch_check_interrupt(ps) && ps->seq_no != pool->cur_seq_no &&
+               pool->bytes >= pool->max_bytes)
+            prefetch_wait(pool);
+        ret = prefetch_check_interrupt(ps);
+        pthread_mutex_unlock(&pool->mutex);
+
+        if (ret) {
+            ret = AVERROR_EXIT;
+            break;
+        }
+
+        ret = avio_read(pb, chunk, FFMIN(remaining, PREFETCH_CHUNK_SIZE));
+        if (ret <= 0) {
+            if (ret == AVERROR_EOF)
+                ret = 0;
+            break;
+        }
+        remaining -= ret;
+
+        pthread_mutex_lock(&pool->mutex);
+        if (ps->data_len + (int64_t)ret > UINT_MAX - AV_INPUT_BUFFER_PADDING_SIZE) {
+            ret = AVERROR(ENOMEM);
+        } else {
+            uint8_t *buf = av_fast_realloc(ps->buf, &ps->buf_size, ps->data_len + ret);
+            if (buf) {
+                ps->buf = buf;
+                memcpy(ps->buf + ps->data_len, chunk, ret);
+                ps->data_len += ret;
+                pool->bytes  += ret;
+                pthread_cond_broadcast(&pool->cond);
+            } else {
+                ret = AVERROR(ENOMEM);
+            }
+        }
+        pthread_mutex_unlock(&pool->mutex);
+        if (ret < 0)
+            break;
+        ret = 0;
+    }
+    av_free(chunk);
+
+end:
+    ff_format_io_close(s, &pb);
+    return ret;
+}
+
+static void *prefetch_worker(void *arg)
+{
+    struct prefetch_pool *pool = arg;
+    int i;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (!pool->abort) {
+        struct prefetch_segment *ps = NULL;
+        int ret;
+
+        /* download the queued segments in playback order */
+        for (i = 0; i < pool->nb_segments; i++) {
+            struct prefetch_segment *cur = &pool->segments[i];
+            if (cur->seq_no >= 0 && cur->state == PREFETCH_QUEUED &&
+                (!ps || cur->seq_no < ps->seq_no))
+                ps = cur;
+        }
+        /* nothing is started while the demuxer is being interrupted */
+        if (!ps || ff_check_interrupt(&pool->parent->interrupt_callback)) {
+            prefetch_wait(pool);
+            continue;
+        }
+
+        ps->state = PREFETCH_RUNNING;
+        pthread_mutex_unlock(&pool->mutex);
+
+        ret = prefetch_download(pool, ps);
+
+        pthread_mutex_lock(&pool->mutex);
+        ps->state = PREFETCH_DONE;
+        ps->error = ret;
+        if (ps->abort)
+            prefetch_segment_reset(pool, ps);
+        pthread_cond_broadcast(&pool->cond);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+static void prefetch_free(struct playlist *pls)
+{
+    struct prefetch_pool *pool = pls->prefetch;
+    int i;
+
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->abort = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (i = 0; i < pool->nb_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+    for (i = 0; i < pool->nb_segments; i++)
+        prefetch_segment_reset(pool, &pool->segments[i]);
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->mutex);
+    av_freep(&pool->threads);
+    av_freep(&pool->segments);
+    av_freep(&pls->prefetch);
+    pls->prefetch_seg = NULL;
+}
+
+static int prefetch_init(HLSContext *c, struct playlist *pls)
+{
+    struct prefetch_pool *pool;
+    int i, ret;
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return AVERROR(ENOMEM);
+    pool->parent      = pls->parent;
+    pool->max_bytes   = c->prefetch_bytes;
+    pool->cur_seq_no  = -1;
+    pool->nb_segments = 2 * c->prefetch_segments + 1;
+    pool->segments    = av_calloc(pool->nb_segments, sizeof(*pool->segments));
+    pool->threads     = av_calloc(c->prefetch_segments, sizeof(*pool->threads));
+    if (!pool->segments || !pool->threads) {
+        av_freep(&pool->segments);
+        av_freep(&pool->threads);
+        av_free(pool);
+        return AVERROR(ENOMEM);
+    }
+    for (i = 0; i < pool->nb_segments; i++) {
+        pool->segments[i].pool   = pool;
+        pool->segments[i].seq_no = -1;
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    pls->prefetch = pool;
+
+    for (i = 0; i < c->prefetch_segments; i++) {
+        ret = pthread_create(&pool->threads[i], NULL, prefetch_worker, pool);
+        if (ret) {
+            av_log(pls->parent, AV_LOG_ERROR, "Failed to create prefetch thread: %s\n",
+                   av_err2str(AVERROR(ret)));
+            prefetch_free(pls);
+            return AVERROR(ret);
+        }
+        pool->nb_threads++;
+    }
+
+    return 0;
+}
+#else
+static void prefetch_free(struct playlist *pls)
+{
+}
+#endif
+
 static void free_playlist_list(HLSContext *c)
 {
     int i;
@@ -262,6 +550,7 @@ static void free_playlist_list(HLSContext *c)
         pls->input_read_done = 0;
         ff_format_io_close(c->ctx, &pls->input_next);
         pls->input_next_requested = 0;
+        prefetch_free(pls);
         if (pls->ctx) {
             pls->ctx->pb = NULL;
             avformat_close_input(&pls->ctx);
@@ -621,14 +910,10 @@ static int open_url_keepalive(AVFormatContext *s, AVIOContext **pb,
 #endif
 }
 
-static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
-                    AVDictionary **opts, AVDictionary *opts2, int *is_http_out)
+static int check_url(AVFormatContext *s, const char *url, int *is_http)
 {
     HLSContext *c = s->priv_data;
-    AVDictionary *tmp = NULL;
     const char *proto_name = NULL;
-    int ret;
-    int is_http = 0;
 
     if (av_strstart(url, "crypto", NULL)) {
         if (url[6] == '+' || url[6] == ':')
@@ -654,7 +939,7 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
             return AVERROR_INVALIDDATA;
         }
     } else if (av_strstart(proto_name, "http", NULL)) {
-        is_http = 1;
+        *is_http = 1;
     } else if (av_strstart(proto_name, "data", NULL)) {
         ;
     } else
@@ -669,6 +954,20 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
     else if (strcmp(proto_name, "file") || !strncmp(url, "file,", 5))
         return AVERROR_INVALIDDATA;
 
+    return 0;
+}
+
+static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
+                    AVDictionary **opts, AVDictionary *opts2, int *is_http_out)
+{
+    HLSContext *c = s->priv_data;
+    AVDictionary *tmp = NULL;
+    int ret;
+    int is_http = 0;
+
+    if ((ret = check_url(s, url, &is_http)) < 0)
+        return ret;
+
     av_dict_copy(&tmp, *opts, 0);
     av_dict_copy(&tmp, opts2, 0);
 
@@ -1313,6 +1612,182 @@ cleanup:
     return ret;
 }
 
+#if HAVE_THREADS
+/* Queue the segments following the current one and drop the others. */
+static void prefetch_schedule(HLSContext *c, struct playlist *pls)
+{
+    struct prefetch_pool *pool;
+    int64_t seq_no, last_seq_no;
+    int i;
+
+    if (!pls->prefetch && prefetch_init(c, pls) < 0) {
+        av_log(pls->parent, AV_LOG_WARNING,
+               "Prefetching disabled for playlist %d\n", pls->index);
+        c->prefetch_segments = 0;
+        return;
+    }
+    pool = pls->prefetch;
+    last_seq_no = FFMIN(pls->cur_seq_no + c->prefetch_segments,
+                        pls->start_seq_no + pls->n_segments - 1);
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->cur_seq_no = pls->cur_seq_no;
+
+    for (i = 0; i < pool->nb_segments; i++) {
+        struct prefetch_segment *ps = &pool->segments[i];
+        if (ps->seq_no < 0 || ps == pls->prefetch_seg ||
+            (ps->seq_no >= pls->cur_seq_no && ps->seq_no <= last_seq_no))
+            continue;
+        if (ps->state == PREFETCH_RUNNING)
+            ps->abort = 1;
+        else
+            prefetch_segment_reset(pool, ps);
+    }
+
+    for (seq_no = pls->cur_seq_no + 1; seq_no <= last_seq_no; seq_no++) {
+        struct segment *seg = pls->segments[seq_no - pls->start_seq_no];
+        struct prefetch_segment *ps = NULL;
+        int is_http = 0;
+
+        if (seg->key_type != KEY_NONE || check_url(pls->parent, seg->url, &is_http) < 0)
+            continue;
+
+        for (i = 0; i < pool->nb_segments; i++) {
+            struct prefetch_segment *cur = &pool->segments[i];
+            if (cur->seq_no == seq_no && !cur->abort)
+                break;
+            if (cur->seq_no < 0 && !ps)
+                ps = cur;
+        }
+        if (i < pool->nb_segments)
+            continue;
+        if (!ps)
+            break;
+
+        ps->url = av_strdup(seg->url);
+        if (!ps->url || av_dict_copy(&ps->opts, c->avio_opts, 0) < 0) {
+            prefetch_segment_reset(pool, ps);
+            break;
+        }
+        if (seg->size >= 0) {
+            av_dict_set_int(&ps->opts, "offset", seg->url_offset, 0);
+            av_dict_set_int(&ps->opts, "end_offset", seg->url_offset + seg->size, 0);
+        }
+        ps->url_offset = seg->url_offset;
+        ps->size       = seg->size;
+        ps->seek       = !is_http && seg->url_offset;
+        ps->seq_no     = seq_no;
+        ps->state      = PREFETCH_QUEUED;
+        av_log(pls->parent, AV_LOG_VERBOSE, "HLS prefetch of url '%s', offset %"PRId64", playlist %d\n",
+               seg->url, seg->url_offset, pls->index);
+    }
+
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/* Return the prefetched data of the current segment once it is available. */
+static struct prefetch_segment *prefetch_get(HLSContext *c, struct playlist *pls)
+{
+    struct prefetch_pool *pool = pls->prefetch;
+    struct prefetch_segment *ps = NULL;
+    int i;
+
+    if (!pool)
+        return NULL;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (i = 0; i < pool->nb_segments; i++) {
+        if (pool->segments[i].seq_no == pls->cur_seq_no && !pool->segments[i].abort) {
+            ps = &pool->segments[i];
+            break;
+        }
+    }
+    while (ps && ps->state != PREFETCH_DONE && !ps->data_len) {
+        if (ff_check_interrupt(c->interrupt_callback)) {
+            ps = NULL;
+            break;
+        }
+        prefetch_wait(pool);
+    }
+    if (ps && ps->state == PREFETCH_DONE && ps->error < 0 && !ps->data_len) {
+        av_log(pls->parent, AV_LOG_WARNING, "Prefetch of segment %"PRId64" of playlist %d failed: %s\n",
+               ps->seq_no, pls->index, av_err2str(ps->error));
+        prefetch_segment_reset(pool, ps);
+        ps = NULL;
+    }
+    if (ps && ps->cookies) {
+        av_dict_set(&c->avio_opts, "cookies", ps->cookies, AV_DICT_DONT_STRDUP_VAL);
+        ps->cookies = NULL;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return ps;
+}
+
+static int prefetch_read(HLSContext *c, struct playlist *pls, uint8_t *buf, int buf_size)
+{
+    struct prefetch_pool *pool = pls->prefetch;
+    struct prefetch_segment *ps = pls->prefetch_seg;
+    int ret;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (ps->read_offset == ps->data_len && ps->state != PREFETCH_DONE) {
+        if (ff_check_interrupt(c->interrupt_callback)) {
+            pthread_mutex_unlock(&pool->mutex);
+            return AVERROR_EXIT;
+        }
+        prefetch_wait(pool);
+    }
+    if (ps->read_offset < ps->data_len) {
+        ret = FFMIN(buf_size, ps->data_len - ps->read_offset);
+        memcpy(buf, ps->buf + ps->read_offset, ret);
+        ps->read_offset += ret;
+    } else {
+        ret = ps->error < 0 ? ps->error : AVERROR_EOF;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return ret;
+}
+
+static void prefetch_release(struct playlist *pls)
+{
+    struct prefetch_pool *pool = pls->prefetch;
+    struct prefetch_segment *ps = pls->prefetch_seg;
+
+    if (!ps)
+        return;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (ps->state == PREFETCH_RUNNING)
+        ps->abort = 1;
+    else
+        prefetch_segment_reset(pool, ps);
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+    pls->prefetch_seg = NULL;
+}
+#else
+static void prefetch_schedule(HLSContext *c, struct playlist *pls)
+{
+}
+
+static struct prefetch_segment *prefetch_get(HLSContext *c, struct playlist *pls)
+{
+    return NULL;
+}
+
+static int prefetch_read(HLSContext *c, struct playlist *pls, uint8_t *buf, int buf_size)
+{
+    return AVERROR(ENOSYS);
+}
+
+static void prefetch_release(struct playlist *pls)
+{
+}
+#endif
+
 static int update_init_section(struct playlist *pls, struct segment *seg)
 {
     static const int max_init_section_size = 1024*1024;
@@ -1436,7 +1911,7 @@ restart:
     if (!v->needed)
         return AVERROR_EOF;
 
-    if (!v->input || (c->http_persistent && v->input_read_done)) {
+    if ((!v->input && !v->prefetch_seg) || (c->http_persistent && v->input_read_done)) {
         int64_t reload_interval;
 
         /* Check that the playlist is still needed before opening a new
@@ -1507,7 +1982,14 @@ reload:
         if (ret)
             return ret;
 
-        if (c->http_multiple == 1 && v->input_next_requested) {
+        if (c->prefetch_segments) {
+            prefetch_schedule(c, v);
+            v->prefetch_seg = prefetch_get(c, v);
+        }
+
+        if (v->prefetch_seg) {
+            ret = 0;
+        } else if (c->http_multiple == 1 && v->input_next_requested) {
             FFSWAP(AVIOContext *, v->input, v->input_next);
             v->cur_seg_offset = 0;
             v->input_next_requested = 0;
@@ -1560,7 +2042,10 @@ reload:
     }
 
     seg = current_segment(v);
-    ret = read_from_url(v, seg, buf, buf_size);
+    if (v->prefetch_seg)
+        ret = prefetch_read(c, v, buf, buf_size);
+    else
+        ret = read_from_url(v, seg, buf, buf_size);
     if (ret > 0) {
         if (just_opened && v->is_id3_timestamped != 0) {
             /* Intercept ID3 tags here, elementary audio streams are required
@@ -1570,7 +2055,11 @@ reload:
 
         return ret;
     }
-    if (c->http_persistent &&
+    if (v->prefetch_seg) {
+        prefetch_release(v);
+        /* a persistent connection left open is reused for the next segment */
+        v->input_read_done = 1;
+    } else if (c->http_persistent &&
         seg->key_type == KEY_NONE && av_strstart(seg->url, "http", NULL)) {
         v->input_read_done = 1;
     } else {
@@ -1876,6 +2365,16 @@ static int hls_read_header(AVFormatContext *s)
        the range header */
     av_dict_set_int(&c->avio_opts, "seekable", c->http_seekable, 0);
 
+    if (c->prefetch_segments) {
+        if (!HAVE_THREADS) {
+            av_log(s, AV_LOG_WARNING, "Segment prefetching requires threads, disabling it\n");
+            c->prefetch_segments = 0;
+        } else {
+            /* the prefetch workers supersede the next segment request */
+            c->http_multiple = 0;
+        }
+    }
+
     if ((ret = parse_playlist(c, s->url, NULL, s->pb)) < 0)
         goto fail;
 
@@ -2338,6 +2837,7 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
         pls->input_read_done = 0;
         ff_format_io_close(pls->parent, &pls->input_next);
         pls->input_next_requested = 0;
+        prefetch_release(pls);
         av_packet_unref(pls->pkt);
         pls->pb.eof_reached = 0;
         /* Clear any buffered data */
@@ -2399,6 +2899,10 @@ static const AVOption hls_options[] = {
         OFFSET(http_multiple), AV_OPT_TYPE_BOOL, {.i64 = -1}, -1, 1, FLAGS},
     {"http_seekable", "Use HTTP partial requests, 0 = disable, 1 = enable, -1 = auto",
         OFFSET(http_seekable), AV_OPT_TYPE_BOOL, { .i64 = -1}, -1, 1, FLAGS},
+    {"prefetch_segments", "Number of segments downloaded ahead of the one being read, 0 = disable",
+        OFFSET(prefetch_segments), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 64, FLAGS},
+    {"prefetch_bytes", "Maximum amount of prefetched data per playlist",
+        OFFSET(prefetch_bytes), AV_OPT_TYPE_INT64, {.i64 = 32 << 20}, 1, INT64_MAX, FLAGS},
     {NULL}
 };
 
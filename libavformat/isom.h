@@ -155,6 +155,36 @@ typedef struct MOVIndexRange {
     int64_t end;
 } MOVIndexRange;
 
+/**
+ * Position in the sample tables of a track, advanced one sample at a time
+ * or repositioned with a binary search over the stsc and stts runs.
+ */
+typedef struct MOVSampleCursor {
+    unsigned int sample;       ///< sample number
+    unsigned int chunk;        ///< chunk containing the sample
+    unsigned int chunk_sample; ///< sample number within the chunk
+    unsigned int stsc_index;
+    unsigned int stts_index;
+    unsigned int stts_sample;
+    int64_t pos;               ///< file offset of the sample
+    int64_t dts;
+} MOVSampleCursor;
+
+/**
+ * Sample index resolved on demand from the stco/stsc/stsz/stts/stss
+ * tables instead of being expanded into one AVIndexEntry per sample.
+ */
+typedef struct MOVLazyIndex {
+    unsigned int nb_samples;
+    int key_off;               ///< 1 if the stss entries are 1-based
+    unsigned int *stsc_sample; ///< first sample of each stsc entry
+    unsigned int *stts_sample; ///< first sample of each stts entry
+    int64_t *stts_dts;         ///< dts of the first sample of each stts entry
+    MOVSampleCursor cur;
+    AVIndexEntry entry;        ///< last sample returned by the index
+    int64_t entry_sample;      ///< sample number of entry, -1 if none
+} MOVLazyIndex;
+
 typedef struct MOVStreamContext {
     AVIOContext *pb;
     int pb_is_copied;
@@ -193,6 +223,7 @@ typedef struct MOVStreamContext {
     int64_t current_index;
     MOVIndexRange* index_ranges;
     MOVIndexRange* current_index_range;
+    MOVLazyIndex *lazy;   ///< set instead of the AVStream index when lazy_index is enabled
     unsigned int bytes_per_frame;
     unsigned int samples_per_frame;
     int dv_audio_container;
@@ -269,6 +300,7 @@ typedef struct MOVContext {
     int advanced_editlist;
     int ignore_chapters;
     int seek_individually;
+    int lazy_index;
     int64_t next_root_atom; ///< offset of the next root atom
     int export_all;
     int export_xmp;
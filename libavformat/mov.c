@@ -3377,6 +3377,228 @@ static int64_t add_ctts_entry(MOVStts** ctts_data, unsigned int* ctts_count, uns
 }
 
 #define MAX_REORDER_DELAY 16
+static unsigned int mov_lazy_sample_size(const MOVStreamContext *sc, unsigned int sample)
+{
+    return sc->stsz_sample_size > 0 ? sc->stsz_sample_size : sc->sample_sizes[sample];
+}
+
+/* Return the first stss entry greater than or equal to the given sample. */
+static unsigned int mov_lazy_search_keyframe(const MOVStreamContext *sc, unsigned int sample)
+{
+    unsigned int key = sample + sc->lazy->key_off;
+    unsigned int a = 0, b = sc->keyframe_count;
+
+    while (a < b) {
+        unsigned int m = (a + b) >> 1;
+        if ((unsigned int)sc->keyframes[m] < key)
+            a = m + 1;
+        else
+            b = m;
+    }
+    return a;
+}
+
+static int mov_lazy_is_keyframe(const AVStream *st, unsigned int sample)
+{
+    const MOVStreamContext *sc = st->priv_data;
+    unsigned int i;
+
+    if (sc->keyframe_absent)
+        return st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO || !sample;
+    if (!sc->keyframe_count)
+        return 1;
+    i = mov_lazy_search_keyframe(sc, sample);
+    return i < sc->keyframe_count &&
+           sc->keyframes[i] == sample + sc->lazy->key_off;
+}
+
+/* Return the distance to the previous keyframe, as mov_build_index() sets
+ * it, i.e. counted from the first sample if there is no such keyframe. */
+static unsigned int mov_lazy_min_distance(const AVStream *st, unsigned int sample)
+{
+    const MOVStreamContext *sc = st->priv_data;
+    unsigned int i, key;
+
+    if (sc->keyframe_absent)
+        return st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO ? 0 : sample;
+    if (!sc->keyframe_count)
+        return 0;
+    i   = mov_lazy_search_keyframe(sc, sample);
+    key = sample + sc->lazy->key_off;
+    if (i < sc->keyframe_count && sc->keyframes[i] == key)
+        return 0;
+    return i ? key - sc->keyframes[i - 1] : sample;
+}
+
+/* Return the last entry of a run table whose first sample is not after the
+ * given sample. */
+static unsigned int mov_lazy_search_run(const unsigned int *first_sample,
+                                        unsigned int count, unsigned int sample)
+{
+    unsigned int a = 0, b = count;
+
+    while (b - a > 1) {
+        unsigned int m = (a + b) >> 1;
+        if (first_sample[m] <= sample)
+            a = m;
+        else
+            b = m;
+    }
+    return a;
+}
+
+static void mov_lazy_cursor_next(MOVStreamContext *sc)
+{
+    MOVSampleCursor *cur = &sc->lazy->cur;
+
+    cur->pos += mov_lazy_sample_size(sc, cur->sample);
+    cur->dts += sc->stts_data[cur->stts_index].duration;
+    cur->stts_sample++;
+    if (cur->stts_index + 1 < sc->stts_count &&
+        cur->stts_sample == sc->stts_data[cur->stts_index].count) {
+        cur->stts_index++;
+        cur->stts_sample = 0;
+    }
+    cur->sample++;
+    if (++cur->chunk_sample == sc->stsc_data[cur->stsc_index].count) {
+        cur->chunk++;
+        cur->chunk_sample = 0;
+        if (mov_stsc_index_valid(cur->stsc_index, sc->stsc_count) &&
+            cur->chunk + 1 == sc->stsc_data[cur->stsc_index + 1].first)
+            cur->stsc_index++;
+        if (cur->chunk < sc->chunk_count)
+            cur->pos = sc->chunk_offsets[cur->chunk];
+    }
+}
+
+static void mov_lazy_cursor_set(MOVStreamContext *sc, unsigned int sample)
+{
+    MOVLazyIndex *li = sc->lazy;
+    MOVSampleCursor *cur = &li->cur;
+    unsigned int i, offset, count;
+
+    if (sample == cur->sample)
+        return;
+    if (sample == cur->sample + 1) {
+        mov_lazy_cursor_next(sc);
+        return;
+    }
+
+    i = mov_lazy_search_run(li->stsc_sample, sc->stsc_count, sample);
+    offset = sample - li->stsc_sample[i];
+    count  = sc->stsc_data[i].count;
+    cur->stsc_index   = i;
+    cur->chunk        = (i ? sc->stsc_data[i].first - 1 : 0) + offset / count;
+    cur->chunk_sample = offset % count;
+    cur->pos          = sc->chunk_offsets[cur->chunk];
+    if (sc->stsz_sample_size > 0) {
+        cur->pos += cur->chunk_sample * (int64_t)sc->stsz_sample_size;
+    } else {
+        for (i = sample - cur->chunk_sample; i < sample; i++)
+            cur->pos += (unsigned int)sc->sample_sizes[i];
+    }
+
+    i = mov_lazy_search_run(li->stts_sample, sc->stts_count, sample);
+    cur->stts_index  = i;
+    cur->stts_sample = sample - li->stts_sample[i];
+    cur->dts         = li->stts_dts[i] +
+                       cur->stts_sample * (int64_t)sc->stts_data[i].duration;
+    cur->sample      = sample;
+}
+
+static int mov_nb_samples(const AVStream *st)
+{
+    const MOVStreamContext *sc = st->priv_data;
+
+    return sc->lazy ? sc->lazy->nb_samples : st->internal->nb_index_entries;
+}
+
+static int64_t mov_sample_dts(const AVStream *st, int sample)
+{
+    const MOVStreamContext *sc = st->priv_data;
+    const MOVLazyIndex *li = sc->lazy;
+    unsigned int i;
+
+    if (!li)
+        return st->internal->index_entries[sample].timestamp;
+
+    i = mov_lazy_search_run(li->stts_sample, sc->stts_count, sample);
+    return li->stts_dts[i] +
+           (sample - li->stts_sample[i]) * (int64_t)sc->stts_data[i].duration;
+}
+
+/**
+ * Return the index entry of a sample. With the lazy index, the entry is
+ * only valid until the next call for the same stream.
+ */
+static AVIndexEntry *mov_sample_entry(AVStream *st, int sample)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *li = sc->lazy;
+
+    if (!li)
+        return &st->internal->index_entries[sample];
+
+    if (li->entry_sample != sample) {
+        mov_lazy_cursor_set(sc, sample);
+        li->entry.pos          = li->cur.pos;
+        li->entry.timestamp    = li->cur.dts;
+        li->entry.size         = mov_lazy_sample_size(sc, sample);
+        li->entry.min_distance = mov_lazy_min_distance(st, sample);
+        li->entry.flags        = mov_lazy_is_keyframe(st, sample) ? AVINDEX_KEYFRAME : 0;
+        li->entry_sample       = sample;
+    }
+    return &li->entry;
+}
+
+/* Same as ff_index_search_timestamp(), using the stss table to find the
+ * closest keyframe with the lazy index. */
+static int mov_index_search_timestamp(AVStream *st, int64_t wanted_timestamp, int flags)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int a, b, m, nb_samples;
+    int64_t timestamp;
+
+    if (!sc->lazy)
+        return av_index_search_timestamp(st, wanted_timestamp, flags);
+
+    nb_samples = sc->lazy->nb_samples;
+    a = -1;
+    b = nb_samples;
+    if (mov_sample_dts(st, b - 1) < wanted_timestamp)
+        a = b - 1;
+
+    while (b - a > 1) {
+        m = (a + b) >> 1;
+        timestamp = mov_sample_dts(st, m);
+        if (timestamp >= wanted_timestamp)
+            b = m;
+        if (timestamp <= wanted_timestamp)
+            a = m;
+    }
+    m = (flags & AVSEEK_FLAG_BACKWARD) ? a : b;
+
+    if (!(flags & AVSEEK_FLAG_ANY) && m >= 0 && m < nb_samples &&
+        !mov_lazy_is_keyframe(st, m)) {
+        if (sc->keyframe_absent) {
+            /* only the first video sample is a keyframe */
+            m = (flags & AVSEEK_FLAG_BACKWARD) ? 0 : nb_samples;
+        } else {
+            unsigned int i = mov_lazy_search_keyframe(sc, m);
+            if (flags & AVSEEK_FLAG_BACKWARD)
+                m = i ? sc->keyframes[i - 1] - sc->lazy->key_off : -1;
+            else if (i < sc->keyframe_count)
+                m = FFMIN((unsigned int)sc->keyframes[i] - sc->lazy->key_off, nb_samples);
+            else
+                m = nb_samples;
+        }
+    }
+
+    if (m == nb_samples)
+        return -1;
+    return m;
+}
+
 static void mov_estimate_video_delay(MOVContext *c, AVStream* st)
 {
     MOVStreamContext *msc = st->priv_data;
@@ -3393,14 +3615,14 @@ static void mov_estimate_video_delay(MOVContext *c, AVStream* st)
     if (st->codecpar->video_delay <= 0 && msc->ctts_data &&
         st->codecpar->codec_id == AV_CODEC_ID_H264) {
         st->codecpar->video_delay = 0;
-        for (ind = 0; ind < st->internal->nb_index_entries && ctts_ind < msc->ctts_count; ++ind) {
+        for (ind = 0; ind < mov_nb_samples(st) && ctts_ind < msc->ctts_count; ++ind) {
             // Point j to the last elem of the buffer and insert the current pts there.
             j = buf_start;
             buf_start = (buf_start + 1);
             if (buf_start == MAX_REORDER_DELAY + 1)
                 buf_start = 0;
 
-            pts_buf[j] = st->internal->index_entries[ind].timestamp + msc->ctts_data[ctts_ind].duration;
+            pts_buf[j] = mov_sample_dts(st, ind) + msc->ctts_data[ctts_ind].duration;
 
             // The timestamps that are already in the sorted buffer, and are greater than the
             // current pts, are exactly the timestamps that need to be buffered to output PTS
@@ -3789,6 +4011,253 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
     msc->current_index = msc->index_ranges[0].start;
 }
 
+static void mov_lazy_index_free(MOVStreamContext *sc)
+{
+    if (!sc->lazy)
+        return;
+    av_freep(&sc->lazy->stsc_sample);
+    av_freep(&sc->lazy->stts_sample);
+    av_freep(&sc->lazy->stts_dts);
+    av_freep(&sc->lazy);
+}
+
+/**
+ * Fill the AVStream index of a lazily indexed track with its sync samples,
+ * or with the first sample of each chunk when all samples are sync samples,
+ * for the generic code and the users of avformat_index_get_entry().
+ */
+static int mov_lazy_add_sync_index(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *li = sc->lazy;
+    AVIndexEntry *entries;
+    unsigned int i, j, nb_entries = 0, size;
+
+    if (sc->keyframe_count || (sc->keyframe_absent &&
+                               st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)) {
+        size    = FFMAX(sc->keyframe_count, 1);
+        entries = av_malloc_array(size, sizeof(*entries));
+        if (!entries)
+            return AVERROR(ENOMEM);
+        if (!sc->keyframe_count)
+            entries[nb_entries++] = *mov_sample_entry(st, 0);
+        for (i = 0; i < sc->keyframe_count; i++) {
+            unsigned int sample = (unsigned int)sc->keyframes[i] - li->key_off;
+            if (sample >= li->nb_samples)
+                break;
+            entries[nb_entries++] = *mov_sample_entry(st, sample);
+        }
+    } else {
+        size    = sc->chunk_count;
+        entries = av_malloc_array(size, sizeof(*entries));
+        if (!entries)
+            return AVERROR(ENOMEM);
+        for (i = 0; i < sc->stsc_count; i++) {
+            unsigned int first = i ? sc->stsc_data[i].first - 1 : 0;
+            unsigned int next  = i + 1 < sc->stsc_count ? sc->stsc_data[i + 1].first - 1
+                                                        : sc->chunk_count;
+            for (j = 0; j < next - first; j++)
+                entries[nb_entries++] = *mov_sample_entry(st,
+                    li->stsc_sample[i] + j * sc->stsc_data[i].count);
+        }
+    }
+
+    st->internal->index_entries = entries;
+    st->internal->nb_index_entries = nb_entries;
+    st->internal->index_entries_allocated_size = size * sizeof(*entries);
+    return 0;
+}
+
+/**
+ * Set up the lazy index of a track whose sample tables can be used as is,
+ * i.e. without rewriting the index according to the edit list or partial
+ * sync samples.
+ *
+ * @return 1 if the lazy index is used, 0 if the full index must be built
+ */
+static int mov_build_lazy_index(MOVContext *mov, AVStream *st, int64_t start_dts)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *li;
+    uint64_t nb_samples = 0, stream_size = 0, stts_sample = 0;
+    int64_t dts = start_dts;
+    unsigned int i;
+
+    if (!mov->lazy_index || st->internal->nb_index_entries ||
+        (st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO &&
+         st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO))
+        return 0;
+    if (!sc->sample_count || !sc->chunk_count || !sc->stsc_count || !sc->stts_count)
+        return 0;
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+        sc->stts_count == 1 && sc->stts_data[0].duration == 1)
+        return 0;
+    if (sc->elst_count && !mov->ignore_editlist && mov->advanced_editlist)
+        return 0;
+    if (sc->stps_count || sc->rap_group_count)
+        return 0;
+    /* mov_build_index() may override the stsz sample size midway */
+    if (sc->stsz_sample_size > 0 && sc->sample_size > 0 &&
+        sc->stsz_sample_size != sc->sample_size)
+        return 0;
+    if (!sc->stsz_sample_size && !sc->sample_sizes)
+        return 0;
+
+    for (i = 0; i < sc->stsc_count; i++) {
+        int64_t first = i ? sc->stsc_data[i].first - 1LL : 0;
+        int64_t next  = i + 1 < sc->stsc_count ? sc->stsc_data[i + 1].first - 1LL
+                                               : sc->chunk_count;
+        if (sc->stsc_data[i].count <= 0 || next <= first || next > sc->chunk_count)
+            return 0;
+        if (sc->pseudo_stream_id != -1 &&
+            sc->stsc_data[i].id - 1 != sc->pseudo_stream_id)
+            return 0;
+        nb_samples += (next - first) * sc->stsc_data[i].count;
+    }
+    if (nb_samples > sc->sample_count)
+        return 0;
+
+    for (i = 0; i < sc->stts_count; i++)
+        if (sc->stts_data[i].duration < 0 ||
+            (!sc->stts_data[i].count && i + 1 < sc->stts_count))
+            return 0;
+    for (i = 1; i < sc->keyframe_count; i++)
+        if ((unsigned int)sc->keyframes[i] <= (unsigned int)sc->keyframes[i - 1])
+            return 0;
+
+    if (sc->stsz_sample_size > 0) {
+        if (sc->stsz_sample_size > 0x3FFFFFFF)
+            return 0;
+        stream_size = nb_samples * sc->stsz_sample_size;
+    } else {
+        for (i = 0; i < nb_samples; i++) {
+            if ((unsigned int)sc->sample_sizes[i] > 0x3FFFFFFF)
+                return 0;
+            stream_size += (unsigned int)sc->sample_sizes[i];
+        }
+    }
+
+    li = av_mallocz(sizeof(*li));
+    if (!li)
+        return 0;
+    sc->lazy = li;
+    li->stsc_sample = av_malloc_array(sc->stsc_count, sizeof(*li->stsc_sample));
+    li->stts_sample = av_malloc_array(sc->stts_count, sizeof(*li->stts_sample));
+    li->stts_dts    = av_malloc_array(sc->stts_count, sizeof(*li->stts_dts));
+    if (!li->stsc_sample || !li->stts_sample || !li->stts_dts) {
+        mov_lazy_index_free(sc);
+        return 0;
+    }
+
+    li->nb_samples = nb_samples;
+    li->key_off = sc->keyframe_count && sc->keyframes[0] > 0;
+    for (i = 0, nb_samples = 0; i < sc->stsc_count; i++) {
+        int64_t first = i ? sc->stsc_data[i].first - 1LL : 0;
+        int64_t next  = i + 1 < sc->stsc_count ? sc->stsc_data[i + 1].first - 1LL
+                                               : sc->chunk_count;
+        li->stsc_sample[i] = nb_samples;
+        nb_samples += (next - first) * sc->stsc_data[i].count;
+    }
+    for (i = 0; i < sc->stts_count; i++) {
+        li->stts_sample[i] = FFMIN(stts_sample, UINT_MAX);
+        li->stts_dts[i]    = dts;
+        stts_sample += sc->stts_data[i].count;
+        dts         += sc->stts_data[i].count * (int64_t)sc->stts_data[i].duration;
+    }
+    li->cur.pos = sc->chunk_offsets[0];
+    li->cur.dts = start_dts;
+    li->entry_sample = -1;
+    if (mov_lazy_add_sync_index(st) < 0) {
+        mov_lazy_index_free(sc);
+        return 0;
+    }
+
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+        for (i = 0; i < FFMIN(li->nb_samples, 99); i++)
+            ff_rfps_add_frame(mov->fc, st, mov_sample_dts(st, i));
+    if (st->duration > 0)
+        st->codecpar->bit_rate = stream_size*8*sc->time_scale/st->duration;
+
+    av_log(mov->fc, AV_LOG_DEBUG, "Lazy index for stream %d, %u samples\n",
+           st->index, li->nb_samples);
+    return 1;
+}
+
+/* Expand ctts entries such that we have a 1-1 mapping with samples */
+static int mov_expand_ctts(MOVStreamContext *sc)
+{
+    MOVStts *ctts_data_old = sc->ctts_data;
+    unsigned int ctts_count_old = sc->ctts_count;
+    unsigned int i, j;
+
+    if (sc->sample_count >= UINT_MAX / sizeof(*sc->ctts_data))
+        return AVERROR(EINVAL);
+    sc->ctts_count = 0;
+    sc->ctts_allocated_size = 0;
+    sc->ctts_data = av_fast_realloc(NULL, &sc->ctts_allocated_size,
+                            sc->sample_count * sizeof(*sc->ctts_data));
+    if (!sc->ctts_data) {
+        av_free(ctts_data_old);
+        return AVERROR(ENOMEM);
+    }
+
+    memset((uint8_t*)(sc->ctts_data), 0, sc->ctts_allocated_size);
+
+    for (i = 0; i < ctts_count_old &&
+                sc->ctts_count < sc->sample_count; i++)
+        for (j = 0; j < ctts_data_old[i].count &&
+                    sc->ctts_count < sc->sample_count; j++)
+            add_ctts_entry(&sc->ctts_data, &sc->ctts_count,
+                           &sc->ctts_allocated_size, 1,
+                           ctts_data_old[i].duration);
+    av_free(ctts_data_old);
+    return 0;
+}
+
+/**
+ * Replace the lazy index of a track with the full index, for the code
+ * which modifies the index, e.g. when fragments add samples to it.
+ */
+static int mov_lazy_index_expand(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *li = sc->lazy;
+    AVIndexEntry *entries;
+    unsigned int i, distance = 0;
+
+    if (!li)
+        return 0;
+
+    entries = av_malloc_array(li->nb_samples, sizeof(*entries));
+    if (!entries)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < li->nb_samples; i++) {
+        AVIndexEntry *e = &entries[i];
+        int keyframe = mov_lazy_is_keyframe(st, i);
+
+        mov_lazy_cursor_set(sc, i);
+        if (keyframe)
+            distance = 0;
+        e->pos          = li->cur.pos;
+        e->timestamp    = li->cur.dts;
+        e->size         = mov_lazy_sample_size(sc, i);
+        e->min_distance = distance++;
+        e->flags        = keyframe ? AVINDEX_KEYFRAME : 0;
+    }
+    av_free(st->internal->index_entries);
+    st->internal->index_entries = entries;
+    st->internal->nb_index_entries = li->nb_samples;
+    st->internal->index_entries_allocated_size = li->nb_samples * sizeof(*entries);
+
+    mov_lazy_index_free(sc);
+    av_freep(&sc->chunk_offsets);
+    av_freep(&sc->sample_sizes);
+    av_freep(&sc->keyframes);
+    av_freep(&sc->stts_data);
+    return 0;
+}
+
 static void mov_build_index(MOVContext *mov, AVStream *st)
 {
     MOVStreamContext *sc = st->priv_data;
@@ -3800,8 +4269,6 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
     unsigned int stps_index = 0;
     unsigned int i, j;
     uint64_t stream_size = 0;
-    MOVStts *ctts_data_old = sc->ctts_data;
-    unsigned int ctts_count_old = sc->ctts_count;
 
     if (sc->elst_count) {
         int i, edit_start_index = 0, multiple_edits = 0;
@@ -3842,8 +4309,10 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
             sc->start_pad = start_time;
     }
 
+    if (mov_build_lazy_index(mov, st, current_dts - sc->dts_shift)) {
+        /* samples are resolved from the sample tables on demand */
     /* only use old uncompressed audio chunk demuxing when stts specifies it */
-    if (!(st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+    } else if (!(st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
           sc->stts_count == 1 && sc->stts_data[0].duration == 1)) {
         unsigned int current_sample = 0;
         unsigned int stts_sample = 0;
@@ -3871,30 +4340,8 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
         }
         st->internal->index_entries_allocated_size = (st->internal->nb_index_entries + sc->sample_count) * sizeof(*st->internal->index_entries);
 
-        if (ctts_data_old) {
-            // Expand ctts entries such that we have a 1-1 mapping with samples
-            if (sc->sample_count >= UINT_MAX / sizeof(*sc->ctts_data))
-                return;
-            sc->ctts_count = 0;
-            sc->ctts_allocated_size = 0;
-            sc->ctts_data = av_fast_realloc(NULL, &sc->ctts_allocated_size,
-                                    sc->sample_count * sizeof(*sc->ctts_data));
-            if (!sc->ctts_data) {
-                av_free(ctts_data_old);
-                return;
-            }
-
-            memset((uint8_t*)(sc->ctts_data), 0, sc->ctts_allocated_size);
-
-            for (i = 0; i < ctts_count_old &&
-                        sc->ctts_count < sc->sample_count; i++)
-                for (j = 0; j < ctts_data_old[i].count &&
-                            sc->ctts_count < sc->sample_count; j++)
-                    add_ctts_entry(&sc->ctts_data, &sc->ctts_count,
-                                   &sc->ctts_allocated_size, 1,
-                                   ctts_data_old[i].duration);
-            av_free(ctts_data_old);
-        }
+        if (sc->ctts_data && mov_expand_ctts(sc) < 0)
+            return;
 
         for (i = 0; i < sc->chunk_count; i++) {
             int64_t next_offset = i+1 < sc->chunk_count ? sc->chunk_offsets[i+1] : INT64_MAX;
@@ -4101,14 +4548,14 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
         }
     }
 
-    if (!mov->ignore_editlist && mov->advanced_editlist) {
+    if (!sc->lazy && !mov->ignore_editlist && mov->advanced_editlist) {
         // Fix index according to edit lists.
         mov_fix_index(mov, st);
     }
 
     // Update start time of the stream.
-    if (st->start_time == AV_NOPTS_VALUE && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && st->internal->nb_index_entries > 0) {
-        st->start_time = st->internal->index_entries[0].timestamp + sc->dts_shift;
+    if (st->start_time == AV_NOPTS_VALUE && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && mov_nb_samples(st) > 0) {
+        st->start_time = mov_sample_dts(st, 0) + sc->dts_shift;
         if (sc->ctts_data) {
             st->start_time += sc->ctts_data[0].duration;
         }
@@ -4345,11 +4792,13 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         && sc->time_scale == st->codecpar->sample_rate) {
             st->need_parsing = AVSTREAM_PARSE_FULL;
     }
-    /* Do not need those anymore. */
-    av_freep(&sc->chunk_offsets);
-    av_freep(&sc->sample_sizes);
-    av_freep(&sc->keyframes);
-    av_freep(&sc->stts_data);
+    /* Do not need those anymore, unless samples are resolved from them. */
+    if (!sc->lazy) {
+        av_freep(&sc->chunk_offsets);
+        av_freep(&sc->sample_sizes);
+        av_freep(&sc->keyframes);
+        av_freep(&sc->stts_data);
+    }
     av_freep(&sc->stps_data);
     av_freep(&sc->elst_data);
     av_freep(&sc->rap_group);
@@ -4773,7 +5222,7 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     int64_t dts, pts = AV_NOPTS_VALUE;
     int data_offset = 0;
     unsigned entries, first_sample_flags = frag->flags;
-    int flags, distance, i;
+    int flags, distance, i, ret;
     int64_t prev_dts = AV_NOPTS_VALUE;
     int next_frag_index = -1, index_entry_pos;
     size_t requested_size;
@@ -4799,6 +5248,17 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     sc = st->priv_data;
     if (sc->pseudo_stream_id+1 != frag->stsd_id && sc->pseudo_stream_id != -1)
         return 0;
+    if (sc->lazy) {
+        if ((ret = mov_lazy_index_expand(st)) < 0)
+            return ret;
+        /* the fragment samples are inserted into a 1-1 ctts table */
+        if (sc->ctts_data) {
+            if ((ret = mov_expand_ctts(sc)) < 0)
+                return ret;
+            sc->ctts_index  = sc->current_sample;
+            sc->ctts_sample = 0;
+        }
+    }
 
     // Find the next frag_index index that has a valid index_entry for
     // the current track_id.
@@ -7219,6 +7679,7 @@ static void mov_read_chapters(AVFormatContext *s)
 
         sc = st->priv_data;
         cur_pos = avio_tell(sc->pb);
+        mov_lazy_index_expand(st);
 
         if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
             st->disposition |= AV_DISPOSITION_ATTACHED_PIC | AV_DISPOSITION_TIMED_THUMBNAILS;
@@ -7406,6 +7867,7 @@ static int mov_read_close(AVFormatContext *s)
         av_freep(&sc->rap_group);
         av_freep(&sc->display_matrix);
         av_freep(&sc->index_ranges);
+        mov_lazy_index_free(sc);
 
         if (sc->extradata)
             for (j = 0; j < sc->stsd_count; j++)
@@ -7805,8 +8267,8 @@ static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
     for (i = 0; i < s->nb_streams; i++) {
         AVStream *avst = s->streams[i];
         MOVStreamContext *msc = avst->priv_data;
-        if (msc->pb && msc->current_sample < avst->internal->nb_index_entries) {
-            AVIndexEntry *current_sample = &avst->internal->index_entries[msc->current_sample];
+        if (msc->pb && msc->current_sample < mov_nb_samples(avst)) {
+            AVIndexEntry *current_sample = mov_sample_entry(avst, msc->current_sample);
             int64_t dts = av_rescale(current_sample->timestamp, AV_TIME_BASE, msc->time_scale);
             av_log(s, AV_LOG_TRACE, "stream %d, sample %d, dts %"PRId64"\n", i, msc->current_sample, dts);
             if (!sample || (!(s->pb->seekable & AVIO_SEEKABLE_NORMAL) && current_sample->pos < sample->pos) ||
@@ -8011,8 +8473,8 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
             sc->ctts_sample = 0;
         }
     } else {
-        int64_t next_dts = (sc->current_sample < st->internal->nb_index_entries) ?
-            st->internal->index_entries[sc->current_sample].timestamp : st->duration;
+        int64_t next_dts = (sc->current_sample < mov_nb_samples(st)) ?
+            mov_sample_dts(st, sc->current_sample) : st->duration;
 
         if (next_dts >= pkt->dts)
             pkt->duration = next_dts - pkt->dts;
@@ -8091,9 +8553,9 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
     if (ret < 0)
         return ret;
 
-    sample = av_index_search_timestamp(st, timestamp, flags);
+    sample = mov_index_search_timestamp(st, timestamp, flags);
     av_log(s, AV_LOG_TRACE, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
-    if (sample < 0 && st->internal->nb_index_entries && timestamp < st->internal->index_entries[0].timestamp)
+    if (sample < 0 && mov_nb_samples(st) && timestamp < mov_sample_dts(st, 0))
         sample = 0;
     if (sample < 0) /* not sure what to do */
         return AVERROR_INVALIDDATA;
@@ -8134,8 +8596,8 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
 static int64_t mov_get_skip_samples(AVStream *st, int sample)
 {
     MOVStreamContext *sc = st->priv_data;
-    int64_t first_ts = st->internal->index_entries[0].timestamp;
-    int64_t ts = st->internal->index_entries[sample].timestamp;
+    int64_t first_ts = mov_sample_dts(st, 0);
+    int64_t ts = mov_sample_dts(st, sample);
     int64_t off;
 
     if (st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
@@ -8164,7 +8626,7 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
 
     if (mc->seek_individually) {
         /* adjust seek timestamp to found sample timestamp */
-        int64_t seek_timestamp = st->internal->index_entries[sample].timestamp;
+        int64_t seek_timestamp = mov_sample_dts(st, sample);
         st->internal->skip_samples = mov_get_skip_samples(st, sample);
 
         for (i = 0; i < s->nb_streams; i++) {
@@ -8217,6 +8679,10 @@ static const AVOption mov_options[] = {
         "Modify the AVIndex according to the editlists. Use this option to decode in the order specified by the edits.",
         OFFSET(advanced_editlist), AV_OPT_TYPE_BOOL, {.i64 = 1},
         0, 1, FLAGS},
+    {"lazy_index",
+        "Resolve the samples from the sample tables on demand instead of building the full index.",
+        OFFSET(lazy_index), AV_OPT_TYPE_BOOL, {.i64 = 0},
+        0, 1, FLAGS},
     {"ignore_chapters", "", OFFSET(ignore_chapters), AV_OPT_TYPE_BOOL, {.i64 = 0},
         0, 1, FLAGS},
     {"use_mfra_for",
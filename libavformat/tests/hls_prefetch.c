@@ -0,0 +1,250 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Read a HLS playlist from a local HTTP server, with and without segment
+ * prefetching, and check that both give the same packets and open all the
+ * URLs through the io_open callback.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/opt.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+#include "libavformat/avformat.h"
+
+#define NB_SEGMENTS   6
+#define SEGMENT_SIZE  16000 /* 1 second of 8 kHz mono s16 */
+#define WAV_HEADER    44
+
+typedef struct Server {
+    AVIOContext *listener;
+    char url[64];
+    atomic_int stop;
+    uint8_t segments[NB_SEGMENTS][WAV_HEADER + SEGMENT_SIZE];
+    int segment_size[NB_SEGMENTS];
+    char playlist[1024];
+} Server;
+
+static atomic_int nb_opens;
+static int (*default_io_open)(AVFormatContext *s, AVIOContext **pb, const char *url,
+                              int flags, AVDictionary **options);
+
+static int server_interrupt(void *opaque)
+{
+    Server *srv = opaque;
+    return atomic_load(&srv->stop);
+}
+
+static void make_content(Server *srv)
+{
+    const int data_size = NB_SEGMENTS * SEGMENT_SIZE;
+    uint8_t *p = srv->segments[0];
+    int i, j, len;
+
+    memcpy(p, "RIFF", 4);
+    AV_WL32(p +  4, data_size + WAV_HEADER - 8);
+    memcpy(p +  8, "WAVEfmt ", 8);
+    AV_WL32(p + 16, 16);
+    AV_WL16(p + 20, 1);    /* PCM */
+    AV_WL16(p + 22, 1);    /* mono */
+    AV_WL32(p + 24, 8000);
+    AV_WL32(p + 28, 16000);
+    AV_WL16(p + 32, 2);
+    AV_WL16(p + 34, 16);
+    memcpy(p + 36, "data", 4);
+    AV_WL32(p + 40, data_size);
+
+    for (i = 0; i < NB_SEGMENTS; i++) {
+        uint8_t *data = srv->segments[i] + (i ? 0 : WAV_HEADER);
+        for (j = 0; j < SEGMENT_SIZE; j++)
+            data[j] = (i * 37 + j * 13 + (j >> 7)) & 0xFF;
+        srv->segment_size[i] = SEGMENT_SIZE + (i ? 0 : WAV_HEADER);
+    }
+
+    len = snprintf(srv->playlist, sizeof(srv->playlist),
+                   "#EXTM3U\n#EXT-X-VERSION:3\n#EXT-X-TARGETDURATION:1\n"
+                   "#EXT-X-MEDIA-SEQUENCE:0\n");
+    for (i = 0; i < NB_SEGMENTS; i++)
+        len += snprintf(srv->playlist + len, sizeof(srv->playlist) - len,
+                        "#EXTINF:1.0,\nseg%d.wav\n", i);
+    snprintf(srv->playlist + len, sizeof(srv->playlist) - len, "#EXT-X-ENDLIST\n");
+}
+
+static int server_open(Server *srv)
+{
+    const AVIOInterruptCB int_cb = { server_interrupt, srv };
+    int i, ret = AVERROR(EADDRINUSE);
+
+    /* try a few ports, in case tests run concurrently */
+    for (i = 0; i < 20 && ret < 0; i++) {
+        AVDictionary *opts = NULL;
+
+        snprintf(srv->url, sizeof(srv->url), "http://127.0.0.1:%d",
+                 20000 + (int)((av_gettime_relative() + i * 997) % 20000));
+        av_dict_set(&opts, "listen", "2", 0);
+        ret = avio_open2(&srv->listener, srv->url, AVIO_FLAG_WRITE, &int_cb, &opts);
+        av_dict_free(&opts);
+    }
+    return ret;
+}
+
+static void serve_client(Server *srv, AVIOContext *client)
+{
+    const uint8_t *data = NULL;
+    uint8_t *resource = NULL;
+    int size = 0, seg, ret;
+
+    while ((ret = avio_handshake(client)) > 0) {
+        av_opt_get(client, "resource", AV_OPT_SEARCH_CHILDREN, &resource);
+        /* av_opt_get() may return an empty string */
+        if (resource && *resource)
+            break;
+        av_freep(&resource);
+    }
+    if (ret < 0)
+        goto end;
+
+    if (resource && !strcmp((char *)resource, "/test.m3u8")) {
+        data = (const uint8_t *)srv->playlist;
+        size = strlen(srv->playlist);
+    } else if (resource && sscanf((char *)resource, "/seg%d.wav", &seg) == 1 &&
+               seg >= 0 && seg < NB_SEGMENTS) {
+        data = srv->segments[seg];
+        size = srv->segment_size[seg];
+    }
+
+    if (av_opt_set_int(client, "reply_code", data ? 200 : 404, AV_OPT_SEARCH_CHILDREN) < 0)
+        goto end;
+    while ((ret = avio_handshake(client)) > 0);
+    if (ret < 0 || !data)
+        goto end;
+
+    avio_write(client, data, size);
+
+end:
+    av_free(resource);
+    avio_flush(client);
+    avio_close(client);
+}
+
+static void *server_thread(void *arg)
+{
+    Server *srv = arg;
+
+    while (!atomic_load(&srv->stop)) {
+        AVIOContext *client = NULL;
+        if (avio_accept(srv->listener, &client) < 0)
+            break;
+        serve_client(srv, client);
+    }
+    return NULL;
+}
+
+static int counting_io_open(AVFormatContext *s, AVIOContext **pb, const char *url,
+                            int flags, AVDictionary **options)
+{
+    atomic_fetch_add(&nb_opens, 1);
+    return default_io_open(s, pb, url, flags, options);
+}
+
+static int read_playlist(const Server *srv, int prefetch_segments)
+{
+    AVFormatContext *s = avformat_alloc_context();
+    AVDictionary *opts = NULL;
+    AVPacket *pkt = av_packet_alloc();
+    char url[128];
+    unsigned long checksum = 1;
+    int64_t bytes = 0;
+    int nb_packets = 0, ret;
+
+    if (!s || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    default_io_open = s->io_open;
+    s->io_open      = counting_io_open;
+    atomic_store(&nb_opens, 0);
+
+    snprintf(url, sizeof(url), "%s/test.m3u8", srv->url);
+    av_dict_set_int(&opts, "prefetch_segments", prefetch_segments, 0);
+    av_dict_set(&opts, "http_persistent", "0", 0);
+    ret = avformat_open_input(&s, url, NULL, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+        goto end;
+
+    while ((ret = av_read_frame(s, pkt)) >= 0) {
+        checksum = av_adler32_update(checksum, pkt->data, pkt->size);
+        bytes += pkt->size;
+        nb_packets++;
+        av_packet_unref(pkt);
+    }
+    if (ret == AVERROR_EOF)
+        ret = 0;
+
+    printf("prefetch_segments=%d: %d packets, %"PRId64" bytes, adler32 0x%08lx, %d urls opened\n",
+           prefetch_segments, nb_packets, bytes, checksum, atomic_load(&nb_opens));
+
+end:
+    av_packet_free(&pkt);
+    avformat_close_input(&s);
+    return ret;
+}
+
+int main(void)
+{
+    static Server srv;
+    pthread_t thread;
+    int ret;
+
+    av_log_set_level(AV_LOG_ERROR);
+    avformat_network_init();
+
+    make_content(&srv);
+    ret = server_open(&srv);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to start the HTTP server: %s\n", av_err2str(ret));
+        return 1;
+    }
+    if (pthread_create(&thread, NULL, server_thread, &srv)) {
+        avio_close(srv.listener);
+        return 1;
+    }
+
+    ret = read_playlist(&srv, 0);
+    if (ret >= 0)
+        ret = read_playlist(&srv, 2);
+    if (ret < 0)
+        fprintf(stderr, "Failed to read the playlist: %s\n", av_err2str(ret));
+
+    /* the listener reports the interrupted accept */
+    av_log_set_level(AV_LOG_QUIET);
+    atomic_store(&srv.stop, 1);
+    pthread_join(thread, NULL);
+    avio_close(srv.listener);
+    avformat_network_deinit();
+
+    return ret < 0;
+}
@@ -0,0 +1,212 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Write, read and seek in a file through the uring protocol, once with
+ * io_uring and once with the plain file I/O used for files opened for both
+ * reading and writing, then move, list and delete it.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/mem.h"
+#include "libavformat/avio.h"
+#include "libavformat/url.h"
+
+#define FILE_SIZE 300777
+
+static const int chunk_sizes[] = { 1, 4095, 70000, 13, 65536, 16384, 777 };
+
+static const struct {
+    int64_t pos;
+    int whence;
+    int size;
+} seeks[] = {
+    {   5000, SEEK_SET,    100 },
+    {   -200, SEEK_END,    300 },
+    {  -1000, SEEK_CUR,  20000 },
+    {      0, SEEK_SET,  40000 },
+    { 250000, SEEK_SET,  10000 },
+    {  10000, SEEK_CUR,   1000 },
+    {  17000, SEEK_SET,  65536 },
+    {      0, SEEK_END,     10 },
+};
+
+static uint8_t data[FILE_SIZE];
+
+static URLContext *open_url(const char *url, int flags, int io_uring)
+{
+    URLContext *h = NULL;
+    AVDictionary *opts = NULL;
+    int ret;
+
+    /* small buffers, so that the file spans several rounds of requests */
+    av_dict_set(&opts, "read_ahead_size", "65536", 0);
+    av_dict_set(&opts, "queue_depth", "4", 0);
+    av_dict_set(&opts, "truncate", flags & AVIO_FLAG_WRITE ? "1" : "0", 0);
+    ret = ffurl_open_whitelist(&h, url, io_uring ? flags : AVIO_FLAG_READ_WRITE,
+                               NULL, &opts, NULL, NULL, NULL);
+    av_dict_free(&opts);
+    if (ret < 0)
+        printf("open %s: %s\n", flags & AVIO_FLAG_WRITE ? "write" : "read",
+               av_err2str(ret));
+    return h;
+}
+
+static int write_file(const char *url, int io_uring)
+{
+    URLContext *h = open_url(url, AVIO_FLAG_WRITE, io_uring);
+    int pos = 0, i = 0, size, ret;
+
+    if (!h)
+        return -1;
+
+    while (pos < FILE_SIZE) {
+        size = chunk_sizes[i++ % FF_ARRAY_ELEMS(chunk_sizes)];
+        size = FFMIN(size, FILE_SIZE - pos);
+        if ((ret = ffurl_write(h, data + pos, size)) < 0)
+            goto fail;
+        pos += size;
+    }
+
+    /* rewrite a header, like muxers do */
+    memset(data + 100, 0x55, 50);
+    if ((ret = ffurl_seek(h, 100, SEEK_SET)) < 0 ||
+        (ret = ffurl_write(h, data + 100, 50)) < 0)
+        goto fail;
+    printf("size after writing: %"PRId64"\n", ffurl_seek(h, 0, AVSEEK_SIZE));
+
+    return ffurl_closep(&h);
+fail:
+    printf("write: %s\n", av_err2str(ret));
+    ffurl_closep(&h);
+    return ret;
+}
+
+static int read_file(const char *url, int io_uring)
+{
+    URLContext *h = open_url(url, AVIO_FLAG_READ, io_uring);
+    uint8_t *buf = av_malloc(FILE_SIZE);
+    unsigned long checksum = 1;
+    int64_t pos = 0;
+    int i = 0, size, ret = 0;
+
+    if (!h || !buf) {
+        ret = -1;
+        goto end;
+    }
+
+    for (;;) {
+        size = chunk_sizes[i++ % FF_ARRAY_ELEMS(chunk_sizes)];
+        ret = ffurl_read_complete(h, buf, size);
+        if (ret == AVERROR_EOF)
+            break;
+        if (ret < 0)
+            goto end;
+        if (memcmp(buf, data + pos, ret))
+            printf("mismatch reading %d bytes at %"PRId64"\n", ret, pos);
+        checksum = av_adler32_update(checksum, buf, ret);
+        pos += ret;
+    }
+    printf("read %"PRId64" bytes, adler32 0x%08lx\n", pos, checksum);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(seeks); i++) {
+        pos = ffurl_seek(h, seeks[i].pos, seeks[i].whence);
+        if (pos < 0) {
+            ret = pos;
+            goto end;
+        }
+        ret = ffurl_read_complete(h, buf, seeks[i].size);
+        if (ret == AVERROR_EOF)
+            ret = 0;
+        if (ret < 0)
+            goto end;
+        printf("seek to %"PRId64": read %d bytes, %s\n", pos, ret,
+               memcmp(buf, data + pos, ret) ? "mismatch" : "ok");
+    }
+    ret = 0;
+
+end:
+    if (ret < 0)
+        printf("read: %s\n", av_err2str(ret));
+    av_free(buf);
+    ffurl_closep(&h);
+    return ret;
+}
+
+static int list_dir(const char *url)
+{
+    AVIODirContext *ctx = NULL;
+    AVIODirEntry *entry = NULL;
+    int ret;
+
+    if ((ret = avio_open_dir(&ctx, url, NULL)) < 0)
+        goto end;
+    while ((ret = avio_read_dir(ctx, &entry)) >= 0 && entry) {
+        printf("entry %s: type %d, size %"PRId64"\n",
+               entry->name, entry->type, entry->size);
+        avio_free_directory_entry(&entry);
+    }
+    avio_close_dir(&ctx);
+
+end:
+    if (ret < 0)
+        printf("list: %s\n", av_err2str(ret));
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    char dir[1024], url[1040], moved[1040];
+    int i, io_uring, ret = 0;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <directory>\n", argv[0]);
+        return 1;
+    }
+    snprintf(dir,   sizeof(dir),   "uring:%s", argv[1]);
+    snprintf(url,   sizeof(url),   "%s/test.bin", dir);
+    snprintf(moved, sizeof(moved), "%s/moved.bin", dir);
+    if (mkdir(argv[1], 0777) < 0 && errno != EEXIST) {
+        fprintf(stderr, "Failed to create %s\n", argv[1]);
+        return 1;
+    }
+
+    for (io_uring = 1; io_uring >= 0 && ret >= 0; io_uring--) {
+        printf("%s:\n", io_uring ? "io_uring" : "plain file I/O");
+        for (i = 0; i < FILE_SIZE; i++)
+            data[i] = (i * 37 + (i >> 8) * 13) & 0xFF;
+        if ((ret = write_file(url, io_uring)) >= 0)
+            ret = read_file(url, io_uring);
+    }
+
+    printf("check: %d\n", avio_check(url, AVIO_FLAG_READ_WRITE));
+    if ((ret = avpriv_io_move(url, moved)) < 0)
+        printf("move: %s\n", av_err2str(ret));
+    printf("check after move: %s\n", av_err2str(avio_check(url, AVIO_FLAG_READ)));
+    list_dir(dir);
+    if ((ret = avpriv_io_delete(moved)) < 0 || (ret = avpriv_io_delete(dir)) < 0)
+        printf("delete: %s\n", av_err2str(ret));
+    printf("check after delete: %s\n", av_err2str(avio_check(dir, AVIO_FLAG_READ)));
+
+    return ret < 0;
+}
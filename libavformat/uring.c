@@ -0,0 +1,718 @@
+/*
+ * io_uring file protocol
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * File protocol reading ahead and writing behind with io_uring.
+ *
+ * The file is accessed through queue_depth buffers covering consecutive
+ * ranges of the file. When reading, all of them are kept in flight ahead of
+ * the current position and each one is queued again for the next range as
+ * soon as it has been consumed. When writing, a full buffer is queued and
+ * filling continues in the next one while the kernel writes it.
+ *
+ * Files that are not regular, files opened for both reading and writing
+ * and kernels without io_uring use plain file I/O. The other operations
+ * behave like the ones of the file protocol.
+ */
+
+#define _GNU_SOURCE /* for syscall() and MAP_POPULATE */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "avformat.h"
+#include "os_support.h"
+#include "url.h"
+
+enum BufferState {
+    BUFFER_IDLE,    ///< not queued; when writing, may hold data being filled
+    BUFFER_PENDING, ///< queued to the kernel
+    BUFFER_DONE,    ///< read completed
+};
+
+typedef struct UringBuffer {
+    uint8_t *data;
+    int64_t offset;         ///< file offset of data[0]
+    int size;               ///< number of bytes requested
+    int len;                ///< bytes read or filled, or an AVERROR code
+    int pos;                ///< bytes consumed or already written
+    enum BufferState state;
+} UringBuffer;
+
+typedef struct UringContext {
+    const AVClass *class;
+    int fd;
+    int trunc;
+    int read_ahead_size;
+    int queue_depth;
+
+    int write;
+    int64_t pos;            ///< logical position in the file
+    int64_t next_offset;    ///< file offset of the next read-ahead request
+    int error;              ///< deferred write error
+
+    int ring_fd;            ///< -1 when using plain file I/O
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned to_submit;
+    int registered;
+
+    uint8_t *pool;
+    UringBuffer *bufs;
+    int buffer_size;
+    int first;              ///< buffer holding pos, or being filled
+    int nb_pending;
+
+    DIR *dir;
+} UringContext;
+
+#define OFFSET(x) offsetof(UringContext, x)
+#define D AV_OPT_FLAG_DECODING_PARAM
+#define E AV_OPT_FLAG_ENCODING_PARAM
+static const AVOption uring_options[] = {
+    { "truncate", "truncate existing files on write", OFFSET(trunc), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, E },
+    { "read_ahead_size", "set the amount of data read ahead or written behind", OFFSET(read_ahead_size), AV_OPT_TYPE_INT, { .i64 = 2 << 20 }, 4096, INT_MAX / 2, D|E },
+    { "queue_depth", "set the number of concurrent I/O requests", OFFSET(queue_depth), AV_OPT_TYPE_INT, { .i64 = 8 }, 1, 64, D|E },
+    { NULL }
+};
+
+static const AVClass uring_class = {
+    .class_name = "uring",
+    .item_name  = av_default_item_name,
+    .option     = uring_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
+static int ring_init(UringContext *c, unsigned entries)
+{
+    struct io_uring_params p = { 0 };
+    uint8_t *sq, *cq;
+    int fd;
+
+    fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0)
+        return AVERROR(errno);
+    c->ring_fd = fd;
+
+    c->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    c->cq_ring_size = p.cq_off.cqes  + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        c->sq_ring_size = c->cq_ring_size = FFMAX(c->sq_ring_size, c->cq_ring_size);
+
+    c->sq_ring = mmap(NULL, c->sq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (c->sq_ring == MAP_FAILED) {
+        c->sq_ring = NULL;
+        return AVERROR(errno);
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        c->cq_ring = c->sq_ring;
+    } else {
+        c->cq_ring = mmap(NULL, c->cq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (c->cq_ring == MAP_FAILED) {
+            c->cq_ring = NULL;
+            return AVERROR(errno);
+        }
+    }
+    c->sqes_size = p.sq_entries * sizeof(*c->sqes);
+    c->sqes = mmap(NULL, c->sqes_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (c->sqes == MAP_FAILED) {
+        c->sqes = NULL;
+        return AVERROR(errno);
+    }
+
+    sq = c->sq_ring;
+    cq = c->cq_ring;
+    c->sq_tail  = (unsigned *)(sq + p.sq_off.tail);
+    c->sq_mask  = (unsigned *)(sq + p.sq_off.ring_mask);
+    c->sq_array = (unsigned *)(sq + p.sq_off.array);
+    c->cq_head  = (unsigned *)(cq + p.cq_off.head);
+    c->cq_tail  = (unsigned *)(cq + p.cq_off.tail);
+    c->cq_mask  = (unsigned *)(cq + p.cq_off.ring_mask);
+    c->cqes     = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    return 0;
+}
+
+static void ring_uninit(UringContext *c)
+{
+    if (c->sqes)
+        munmap(c->sqes, c->sqes_size);
+    if (c->cq_ring && c->cq_ring != c->sq_ring)
+        munmap(c->cq_ring, c->cq_ring_size);
+    if (c->sq_ring)
+        munmap(c->sq_ring, c->sq_ring_size);
+    if (c->ring_fd >= 0)
+        close(c->ring_fd);
+    c->sqes    = NULL;
+    c->sq_ring = c->cq_ring = NULL;
+    c->ring_fd = -1;
+
+    av_freep(&c->pool);
+    av_freep(&c->bufs);
+}
+
+static void queue_request(UringContext *c, UringBuffer *b)
+{
+    const unsigned tail = *c->sq_tail;
+    const unsigned idx  = tail & *c->sq_mask;
+    struct io_uring_sqe *sqe = &c->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    if (c->registered) {
+        sqe->opcode    = c->write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->buf_index = b - c->bufs;
+    } else {
+        sqe->opcode    = c->write ? IORING_OP_WRITE : IORING_OP_READ;
+    }
+    sqe->fd        = c->fd;
+    sqe->off       = b->offset + b->pos;
+    sqe->addr      = (uintptr_t)(b->data + b->pos);
+    sqe->len       = b->size - b->pos;
+    sqe->user_data = b - c->bufs;
+
+    c->sq_array[idx] = idx;
+    atomic_store_explicit((atomic_uint *)c->sq_tail, tail + 1, memory_order_release);
+
+    b->state = BUFFER_PENDING;
+    c->nb_pending++;
+    c->to_submit++;
+}
+
+static void complete_request(UringContext *c, UringBuffer *b, int res)
+{
+    c->nb_pending--;
+
+    if (!c->write) {
+        b->len   = res < 0 ? AVERROR(-res) : res;
+        b->state = BUFFER_DONE;
+        return;
+    }
+
+    if (res <= 0) {
+        if (!c->error)
+            c->error = res < 0 ? AVERROR(-res) : AVERROR(EIO);
+    } else if ((b->pos += res) < b->size) {
+        /* short write, queue the remaining data */
+        queue_request(c, b);
+        return;
+    }
+    b->len   = 0;
+    b->state = BUFFER_IDLE;
+}
+
+/**
+ * Submit the queued requests and reap the completed ones.
+ *
+ * @param wait if nonzero, block until at least one request completes
+ */
+static int ring_enter(UringContext *c, int wait)
+{
+    unsigned head, tail;
+    int ret;
+
+    while (c->to_submit || wait) {
+        ret = syscall(__NR_io_uring_enter, c->ring_fd, c->to_submit, wait,
+                      wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return AVERROR(errno);
+        }
+        c->to_submit -= ret;
+        if (!c->to_submit)
+            break;
+    }
+
+    head = *c->cq_head;
+    tail = atomic_load_explicit((atomic_uint *)c->cq_tail, memory_order_acquire);
+    for (; head != tail; head++) {
+        const struct io_uring_cqe *cqe = &c->cqes[head & *c->cq_mask];
+        complete_request(c, &c->bufs[cqe->user_data], cqe->res);
+    }
+    atomic_store_explicit((atomic_uint *)c->cq_head, head, memory_order_release);
+
+    return 0;
+}
+
+static int wait_for(UringContext *c, UringBuffer *b)
+{
+    int ret;
+
+    while (b->state == BUFFER_PENDING)
+        if ((ret = ring_enter(c, 1)) < 0)
+            return ret;
+    return 0;
+}
+
+static int drain(UringContext *c)
+{
+    int ret;
+
+    while (c->nb_pending)
+        if ((ret = ring_enter(c, 1)) < 0)
+            return ret;
+    return 0;
+}
+
+static int uring_setup(URLContext *h)
+{
+    UringContext *c = h->priv_data;
+    struct iovec *iov;
+    int i, ret;
+
+    c->buffer_size = FFMAX(FFALIGN(c->read_ahead_size / c->queue_depth, 4096), 4096);
+    c->pool = av_malloc_array(c->queue_depth, c->buffer_size);
+    c->bufs = av_calloc(c->queue_depth, sizeof(*c->bufs));
+    iov     = av_malloc_array(c->queue_depth, sizeof(*iov));
+    if (!c->pool || !c->bufs || !iov) {
+        av_free(iov);
+        return AVERROR(ENOMEM);
+    }
+
+    if ((ret = ring_init(c, c->queue_depth)) < 0) {
+        av_free(iov);
+        return ret;
+    }
+
+    for (i = 0; i < c->queue_depth; i++) {
+        c->bufs[i].data = c->pool + (size_t)i * c->buffer_size;
+        iov[i].iov_base = c->bufs[i].data;
+        iov[i].iov_len  = c->buffer_size;
+    }
+    /* Registration pins the buffers, which may exceed RLIMIT_MEMLOCK on
+     * older kernels; unregistered buffers only cost an extra mapping per
+     * request. */
+    c->registered = !syscall(__NR_io_uring_register, c->ring_fd,
+                             IORING_REGISTER_BUFFERS, iov, c->queue_depth);
+    av_free(iov);
+
+    av_log(h, AV_LOG_DEBUG, "io_uring with %d %sbuffers of %d bytes\n",
+           c->queue_depth, c->registered ? "registered " : "", c->buffer_size);
+
+    return 0;
+}
+
+static void submit_read(UringContext *c, UringBuffer *b)
+{
+    b->offset = c->next_offset;
+    b->size   = c->buffer_size;
+    b->len    = 0;
+    b->pos    = 0;
+    c->next_offset += b->size;
+    queue_request(c, b);
+}
+
+static int start_read_ahead(UringContext *c)
+{
+    int i;
+
+    c->first       = 0;
+    c->next_offset = c->pos;
+    for (i = 0; i < c->queue_depth; i++)
+        submit_read(c, &c->bufs[i]);
+    return ring_enter(c, 0);
+}
+
+static int reset_read_ahead(UringContext *c)
+{
+    int i, ret = drain(c);
+
+    for (i = 0; i < c->queue_depth; i++)
+        c->bufs[i].state = BUFFER_IDLE;
+    c->first = 0;
+    return ret;
+}
+
+/**
+ * Move the read position, keeping the requests that are already in flight
+ * for the data after it.
+ */
+static int seek_read_ahead(UringContext *c, int64_t pos)
+{
+    int i, ret;
+
+    for (i = 0; i < c->queue_depth; i++) {
+        UringBuffer *b = &c->bufs[(c->first + i) % c->queue_depth];
+
+        if (b->state == BUFFER_IDLE)
+            break;
+        if (pos < b->offset || pos >= b->offset + b->size)
+            continue;
+
+        while (i--) {
+            UringBuffer *skipped = &c->bufs[c->first];
+            if ((ret = wait_for(c, skipped)) < 0)
+                return ret;
+            submit_read(c, skipped);
+            c->first = (c->first + 1) % c->queue_depth;
+        }
+        b->pos = pos - b->offset;
+        return ring_enter(c, 0);
+    }
+
+    return reset_read_ahead(c);
+}
+
+static int flush_write(UringContext *c)
+{
+    UringBuffer *b = &c->bufs[c->first];
+    int ret;
+
+    if (b->state == BUFFER_IDLE && b->len) {
+        b->size = b->len;
+        b->pos  = 0;
+        queue_request(c, b);
+        c->first = (c->first + 1) % c->queue_depth;
+    }
+    if ((ret = drain(c)) < 0)
+        return ret;
+    return c->error;
+}
+
+static int uring_read(URLContext *h, unsigned char *buf, int size)
+{
+    UringContext *c = h->priv_data;
+    UringBuffer *b;
+    int ret;
+
+    if (c->ring_fd < 0) {
+        ret = read(c->fd, buf, size);
+        if (ret == 0)
+            return AVERROR_EOF;
+        return ret < 0 ? AVERROR(errno) : ret;
+    }
+
+    for (;;) {
+        b = &c->bufs[c->first];
+        if (b->state == BUFFER_IDLE && (ret = start_read_ahead(c)) < 0)
+            return ret;
+        if ((ret = wait_for(c, b)) < 0)
+            return ret;
+        if (b->len < 0)
+            return b->len;
+
+        if (b->pos < b->len) {
+            size = FFMIN(size, b->len - b->pos);
+            memcpy(buf, b->data + b->pos, size);
+            b->pos += size;
+            c->pos += size;
+            if (b->pos == b->size) {
+                submit_read(c, b);
+                c->first = (c->first + 1) % c->queue_depth;
+                if ((ret = ring_enter(c, 0)) < 0)
+                    return ret;
+            }
+            return size;
+        }
+        if (!b->len)
+            return AVERROR_EOF;
+
+        /* A short read was consumed: the requests queued after it do not
+         * start where it ended, so read ahead again from the position. */
+        if ((ret = reset_read_ahead(c)) < 0)
+            return ret;
+    }
+}
+
+static int uring_write(URLContext *h, const unsigned char *buf, int size)
+{
+    UringContext *c = h->priv_data;
+    UringBuffer *b;
+    int ret;
+
+    if (c->ring_fd < 0) {
+        ret = write(c->fd, buf, size);
+        return ret < 0 ? AVERROR(errno) : ret;
+    }
+
+    b = &c->bufs[c->first];
+    if ((ret = wait_for(c, b)) < 0)
+        return ret;
+    if (c->error)
+        return c->error;
+
+    if (!b->len)
+        b->offset = c->pos;
+    size = FFMIN(size, c->buffer_size - b->len);
+    memcpy(b->data + b->len, buf, size);
+    b->len += size;
+    c->pos += size;
+
+    if (b->len == c->buffer_size) {
+        b->size = b->len;
+        b->pos  = 0;
+        queue_request(c, b);
+        c->first = (c->first + 1) % c->queue_depth;
+        if ((ret = ring_enter(c, 0)) < 0)
+            return ret;
+    }
+    return size;
+}
+
+static int64_t uring_seek(URLContext *h, int64_t pos, int whence)
+{
+    UringContext *c = h->priv_data;
+    struct stat st;
+    int ret;
+
+    if (c->ring_fd < 0) {
+        int64_t ret;
+        if (whence == AVSEEK_SIZE) {
+            ret = fstat(c->fd, &st);
+            return ret < 0 ? AVERROR(errno) : (S_ISFIFO(st.st_mode) ? 0 : st.st_size);
+        }
+        ret = lseek(c->fd, pos, whence);
+        return ret < 0 ? AVERROR(errno) : ret;
+    }
+
+    if (whence == AVSEEK_SIZE || whence == SEEK_END) {
+        if (c->write && (ret = flush_write(c)) < 0)
+            return ret;
+        if (fstat(c->fd, &st) < 0)
+            return AVERROR(errno);
+        if (whence == AVSEEK_SIZE)
+            return st.st_size;
+        pos += st.st_size;
+    } else if (whence == SEEK_CUR) {
+        pos += c->pos;
+    } else if (whence != SEEK_SET) {
+        return AVERROR(EINVAL);
+    }
+    if (pos < 0)
+        return AVERROR(EINVAL);
+
+    if (pos != c->pos) {
+        ret = c->write ? flush_write(c) : seek_read_ahead(c, pos);
+        if (ret < 0)
+            return ret;
+        c->pos = pos;
+    }
+    return pos;
+}
+
+static int uring_open(URLContext *h, const char *filename, int flags)
+{
+    UringContext *c = h->priv_data;
+    struct stat st;
+    int access, fd, ret;
+
+    c->ring_fd = -1;
+    av_strstart(filename, "uring:", &filename);
+
+    if (flags & AVIO_FLAG_WRITE && flags & AVIO_FLAG_READ) {
+        access = O_CREAT | O_RDWR;
+        if (c->trunc)
+            access |= O_TRUNC;
+    } else if (flags & AVIO_FLAG_WRITE) {
+        access = O_CREAT | O_WRONLY;
+        if (c->trunc)
+            access |= O_TRUNC;
+    } else {
+        access = O_RDONLY;
+    }
+    fd = avpriv_open(filename, access, 0666);
+    if (fd == -1)
+        return AVERROR(errno);
+    c->fd    = fd;
+    c->write = (flags & AVIO_FLAG_READ_WRITE) == AVIO_FLAG_WRITE;
+
+    if (fstat(fd, &st) < 0)
+        st.st_mode = 0;
+    h->is_streamed = S_ISFIFO(st.st_mode);
+
+    if (S_ISREG(st.st_mode) && (flags & AVIO_FLAG_READ_WRITE) != AVIO_FLAG_READ_WRITE) {
+        if ((ret = uring_setup(h)) < 0) {
+            av_log(h, AV_LOG_VERBOSE, "io_uring is not available (%s), "
+                   "using plain file I/O\n", av_err2str(ret));
+            ring_uninit(c);
+        }
+    }
+
+    if (!h->is_streamed && flags & AVIO_FLAG_WRITE)
+        h->min_packet_size = h->max_packet_size = 262144;
+
+    return 0;
+}
+
+static int uring_close(URLContext *h)
+{
+    UringContext *c = h->priv_data;
+    int ret = 0;
+
+    if (c->ring_fd >= 0) {
+        ret = c->write ? flush_write(c) : drain(c);
+        ring_uninit(c);
+    }
+    if (close(c->fd) < 0 && ret >= 0)
+        ret = AVERROR(errno);
+    return ret;
+}
+
+static int uring_get_handle(URLContext *h)
+{
+    UringContext *c = h->priv_data;
+    return c->fd;
+}
+
+static const char *uring_path(const URLContext *h)
+{
+    const char *filename = h->filename;
+    av_strstart(filename, "uring:", &filename);
+    return filename;
+}
+
+static int uring_check(URLContext *h, int mask)
+{
+    const char *filename = uring_path(h);
+    int ret = 0;
+
+    if (access(filename, F_OK) < 0)
+        return AVERROR(errno);
+    if (mask & AVIO_FLAG_READ && access(filename, R_OK) >= 0)
+        ret |= AVIO_FLAG_READ;
+    if (mask & AVIO_FLAG_WRITE && access(filename, W_OK) >= 0)
+        ret |= AVIO_FLAG_WRITE;
+    return ret;
+}
+
+static int uring_delete(URLContext *h)
+{
+    const char *filename = uring_path(h);
+    int ret;
+
+    ret = rmdir(filename);
+    if (ret < 0 && errno == ENOTDIR)
+        ret = unlink(filename);
+    return ret < 0 ? AVERROR(errno) : 0;
+}
+
+static int uring_move(URLContext *h_src, URLContext *h_dst)
+{
+    if (rename(uring_path(h_src), uring_path(h_dst)) < 0)
+        return AVERROR(errno);
+    return 0;
+}
+
+static int uring_open_dir(URLContext *h)
+{
+    UringContext *c = h->priv_data;
+
+    c->dir = opendir(uring_path(h));
+    if (!c->dir)
+        return AVERROR(errno);
+    return 0;
+}
+
+static int uring_read_dir(URLContext *h, AVIODirEntry **next)
+{
+    UringContext *c = h->priv_data;
+    struct dirent *dir;
+    struct stat st;
+    char *fullpath;
+
+    *next = ff_alloc_dir_entry();
+    if (!*next)
+        return AVERROR(ENOMEM);
+    do {
+        errno = 0;
+        dir = readdir(c->dir);
+        if (!dir) {
+            av_freep(next);
+            return AVERROR(errno);
+        }
+    } while (!strcmp(dir->d_name, ".") || !strcmp(dir->d_name, ".."));
+
+    fullpath = av_append_path_component(uring_path(h), dir->d_name);
+    if (fullpath && !lstat(fullpath, &st)) {
+        if (S_ISDIR(st.st_mode))
+            (*next)->type = AVIO_ENTRY_DIRECTORY;
+        else if (S_ISFIFO(st.st_mode))
+            (*next)->type = AVIO_ENTRY_NAMED_PIPE;
+        else if (S_ISCHR(st.st_mode))
+            (*next)->type = AVIO_ENTRY_CHARACTER_DEVICE;
+        else if (S_ISBLK(st.st_mode))
+            (*next)->type = AVIO_ENTRY_BLOCK_DEVICE;
+        else if (S_ISLNK(st.st_mode))
+            (*next)->type = AVIO_ENTRY_SYMBOLIC_LINK;
+        else if (S_ISSOCK(st.st_mode))
+            (*next)->type = AVIO_ENTRY_SOCKET;
+        else if (S_ISREG(st.st_mode))
+            (*next)->type = AVIO_ENTRY_FILE;
+        else
+            (*next)->type = AVIO_ENTRY_UNKNOWN;
+
+        (*next)->group_id                = st.st_gid;
+        (*next)->user_id                 = st.st_uid;
+        (*next)->size                    = st.st_size;
+        (*next)->filemode                = st.st_mode & 0777;
+        (*next)->modification_timestamp  = INT64_C(1000000) * st.st_mtime;
+        (*next)->access_timestamp        = INT64_C(1000000) * st.st_atime;
+        (*next)->status_change_timestamp = INT64_C(1000000) * st.st_ctime;
+    }
+    av_free(fullpath);
+
+    (*next)->name = av_strdup(dir->d_name);
+    return 0;
+}
+
+static int uring_close_dir(URLContext *h)
+{
+    UringContext *c = h->priv_data;
+    closedir(c->dir);
+    return 0;
+}
+
+const URLProtocol ff_uring_protocol = {
+    .name                = "uring",
+    .url_open            = uring_open,
+    .url_read            = uring_read,
+    .url_write           = uring_write,
+    .url_seek            = uring_seek,
+    .url_close           = uring_close,
+    .url_get_file_handle = uring_get_handle,
+    .url_check           = uring_check,
+    .url_delete          = uring_delete,
+    .url_move            = uring_move,
+    .priv_data_size      = sizeof(UringContext),
+    .priv_data_class     = &uring_class,
+    .url_open_dir        = uring_open_dir,
+    .url_read_dir        = uring_read_dir,
+    .url_close_dir       = uring_close_dir,
+    .default_whitelist   = "uring,crypto,data",
+};
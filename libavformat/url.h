@@ -27,6 +27,7 @@
 #include "avio.h"
 #include "libavformat/version.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
 
@@ -86,6 +87,8 @@ typedef struct URLProtocol {
     int (*url_get_multi_file_handle)(URLContext *h, int **handles,
                                      int *numhandles);
     int (*url_get_short_seek)(URLContext *h);
+    int (*url_get_mapped_buffer)(URLContext *h, int64_t pos, int size,
+                                 AVBufferRef **buf);
     int (*url_shutdown)(URLContext *h, int flags);
     const AVClass *priv_data_class;
     int priv_data_size;
@@ -254,6 +257,20 @@ int ffurl_get_multi_file_handle(URLContext *h, int **handles, int *numhandles);
  */
 int ffurl_get_short_seek(URLContext *h);
 
+/**
+ * Get a reference to size bytes of the resource starting at pos, e.g. from a
+ * memory mapping of a local file, without copying them when possible. The
+ * data is followed by at least AV_INPUT_BUFFER_PADDING_SIZE readable bytes,
+ * which are the following data of the resource and are not necessarily
+ * zero; the resource itself is followed by AV_INPUT_BUFFER_PADDING_SIZE
+ * zeroed bytes.
+ *
+ * @return 0 on success, AVERROR(ENOSYS) if the protocol cannot provide the
+ *         data this way, or another negative error code
+ */
+int ffurl_get_mapped_buffer(URLContext *h, int64_t pos, int size,
+                            AVBufferRef **buf);
+
 /**
  * Signal the URLContext that we are done reading or writing the stream.
  *
@@ -273,6 +273,16 @@ static int append_packet_chunked(AVIOContext *s, AVPacket *pkt, int size)
     int orig_size      = pkt->size;
     int ret;
 
+    if (!orig_size) {
+        AVBufferRef *buf;
+        if (ffio_read_mapped_buffer(s, size, &buf) >= 0) {
+            pkt->buf  = buf;
+            pkt->data = buf->data;
+            pkt->size = size;
+            return size;
+        }
+    }
+
     do {
         int prev_size = pkt->size;
         int read_size;
@@ -22,9 +22,12 @@
 #include "common.h"
 #include "aes_ctr.h"
 #include "aes.h"
+#include "intreadwrite.h"
+#include "mem_internal.h"
 #include "random_seed.h"
 
 #define AES_BLOCK_SIZE (16)
+#define AES_CTR_BATCH  (32)   ///< counter blocks encrypted per av_aes_crypt() call
 
 typedef struct AVAESCTR {
     struct AVAES* aes;
@@ -115,6 +118,28 @@ void av_aes_ctr_crypt(struct AVAESCTR *a, uint8_t *dst, const uint8_t *src, int
     uint8_t* encrypted_counter_pos;
 
     while (src < src_end) {
+        if (a->block_offset == 0 && src_end - src >= 2 * AES_BLOCK_SIZE) {
+            /* Encrypt the counters of several whole blocks in one call, so
+             * that optimized implementations can process them in parallel. */
+            DECLARE_ALIGNED(16, uint8_t, counters)[AES_CTR_BATCH][AES_BLOCK_SIZE];
+            DECLARE_ALIGNED(16, uint8_t, keystream)[AES_CTR_BATCH][AES_BLOCK_SIZE];
+            int i, nb_blocks = FFMIN((src_end - src) / AES_BLOCK_SIZE, AES_CTR_BATCH);
+
+            for (i = 0; i < nb_blocks; i++) {
+                memcpy(counters[i], a->counter, AES_BLOCK_SIZE);
+                av_aes_ctr_increment_be64(a->counter + 8);
+            }
+            av_aes_crypt(a->aes, keystream[0], counters[0], nb_blocks, NULL, 0);
+
+            for (i = 0; i < nb_blocks; i++) {
+                AV_WN64(dst,     AV_RN64(src)     ^ AV_RN64(keystream[i]));
+                AV_WN64(dst + 8, AV_RN64(src + 8) ^ AV_RN64(keystream[i] + 8));
+                src += AES_BLOCK_SIZE;
+                dst += AES_BLOCK_SIZE;
+            }
+            continue;
+        }
+
         if (a->block_offset == 0) {
             av_aes_crypt(a->aes, a->encrypted_counter, a->counter, 1, NULL, 0);
 
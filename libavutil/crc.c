@@ -24,7 +24,9 @@
 #include "avassert.h"
 #include "bswap.h"
 #include "common.h"
+#include "cpu.h"
 #include "crc.h"
+#include "crc_internal.h"
 
 #if CONFIG_HARDCODED_TABLES
 static const AVCRC av_crc_table[AV_CRC_MAX][257] = {
@@ -389,11 +391,35 @@ const AVCRC *av_crc_get_table(AVCRCId crc_id)
     return av_crc_table[crc_id];
 }
 
+#if ARCH_X86
+/* Return the AVCRCId of a table returned by av_crc_get_table(), or -1. */
+static int crc_table_id(const AVCRC *ctx)
+{
+    uintptr_t offset = (uintptr_t)ctx - (uintptr_t)av_crc_table;
+
+    if (offset >= sizeof(av_crc_table) || offset % sizeof(av_crc_table[0]))
+        return -1;
+    return offset / sizeof(av_crc_table[0]);
+}
+#endif
+
 uint32_t av_crc(const AVCRC *ctx, uint32_t crc,
                 const uint8_t *buffer, size_t length)
 {
     const uint8_t *end = buffer + length;
 
+#if ARCH_X86
+    if (length >= 64) {
+        ff_crc_func crc_simd = ff_crc_get_func_x86(av_get_cpu_flags());
+        int crc_id;
+
+        if (crc_simd && (crc_id = crc_table_id(ctx)) >= 0) {
+            crc     = crc_simd(crc_id, crc, buffer, length & ~15);
+            buffer += length & ~15;
+        }
+    }
+#endif
+
 #if !CONFIG_SMALL
     if (!ctx[256]) {
         while (((intptr_t) buffer & 3) && buffer < end)
@@ -0,0 +1,40 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_CRC_INTERNAL_H
+#define AVUTIL_CRC_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crc.h"
+
+/**
+ * Update crc with length bytes of buffer, like av_crc() with the table
+ * returned by av_crc_get_table(crc_id). length must be a non-zero multiple
+ * of 16.
+ */
+typedef uint32_t (*ff_crc_func)(AVCRCId crc_id, uint32_t crc,
+                                const uint8_t *buffer, size_t length);
+
+/**
+ * Return an optimized ff_crc_func for the given CPU flags, or NULL.
+ */
+ff_crc_func ff_crc_get_func_x86(int cpu_flags);
+
+#endif /* AVUTIL_CRC_INTERNAL_H */
@@ -50,6 +50,8 @@ typedef struct Parser {
     const char * const *func1_names;          // NULL terminated
     double (* const *funcs2)(void *, double a, double b); // NULL terminated
     const char * const *func2_names;          // NULL terminated
+    const double * const *const_arrays;
+    int index;
     void *opaque;
     int log_offset;
     void *log_ctx;
@@ -154,6 +156,15 @@ static int strmatch(const char *s, const char *prefix)
     return !IS_IDENTIFIER_CHAR(s[i]);
 }
 
+/* number of points evaluated at once by av_expr_eval_array() */
+#define BLOCK_SIZE 128
+
+typedef struct ExprInsn {
+    const struct AVExpr *e;
+    int dst;                    ///< register receiving the result
+    int src[3];                 ///< registers holding the parameters, -1 if unset
+} ExprInsn;
+
 struct AVExpr {
     enum {
         e_value, e_const, e_func0, e_func1, e_func2,
@@ -174,6 +185,10 @@ struct AVExpr {
     } a;
     struct AVExpr *param[3];
     double *var;
+    ExprInsn *insn;             ///< flat program, in evaluation order
+    int nb_insn;
+    double (*regs)[BLOCK_SIZE]; ///< registers used by the flat program
+    int compiled;               ///< 1 if compiled, -1 if it cannot be, 0 if not tried yet
 };
 
 static double etime(double v)
@@ -185,7 +200,9 @@ static double eval_expr(Parser *p, AVExpr *e)
 {
     switch (e->type) {
         case e_value:  return e->value;
-        case e_const:  return e->value * p->const_values[e->const_index];
+        case e_const:  return e->value * (p->const_arrays && p->const_arrays[e->const_index] ?
+                                          p->const_arrays[e->const_index][p->index] :
+                                          p->const_values[e->const_index]);
         case e_func0:  return e->value * e->a.func0(eval_expr(p, e->param[0]));
         case e_func1:  return e->value * e->a.func1(p->opaque, eval_expr(p, e->param[0]));
         case e_func2:  return e->value * e->a.func2(p->opaque, eval_expr(p, e->param[0]), eval_expr(p, e->param[1]));
@@ -340,6 +357,8 @@ void av_expr_free(AVExpr *e)
     av_expr_free(e->param[1]);
     av_expr_free(e->param[2]);
     av_freep(&e->var);
+    av_freep(&e->insn);
+    av_freep(&e->regs);
     av_freep(&e);
 }
 
@@ -682,6 +701,139 @@ static int verify_expr(AVExpr *e)
     }
 }
 
+/**
+ * Return 1 if the node does not depend on anything but its parameters,
+ * i.e. on neither the identifiers, the user functions, the variables nor
+ * the time, and has no side effects.
+ */
+static int is_pure(const AVExpr *e)
+{
+    switch (e->type) {
+    case e_func0:  return e->a.func0 != etime;
+    case e_const:
+    case e_func1:
+    case e_func2:
+    case e_ld:
+    case e_st:
+    case e_random:
+    case e_print:
+    case e_while:
+    case e_taylor:
+    case e_root:   return 0;
+    default:       return 1;
+    }
+}
+
+static void fold_expr(AVExpr *e)
+{
+    Parser p = { 0 };
+    int i;
+
+    if (!e || e->type == e_value)
+        return;
+    for (i = 0; i < 3; i++)
+        fold_expr(e->param[i]);
+
+    if (!is_pure(e))
+        return;
+    for (i = 0; i < 3; i++)
+        if (e->param[i] && e->param[i]->type != e_value)
+            return;
+
+    e->value = eval_expr(&p, e);
+    e->type  = e_value;
+    for (i = 0; i < 3; i++) {
+        av_expr_free(e->param[i]);
+        e->param[i] = NULL;
+    }
+}
+
+/**
+ * Return 1 if the expression can be evaluated for several points at once,
+ * i.e. if it does not access the variables, whose value would depend on
+ * the evaluation order.
+ */
+static int can_compile(const AVExpr *e)
+{
+    int i;
+
+    if (!e)
+        return 1;
+    switch (e->type) {
+    case e_ld:
+    case e_st:
+    case e_random:
+    case e_print:
+    case e_while:
+    case e_taylor:
+    case e_root:
+        return 0;
+    default:
+        break;
+    }
+    for (i = 0; i < 3; i++)
+        if (!can_compile(e->param[i]))
+            return 0;
+    return 1;
+}
+
+static int count_nodes(const AVExpr *e)
+{
+    if (!e)
+        return 0;
+    return 1 + count_nodes(e->param[0]) + count_nodes(e->param[1]) + count_nodes(e->param[2]);
+}
+
+/**
+ * Emit the instructions evaluating e into register dst. The first parameter
+ * is evaluated into dst too, as it is not needed anymore once the node has
+ * been evaluated, which keeps left-nested chains in two registers.
+ */
+static void compile_node(AVExpr *root, const AVExpr *e, int dst, int *nb_regs)
+{
+    ExprInsn *insn;
+    int i;
+
+    for (i = 0; i < 3; i++)
+        if (e->param[i])
+            compile_node(root, e->param[i], dst + i, nb_regs);
+
+    insn = &root->insn[root->nb_insn++];
+    insn->e   = e;
+    insn->dst = dst;
+    for (i = 0; i < 3; i++)
+        insn->src[i] = e->param[i] ? dst + i : -1;
+    *nb_regs = FFMAX(*nb_regs, dst + 3);
+}
+
+/**
+ * Build the flat program of e, on the first av_expr_eval_array() call so
+ * that the expressions only used with av_expr_eval() do not pay for it.
+ */
+static int compile_expr(AVExpr *e)
+{
+    int nb_regs = 1;
+
+    if (!can_compile(e)) {
+        e->compiled = -1;
+        return 0;
+    }
+
+    e->insn = av_malloc_array(count_nodes(e), sizeof(*e->insn));
+    if (!e->insn)
+        return AVERROR(ENOMEM);
+    e->nb_insn = 0;
+    compile_node(e, e, 0, &nb_regs);
+
+    e->regs = av_malloc_array(nb_regs, sizeof(*e->regs));
+    if (!e->regs) {
+        av_freep(&e->insn);
+        return AVERROR(ENOMEM);
+    }
+    e->compiled = 1;
+    return 0;
+}
+
 int av_expr_parse(AVExpr **expr, const char *s,
                   const char * const *const_names,
                   const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -724,6 +876,7 @@ int av_expr_parse(AVExpr **expr, const char *s,
         ret = AVERROR(EINVAL);
         goto end;
     }
+    fold_expr(e);
     e->var= av_mallocz(sizeof(double) *VARS);
     if (!e->var) {
         ret = AVERROR(ENOMEM);
@@ -773,6 +926,114 @@ double av_expr_eval(AVExpr *e, const double *const_values, void *opaque)
     return eval_expr(&p, e);
 }
 
+#define LOOP(x) for (i = 0; i < n; i++) d[i] = (x)
+
+static void eval_block(AVExpr *root, int n, int offset, const double *const_values,
+                       const double * const *const_arrays, void *opaque)
+{
+    int i, j;
+
+    for (j = 0; j < root->nb_insn; j++) {
+        const ExprInsn *insn = &root->insn[j];
+        const AVExpr *e = insn->e;
+        const double v = e->value;
+        double *d = root->regs[insn->dst];
+        const double *a = insn->src[0] >= 0 ? root->regs[insn->src[0]] : NULL;
+        const double *b = insn->src[1] >= 0 ? root->regs[insn->src[1]] : NULL;
+        const double *c = insn->src[2] >= 0 ? root->regs[insn->src[2]] : NULL;
+
+        switch (e->type) {
+        case e_value:  LOOP(v); break;
+        case e_const:
+            if (const_arrays && const_arrays[e->const_index]) {
+                const double *s = const_arrays[e->const_index] + offset;
+                LOOP(v * s[i]);
+            } else {
+                const double s = v * const_values[e->const_index];
+                LOOP(s);
+            }
+            break;
+        case e_func0:  LOOP(v * e->a.func0(a[i])); break;
+        case e_func1:  LOOP(v * e->a.func1(opaque, a[i])); break;
+        case e_func2:  LOOP(v * e->a.func2(opaque, a[i], b[i])); break;
+        case e_squish: LOOP(1/(1+exp(4*a[i]))); break;
+        case e_gauss:  LOOP(exp(-a[i]*a[i]/2)/sqrt(2*M_PI)); break;
+        case e_isnan:  LOOP(v * !!isnan(a[i])); break;
+        case e_isinf:  LOOP(v * !!isinf(a[i])); break;
+        case e_floor:  LOOP(v * floor(a[i])); break;
+        case e_ceil :  LOOP(v * ceil (a[i])); break;
+        case e_trunc:  LOOP(v * trunc(a[i])); break;
+        case e_round:  LOOP(v * round(a[i])); break;
+        case e_sgn:    LOOP(v * FFDIFFSIGN(a[i], 0)); break;
+        case e_sqrt:   LOOP(v * sqrt (a[i])); break;
+        case e_not:    LOOP(v * (a[i] == 0)); break;
+        case e_if:
+            if (c) LOOP(v * (a[i] ? b[i] : c[i]));
+            else   LOOP(v * (a[i] ? b[i] : 0));
+            break;
+        case e_ifnot:
+            if (c) LOOP(v * (!a[i] ? b[i] : c[i]));
+            else   LOOP(v * (!a[i] ? b[i] : 0));
+            break;
+        case e_clip:
+            LOOP(isnan(b[i]) || isnan(c[i]) || isnan(a[i]) || b[i] > c[i] ? NAN :
+                 v * av_clipd(a[i], b[i], c[i]));
+            break;
+        case e_between: LOOP(v * (a[i] >= b[i] && a[i] <= c[i])); break;
+        case e_lerp:    LOOP(a[i] + (b[i] - a[i]) * c[i]); break;
+        case e_mod:     LOOP(v * (a[i] - floor(b[i] ? a[i] / b[i] : a[i] * INFINITY) * b[i])); break;
+        case e_gcd:     LOOP(v * av_gcd(a[i], b[i])); break;
+        case e_max:     LOOP(v * (a[i] >  b[i] ? a[i] : b[i])); break;
+        case e_min:     LOOP(v * (a[i] <  b[i] ? a[i] : b[i])); break;
+        case e_eq:      LOOP(v * (a[i] == b[i] ? 1.0 : 0.0)); break;
+        case e_gt:      LOOP(v * (a[i] >  b[i] ? 1.0 : 0.0)); break;
+        case e_gte:     LOOP(v * (a[i] >= b[i] ? 1.0 : 0.0)); break;
+        case e_lt:      LOOP(v * (a[i] <  b[i] ? 1.0 : 0.0)); break;
+        case e_lte:     LOOP(v * (a[i] <= b[i] ? 1.0 : 0.0)); break;
+        case e_pow:     LOOP(v * pow(a[i], b[i])); break;
+        case e_mul:     LOOP(v * (a[i] * b[i])); break;
+        case e_div:     LOOP(v * (b[i] ? (a[i] / b[i]) : a[i] * INFINITY)); break;
+        case e_add:     LOOP(v * (a[i] + b[i])); break;
+        case e_last:    LOOP(v * b[i]); break;
+        case e_hypot:   LOOP(v * hypot(a[i], b[i])); break;
+        case e_atan2:   LOOP(v * atan2(a[i], b[i])); break;
+        case e_bitand:  LOOP(isnan(a[i]) || isnan(b[i]) ? NAN : v * ((long int)a[i] & (long int)b[i])); break;
+        case e_bitor:   LOOP(isnan(a[i]) || isnan(b[i]) ? NAN : v * ((long int)a[i] | (long int)b[i])); break;
+        default:        LOOP(NAN); break;
+        }
+    }
+}
+
+int av_expr_eval_array(AVExpr *e, double *res, int nb, const double *const_values,
+                       const double * const *const_arrays, void *opaque)
+{
+    int i, ret;
+
+    if (nb < 0)
+        return AVERROR(EINVAL);
+
+    if (!e->compiled && (ret = compile_expr(e)) < 0)
+        return ret;
+
+    if (e->compiled < 0) {
+        Parser p = { 0 };
+        p.var          = e->var;
+        p.const_values = const_values;
+        p.const_arrays = const_arrays;
+        p.opaque       = opaque;
+        for (p.index = 0; p.index < nb; p.index++)
+            res[p.index] = eval_expr(&p, e);
+        return 0;
+    }
+
+    for (i = 0; i < nb; i += BLOCK_SIZE) {
+        const int n = FFMIN(nb - i, BLOCK_SIZE);
+        eval_block(e, n, i, const_values, const_arrays, opaque);
+        memcpy(res + i, e->regs[0], n * sizeof(*res));
+    }
+    return 0;
+}
+
 int av_expr_parse_and_eval(double *d, const char *s,
                            const char * const *const_names, const double *const_values,
                            const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -86,6 +86,33 @@ int av_expr_parse(AVExpr **expr, const char *s,
  */
 double av_expr_eval(AVExpr *e, const double *const_values, void *opaque);
 
+/**
+ * Evaluate a previously parsed expression for several points at once.
+ *
+ * This gives the same results as calling av_expr_eval() nb times, but is
+ * much faster when the expression does not use the ld(), st(), random(),
+ * print(), while(), taylor() or root() functions. In that case the
+ * functions from funcs1 and funcs2 may be called in a different order and
+ * for both branches of if() and ifnot(), so they should not have side effects.
+ *
+ * The expression keeps the scratch space of the evaluation, which is
+ * allocated on the first call, so this function must not be called
+ * concurrently on the same AVExpr; use one AVExpr per thread instead.
+ *
+ * @param res          array of nb doubles where the results are stored
+ * @param nb           number of points to evaluate
+ * @param const_values a zero terminated array of values for the identifiers
+ *                     from av_expr_parse() const_names which are the same
+ *                     for all points
+ * @param const_arrays NULL or an array with one entry per identifier from
+ *                     const_names; a non-NULL entry points to the nb values
+ *                     of that identifier and overrides const_values
+ * @param opaque       a pointer which will be passed to all functions from funcs1 and funcs2
+ * @return 0 on success, a negative AVERROR code otherwise
+ */
+int av_expr_eval_array(AVExpr *e, double *res, int nb, const double *const_values,
+                       const double * const *const_arrays, void *opaque);
+
 /**
  * Track the presence of variables and their number of occurrences in a parsed expression
  *
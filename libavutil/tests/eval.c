@@ -37,6 +37,14 @@ static const char *const const_names[] = {
     0
 };
 
+static const char *const array_names[] = {
+    "X",
+    "Y",
+    0
+};
+
+#define NB_POINTS 300
+
 int main(int argc, char **argv)
 {
     int i;
@@ -140,6 +148,19 @@ int main(int argc, char **argv)
         "clip(0, 0/0, 1)",
         NULL
     };
+    static const char *const array_exprs[] = {
+        "X",
+        "-X*Y+3",
+        "if(gt(X,100), X/Y, -Y) + sin(X)^2",
+        "ifnot(mod(X,3), 1/(X-150))",
+        "clip(X, Y, 200) + between(X, 10, 20)",
+        "lerp(X, Y, 0.25) + squish(X) + hypot(X, Y) - atan2(X, 3)",
+        "bitand(X, 12) + bitor(Y, 3) + gcd(X, 30) + sgn(X-100)",
+        "st(0, ld(0)+X); ld(0)",
+        "random(0)*X",
+        NULL
+    };
+    double xs[NB_POINTS], res[NB_POINTS];
     int ret;
 
     for (expr = exprs; *expr; expr++) {
@@ -155,6 +176,32 @@ int main(int argc, char **argv)
             printf("av_expr_parse_and_eval failed\n");
     }
 
+    for (i = 0; i < NB_POINTS; i++)
+        xs[i] = i;
+    for (expr = array_exprs; *expr; expr++) {
+        const double values[] = { 0, 7, 0 };
+        const double *const arrays[] = { xs, NULL };
+        AVExpr *e = NULL, *e_ref = NULL;
+
+        if (av_expr_parse(&e,     *expr, array_names, NULL, NULL, NULL, NULL, 0, NULL) < 0 ||
+            av_expr_parse(&e_ref, *expr, array_names, NULL, NULL, NULL, NULL, 0, NULL) < 0 ||
+            av_expr_eval_array(e, res, NB_POINTS, values, arrays, NULL) < 0) {
+            printf("av_expr_eval_array('%s') failed\n", *expr);
+        } else {
+            double ref_values[] = { 0, 7, 0 };
+            for (i = 0; i < NB_POINTS; i++) {
+                ref_values[0] = xs[i];
+                d = av_expr_eval(e_ref, ref_values, NULL);
+                if (d != res[i] && !(isnan(d) && isnan(res[i])))
+                    break;
+            }
+            printf("av_expr_eval_array('%s') %s\n", *expr,
+                   i == NB_POINTS ? "matches av_expr_eval()" : "differs from av_expr_eval()");
+        }
+        av_expr_free(e);
+        av_expr_free(e_ref);
+    }
+
     ret = av_expr_parse_and_eval(&d, "1+(5-2)^(3-1)+1/2+sin(PI)-max(-2.2,-3.1)",
                            const_names, const_values,
                            NULL, NULL, NULL, NULL, NULL, 0, NULL);
@@ -118,6 +118,9 @@ struct AVTXContext {
     int        *pfatab; /* Input/Output mapping for compound transforms */
     int        *revtab; /* Input mapping for power of two transforms */
     int   *inplace_idx; /* Required indices to revtab for in-place transforms */
+
+    /* In-place power of two FFT of length m, on revtab-permuted input */
+    void (*fft)(FFTComplex *z);
 };
 
 /* Shared functions */
@@ -153,6 +156,8 @@ int ff_tx_init_mdct_fft_int32(AVTXContext *s, av_tx_fn *tx,
                               enum AVTXType type, int inv, int len,
                               const void *scale, uint64_t flags);
 
+void ff_tx_init_float_x86(AVTXContext *s);
+
 typedef struct CosTabsInitOnce {
     void (*func)(void);
     AVOnce control;
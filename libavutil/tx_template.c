@@ -367,7 +367,7 @@ static void compound_fft_##N##xM(AVTXContext *s, void *_out,                   \
     FFTComplex *in = _in;                                                      \
     FFTComplex *out = _out;                                                    \
     FFTComplex fft##N##in[N];                                                  \
-    void (*fftp)(FFTComplex *z) = fft_dispatch[av_log2(m)];                    \
+    void (*fftp)(FFTComplex *z) = s->fft;                                      \
                                                                                \
     for (int i = 0; i < m; i++) {                                              \
         for (int j = 0; j < N; j++)                                            \
@@ -391,7 +391,7 @@ static void monolithic_fft(AVTXContext *s, void *_out, void *_in,
 {
     FFTComplex *in = _in;
     FFTComplex *out = _out;
-    int m = s->m, mb = av_log2(m);
+    int m = s->m;
 
     if (s->flags & AV_TX_INPLACE) {
         FFTComplex tmp;
@@ -413,7 +413,7 @@ static void monolithic_fft(AVTXContext *s, void *_out, void *_in,
             out[i] = in[s->revtab[i]];
     }
 
-    fft_dispatch[mb](out);
+    s->fft(out);
 }
 
 static void naive_fft(AVTXContext *s, void *_out, void *_in,
@@ -450,7 +450,7 @@ static void compound_imdct_##N##xM(AVTXContext *s, void *_dst, void *_src,     \
     const int m = s->m, len8 = N*m >> 1;                                       \
     const int *in_map = s->pfatab, *out_map = in_map + N*m;                    \
     const FFTSample *src = _src, *in1, *in2;                                   \
-    void (*fftp)(FFTComplex *) = fft_dispatch[av_log2(m)];                     \
+    void (*fftp)(FFTComplex *) = s->fft;                                       \
                                                                                \
     stride /= sizeof(*src); /* To convert it from bytes */                     \
     in1 = src;                                                                 \
@@ -491,7 +491,7 @@ static void compound_mdct_##N##xM(AVTXContext *s, void *_dst, void *_src,      \
     FFTComplex *exp = s->exptab, tmp, fft##N##in[N];                           \
     const int m = s->m, len4 = N*m, len3 = len4 * 3, len8 = len4 >> 1;         \
     const int *in_map = s->pfatab, *out_map = in_map + N*m;                    \
-    void (*fftp)(FFTComplex *) = fft_dispatch[av_log2(m)];                     \
+    void (*fftp)(FFTComplex *) = s->fft;                                       \
                                                                                \
     stride /= sizeof(*dst);                                                    \
                                                                                \
@@ -537,7 +537,7 @@ static void monolithic_imdct(AVTXContext *s, void *_dst, void *_src,
     FFTComplex *z = _dst, *exp = s->exptab;
     const int m = s->m, len8 = m >> 1;
     const FFTSample *src = _src, *in1, *in2;
-    void (*fftp)(FFTComplex *) = fft_dispatch[av_log2(m)];
+    void (*fftp)(FFTComplex *) = s->fft;
 
     stride /= sizeof(*src);
     in1 = src;
@@ -566,7 +566,7 @@ static void monolithic_mdct(AVTXContext *s, void *_dst, void *_src,
     FFTSample *src = _src, *dst = _dst;
     FFTComplex *exp = s->exptab, tmp, *z = _dst;
     const int m = s->m, len4 = m, len3 = len4 * 3, len8 = len4 >> 1;
-    void (*fftp)(FFTComplex *) = fft_dispatch[av_log2(m)];
+    void (*fftp)(FFTComplex *) = s->fft;
 
     stride /= sizeof(*dst);
 
@@ -748,6 +748,11 @@ int TX_NAME(ff_tx_init_mdct_fft)(AVTXContext *s, av_tx_fn *tx,
         }
         for (int i = 4; i <= av_log2(m); i++)
             init_cos_tabs(i);
+        s->fft = fft_dispatch[av_log2(m)];
+#ifdef TX_FLOAT
+        if (ARCH_X86)
+            ff_tx_init_float_x86(s);
+#endif
     }
 
     if (is_mdct)
@@ -0,0 +1,191 @@
+;*****************************************************************************
+;* x86-optimized AES
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "x86util.asm"
+
+SECTION .text
+
+; The round keys are the ones computed by av_aes_init(): round_key[rounds] is
+; applied first and round_key[0] last, and the inner decryption keys already
+; have InvMixColumns applied, as aesdec expects.
+
+; %1 = aesenc/aesdec, %2 = number of blocks (in m0 ... m%2-1)
+; uses m4 and tmpq, expects tmpq = rounds * 16
+%macro AES_ROUNDS 2
+    mova          m4, [aq + tmpq]
+%assign i 0
+%rep %2
+    pxor         m %+ i, m4
+%assign i i+1
+%endrep
+    sub         tmpq, 16
+%%round:
+    mova          m4, [aq + tmpq]
+%assign i 0
+%rep %2
+    %1           m %+ i, m4
+%assign i i+1
+%endrep
+    sub         tmpq, 16
+    jnz %%round
+    mova          m4, [aq]
+%assign i 0
+%rep %2
+    %{1}last     m %+ i, m4
+%assign i i+1
+%endrep
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_aes_encrypt(AVAES *a, uint8_t *dst, const uint8_t *src,
+;                     int count, uint8_t *iv, int rounds)
+;-----------------------------------------------------------------------------
+INIT_XMM aesni
+cglobal aes_encrypt, 6, 7, 5, a, dst, src, count, iv, rounds, tmp
+    test      countd, countd
+    jle .end
+    shl     roundsd, 4
+    test        ivq, ivq
+    jz .ecb
+
+    ; CBC: every block depends on the previous one
+    movu          m1, [ivq]
+.cbc_loop:
+    movu          m0, [srcq]
+    pxor          m0, m1
+    mov         tmpq, roundsq
+    AES_ROUNDS aesenc, 1
+    movu      [dstq], m0
+    mova          m1, m0
+    add         srcq, 16
+    add         dstq, 16
+    dec       countd
+    jg .cbc_loop
+    movu       [ivq], m1
+    RET
+
+.ecb:
+    sub       countd, 4
+    jl .ecb_tail
+.ecb_loop4:
+    movu          m0, [srcq]
+    movu          m1, [srcq + 16]
+    movu          m2, [srcq + 32]
+    movu          m3, [srcq + 48]
+    mov         tmpq, roundsq
+    AES_ROUNDS aesenc, 4
+    movu [dstq     ], m0
+    movu [dstq + 16], m1
+    movu [dstq + 32], m2
+    movu [dstq + 48], m3
+    add         srcq, 64
+    add         dstq, 64
+    sub       countd, 4
+    jge .ecb_loop4
+.ecb_tail:
+    add       countd, 4
+    jz .end
+.ecb_loop1:
+    movu          m0, [srcq]
+    mov         tmpq, roundsq
+    AES_ROUNDS aesenc, 1
+    movu      [dstq], m0
+    add         srcq, 16
+    add         dstq, 16
+    dec       countd
+    jg .ecb_loop1
+.end:
+    RET
+
+;-----------------------------------------------------------------------------
+; void ff_aes_decrypt(AVAES *a, uint8_t *dst, const uint8_t *src,
+;                     int count, uint8_t *iv, int rounds)
+;-----------------------------------------------------------------------------
+; %1 = number of blocks, %2 = cbc
+; All source blocks needed for chaining are loaded before the first store, so
+; that dst may be equal to src.
+%macro AES_DECRYPT 2
+%assign i 0
+%rep %1
+    movu         m %+ i, [srcq + i * 16]
+%assign i i+1
+%endrep
+    mov         tmpq, roundsq
+    AES_ROUNDS aesdec, %1
+%if %2
+    pxor          m0, m5
+%assign i 1
+%rep %1 - 1
+    movu          m5, [srcq + (i - 1) * 16]
+    pxor         m %+ i, m5
+%assign i i+1
+%endrep
+    movu          m5, [srcq + (%1 - 1) * 16]
+%endif
+%assign i 0
+%rep %1
+    movu [dstq + i * 16], m %+ i
+%assign i i+1
+%endrep
+    add         srcq, %1 * 16
+    add         dstq, %1 * 16
+%endmacro
+
+cglobal aes_decrypt, 6, 7, 6, a, dst, src, count, iv, rounds, tmp
+    test      countd, countd
+    jle .end
+    shl     roundsd, 4
+    test        ivq, ivq
+    jz .ecb
+
+    movu          m5, [ivq]
+    sub       countd, 4
+    jl .cbc_tail
+.cbc_loop4:
+    AES_DECRYPT 4, 1
+    sub       countd, 4
+    jge .cbc_loop4
+.cbc_tail:
+    add       countd, 4
+    jz .cbc_end
+.cbc_loop1:
+    AES_DECRYPT 1, 1
+    dec       countd
+    jg .cbc_loop1
+.cbc_end:
+    movu       [ivq], m5
+    RET
+
+.ecb:
+    sub       countd, 4
+    jl .ecb_tail
+.ecb_loop4:
+    AES_DECRYPT 4, 0
+    sub       countd, 4
+    jge .ecb_loop4
+.ecb_tail:
+    add       countd, 4
+    jz .end
+.ecb_loop1:
+    AES_DECRYPT 1, 0
+    dec       countd
+    jg .ecb_loop1
+.end:
+    RET
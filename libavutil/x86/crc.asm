@@ -0,0 +1,169 @@
+;*****************************************************************************
+;* x86-optimized CRC
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "x86util.asm"
+
+SECTION_RODATA
+
+pb_reverse: db 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+pd_low32:   dd -1, 0, -1, 0
+
+SECTION .text
+
+; Folding CRC computation with carry-less multiplication, as described in
+; "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+; (Intel, 2009). The constants are documented in crc_init.c.
+
+; %1 = dst, %2 = src
+%macro LOAD 2
+    movu          %1, %2
+%if BE
+    pshufb        %1, m7
+%endif
+%endmacro
+
+; fold %1 forward by the distance encoded in %3 and add %4, uses %2
+%macro FOLD 4
+    mova          %2, %1
+    pclmulqdq     %1, %3, 0x00
+    pclmulqdq     %2, %3, 0x11
+    pxor          %1, %2
+    pxor          %1, %4
+%endmacro
+
+;-----------------------------------------------------------------------------
+; uint32_t ff_crc_{le,be}(const uint64_t *k, uint32_t crc,
+;                         const uint8_t *buffer, size_t length)
+; length must be a non-zero multiple of 16
+;-----------------------------------------------------------------------------
+%macro CRC 1
+%ifidn %1, be
+    %define BE 1
+%else
+    %define BE 0
+%endif
+cglobal crc_%1, 4, 4, 8, k, crc, buf, len
+%if BE
+    mova          m7, [pb_reverse]
+%endif
+    LOAD          m0, [bufq]
+    movd          m1, crcd
+%if BE
+    pslldq        m1, 12
+%endif
+    pxor          m0, m1
+    cmp         lenq, 64
+    jb .fold1
+
+    LOAD          m1, [bufq + 16]
+    LOAD          m2, [bufq + 32]
+    LOAD          m3, [bufq + 48]
+    add         bufq, 64
+    sub         lenq, 64
+    mova          m6, [kq]
+.loop4:
+    cmp         lenq, 64
+    jb .reduce4
+    LOAD          m4, [bufq]
+    FOLD          m0, m5, m6, m4
+    LOAD          m4, [bufq + 16]
+    FOLD          m1, m5, m6, m4
+    LOAD          m4, [bufq + 32]
+    FOLD          m2, m5, m6, m4
+    LOAD          m4, [bufq + 48]
+    FOLD          m3, m5, m6, m4
+    add         bufq, 64
+    sub         lenq, 64
+    jmp .loop4
+.reduce4:
+    mova          m6, [kq + 16]
+    FOLD          m0, m5, m6, m1
+    FOLD          m0, m5, m6, m2
+    FOLD          m0, m5, m6, m3
+    jmp .loop1
+
+.fold1:
+    add         bufq, 16
+    sub         lenq, 16
+    mova          m6, [kq + 16]
+.loop1:
+    test        lenq, lenq
+    jz .reduce
+    LOAD          m4, [bufq]
+    FOLD          m0, m5, m6, m4
+    add         bufq, 16
+    sub         lenq, 16
+    jmp .loop1
+
+.reduce:
+%if BE
+    ; 128 -> 96 bits, multiplying by x^32 on the way
+    mova          m2, [kq + 32]
+    mova          m1, m0
+    pclmulqdq     m1, m2, 0x11
+    pslldq        m0, 8
+    psrldq        m0, 4
+    pxor          m0, m1
+    ; 96 -> 64 bits
+    mova          m1, m0
+    psrldq        m1, 8
+    pclmulqdq     m1, m2, 0x00
+    movq          m0, m0
+    pxor          m0, m1
+    ; Barrett reduction, 64 -> 32 bits
+    mova          m2, [kq + 48]
+    mova          m1, m0
+    psrlq         m1, 32
+    pclmulqdq     m1, m2, 0x10
+    psrlq         m1, 32
+    pclmulqdq     m1, m2, 0x00
+    pxor          m0, m1
+    movd         eax, m0
+%else
+    ; 128 -> 64 bits
+    mova          m1, m0
+    psrldq        m0, 8
+    pclmulqdq     m1, m6, 0x10
+    pxor          m0, m1
+    ; 64 -> 32 bits, multiplying by x^32 on the way
+    mova          m3, [pd_low32]
+    mova          m2, [kq + 32]
+    mova          m1, m0
+    pand          m1, m3
+    psrldq        m0, 4
+    pclmulqdq     m1, m2, 0x00
+    pxor          m0, m1
+    ; Barrett reduction
+    mova          m2, [kq + 48]
+    mova          m1, m0
+    pand          m1, m3
+    pclmulqdq     m1, m2, 0x10
+    pand          m1, m3
+    pclmulqdq     m1, m2, 0x00
+    pxor          m0, m1
+    pextrd       eax, m0, 1
+%endif
+    RET
+%undef BE
+%endmacro
+
+INIT_XMM clmul
+CRC le
+CRC be
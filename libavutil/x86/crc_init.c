@@ -0,0 +1,115 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/bswap.h"
+#include "libavutil/cpu.h"
+#include "libavutil/crc.h"
+#include "libavutil/crc_internal.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/x86/cpu.h"
+
+uint32_t ff_crc_le_clmul(const uint64_t *k, uint32_t crc,
+                         const uint8_t *buffer, size_t length);
+uint32_t ff_crc_be_clmul(const uint64_t *k, uint32_t crc,
+                         const uint8_t *buffer, size_t length);
+
+/*
+ * Every av_crc() table behaves as a 32-bit CRC: the big-endian ones use the
+ * polynomial x^32 + (poly << (32 - bits)) on a byte-swapped state, the
+ * little-endian ones the reflected polynomial as is. With P that polynomial,
+ * the constants are, for the big-endian CRCs:
+ *   x^512 mod P, x^576 mod P  (fold by 4 blocks)
+ *   x^128 mod P, x^192 mod P  (fold by 1 block)
+ *   x^64  mod P, x^96  mod P  (128 -> 32 bits)
+ *   P, floor(x^64 / P)        (Barrett reduction)
+ * and for the little-endian CRCs the bit-reflected and shifted equivalents:
+ *   (x^544 mod P)' << 1, (x^480 mod P)' << 1
+ *   (x^160 mod P)' << 1, (x^96  mod P)' << 1
+ *   (x^64  mod P)' << 1, 0
+ *   P', floor(x^64 / P)'
+ */
+static const DECLARE_ALIGNED(16, uint64_t, crc_clmul_k)[AV_CRC_MAX][8] = {
+    [AV_CRC_8_ATM] = {
+        0x0bc000000, 0x032000000,
+        0x094000000, 0x0c4000000,
+        0x062000000, 0x079000000,
+        0x107000000, 0x107156a16,
+    },
+    [AV_CRC_16_ANSI] = {
+        0x0807d0000, 0x0f9e30000,
+        0x0ff830000, 0x0f9130000,
+        0x0807b0000, 0x086630000,
+        0x180050000, 0x1fffbffe7,
+    },
+    [AV_CRC_16_CCITT] = {
+        0x059b00000, 0x060190000,
+        0x045630000, 0x0d5f60000,
+        0x0aa510000, 0x0eb230000,
+        0x110210000, 0x111303471,
+    },
+    [AV_CRC_32_IEEE] = {
+        0x0e6228b11, 0x08833794c,
+        0x0e8a45605, 0x0c5b9cd4c,
+        0x0490d678d, 0x0f200aa66,
+        0x104c11db7, 0x104d101df,
+    },
+    [AV_CRC_32_IEEE_LE] = {
+        0x154442bd4, 0x1c6e41596,
+        0x1751997d0, 0x0ccaa009e,
+        0x163cd6124, 0x000000000,
+        0x1db710641, 0x1f7011641,
+    },
+    [AV_CRC_16_ANSI_LE] = {
+        0x00001b0c2, 0x00000bffa,
+        0x00001d0c2, 0x000018cc2,
+        0x00001bc02, 0x000000000,
+        0x000014003, 0x1cfffbfff,
+    },
+    [AV_CRC_24_IEEE] = {
+        0x0467d2400, 0x01f428700,
+        0x064e4d700, 0x02c8c9d00,
+        0x0d9fe8c00, 0x0fd7e0c00,
+        0x1864cfb00, 0x1f845fe24,
+    },
+    [AV_CRC_8_EBU] = {
+        0x0f3000000, 0x0b5000000,
+        0x00d000000, 0x0fc000000,
+        0x06a000000, 0x065000000,
+        0x11d000000, 0x11c4b8192,
+    },
+};
+
+static uint32_t crc_clmul(AVCRCId crc_id, uint32_t crc,
+                          const uint8_t *buffer, size_t length)
+{
+    const uint64_t *k = crc_clmul_k[crc_id];
+
+    if (crc_id == AV_CRC_32_IEEE_LE || crc_id == AV_CRC_16_ANSI_LE)
+        return ff_crc_le_clmul(k, crc, buffer, length);
+    return av_bswap32(ff_crc_be_clmul(k, av_bswap32(crc), buffer, length));
+}
+
+ff_crc_func ff_crc_get_func_x86(int cpu_flags)
+{
+    if (EXTERNAL_CLMUL(cpu_flags))
+        return crc_clmul;
+    return NULL;
+}
@@ -463,6 +463,45 @@ cglobal scalarproduct_float, 3,3,2, v1, v2, offset
 %endif
     RET
 
+;-----------------------------------------------------------------------------
+; float scalarproduct_float_fma3(const float *v1, const float *v2, int len)
+;-----------------------------------------------------------------------------
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+cglobal scalarproduct_float, 3,3,2, v1, v2, offset
+    shl   offsetd, 2
+    add       v1q, offsetq
+    add       v2q, offsetq
+    neg   offsetq
+    xorps      m0, m0, m0
+    add   offsetq, mmsize
+    jg .tail
+.loop:
+    movu       m1, [v1q+offsetq-mmsize]
+    fmaddps    m0, m1, [v2q+offsetq-mmsize], m0
+    add   offsetq, mmsize
+    jle .loop
+.tail:
+    vextractf128 xm1, m0, 1
+    addps     xm0, xm1
+    ; len is only a multiple of 4, so there may be 4 floats left
+    cmp   offsetq, mmsize
+    je .end
+    movu      xm1, [v1q+offsetq-mmsize]
+    fmaddps   xm0, xm1, [v2q+offsetq-mmsize], xm0
+.end:
+    movhlps   xm1, xm0
+    addps     xm0, xm1
+    movss     xm1, xm0
+    shufps    xm0, xm0, 1
+    addss     xm0, xm1
+%if ARCH_X86_64 == 0
+    movss     r0m, xm0
+    fld dword r0m
+%endif
+    RET
+%endif
+
 ;-----------------------------------------------------------------------------
 ; void ff_butterflies_float(float *src0, float *src1, int len);
 ;-----------------------------------------------------------------------------
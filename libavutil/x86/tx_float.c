@@ -0,0 +1,355 @@
+/*
+ * SIMD-optimized power of two FFT for the float av_tx transforms
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/x86/asm.h"
+#include "libavutil/x86/cpu.h"
+
+#define TX_FLOAT
+#include "libavutil/tx_priv.h"
+
+/*
+ * These follow the split-radix recursion of the C version in tx_template.c
+ * and do the same butterflies on whole vectors of complex values. The output
+ * may differ from the C one in the last bits due to rounding.
+ */
+
+#if HAVE_SSE3_INLINE
+
+extern COSTABLE(16);
+extern COSTABLE(32);
+extern COSTABLE(64);
+extern COSTABLE(128);
+extern COSTABLE(256);
+extern COSTABLE(512);
+extern COSTABLE(1024);
+extern COSTABLE(2048);
+extern COSTABLE(4096);
+extern COSTABLE(8192);
+extern COSTABLE(16384);
+extern COSTABLE(32768);
+extern COSTABLE(65536);
+extern COSTABLE(131072);
+
+/* twiddles of the two odd outputs of fft8: 1 and e^(i*pi/4) */
+DECLARE_ALIGNED(16, static const float, fft8_wre)[4] = {
+    1.0f, 1.0f, M_SQRT1_2, M_SQRT1_2,
+};
+DECLARE_ALIGNED(16, static const float, fft8_wim)[4] = {
+    0.0f, 0.0f, M_SQRT1_2, M_SQRT1_2,
+};
+
+/*
+ * Combine z[0], z[o1], z[o2] and z[o3] with the twiddles wre in xmm4 and wim
+ * in xmm5, for 2 consecutive complex values.
+ * %0: z, %1: o1 in bytes, %2: z + o3
+ */
+#define TRANSFORM_SSE3                                                         \
+    "movups      (%0),        %%xmm0        \n\t"                              \
+    "movups      (%0,%1),     %%xmm1        \n\t"                              \
+    "movups      (%0,%1,2),   %%xmm2        \n\t"                              \
+    "movups      (%2),        %%xmm3        \n\t"                              \
+    /* z[o2] * conj(w) */                                                      \
+    "movaps      %%xmm2,      %%xmm6        \n\t"                              \
+    "shufps $0xb1, %%xmm6,    %%xmm6        \n\t"                              \
+    "mulps       %%xmm4,      %%xmm6        \n\t"                              \
+    "mulps       %%xmm5,      %%xmm2        \n\t"                              \
+    "addsubps    %%xmm2,      %%xmm6        \n\t"                              \
+    "shufps $0xb1, %%xmm6,    %%xmm6        \n\t"                              \
+    /* z[o3] * w */                                                            \
+    "movaps      %%xmm3,      %%xmm7        \n\t"                              \
+    "shufps $0xb1, %%xmm7,    %%xmm7        \n\t"                              \
+    "mulps       %%xmm5,      %%xmm7        \n\t"                              \
+    "mulps       %%xmm4,      %%xmm3        \n\t"                              \
+    "addsubps    %%xmm7,      %%xmm3        \n\t"                              \
+    "movaps      %%xmm3,      %%xmm2        \n\t"                              \
+    "addps       %%xmm6,      %%xmm2        \n\t"                              \
+    "subps       %%xmm6,      %%xmm3        \n\t"                              \
+    "movaps      %%xmm0,      %%xmm4        \n\t"                              \
+    "addps       %%xmm2,      %%xmm4        \n\t"                              \
+    "subps       %%xmm2,      %%xmm0        \n\t"                              \
+    "movaps      %%xmm3,      %%xmm6        \n\t"                              \
+    "shufps $0xb1, %%xmm6,    %%xmm6        \n\t"                              \
+    "movaps      %%xmm1,      %%xmm7        \n\t"                              \
+    "shufps $0xb1, %%xmm7,    %%xmm7        \n\t"                              \
+    "addsubps    %%xmm6,      %%xmm1        \n\t"                              \
+    "addsubps    %%xmm3,      %%xmm7        \n\t"                              \
+    "shufps $0xb1, %%xmm7,    %%xmm7        \n\t"                              \
+    "movups      %%xmm4,      (%0)          \n\t"                              \
+    "movups      %%xmm1,      (%0,%1)       \n\t"                              \
+    "movups      %%xmm0,      (%0,%1,2)     \n\t"                              \
+    "movups      %%xmm7,      (%2)          \n\t"
+
+#define TRANSFORM_SSE3_CLOBBERS                                                \
+    XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",                           \
+                 "%xmm4", "%xmm5", "%xmm6", "%xmm7",) "memory"
+
+static void fft4_sse3(FFTComplex *z)
+{
+    __asm__ volatile(
+        "movups      (%0),        %%xmm0        \n\t"
+        "movups    16(%0),        %%xmm1        \n\t"
+        "movaps      %%xmm0,      %%xmm2        \n\t"
+        "shufps $0x4e, %%xmm2,    %%xmm2        \n\t"
+        "movaps      %%xmm0,      %%xmm3        \n\t"
+        "addps       %%xmm2,      %%xmm3        \n\t"
+        "subps       %%xmm2,      %%xmm0        \n\t"
+        "shufps $0x44, %%xmm0,    %%xmm3        \n\t"
+        "movaps      %%xmm1,      %%xmm2        \n\t"
+        "shufps $0x4e, %%xmm2,    %%xmm2        \n\t"
+        "movaps      %%xmm1,      %%xmm4        \n\t"
+        "addps       %%xmm2,      %%xmm4        \n\t"
+        "subps       %%xmm1,      %%xmm2        \n\t"
+        "shufps $0x44, %%xmm2,    %%xmm4        \n\t"
+        "movaps      %%xmm3,      %%xmm5        \n\t"
+        "addps       %%xmm4,      %%xmm5        \n\t"
+        "movaps      %%xmm3,      %%xmm6        \n\t"
+        "subps       %%xmm4,      %%xmm6        \n\t"
+        "movaps      %%xmm4,      %%xmm7        \n\t"
+        "shufps $0xb1, %%xmm7,    %%xmm7        \n\t"
+        "movaps      %%xmm3,      %%xmm0        \n\t"
+        "addsubps    %%xmm7,      %%xmm0        \n\t"
+        "shufps $0xb1, %%xmm3,    %%xmm3        \n\t"
+        "addsubps    %%xmm4,      %%xmm3        \n\t"
+        "shufps $0xb1, %%xmm3,    %%xmm3        \n\t"
+        "movsd       %%xmm5,      %%xmm0        \n\t"
+        "movsd       %%xmm6,      %%xmm3        \n\t"
+        "movups      %%xmm0,      (%0)          \n\t"
+        "movups      %%xmm3,    16(%0)          \n\t"
+        :
+        : "r"(z)
+        : TRANSFORM_SSE3_CLOBBERS
+    );
+}
+
+static void fft8_sse3(FFTComplex *z)
+{
+    fft4_sse3(z);
+
+    __asm__ volatile(
+        /* the two size 2 FFTs of z[4..7] */
+        "movups    32(%0),        %%xmm0        \n\t"
+        "movups    48(%0),        %%xmm1        \n\t"
+        "movaps      %%xmm0,      %%xmm2        \n\t"
+        "shufps $0x4e, %%xmm2,    %%xmm2        \n\t"
+        "movaps      %%xmm0,      %%xmm3        \n\t"
+        "addps       %%xmm2,      %%xmm3        \n\t"
+        "subps       %%xmm2,      %%xmm0        \n\t"
+        "shufps $0x44, %%xmm0,    %%xmm3        \n\t"
+        "movaps      %%xmm1,      %%xmm2        \n\t"
+        "shufps $0x4e, %%xmm2,    %%xmm2        \n\t"
+        "movaps      %%xmm1,      %%xmm4        \n\t"
+        "addps       %%xmm2,      %%xmm4        \n\t"
+        "subps       %%xmm2,      %%xmm1        \n\t"
+        "shufps $0x44, %%xmm1,    %%xmm4        \n\t"
+        "movups      %%xmm3,    32(%0)          \n\t"
+        "movups      %%xmm4,    48(%0)          \n\t"
+        "movaps      (%3),        %%xmm4        \n\t"
+        "movaps      (%4),        %%xmm5        \n\t"
+        TRANSFORM_SSE3
+        :
+        : "r"(z), "r"((x86_reg)(2 * sizeof(*z))), "r"(z + 6),
+          "r"(fft8_wre), "r"(fft8_wim)
+        : TRANSFORM_SSE3_CLOBBERS
+    );
+}
+
+/* z[0...8n-1], w[1...2n-1], n >= 2 */
+static void pass_sse3(FFTComplex *z, const FFTSample *wre, unsigned int n)
+{
+    const x86_reg o1 = 2 * n * sizeof(*z);
+    const FFTSample *wim = wre + 2 * n;
+    FFTComplex *z3 = z + 6 * n;
+
+    /* the first twiddle is exactly 1, as in TRANSFORM_ZERO */
+    __asm__ volatile(
+        "movsd       (%3),        %%xmm4        \n\t"
+        "unpcklps    %%xmm4,      %%xmm4        \n\t"
+        "movss     -4(%4),        %%xmm5        \n\t"
+        "shufps $0x05, %%xmm5,    %%xmm5        \n\t"
+        TRANSFORM_SSE3
+        :
+        : "r"(z), "r"(o1), "r"(z3), "r"(wre), "r"(wim)
+        : TRANSFORM_SSE3_CLOBBERS
+    );
+
+    while (--n) {
+        z   += 2;
+        z3  += 2;
+        wre += 2;
+        wim -= 2;
+        __asm__ volatile(
+            "movsd       (%3),        %%xmm4        \n\t"
+            "unpcklps    %%xmm4,      %%xmm4        \n\t"
+            "movsd     -4(%4),        %%xmm5        \n\t"
+            "shufps $0x05, %%xmm5,    %%xmm5        \n\t"
+            TRANSFORM_SSE3
+            :
+            : "r"(z), "r"(o1), "r"(z3), "r"(wre), "r"(wim)
+            : TRANSFORM_SSE3_CLOBBERS
+        );
+    }
+}
+
+#define DECL_FFT(n, n2, n4, ext)                                               \
+static void fft##n##_##ext(FFTComplex *z)                                      \
+{                                                                              \
+    fft##n2##_##ext(z);                                                        \
+    fft##n4##_##ext(z + n4*2);                                                 \
+    fft##n4##_##ext(z + n4*3);                                                 \
+    pass_##ext(z, ff_cos_##n##_float, n4/2);                                   \
+}
+
+#define DECL_FFTS(ext)                                                         \
+DECL_FFT(16, 8, 4, ext)                                                        \
+DECL_FFT(32, 16, 8, ext)                                                       \
+DECL_FFT(64, 32, 16, ext)                                                      \
+DECL_FFT(128, 64, 32, ext)                                                     \
+DECL_FFT(256, 128, 64, ext)                                                    \
+DECL_FFT(512, 256, 128, ext)                                                   \
+DECL_FFT(1024, 512, 256, ext)                                                  \
+DECL_FFT(2048, 1024, 512, ext)                                                 \
+DECL_FFT(4096, 2048, 1024, ext)                                                \
+DECL_FFT(8192, 4096, 2048, ext)                                                \
+DECL_FFT(16384, 8192, 4096, ext)                                               \
+DECL_FFT(32768, 16384, 8192, ext)                                              \
+DECL_FFT(65536, 32768, 16384, ext)                                             \
+DECL_FFT(131072, 65536, 32768, ext)                                            \
+                                                                               \
+static void (* const fft_dispatch_##ext[])(FFTComplex *) = {                   \
+    NULL, NULL, fft4_##ext, fft8_##ext, fft16_##ext, fft32_##ext,              \
+    fft64_##ext, fft128_##ext, fft256_##ext, fft512_##ext, fft1024_##ext,      \
+    fft2048_##ext, fft4096_##ext, fft8192_##ext, fft16384_##ext,               \
+    fft32768_##ext, fft65536_##ext, fft131072_##ext,                           \
+};
+
+DECL_FFTS(sse3)
+
+#endif /* HAVE_SSE3_INLINE */
+
+#if HAVE_AVX_INLINE
+
+/* As TRANSFORM_SSE3, for 4 consecutive complex values */
+#define TRANSFORM_AVX                                                          \
+    "vmovups     (%0),        %%ymm0                \n\t"                      \
+    "vmovups     (%0,%1),     %%ymm1                \n\t"                      \
+    "vmovups     (%0,%1,2),   %%ymm2                \n\t"                      \
+    "vmovups     (%2),        %%ymm3                \n\t"                      \
+    "vshufps $0xb1, %%ymm2,   %%ymm2,   %%ymm6      \n\t"                      \
+    "vmulps      %%ymm4,      %%ymm6,   %%ymm6      \n\t"                      \
+    "vmulps      %%ymm5,      %%ymm2,   %%ymm2      \n\t"                      \
+    "vaddsubps   %%ymm2,      %%ymm6,   %%ymm6      \n\t"                      \
+    "vshufps $0xb1, %%ymm6,   %%ymm6,   %%ymm6      \n\t"                      \
+    "vshufps $0xb1, %%ymm3,   %%ymm3,   %%ymm7      \n\t"                      \
+    "vmulps      %%ymm5,      %%ymm7,   %%ymm7      \n\t"                      \
+    "vmulps      %%ymm4,      %%ymm3,   %%ymm3      \n\t"                      \
+    "vaddsubps   %%ymm7,      %%ymm3,   %%ymm3      \n\t"                      \
+    "vaddps      %%ymm6,      %%ymm3,   %%ymm2      \n\t"                      \
+    "vsubps      %%ymm6,      %%ymm3,   %%ymm3      \n\t"                      \
+    "vaddps      %%ymm2,      %%ymm0,   %%ymm4      \n\t"                      \
+    "vsubps      %%ymm2,      %%ymm0,   %%ymm5      \n\t"                      \
+    "vshufps $0xb1, %%ymm3,   %%ymm3,   %%ymm6      \n\t"                      \
+    "vaddsubps   %%ymm6,      %%ymm1,   %%ymm6      \n\t"                      \
+    "vshufps $0xb1, %%ymm1,   %%ymm1,   %%ymm7      \n\t"                      \
+    "vaddsubps   %%ymm3,      %%ymm7,   %%ymm7      \n\t"                      \
+    "vshufps $0xb1, %%ymm7,   %%ymm7,   %%ymm7      \n\t"                      \
+    "vmovups     %%ymm4,      (%0)                  \n\t"                      \
+    "vmovups     %%ymm6,      (%0,%1)               \n\t"                      \
+    "vmovups     %%ymm5,      (%0,%1,2)             \n\t"                      \
+    "vmovups     %%ymm7,      (%2)                  \n\t"
+
+/* Load wre[0..3] and wim[0..-3] duplicated for each real and imaginary part,
+ * optionally with wim[0] set to 0 */
+#define LOAD_TWIDDLES_AVX(first)                                               \
+    "vmovups     (%3),        %%xmm4                \n\t"                      \
+    "vunpcklps   %%xmm4,      %%xmm4,   %%xmm6      \n\t"                      \
+    "vunpckhps   %%xmm4,      %%xmm4,   %%xmm4      \n\t"                      \
+    "vinsertf128 $1, %%xmm4,  %%ymm6,   %%ymm4      \n\t"                      \
+    "vmovups  -12(%4),        %%xmm5                \n\t"                      \
+    "vshufps $0x1b, %%xmm5,   %%xmm5,   %%xmm5      \n\t"                      \
+    first                                                                      \
+    "vunpcklps   %%xmm5,      %%xmm5,   %%xmm7      \n\t"                      \
+    "vunpckhps   %%xmm5,      %%xmm5,   %%xmm5      \n\t"                      \
+    "vinsertf128 $1, %%xmm5,  %%ymm7,   %%ymm5      \n\t"
+
+#define ZERO_FIRST_WIM_AVX                                                     \
+    "vxorps      %%xmm7,      %%xmm7,   %%xmm7      \n\t"                      \
+    "vblendps $1, %%xmm7,     %%xmm5,   %%xmm5      \n\t"
+
+/* z[0...8n-1], w[1...2n-1], n >= 2 */
+static void pass_avx(FFTComplex *z, const FFTSample *wre, unsigned int n)
+{
+    const x86_reg o1 = 2 * n * sizeof(*z);
+    const FFTSample *wim = wre + 2 * n;
+    FFTComplex *z3 = z + 6 * n;
+
+    n >>= 1;
+
+    __asm__ volatile(
+        LOAD_TWIDDLES_AVX(ZERO_FIRST_WIM_AVX)
+        TRANSFORM_AVX
+        :
+        : "r"(z), "r"(o1), "r"(z3), "r"(wre), "r"(wim)
+        : TRANSFORM_SSE3_CLOBBERS
+    );
+
+    while (--n) {
+        z   += 4;
+        z3  += 4;
+        wre += 4;
+        wim -= 4;
+        __asm__ volatile(
+            LOAD_TWIDDLES_AVX("")
+            TRANSFORM_AVX
+            :
+            : "r"(z), "r"(o1), "r"(z3), "r"(wre), "r"(wim)
+            : TRANSFORM_SSE3_CLOBBERS
+        );
+    }
+
+    __asm__ volatile("vzeroupper" ::: TRANSFORM_SSE3_CLOBBERS);
+}
+
+#define fft4_avx fft4_sse3
+#define fft8_avx fft8_sse3
+
+DECL_FFTS(avx)
+
+#endif /* HAVE_AVX_INLINE */
+
+av_cold void ff_tx_init_float_x86(AVTXContext *s)
+{
+    int cpu_flags = av_get_cpu_flags();
+    int mb = av_log2(s->m);
+
+    if (mb < 2)
+        return;
+
+#if HAVE_SSE3_INLINE
+    if (INLINE_SSE3(cpu_flags))
+        s->fft = fft_dispatch_sse3[mb];
+#endif
+#if HAVE_AVX_INLINE
+    if (INLINE_AVX_FAST(cpu_flags))
+        s->fft = fft_dispatch_avx[mb];
+#endif
+}
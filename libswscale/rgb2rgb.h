@@ -142,6 +142,27 @@ extern void (*deinterleaveBytes)(const uint8_t *src, uint8_t *dst1, uint8_t *dst
                                  int width, int height, int srcStride,
                                  int dst1Stride, int dst2Stride);
 
+/*
+ * The *Words functions operate on native-endian 16-bit samples and shift
+ * every sample left or right by shift bits. Widths are in samples, strides
+ * in bytes.
+ */
+extern void (*lshiftWords)(const uint8_t *src, uint8_t *dst,
+                           int width, int height,
+                           int srcStride, int dstStride, int shift);
+
+extern void (*rshiftWords)(const uint8_t *src, uint8_t *dst,
+                           int width, int height,
+                           int srcStride, int dstStride, int shift);
+
+extern void (*interleaveWords)(const uint8_t *src1, const uint8_t *src2, uint8_t *dst,
+                               int width, int height, int src1Stride,
+                               int src2Stride, int dstStride, int shift);
+
+extern void (*deinterleaveWords)(const uint8_t *src, uint8_t *dst1, uint8_t *dst2,
+                                 int width, int height, int srcStride,
+                                 int dst1Stride, int dst2Stride, int shift);
+
 extern void (*vu9_to_vu12)(const uint8_t *src1, const uint8_t *src2,
                            uint8_t *dst1, uint8_t *dst2,
                            int width, int height,
@@ -166,6 +187,12 @@ extern void (*yuyvtoyuv420)(uint8_t *ydst, uint8_t *udst, uint8_t *vdst, const u
 extern void (*yuyvtoyuv422)(uint8_t *ydst, uint8_t *udst, uint8_t *vdst, const uint8_t *src,
                             int width, int height,
                             int lumStride, int chromStride, int srcStride);
+/**
+ * Width should be a multiple of 2, samples are shifted right by shift bits.
+ */
+extern void (*y210toyuv422)(uint8_t *ydst, uint8_t *udst, uint8_t *vdst, const uint8_t *src,
+                            int width, int height,
+                            int lumStride, int chromStride, int srcStride, int shift);
 
 void ff_sws_rgb2rgb_init(void);
 
@@ -743,6 +743,83 @@ static void deinterleaveBytes_c(const uint8_t *src, uint8_t *dst1, uint8_t *dst2
     }
 }
 
+static void lshiftWords_c(const uint8_t *src, uint8_t *dst,
+                          int width, int height,
+                          int srcStride, int dstStride, int shift)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        const uint16_t *s = (const uint16_t *)src;
+        uint16_t *d       = (uint16_t *)dst;
+        int w;
+        for (w = 0; w < width; w++)
+            d[w] = s[w] << shift;
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+static void rshiftWords_c(const uint8_t *src, uint8_t *dst,
+                          int width, int height,
+                          int srcStride, int dstStride, int shift)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        const uint16_t *s = (const uint16_t *)src;
+        uint16_t *d       = (uint16_t *)dst;
+        int w;
+        for (w = 0; w < width; w++)
+            d[w] = s[w] >> shift;
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+static void interleaveWords_c(const uint8_t *src1, const uint8_t *src2,
+                              uint8_t *dest, int width, int height,
+                              int src1Stride, int src2Stride, int dstStride,
+                              int shift)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        const uint16_t *s1 = (const uint16_t *)src1;
+        const uint16_t *s2 = (const uint16_t *)src2;
+        uint16_t *d        = (uint16_t *)dest;
+        int w;
+        for (w = 0; w < width; w++) {
+            d[2 * w + 0] = s1[w] << shift;
+            d[2 * w + 1] = s2[w] << shift;
+        }
+        dest += dstStride;
+        src1 += src1Stride;
+        src2 += src2Stride;
+    }
+}
+
+static void deinterleaveWords_c(const uint8_t *src, uint8_t *dst1, uint8_t *dst2,
+                                int width, int height, int srcStride,
+                                int dst1Stride, int dst2Stride, int shift)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        const uint16_t *s = (const uint16_t *)src;
+        uint16_t *d1      = (uint16_t *)dst1;
+        uint16_t *d2      = (uint16_t *)dst2;
+        int w;
+        for (w = 0; w < width; w++) {
+            d1[w] = s[2 * w + 0] >> shift;
+            d2[w] = s[2 * w + 1] >> shift;
+        }
+        src  += srcStride;
+        dst1 += dst1Stride;
+        dst2 += dst2Stride;
+    }
+}
+
 static inline void vu9_to_vu12_c(const uint8_t *src1, const uint8_t *src2,
                                  uint8_t *dst1, uint8_t *dst2,
                                  int width, int height,
@@ -944,6 +1021,33 @@ static void uyvytoyuv422_c(uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
     }
 }
 
+static void y210toyuv422_c(uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
+                           const uint8_t *src, int width, int height,
+                           int lumStride, int chromStride, int srcStride,
+                           int shift)
+{
+    int x, y;
+
+    for (y = 0; y < height; y++) {
+        const uint16_t *s = (const uint16_t *)src;
+        uint16_t *yd      = (uint16_t *)ydst;
+        uint16_t *ud      = (uint16_t *)udst;
+        uint16_t *vd      = (uint16_t *)vdst;
+
+        for (x = 0; x < width / 2; x++) {
+            yd[2 * x + 0] = s[4 * x + 0] >> shift;
+            ud[x]         = s[4 * x + 1] >> shift;
+            yd[2 * x + 1] = s[4 * x + 2] >> shift;
+            vd[x]         = s[4 * x + 3] >> shift;
+        }
+
+        src  += srcStride;
+        ydst += lumStride;
+        udst += chromStride;
+        vdst += chromStride;
+    }
+}
+
 static av_cold void rgb2rgb_init_c(void)
 {
     rgb15to16          = rgb15to16_c;
@@ -982,6 +1086,10 @@ static av_cold void rgb2rgb_init_c(void)
     ff_rgb24toyv12     = ff_rgb24toyv12_c;
     interleaveBytes    = interleaveBytes_c;
     deinterleaveBytes  = deinterleaveBytes_c;
+    lshiftWords        = lshiftWords_c;
+    rshiftWords        = rshiftWords_c;
+    interleaveWords    = interleaveWords_c;
+    deinterleaveWords  = deinterleaveWords_c;
     vu9_to_vu12        = vu9_to_vu12_c;
     yvu9_to_yuy2       = yvu9_to_yuy2_c;
 
@@ -989,4 +1097,5 @@ static av_cold void rgb2rgb_init_c(void)
     uyvytoyuv422       = uyvytoyuv422_c;
     yuyvtoyuv420       = yuyvtoyuv420_c;
     yuyvtoyuv422       = yuyvtoyuv422_c;
+    y210toyuv422       = y210toyuv422_c;
 }
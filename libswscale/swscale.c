@@ -235,10 +235,17 @@ static void lumRangeFromJpeg16_c(int16_t *_dst, int width)
     if (DEBUG_SWSCALE_BUFFERS)                  \
         av_log(c, AV_LOG_DEBUG, __VA_ARGS__)
 
-static int swscale(SwsContext *c, const uint8_t *src[],
-                   int srcStride[], int srcSliceY,
-                   int srcSliceH, uint8_t *dst[], int dstStride[])
+/**
+ * Scale a slice of the source image. If dstSliceY/dstSliceH do not cover the
+ * whole destination, only those output lines are produced; this requires the
+ * complete source image to be passed in a single slice.
+ */
+static int swscale_dst_slice(SwsContext *c, const uint8_t *src[],
+                             int srcStride[], int srcSliceY, int srcSliceH,
+                             uint8_t *dst[], int dstStride[],
+                             int dstSliceY, int dstSliceH)
 {
+    const int scale_dst              = dstSliceY > 0 || dstSliceH < c->dstH;
     /* load a few things into local vars to make the code more readable?
      * and faster */
     const int dstW                   = c->dstW;
@@ -263,6 +270,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     const int chrSrcSliceH           = AV_CEIL_RSHIFT(srcSliceH,   c->chrSrcVSubSample);
     int should_dither                = isNBPS(c->srcFormat) ||
                                        is16BPS(c->srcFormat);
+    const int dstSliceEnd            = dstSliceY + dstSliceH;
     int lastDstY;
 
     /* vars which will change and which we need to store back in the context */
@@ -335,10 +343,11 @@ static int swscale(SwsContext *c, const uint8_t *src[],
      * will not get executed. This is not really intended but works
      * currently, so people might do it. */
     if (srcSliceY == 0) {
-        dstY         = 0;
+        dstY         = dstSliceY;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
+    av_assert1(!scale_dst || (srcSliceY == 0 && srcSliceH == c->srcH));
 
     if (!should_dither) {
         c->chrDither8 = c->lumDither8 = sws_pb_64;
@@ -351,9 +360,14 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     ff_init_slice_from_src(src_slice, (uint8_t**)src, srcStride, c->srcW,
             srcSliceY, srcSliceH, chrSrcSliceY, chrSrcSliceH, 1);
 
-    ff_init_slice_from_src(vout_slice, (uint8_t**)dst, dstStride, c->dstW,
-            dstY, dstH, dstY >> c->chrDstVSubSample,
-            AV_CEIL_RSHIFT(dstH, c->chrDstVSubSample), 0);
+    if (scale_dst)
+        ff_init_slice_from_src(vout_slice, (uint8_t**)dst, dstStride, c->dstW,
+                dstSliceY, dstSliceH, dstSliceY >> c->chrDstVSubSample,
+                AV_CEIL_RSHIFT(dstSliceEnd, c->chrDstVSubSample) - (dstSliceY >> c->chrDstVSubSample), 0);
+    else
+        ff_init_slice_from_src(vout_slice, (uint8_t**)dst, dstStride, c->dstW,
+                dstY, dstH, dstY >> c->chrDstVSubSample,
+                AV_CEIL_RSHIFT(dstH, c->chrDstVSubSample), 0);
     if (srcSliceY == 0) {
         hout_slice->plane[0].sliceY = lastInLumBuf + 1;
         hout_slice->plane[1].sliceY = lastInChrBuf + 1;
@@ -367,7 +381,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         hout_slice->width = dstW;
     }
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstSliceEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         int use_mmx_vfilter= c->use_mmx_vfilter;
 
@@ -524,6 +538,70 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     return dstY - lastDstY;
 }
 
+static int swscale(SwsContext *c, const uint8_t *src[],
+                   int srcStride[], int srcSliceY,
+                   int srcSliceH, uint8_t *dst[], int dstStride[])
+{
+    return swscale_dst_slice(c, src, srcStride, srcSliceY, srcSliceH,
+                             dst, dstStride, 0, c->dstH);
+}
+
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads)
+{
+    SwsContext *parent = priv;
+    SwsContext      *c = parent->slice_ctx[threadnr];
+    /* keep chroma lines of subsampled outputs within one slice */
+    const int slice_height = FFALIGN((c->dstH + nb_jobs - 1) / nb_jobs,
+                                     1 << c->chrDstVSubSample);
+    const int slice_start  = jobnr * slice_height;
+    const int slice_end    = FFMIN(slice_start + slice_height, c->dstH);
+    const uint8_t *src[4];
+    uint8_t *dst[4];
+    int srcStride[4], dstStride[4];
+
+    if (slice_start >= slice_end)
+        return;
+
+    /* swscale() modifies the pointer and stride arrays */
+    memcpy(src,       parent->frame_src,        sizeof(src));
+    memcpy(srcStride, parent->frame_src_stride, sizeof(srcStride));
+    memcpy(dst,       parent->frame_dst,        sizeof(dst));
+    memcpy(dstStride, parent->frame_dst_stride, sizeof(dstStride));
+
+    swscale_dst_slice(c, src, srcStride, 0, c->srcH, dst, dstStride,
+                      slice_start, slice_end - slice_start);
+}
+
+/**
+ * Scale a complete frame by splitting the output lines between the slice
+ * threads. Each thread horizontally scales the source lines its band needs
+ * on its own, so the vertical filter overlap is simply computed twice.
+ */
+static int scale_threaded(SwsContext *c, const uint8_t *src[], int srcStride[],
+                          uint8_t *dst[], int dstStride[])
+{
+    int i;
+
+    if (usePal(c->srcFormat)) {
+        for (i = 0; i < c->nb_slice_ctx; i++) {
+            memcpy(c->slice_ctx[i]->pal_yuv, c->pal_yuv, sizeof(c->pal_yuv));
+            memcpy(c->slice_ctx[i]->pal_rgb, c->pal_rgb, sizeof(c->pal_rgb));
+        }
+    }
+
+    c->frame_src        = src;
+    c->frame_src_stride = srcStride;
+    c->frame_dst        = dst;
+    c->frame_dst_stride = dstStride;
+
+    avpriv_slicethread_execute(c->slicethread,
+                               FFMIN(c->nb_slice_ctx, AV_CEIL_RSHIFT(c->dstH, c->chrDstVSubSample)), 0);
+
+    c->dstY = c->dstH;
+    return c->dstH;
+}
+
 av_cold void ff_sws_init_range_convert(SwsContext *c)
 {
     c->lumConvertRange = NULL;
@@ -738,16 +816,13 @@ static void rgb48Toxyz12(struct SwsContext *c, uint16_t *dst,
     }
 }
 
-/**
- * swscale wrapper, so we don't need to export the SwsContext.
- * Assumes planar YUV to be in YUV order instead of YVU.
- */
-int attribute_align_arg sws_scale(struct SwsContext *c,
-                                  const uint8_t * const srcSlice[],
-                                  const int srcStride[], int srcSliceY,
-                                  int srcSliceH, uint8_t *const dst[],
-                                  const int dstStride[])
+static int scale_internal(SwsContext *c,
+                          const uint8_t * const srcSlice[], const int srcStride[],
+                          int srcSliceY, int srcSliceH,
+                          uint8_t *const dst[], const int dstStride[],
+                          int dstSliceY, int dstSliceH)
 {
+    const int scale_dst = dstSliceY > 0 || dstSliceH < c->dstH;
     int i, ret;
     const uint8_t *src2[4];
     uint8_t *dst2[4];
@@ -967,7 +1042,13 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     /* reset slice direction at end of frame */
     if (srcSliceY_internal + srcSliceH == c->srcH)
         c->sliceDir = 0;
-    ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
+    if (scale_dst)
+        ret = swscale_dst_slice(c, src2, srcStride2, 0, c->srcH,
+                                dst2, dstStride2, dstSliceY, dstSliceH);
+    else if (c->slicethread && srcSliceY_internal == 0 && srcSliceH == c->srcH)
+        ret = scale_threaded(c, src2, srcStride2, dst2, dstStride2);
+    else
+        ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
 
     if (c->dstXYZ && !(c->srcXYZ && c->srcW==c->dstW && c->srcH==c->dstH)) {
         int dstY = c->dstY ? c->dstY : srcSliceY + srcSliceH;
@@ -983,3 +1064,46 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     av_free(rgb0_tmp);
     return ret;
 }
+
+/**
+ * swscale wrapper, so we don't need to export the SwsContext.
+ * Assumes planar YUV to be in YUV order instead of YVU.
+ */
+int attribute_align_arg sws_scale(struct SwsContext *c,
+                                  const uint8_t * const srcSlice[],
+                                  const int srcStride[], int srcSliceY,
+                                  int srcSliceH, uint8_t *const dst[],
+                                  const int dstStride[])
+{
+    return scale_internal(c, srcSlice, srcStride, srcSliceY, srcSliceH,
+                          dst, dstStride, 0, c->dstH);
+}
+
+unsigned int sws_dst_slice_alignment(const struct SwsContext *c)
+{
+    return ff_sws_dst_slice_supported(c) ? 1 << c->chrDstVSubSample : 0;
+}
+
+int attribute_align_arg sws_scale_dst_slice(struct SwsContext *c,
+                                            const uint8_t * const src[],
+                                            const int srcStride[],
+                                            uint8_t *const dst[],
+                                            const int dstStride[],
+                                            int dstSliceY, int dstSliceH)
+{
+    const unsigned int align = sws_dst_slice_alignment(c);
+
+    if (!align)
+        return AVERROR(ENOSYS);
+
+    if (dstSliceY < 0 || dstSliceH <= 0 || dstSliceY + dstSliceH > c->dstH ||
+        dstSliceY % align ||
+        (dstSliceH % align && dstSliceY + dstSliceH != c->dstH)) {
+        av_log(c, AV_LOG_ERROR, "Output slice parameters %d, %d are invalid\n",
+               dstSliceY, dstSliceH);
+        return AVERROR(EINVAL);
+    }
+
+    return scale_internal(c, src, srcStride, 0, c->srcH,
+                          dst, dstStride, dstSliceY, dstSliceH);
+}
@@ -218,6 +218,33 @@ int sws_scale(struct SwsContext *c, const uint8_t *const srcSlice[],
               const int srcStride[], int srcSliceY, int srcSliceH,
               uint8_t *const dst[], const int dstStride[]);
 
+/**
+ * Scale the complete source image, but only output the lines dstSliceY to
+ * dstSliceY + dstSliceH - 1 of the destination image. Several contexts
+ * configured identically can so scale separate bands of the same image
+ * concurrently.
+ *
+ * @param dst       the array containing the pointers to the planes of
+ *                  the whole destination image
+ * @param dstSliceY the first line to output, a multiple of
+ *                  sws_dst_slice_alignment()
+ * @param dstSliceH the number of lines to output, a multiple of
+ *                  sws_dst_slice_alignment() unless the slice ends at the
+ *                  bottom of the image
+ * @return          the number of lines written, a negative error code
+ *                  otherwise; AVERROR(ENOSYS) if the context can only
+ *                  output complete images
+ */
+int sws_scale_dst_slice(struct SwsContext *c, const uint8_t *const src[],
+                        const int srcStride[], uint8_t *const dst[],
+                        const int dstStride[], int dstSliceY, int dstSliceH);
+
+/**
+ * @return the alignment required for the output slices of
+ *         sws_scale_dst_slice(), or 0 if the context cannot output slices
+ */
+unsigned int sws_dst_slice_alignment(const struct SwsContext *c);
+
 /**
  * @param dstRange flag indicating the while-black range of the output (1=jpeg / 0=mpeg)
  * @param srcRange flag indicating the while-black range of the input (1=jpeg / 0=mpeg)
@@ -33,6 +33,7 @@
 #include "libavutil/pixfmt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/ppc/util_altivec.h"
+#include "libavutil/slicethread.h"
 
 #define STR(s) AV_TOSTRING(s) // AV_STRINGIFY is too long
 
@@ -324,6 +325,17 @@ typedef struct SwsContext {
     uint8_t *cascaded1_tmp[4];
     int cascaded_mainindex;
 
+    /* Slice threading: every thread scales a band of output lines of a
+     * complete frame using its own copy of the context. */
+    int nb_threads;
+    int nb_slice_ctx;
+    struct SwsContext **slice_ctx;
+    AVSliceThread *slicethread;
+    const uint8_t **frame_src;    ///< source planes of the threaded sws_scale() call
+    int *frame_src_stride;
+    uint8_t **frame_dst;          ///< destination planes of the threaded sws_scale() call
+    int *frame_dst_stride;
+
     double gamma_value;
     int gamma_flag;
     int is_internal_gamma;
@@ -872,6 +884,19 @@ void ff_get_unscaled_swscale_aarch64(SwsContext *c);
  */
 SwsFunc ff_getSwsFunc(SwsContext *c);
 
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads);
+
+/**
+ * Only the generic scaler can produce a band of output lines from a full
+ * frame. Error diffusion dithering carries state from one line to the next,
+ * so it cannot be split either.
+ */
+static inline int ff_sws_dst_slice_supported(const SwsContext *c)
+{
+    return c->numDesc && !c->cascaded_context[0] && c->dither != SWS_DITHER_ED;
+}
+
 void ff_sws_init_input_funcs(SwsContext *c);
 void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2planar1_fn *yuv2plane1,
@@ -229,10 +229,8 @@ static int planarToP01xWrapper(SwsContext *c, const uint8_t *src8[],
 {
     const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
     const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
-    const uint16_t **src = (const uint16_t**)src8;
-    uint16_t *dstY = (uint16_t*)(dstParam8[0] + dstStride[0] * srcSliceY);
-    uint16_t *dstUV = (uint16_t*)(dstParam8[1] + dstStride[1] * srcSliceY / 2);
-    int x, y;
+    uint8_t *dstY  = dstParam8[0] + dstStride[0] * srcSliceY;
+    uint8_t *dstUV = dstParam8[1] + dstStride[1] * srcSliceY / 2;
 
     /* Calculate net shift required for values. */
     const int shift[3] = {
@@ -246,29 +244,54 @@ static int planarToP01xWrapper(SwsContext *c, const uint8_t *src8[],
 
     av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 || srcStride[2] % 2 ||
                  dstStride[0] % 2 || dstStride[1] % 2));
+    av_assert1(shift[1] == shift[2]);
 
-    for (y = 0; y < srcSliceH; y++) {
-        uint16_t *tdstY = dstY;
-        const uint16_t *tsrc0 = src[0];
-        for (x = c->srcW; x > 0; x--) {
-            *tdstY++ = *tsrc0++ << shift[0];
-        }
-        src[0] += srcStride[0] / 2;
-        dstY += dstStride[0] / 2;
+    lshiftWords(src8[0], dstY, c->srcW, srcSliceH,
+                srcStride[0], dstStride[0], shift[0]);
+    interleaveWords(src8[1], src8[2], dstUV, c->srcW / 2, (srcSliceH + 1) / 2,
+                    srcStride[1], srcStride[2], dstStride[1], shift[1]);
 
-        if (!(y & 1)) {
-            uint16_t *tdstUV = dstUV;
-            const uint16_t *tsrc1 = src[1];
-            const uint16_t *tsrc2 = src[2];
-            for (x = c->srcW / 2; x > 0; x--) {
-                *tdstUV++ = *tsrc1++ << shift[1];
-                *tdstUV++ = *tsrc2++ << shift[2];
-            }
-            src[1] += srcStride[1] / 2;
-            src[2] += srcStride[2] / 2;
-            dstUV += dstStride[1] / 2;
-        }
-    }
+    return srcSliceH;
+}
+
+static int p01xToPlanarWrapper(SwsContext *c, const uint8_t *src[],
+                               int srcStride[], int srcSliceY,
+                               int srcSliceH, uint8_t *dstParam[],
+                               int dstStride[])
+{
+    const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
+    const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
+    uint8_t *dstY = dstParam[0] + dstStride[0] * srcSliceY;
+    uint8_t *dstU = dstParam[1] + dstStride[1] * srcSliceY / 2;
+    uint8_t *dstV = dstParam[2] + dstStride[2] * srcSliceY / 2;
+
+    /* The data is in the high bits of the semi-planar format. */
+    const int shift = src_format->comp[0].depth + src_format->comp[0].shift -
+                      dst_format->comp[0].depth - dst_format->comp[0].shift;
+
+    rshiftWords(src[0], dstY, c->srcW, srcSliceH,
+                srcStride[0], dstStride[0], shift);
+    deinterleaveWords(src[1], dstU, dstV, c->chrSrcW, (srcSliceH + 1) / 2,
+                      srcStride[1], dstStride[1], dstStride[2], shift);
+
+    return srcSliceH;
+}
+
+static int y210ToPlanarWrapper(SwsContext *c, const uint8_t *src[],
+                               int srcStride[], int srcSliceY, int srcSliceH,
+                               uint8_t *dstParam[], int dstStride[])
+{
+    const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
+    const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
+    uint8_t *ydst = dstParam[0] + dstStride[0] * srcSliceY;
+    uint8_t *udst = dstParam[1] + dstStride[1] * srcSliceY;
+    uint8_t *vdst = dstParam[2] + dstStride[2] * srcSliceY;
+
+    const int shift = src_format->comp[0].depth + src_format->comp[0].shift -
+                      dst_format->comp[0].depth - dst_format->comp[0].shift;
+
+    y210toyuv422(ydst, udst, vdst, src[0], c->srcW, srcSliceH, dstStride[0],
+                 dstStride[1], srcStride[0], shift);
 
     return srcSliceH;
 }
@@ -2018,6 +2041,16 @@ void ff_get_unscaled_swscale(SwsContext *c)
         (dstFormat == AV_PIX_FMT_P010 || dstFormat == AV_PIX_FMT_P016)) {
         c->swscale = planarToP01xWrapper;
     }
+    /* p01x_to_yuv420p1x */
+    if ((srcFormat == AV_PIX_FMT_P010 && dstFormat == AV_PIX_FMT_YUV420P10) ||
+        (srcFormat == AV_PIX_FMT_P016 && dstFormat == AV_PIX_FMT_YUV420P16)) {
+        c->swscale = p01xToPlanarWrapper;
+    }
+    /* y210_to_yuv422p10 */
+    if (srcFormat == AV_PIX_FMT_Y210 && dstFormat == AV_PIX_FMT_YUV422P10 &&
+        !(c->srcW & 1)) {
+        c->swscale = y210ToPlanarWrapper;
+    }
     /* yuv420p_to_p01xle */
     if ((srcFormat == AV_PIX_FMT_YUV420P || srcFormat == AV_PIX_FMT_YUVA420P) &&
         (dstFormat == AV_PIX_FMT_P010LE || dstFormat == AV_PIX_FMT_P016LE)) {
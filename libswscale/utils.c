@@ -352,8 +352,8 @@ static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
 
     emms_c(); // FIXME should not be required but IS (even for non-MMX versions)
 
-    // NOTE: the +3 is for the MMX(+1) / SSE(+3) scaler which reads over the end
-    if (!FF_ALLOC_TYPED_ARRAY(*filterPos, dstW + 3))
+    // NOTE: the +7 is for the MMX(+1) / SSE(+3) / AVX2(+7) scaler which reads over the end
+    if (!FF_ALLOC_TYPED_ARRAY(*filterPos, dstW + 7))
         goto nomem;
 
     if (FFABS(xInc - 0x10000) < 10 && srcPos == dstPos) { // unscaled
@@ -683,9 +683,9 @@ static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
         }
     }
 
-    // Note the +1 is for the MMX scaler which reads over the end
+    // Note the +7 is for the MMX/SSE/AVX2 scaler which reads over the end
     /* align at 16 for AltiVec (needed by hScale_altivec_real) */
-    if (!FF_ALLOCZ_TYPED_ARRAY(*outFilter, *outFilterSize * (dstW + 3)))
+    if (!FF_ALLOCZ_TYPED_ARRAY(*outFilter, *outFilterSize * (dstW + 7)))
         goto nomem;
 
     /* normalize & store in outFilter */
@@ -710,15 +710,14 @@ static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
         }
     }
 
-    (*filterPos)[dstW + 0] =
-    (*filterPos)[dstW + 1] =
-    (*filterPos)[dstW + 2] = (*filterPos)[dstW - 1]; /* the MMX/SSE scaler will
-                                                      * read over the end */
+    for (i = 0; i < 7; i++)
+        (*filterPos)[dstW + i] = (*filterPos)[dstW - 1]; /* the MMX/SSE/AVX2
+                                                          * scaler will read
+                                                          * over the end */
     for (i = 0; i < *outFilterSize; i++) {
-        int k = (dstW - 1) * (*outFilterSize) + i;
-        (*outFilter)[k + 1 * (*outFilterSize)] =
-        (*outFilter)[k + 2 * (*outFilterSize)] =
-        (*outFilter)[k + 3 * (*outFilterSize)] = (*outFilter)[k];
+        int j, k = (dstW - 1) * (*outFilterSize) + i;
+        for (j = 1; j <= 7; j++)
+            (*outFilter)[k + j * (*outFilterSize)] = (*outFilter)[k];
     }
 
     ret = 0;
@@ -869,9 +868,9 @@ static int range_override_needed(enum AVPixelFormat format)
     return !isYUV(format) && !isGray(format);
 }
 
-int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
-                             int srcRange, const int table[4], int dstRange,
-                             int brightness, int contrast, int saturation)
+static int set_colorspace_details(SwsContext *c, const int inv_table[4],
+                                  int srcRange, const int table[4], int dstRange,
+                                  int brightness, int contrast, int saturation)
 {
     const AVPixFmtDescriptor *desc_dst;
     const AVPixFmtDescriptor *desc_src;
@@ -1004,6 +1003,26 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     return 0;
 }
 
+int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
+                             int srcRange, const int table[4], int dstRange,
+                             int brightness, int contrast, int saturation)
+{
+    int i, ret, slice_ret = 0;
+
+    /* the slice contexts have to match the parent even if one fails */
+    for (i = 0; i < c->nb_slice_ctx; i++) {
+        ret = sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange,
+                                       table, dstRange, brightness,
+                                       contrast, saturation);
+        if (ret < 0 && !slice_ret)
+            slice_ret = ret;
+    }
+
+    ret = set_colorspace_details(c, inv_table, srcRange, table, dstRange,
+                                 brightness, contrast, saturation);
+    return slice_ret < 0 ? slice_ret : ret;
+}
+
 int sws_getColorspaceDetails(struct SwsContext *c, int **inv_table,
                              int *srcRange, int **table, int *dstRange,
                              int *brightness, int *contrast, int *saturation)
@@ -1176,8 +1195,8 @@ static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
     }
 }
 
-av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
-                             SwsFilter *dstFilter)
+static av_cold int sws_init_single_context(SwsContext *c, SwsFilter *srcFilter,
+                                           SwsFilter *dstFilter)
 {
     int i;
     int usesVFilter, usesHFilter;
@@ -1889,6 +1908,90 @@ fail: // FIXME replace things by appropriate error codes
     return ret;
 }
 
+static av_cold int context_alloc_threaded(SwsContext *c)
+{
+    int i, ret;
+
+    ret = avpriv_slicethread_create(&c->slicethread, (void *)c,
+                                    ff_sws_slice_worker, NULL, c->nb_threads);
+    if (ret == AVERROR(ENOSYS)) {
+        c->nb_threads = 1;
+        return 0;
+    } else if (ret < 0)
+        return ret;
+
+    c->nb_threads = ret;
+    if (c->nb_threads == 1) {
+        avpriv_slicethread_free(&c->slicethread);
+        return 0;
+    }
+
+    c->slice_ctx = av_mallocz_array(c->nb_threads, sizeof(*c->slice_ctx));
+    if (!c->slice_ctx)
+        return AVERROR(ENOMEM);
+
+    /* copy the options before the main context modifies them on init */
+    for (i = 0; i < c->nb_threads; i++) {
+        c->slice_ctx[i] = sws_alloc_context();
+        if (!c->slice_ctx[i])
+            return AVERROR(ENOMEM);
+        c->nb_slice_ctx++;
+
+        ret = av_opt_copy(c->slice_ctx[i], c);
+        if (ret < 0)
+            return ret;
+        c->slice_ctx[i]->nb_threads = 1;
+    }
+
+    return 0;
+}
+
+static av_cold void context_free_threaded(SwsContext *c)
+{
+    int i;
+
+    avpriv_slicethread_free(&c->slicethread);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+    c->nb_slice_ctx = 0;
+}
+
+av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
+                             SwsFilter *dstFilter)
+{
+    int i, ret, nb_slice_ctx;
+
+    if (c->nb_threads != 1) {
+        ret = context_alloc_threaded(c);
+        if (ret < 0)
+            return ret;
+    }
+
+    /* keep sws_setColorspaceDetails() away from the uninitialized slice
+     * contexts, they are set up on their own below */
+    nb_slice_ctx    = c->nb_slice_ctx;
+    c->nb_slice_ctx = 0;
+    ret = sws_init_single_context(c, srcFilter, dstFilter);
+    c->nb_slice_ctx = nb_slice_ctx;
+    if (ret < 0 || !c->nb_slice_ctx)
+        return ret;
+
+    if (!ff_sws_dst_slice_supported(c)) {
+        av_log(c, AV_LOG_VERBOSE, "Scaling will be single-threaded.\n");
+        context_free_threaded(c);
+        return 0;
+    }
+
+    for (i = 0; i < c->nb_slice_ctx; i++) {
+        ret = sws_init_single_context(c->slice_ctx[i], srcFilter, dstFilter);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
 SwsContext *sws_alloc_set_opts(int srcW, int srcH, enum AVPixelFormat srcFormat,
                                int dstW, int dstH, enum AVPixelFormat dstFormat,
                                int flags, const double *param)
@@ -2340,6 +2443,8 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    context_free_threaded(c);
+
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
 
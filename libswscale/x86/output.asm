@@ -25,12 +25,12 @@
 
 SECTION_RODATA 32
 
-minshort:      times 8 dw 0x8000
-yuv2yuvX_16_start:  times 4 dd 0x4000 - 0x40000000
-yuv2yuvX_10_start:  times 4 dd 0x10000
-yuv2yuvX_9_start:   times 4 dd 0x20000
-yuv2yuvX_10_upper:  times 8 dw 0x3ff
-yuv2yuvX_9_upper:   times 8 dw 0x1ff
+minshort:      times 16 dw 0x8000
+yuv2yuvX_16_start:  times 8 dd 0x4000 - 0x40000000
+yuv2yuvX_10_start:  times 8 dd 0x10000
+yuv2yuvX_9_start:   times 8 dd 0x20000
+yuv2yuvX_10_upper:  times 16 dw 0x3ff
+yuv2yuvX_9_upper:   times 16 dw 0x1ff
 pd_4:          times 4 dd 4
 pd_4min0x40000:times 4 dd 4 - (0x40000)
 pw_16:         times 8 dw 16
@@ -98,26 +98,36 @@ SECTION .text
     ; input pixels
     mov             r6, [srcq+gprsize*cntr_reg-2*gprsize]
 %if %1 == 16
-    mova            m3, [r6+r5*4]
-    mova            m5, [r6+r5*4+mmsize]
+    movsrc          m3, [r6+r5*4]
+    movsrc          m5, [r6+r5*4+mmsize]
 %else ; %1 == 8/9/10
-    mova            m3, [r6+r5*2]
+    movsrc          m3, [r6+r5*2]
 %endif ; %1 == 8/9/10/16
     mov             r6, [srcq+gprsize*cntr_reg-gprsize]
 %if %1 == 16
-    mova            m4, [r6+r5*4]
-    mova            m6, [r6+r5*4+mmsize]
+    movsrc          m4, [r6+r5*4]
+    movsrc          m6, [r6+r5*4+mmsize]
 %else ; %1 == 8/9/10
-    mova            m4, [r6+r5*2]
+    movsrc          m4, [r6+r5*2]
 %endif ; %1 == 8/9/10/16
 
     ; coefficients
+%if mmsize == 32
+    vpbroadcastd    m0, [filterq+2*cntr_reg-4] ; coeff[0], coeff[1]
+%else ; mmsize == 8/16
     movd            m0, [filterq+2*cntr_reg-4] ; coeff[0], coeff[1]
+%endif ; mmsize == 8/16/32
 %if %1 == 16
+%if mmsize == 32
+    pslld           m7,  m0,  16
+    psrad           m7,  16              ; coeff[0]
+    psrad           m0,  16              ; coeff[1]
+%else ; mmsize == 16
     pshuflw         m7,  m0,  0          ; coeff[0]
     pshuflw         m0,  m0,  0x55       ; coeff[1]
     pmovsxwd        m7,  m7              ; word -> dword
     pmovsxwd        m0,  m0              ; word -> dword
+%endif ; mmsize == 16/32
 
     pmulld          m3,  m7
     pmulld          m5,  m7
@@ -131,7 +141,9 @@ SECTION .text
 %else ; %1 == 10/9/8
     punpcklwd       m5,  m3,  m4
     punpckhwd       m3,  m4
+%if mmsize != 32
     SPLATD          m0
+%endif
 
     pmaddwd         m5,  m0
     pmaddwd         m3,  m0
@@ -158,6 +170,9 @@ SECTION .text
 %else ; %1 == 9/10/16
 %if %1 == 16
     packssdw        m2,  m1
+%if mmsize == 32
+    vpermq          m2,  m2,  q3120
+%endif
     paddw           m2, [minshort]
 %else ; %1 == 9/10
 %if cpuflag(sse4)
@@ -189,6 +204,13 @@ SECTION .text
 %define movsx movsxd
 %endif
 
+%if mmsize == 32
+; the intermediate lines are only guaranteed to be 16-byte aligned
+%define movsrc movu
+%else
+%define movsrc mova
+%endif
+
 cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
 %if %1 == 8 || %1 == 9 || %1 == 10
     pxor            m6,  m6
@@ -249,8 +271,8 @@ cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
 
 %if mmsize == 8 || %1 == 8
     yuv2planeX_mainloop %1, a
-%else ; mmsize == 16
-    test          dstq, 15
+%else ; mmsize == 16/32
+    test          dstq, mmsize-1
     jnz .unaligned
     yuv2planeX_mainloop %1, a
     REP_RET
@@ -295,6 +317,13 @@ yuv2planeX_fn  9,  7, 5
 yuv2planeX_fn 10,  7, 5
 %endif
 
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+yuv2planeX_fn  9,  7, 5
+yuv2planeX_fn 10,  7, 5
+yuv2planeX_fn 16,  8, 5
+%endif
+
 ; %1=outout-bpc, %2=alignment (u/a)
 %macro yuv2plane1_mainloop 2
 .loop_%2:
@@ -398,8 +427,8 @@ cglobal yuv2plane1_%1, %3, %3, %2, src, dst, w, dither, offset
     ; actual pixel scaling
 %if mmsize == 8
     yuv2plane1_mainloop %1, a
-%else ; mmsize == 16
-    test          dstq, 15
+%else ; mmsize == 16/32
+    test          dstq, mmsize-1
     jnz .unaligned
     yuv2plane1_mainloop %1, a
     REP_RET
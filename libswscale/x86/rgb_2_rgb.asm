@@ -298,3 +298,303 @@ UYVY_TO_YUV422
 INIT_XMM avx
 UYVY_TO_YUV422
 %endif
+
+; The 16-bit functions below take native-endian words and shift every sample
+; by a variable amount. Widths are in samples, strides in bytes.
+
+; %1 = even samples in, even samples out; %2 = odd samples out
+; the samples are sign extended so that packssdw does not saturate
+%macro SPLIT_WORDS 2
+    psrad          %2, %1, 16
+    pslld          %1, 16
+    psrad          %1, 16
+%endmacro
+
+%macro PACK_WORDS 2
+    packssdw       %1, %2
+%if mmsize == 32
+    vpermq         %1, %1, q3120
+%endif
+%endmacro
+
+;------------------------------------------------------------------------------
+; lshift_words(const uint8_t *src, uint8_t *dst, int width, int height,
+;              int srcStride, int dstStride, int shift)
+; rshift_words(const uint8_t *src, uint8_t *dst, int width, int height,
+;              int srcStride, int dstStride, int shift)
+;------------------------------------------------------------------------------
+; %1 = l/r
+%macro SHIFT_WORDS 1
+cglobal %1shift_words, 7, 9, 3, src, dst, w, h, src_stride, dst_stride, shift, x, wsimd
+    movd          xm2, shiftd
+    movsxdifnidn            wq, wd
+    movsxdifnidn   src_strideq, src_strided
+    movsxdifnidn   dst_strideq, dst_strided
+    mov         wsimdq, wq
+    and         wsimdq, ~(mmsize - 1)
+    test            hd, hd
+    jle .end
+
+.loop_line:
+    xor             xq, xq
+    test        wsimdq, wsimdq
+    jz .loop_scalar
+
+.loop_simd:
+    movu            m0, [srcq + xq * 2]
+    movu            m1, [srcq + xq * 2 + mmsize]
+    ps%1lw          m0, xm2
+    ps%1lw          m1, xm2
+    movu [dstq + xq * 2], m0
+    movu [dstq + xq * 2 + mmsize], m1
+    add             xq, mmsize
+    cmp             xq, wsimdq
+    jl .loop_simd
+
+.loop_scalar:
+    cmp             xq, wq
+    jge .end_line
+    movzx       shiftd, word [srcq + xq * 2]
+    movd           xm0, shiftd
+    ps%1lw         xm0, xm2
+    movd        shiftd, xm0
+    mov [dstq + xq * 2], shiftw
+    inc             xq
+    jmp .loop_scalar
+
+.end_line:
+    add           srcq, src_strideq
+    add           dstq, dst_strideq
+    dec             hd
+    jg .loop_line
+
+.end:
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; interleave_words(const uint8_t *src1, const uint8_t *src2, uint8_t *dst,
+;                  int width, int height, int src1Stride,
+;                  int src2Stride, int dstStride, int shift)
+;------------------------------------------------------------------------------
+%macro INTERLEAVE_WORDS 0
+cglobal interleave_words, 9, 11, 5, src1, src2, dst, w, h, src1_stride, src2_stride, dst_stride, shift, x, wsimd
+    movd          xm4, shiftd
+    movsxdifnidn            wq, wd
+    movsxdifnidn  src1_strideq, src1_strided
+    movsxdifnidn  src2_strideq, src2_strided
+    movsxdifnidn   dst_strideq, dst_strided
+    mov         wsimdq, wq
+    and         wsimdq, ~(mmsize / 2 - 1)
+    test            hd, hd
+    jle .end
+
+.loop_line:
+    xor             xq, xq
+    test        wsimdq, wsimdq
+    jz .loop_scalar
+
+.loop_simd:
+    movu            m0, [src1q + xq * 2]
+    movu            m1, [src2q + xq * 2]
+    psllw           m0, xm4
+    psllw           m1, xm4
+%if mmsize == 32
+    vpermq          m0, m0, q3120
+    vpermq          m1, m1, q3120
+%endif
+    punpcklwd       m2, m0, m1
+    punpckhwd       m0, m1
+    movu [dstq + xq * 4], m2
+    movu [dstq + xq * 4 + mmsize], m0
+    add             xq, mmsize / 2
+    cmp             xq, wsimdq
+    jl .loop_simd
+
+.loop_scalar:
+    cmp             xq, wq
+    jge .end_line
+    movzx       shiftd, word [src2q + xq * 2]
+    shl         shiftd, 16
+    mov         shiftw, [src1q + xq * 2]
+    movd           xm0, shiftd
+    psllw          xm0, xm4
+    movd [dstq + xq * 4], xm0
+    inc             xq
+    jmp .loop_scalar
+
+.end_line:
+    add          src1q, src1_strideq
+    add          src2q, src2_strideq
+    add           dstq, dst_strideq
+    dec             hd
+    jg .loop_line
+
+.end:
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; deinterleave_words(const uint8_t *src, uint8_t *dst1, uint8_t *dst2,
+;                    int width, int height, int srcStride,
+;                    int dst1Stride, int dst2Stride, int shift)
+;------------------------------------------------------------------------------
+%macro DEINTERLEAVE_WORDS 0
+cglobal deinterleave_words, 9, 11, 5, src, dst1, dst2, w, h, src_stride, dst1_stride, dst2_stride, shift, x, wsimd
+    movd          xm4, shiftd
+    movsxdifnidn            wq, wd
+    movsxdifnidn   src_strideq, src_strided
+    movsxdifnidn  dst1_strideq, dst1_strided
+    movsxdifnidn  dst2_strideq, dst2_strided
+    mov         wsimdq, wq
+    and         wsimdq, ~(mmsize / 2 - 1)
+    test            hd, hd
+    jle .end
+
+.loop_line:
+    xor             xq, xq
+    test        wsimdq, wsimdq
+    jz .loop_scalar
+
+.loop_simd:
+    movu            m0, [srcq + xq * 4]
+    movu            m1, [srcq + xq * 4 + mmsize]
+    psrlw           m0, xm4
+    psrlw           m1, xm4
+    SPLIT_WORDS     m0, m2
+    SPLIT_WORDS     m1, m3
+    PACK_WORDS      m0, m1
+    PACK_WORDS      m2, m3
+    movu [dst1q + xq * 2], m0
+    movu [dst2q + xq * 2], m2
+    add             xq, mmsize / 2
+    cmp             xq, wsimdq
+    jl .loop_simd
+
+.loop_scalar:
+    cmp             xq, wq
+    jge .end_line
+    movd           xm0, [srcq + xq * 4]
+    psrlw          xm0, xm4
+    movd        shiftd, xm0
+    mov [dst1q + xq * 2], shiftw
+    shr         shiftd, 16
+    mov [dst2q + xq * 2], shiftw
+    inc             xq
+    jmp .loop_scalar
+
+.end_line:
+    add           srcq, src_strideq
+    add          dst1q, dst1_strideq
+    add          dst2q, dst2_strideq
+    dec             hd
+    jg .loop_line
+
+.end:
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; y210toyuv422(uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
+;              const uint8_t *src, int width, int height,
+;              int lumStride, int chromStride, int srcStride, int shift)
+;
+; width must be even
+;------------------------------------------------------------------------------
+%macro Y210_TO_YUV422 0
+cglobal y210toyuv422, 10, 12, 7, ydst, udst, vdst, src, w, h, lum_stride, chrom_stride, src_stride, shift, x, wsimd
+    movd          xm5, shiftd
+    movsxdifnidn            wq, wd
+    movsxdifnidn   lum_strideq, lum_strided
+    movsxdifnidn chrom_strideq, chrom_strided
+    movsxdifnidn   src_strideq, src_strided
+    mov         wsimdq, wq
+    and         wsimdq, ~(mmsize - 1)
+    test            hd, hd
+    jle .end
+
+.loop_line:
+    xor             xq, xq
+    test        wsimdq, wsimdq
+    jz .loop_scalar
+
+.loop_simd:
+    movu            m0, [srcq + xq * 4 + mmsize * 0]
+    movu            m1, [srcq + xq * 4 + mmsize * 1]
+    movu            m2, [srcq + xq * 4 + mmsize * 2]
+    movu            m3, [srcq + xq * 4 + mmsize * 3]
+    psrlw           m0, xm5
+    psrlw           m1, xm5
+    psrlw           m2, xm5
+    psrlw           m3, xm5
+
+    ; YUYV -> YY, UV
+    SPLIT_WORDS     m0, m4
+    SPLIT_WORDS     m1, m6
+    PACK_WORDS      m0, m1
+    PACK_WORDS      m4, m6
+    SPLIT_WORDS     m2, m1
+    SPLIT_WORDS     m3, m6
+    PACK_WORDS      m2, m3
+    PACK_WORDS      m1, m6
+    movu [ydstq + xq * 2], m0
+    movu [ydstq + xq * 2 + mmsize], m2
+
+    ; UV -> U, V
+    SPLIT_WORDS     m4, m3
+    SPLIT_WORDS     m1, m6
+    PACK_WORDS      m4, m1
+    PACK_WORDS      m3, m6
+    movu [udstq + xq], m4
+    movu [vdstq + xq], m3
+
+    add             xq, mmsize
+    cmp             xq, wsimdq
+    jl .loop_simd
+
+.loop_scalar:
+    cmp             xq, wq
+    jge .end_line
+    movq           xm0, [srcq + xq * 4]
+    psrlw          xm0, xm5
+    movd        shiftd, xm0
+    mov [ydstq + xq * 2], shiftw
+    shr         shiftd, 16
+    mov    [udstq + xq], shiftw
+    psrlq          xm0, 32
+    movd        shiftd, xm0
+    mov [ydstq + xq * 2 + 2], shiftw
+    shr         shiftd, 16
+    mov    [vdstq + xq], shiftw
+    add             xq, 2
+    jmp .loop_scalar
+
+.end_line:
+    add           srcq, src_strideq
+    add          ydstq, lum_strideq
+    add          udstq, chrom_strideq
+    add          vdstq, chrom_strideq
+    dec             hd
+    jg .loop_line
+
+.end:
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse2
+SHIFT_WORDS l
+SHIFT_WORDS r
+INTERLEAVE_WORDS
+DEINTERLEAVE_WORDS
+Y210_TO_YUV422
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SHIFT_WORDS l
+SHIFT_WORDS r
+INTERLEAVE_WORDS
+DEINTERLEAVE_WORDS
+Y210_TO_YUV422
+%endif
+%endif
@@ -21,8 +21,9 @@
 
 %include "libavutil/x86/x86util.asm"
 
-SECTION_RODATA
+SECTION_RODATA 32
 
+permd_8tap:    dd 0, 4, 1, 5, 2, 6, 3, 7
 max_19bit_int: times 4 dd 0x7ffff
 max_19bit_flt: times 4 dd 524287.0
 minshort:      times 8 dw 0x8000
@@ -421,3 +422,270 @@ INIT_XMM ssse3
 SCALE_FUNCS2 6, 6, 8
 INIT_XMM sse4
 SCALE_FUNCS2 6, 6, 8
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+; SCALE_FUNC_AVX2 source_width, intermediate_nbits, filtersize, filtersuffix
+;
+; 8 output pixels per iteration for filterSize 4/8, 4 per iteration for the
+; generic case. filterPos[] and the filter are padded by the allocator, so
+; reading up to 7 entries past dstW is fine.
+%macro SCALE_FUNC_AVX2 4
+%ifnidn %3, X
+cglobal hscale%1to%2_%4, 6, 7, 12, pos0, dst, w, src, filter, fltpos, pos1
+%else
+cglobal hscale%1to%2_%4, 7, 13, 12, pos0, dst, w, srcmem, filter, fltpos, fltsize, \
+                                    pos1, pos2, pos3, src, srcend, fltsize6
+%endif
+    movsxd        wq, wd
+%if %2 == 19
+    vpbroadcastd  m8, [max_19bit_int]
+%endif
+%if %1 == 16
+    vbroadcasti128 m9, [minshort]
+    vbroadcasti128 m10, [unicoeff]
+%endif
+
+%if %1 == 8
+%define srcmul 1
+%else ; %1 == 9-16
+%define srcmul 2
+%endif ; %1 == 8/9-16
+%if %2 == 15
+%define dstmul 2
+%else ; %2 == 19
+%define dstmul 4
+%endif ; %2 == 15/19
+
+    lea      fltposq, [fltposq+wq*4]
+    lea         dstq, [dstq+wq*dstmul]
+    neg           wq
+
+%ifnidn %3, X
+%if %3 == 8
+    mova         m11, [permd_8tap]
+%endif
+
+.loop:
+%if %3 == 4 ; filterSize == 4 scaling
+    ; gather 8x4 source pixels, m0 = dstpx[0-3], m1 = dstpx[4-7]
+%if %1 == 8
+    movu          m5, [fltposq+wq*4]
+    pcmpeqb       m6, m6
+    vpgatherdd    m0, [srcq+m5], m6             ; src[filterPos[0-7] + {0,1,2,3}]
+    vextracti128 xm1, m0, 1
+    pmovzxbw      m0, xm0
+    pmovzxbw      m1, xm1
+%else ; %1 > 8
+    movu         xm4, [fltposq+wq*4+ 0]
+    movu         xm5, [fltposq+wq*4+16]
+    pcmpeqb       m6, m6
+    vpgatherdq    m0, [srcq+xm4*2], m6          ; src[filterPos[0-3] + {0,1,2,3}]
+    pcmpeqb       m6, m6
+    vpgatherdq    m1, [srcq+xm5*2], m6          ; src[filterPos[4-7] + {0,1,2,3}]
+%endif ; %1 == 8/9-16
+%if %1 == 16
+    psubw         m0, m9
+    psubw         m1, m9
+%endif ; %1 == 16
+    pmaddwd       m0, [filterq+mmsize*0]        ; *= filter[{ 0, 1,...,14,15}]
+    pmaddwd       m1, [filterq+mmsize*1]        ; *= filter[{16,17,...,30,31}]
+    phaddd        m0, m1                        ; dstpx[0,1,4,5 | 2,3,6,7]
+    vpermq        m0, m0, q3120
+%else ; %3 == 8, i.e. filterSize == 8 scaling
+    ; load 8x8 source pixels, m0 = dstpx[0-1], m2 = dstpx[2-3],
+    ; m1 = dstpx[4-5], m3 = dstpx[6-7]
+%if %1 == 8
+    movu         xm4, [fltposq+wq*4+ 0]
+    movu         xm5, [fltposq+wq*4+16]
+    pcmpeqb       m6, m6
+    vpgatherdq    m0, [srcq+xm4], m6            ; src[filterPos[0-3] + {0,1,...,7}]
+    pcmpeqb       m6, m6
+    vpgatherdq    m1, [srcq+xm5], m6            ; src[filterPos[4-7] + {0,1,...,7}]
+    vextracti128 xm2, m0, 1
+    vextracti128 xm3, m1, 1
+    pmovzxbw      m0, xm0
+    pmovzxbw      m1, xm1
+    pmovzxbw      m2, xm2
+    pmovzxbw      m3, xm3
+%else ; %1 > 8
+    movsxd     pos0q, dword [fltposq+wq*4+ 0]
+    movsxd     pos1q, dword [fltposq+wq*4+ 4]
+    movu         xm0, [srcq+pos0q*2]
+    vinserti128   m0, m0, [srcq+pos1q*2], 1
+    movsxd     pos0q, dword [fltposq+wq*4+ 8]
+    movsxd     pos1q, dword [fltposq+wq*4+12]
+    movu         xm2, [srcq+pos0q*2]
+    vinserti128   m2, m2, [srcq+pos1q*2], 1
+    movsxd     pos0q, dword [fltposq+wq*4+16]
+    movsxd     pos1q, dword [fltposq+wq*4+20]
+    movu         xm1, [srcq+pos0q*2]
+    vinserti128   m1, m1, [srcq+pos1q*2], 1
+    movsxd     pos0q, dword [fltposq+wq*4+24]
+    movsxd     pos1q, dword [fltposq+wq*4+28]
+    movu         xm3, [srcq+pos0q*2]
+    vinserti128   m3, m3, [srcq+pos1q*2], 1
+%endif ; %1 == 8/9-16
+%if %1 == 16
+    psubw         m0, m9
+    psubw         m1, m9
+    psubw         m2, m9
+    psubw         m3, m9
+%endif ; %1 == 16
+    pmaddwd       m0, [filterq+mmsize*0]        ; *= filter[{ 0, 1,...,14,15}]
+    pmaddwd       m2, [filterq+mmsize*1]        ; *= filter[{16,17,...,30,31}]
+    pmaddwd       m1, [filterq+mmsize*2]        ; *= filter[{32,33,...,46,47}]
+    pmaddwd       m3, [filterq+mmsize*3]        ; *= filter[{48,49,...,62,63}]
+    phaddd        m0, m2
+    phaddd        m1, m3
+    phaddd        m0, m1                        ; dstpx[0,2,4,6 | 1,3,5,7]
+    vpermd        m0, m11, m0
+%endif ; %3 == 4/8
+    add      filterq, 8*%3*2
+
+%else ; %3 == X, i.e. any filterSize scaling
+
+%ifidn %4, X4
+%define dlt 4
+%else ; %4 == X8
+%define dlt 0
+%endif ; %4 ==/!= X4
+    movsxd  fltsizeq, fltsized                  ; filterSize
+    lea      srcendq, [srcmemq+(fltsizeq-dlt)*srcmul] ; &src[filterSize&~4]
+    lea    fltsize6q, [fltsizeq*3]
+    add    fltsize6q, fltsize6q                 ; 2 * 3 * filterSize, i.e. filter row 3
+
+.loop:
+    movsxd     pos0q, dword [fltposq+wq*4+ 0]   ; filterPos[0]
+    movsxd     pos1q, dword [fltposq+wq*4+ 4]   ; filterPos[1]
+    movsxd     pos2q, dword [fltposq+wq*4+ 8]   ; filterPos[2]
+    movsxd     pos3q, dword [fltposq+wq*4+12]   ; filterPos[3]
+    pxor          m4, m4
+    pxor          m5, m5
+    mov         srcq, srcmemq
+
+.innerloop:
+    ; load 4x8 source pixels, m0 = dstpx[0|1], m1 = dstpx[2|3]
+%if %1 == 8
+    pmovzxbw     xm0, [srcq+pos0q]
+    pmovzxbw     xm2, [srcq+pos1q]
+    pmovzxbw     xm1, [srcq+pos2q]
+    pmovzxbw     xm3, [srcq+pos3q]
+    vinserti128   m0, m0, xm2, 1
+    vinserti128   m1, m1, xm3, 1
+%else ; %1 > 8
+    movu         xm0, [srcq+pos0q*2]
+    vinserti128   m0, m0, [srcq+pos1q*2], 1
+    movu         xm1, [srcq+pos2q*2]
+    vinserti128   m1, m1, [srcq+pos3q*2], 1
+%endif ; %1 == 8/9-16
+%if %1 == 16
+    psubw         m0, m9
+    psubw         m1, m9
+%endif ; %1 == 16
+    movu         xm2, [filterq]
+    vinserti128   m2, m2, [filterq+fltsizeq*2], 1
+    movu         xm3, [filterq+fltsizeq*4]
+    vinserti128   m3, m3, [filterq+fltsize6q], 1
+    pmaddwd       m0, m2
+    pmaddwd       m1, m3
+    paddd         m4, m0
+    paddd         m5, m1
+    add      filterq, 16
+    add         srcq, srcmul*8
+    cmp         srcq, srcendq                   ; while (src += 8) < &src[filterSize&~4]
+    jl .innerloop
+
+%ifidn %4, X4
+    ; last 4 source pixels, in the same [dstpx[0,2] | dstpx[1,3]] order
+    ; as the horizontal add of m4/m5 below
+%if %1 == 8
+    movd         xm0, [srcq+pos0q]
+    movd         xm2, [srcq+pos2q]
+    movd         xm1, [srcq+pos1q]
+    movd         xm3, [srcq+pos3q]
+    punpckldq    xm0, xm2
+    punpckldq    xm1, xm3
+    pmovzxbw     xm0, xm0
+    pmovzxbw     xm1, xm1
+%else ; %1 > 8
+    movq         xm0, [srcq+pos0q*2]
+    movhps       xm0, [srcq+pos2q*2]
+    movq         xm1, [srcq+pos1q*2]
+    movhps       xm1, [srcq+pos3q*2]
+%endif ; %1 == 8/9-16
+    vinserti128   m0, m0, xm1, 1
+%if %1 == 16
+    psubw         m0, m9
+%endif ; %1 == 16
+    movq         xm2, [filterq]
+    movhps       xm2, [filterq+fltsizeq*4]
+    movq         xm3, [filterq+fltsizeq*2]
+    movhps       xm3, [filterq+fltsize6q]
+    vinserti128   m2, m2, xm3, 1
+    pmaddwd       m0, m2
+%endif ; %4 == X4
+
+    lea      filterq, [filterq+fltsize6q+dlt*2]
+
+    phaddd        m4, m5                        ; dstpx[0,0,2,2 | 1,1,3,3]
+%ifidn %4, X4
+    paddd         m4, m0
+%endif ; %4 == X4
+    phaddd        m4, m4                        ; dstpx[0,2,0,2 | 1,3,1,3]
+    vextracti128 xm0, m4, 1
+    punpckldq    xm0, xm4, xm0                 ; dstpx[0,1,2,3]
+%endif ; %3 ==/!= X
+
+%if %1 == 16 ; add 0x8000 * sum(coeffs), i.e. back from signed -> unsigned
+    paddd         m0, m10
+%endif ; %1 == 16
+
+    ; clip, store
+%ifnidn %3, X
+    psrad         m0, 14 + %1 - %2
+%if %2 == 15
+    vextracti128 xm1, m0, 1
+    packssdw     xm0, xm1
+    movu [dstq+wq*2], xm0
+%else ; %2 == 19
+    pminsd        m0, m8
+    movu [dstq+wq*4], m0
+%endif ; %2 == 15/19
+    add           wq, 8
+%else ; %3 == X
+    psrad        xm0, 14 + %1 - %2
+%if %2 == 15
+    packssdw     xm0, xm0
+    movq [dstq+wq*2], xm0
+%else ; %2 == 19
+    pminsd       xm0, xm8
+    movu [dstq+wq*4], xm0
+%endif ; %2 == 15/19
+    add           wq, 4
+%endif ; %3 ==/!= X
+    jl .loop
+    RET
+%endmacro
+
+; SCALE_FUNCS_AVX2 source_width, intermediate_nbits
+%macro SCALE_FUNCS_AVX2 2
+SCALE_FUNC_AVX2 %1, %2, 4, 4
+SCALE_FUNC_AVX2 %1, %2, 8, 8
+SCALE_FUNC_AVX2 %1, %2, X, X4
+SCALE_FUNC_AVX2 %1, %2, X, X8
+%endmacro
+
+INIT_YMM avx2
+SCALE_FUNCS_AVX2  8, 15
+SCALE_FUNCS_AVX2  9, 15
+SCALE_FUNCS_AVX2 10, 15
+SCALE_FUNCS_AVX2 12, 15
+SCALE_FUNCS_AVX2 14, 15
+SCALE_FUNCS_AVX2 16, 15
+SCALE_FUNCS_AVX2  8, 19
+SCALE_FUNCS_AVX2  9, 19
+SCALE_FUNCS_AVX2 10, 19
+SCALE_FUNCS_AVX2 12, 19
+SCALE_FUNCS_AVX2 14, 19
+SCALE_FUNCS_AVX2 16, 19
+%endif ; ARCH_X86_64 && HAVE_AVX2_EXTERNAL
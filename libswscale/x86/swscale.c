@@ -275,6 +275,7 @@ SCALE_FUNCS_MMX(mmx);
 SCALE_FUNCS_SSE(sse2);
 SCALE_FUNCS_SSE(ssse3);
 SCALE_FUNCS_SSE(sse4);
+SCALE_FUNCS_SSE(avx2);
 
 #define VSCALEX_FUNC(size, opt) \
 void ff_yuv2planeX_ ## size ## _ ## opt(const int16_t *filter, int filterSize, \
@@ -292,6 +293,9 @@ VSCALEX_FUNCS(sse2);
 VSCALEX_FUNCS(sse4);
 VSCALEX_FUNC(16, sse4);
 VSCALEX_FUNCS(avx);
+VSCALEX_FUNC(9,  avx2);
+VSCALEX_FUNC(10, avx2);
+VSCALEX_FUNC(16, avx2);
 
 #define VSCALE_FUNC(size, opt) \
 void ff_yuv2plane1_ ## size ## _ ## opt(const int16_t *src, uint8_t *dst, int dstW, \
@@ -569,6 +573,24 @@ switch(c->dstBpc){ \
 
 #if ARCH_X86_64
     if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        ASSIGN_SSE_SCALE_FUNC(c->hyScale, c->hLumFilterSize, avx2, avx2);
+        ASSIGN_SSE_SCALE_FUNC(c->hcScale, c->hChrFilterSize, avx2, avx2);
+
+        switch (c->dstBpc) {
+        case 16:
+            if (!isBE(c->dstFormat))
+                c->yuv2planeX = ff_yuv2planeX_16_avx2;
+            break;
+        case 10:
+            if (!isBE(c->dstFormat) && c->dstFormat != AV_PIX_FMT_P010LE)
+                c->yuv2planeX = ff_yuv2planeX_10_avx2;
+            break;
+        case 9:
+            if (!isBE(c->dstFormat))
+                c->yuv2planeX = ff_yuv2planeX_9_avx2;
+            break;
+        }
+
         switch (c->dstFormat) {
         case AV_PIX_FMT_NV12:
         case AV_PIX_FMT_NV24:
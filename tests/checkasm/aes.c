@@ -0,0 +1,111 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/aes.h"
+#include "libavutil/aes_internal.h"
+#include "libavutil/mem_internal.h"
+
+#include "checkasm.h"
+
+#define MAX_BLOCKS 67
+
+#define randomize_buffer(buf, size)             \
+    do {                                        \
+        for (int i = 0; i < size; i++)          \
+            buf[i] = rnd();                     \
+    } while (0)
+
+/* The reference context is created with all CPU flags disabled, so that it
+ * always uses the C implementation. Both contexts share the key schedule. */
+static int init_ref(AVAES *a, const uint8_t *key, int key_bits, int decrypt)
+{
+    int cpu_flags = av_get_cpu_flags(), ret;
+
+    av_force_cpu_flags(0);
+    ret = av_aes_init(a, key, key_bits, decrypt);
+    av_force_cpu_flags(cpu_flags);
+
+    return ret;
+}
+
+static void check_crypt(int key_bits, int decrypt, int cbc)
+{
+    AVAES ctx, ref_ctx;
+    LOCAL_ALIGNED_16(uint8_t, src,     [MAX_BLOCKS * 16]);
+    LOCAL_ALIGNED_16(uint8_t, dst_ref, [MAX_BLOCKS * 16]);
+    LOCAL_ALIGNED_16(uint8_t, dst_new, [MAX_BLOCKS * 16]);
+    uint8_t key[32], iv_ref[16], iv_new[16];
+    static const int counts[] = { 1, 3, 4, 5, 16, MAX_BLOCKS };
+
+    declare_func(void, AVAES *a, uint8_t *dst, const uint8_t *src,
+                 int count, uint8_t *iv, int rounds);
+
+    randomize_buffer(key, sizeof(key));
+    if (av_aes_init(&ctx, key, key_bits, decrypt) < 0 ||
+        init_ref(&ref_ctx, key, key_bits, decrypt) < 0) {
+        fprintf(stderr, "aes: failed to init %d bit key\n", key_bits);
+        fail();
+        return;
+    }
+
+    if (check_func(ctx.crypt, "aes_%s_%d%s", decrypt ? "decrypt" : "encrypt",
+                   key_bits, cbc ? "_cbc" : "")) {
+        func_ref = ref_ctx.crypt;
+        for (int i = 0; i < FF_ARRAY_ELEMS(counts); i++) {
+            const int count = counts[i];
+
+            randomize_buffer(src, MAX_BLOCKS * 16);
+            randomize_buffer(iv_ref, 16);
+            memcpy(iv_new, iv_ref, 16);
+            memset(dst_ref, 0, MAX_BLOCKS * 16);
+            memset(dst_new, 0, MAX_BLOCKS * 16);
+
+            call_ref(&ref_ctx, dst_ref, src, count, cbc ? iv_ref : NULL, ref_ctx.rounds);
+            call_new(&ctx,     dst_new, src, count, cbc ? iv_new : NULL, ctx.rounds);
+            if (memcmp(dst_ref, dst_new, MAX_BLOCKS * 16) ||
+                memcmp(iv_ref, iv_new, 16))
+                fail();
+
+            /* in-place operation, as used by the protocols and demuxers */
+            randomize_buffer(iv_ref, 16);
+            memcpy(iv_new, iv_ref, 16);
+            memcpy(dst_new, src, MAX_BLOCKS * 16);
+            call_ref(&ref_ctx, dst_ref, src, count, cbc ? iv_ref : NULL, ref_ctx.rounds);
+            call_new(&ctx, dst_new, dst_new, count, cbc ? iv_new : NULL, ctx.rounds);
+            if (memcmp(dst_ref, dst_new, MAX_BLOCKS * 16) ||
+                memcmp(iv_ref, iv_new, 16))
+                fail();
+        }
+        bench_new(&ctx, dst_new, src, MAX_BLOCKS, cbc ? iv_new : NULL, ctx.rounds);
+    }
+}
+
+void checkasm_check_aes(void)
+{
+    static const int key_bits[] = { 128, 192, 256 };
+
+    for (int decrypt = 0; decrypt <= 1; decrypt++) {
+        for (int cbc = 0; cbc <= 1; cbc++) {
+            for (int i = 0; i < FF_ARRAY_ELEMS(key_bits); i++)
+                check_crypt(key_bits[i], decrypt, cbc);
+            report("%s%s", decrypt ? "decrypt" : "encrypt", cbc ? "_cbc" : "");
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include "libavutil/mem_internal.h"
+
+#define TX_FLOAT
+#include "libavutil/tx_priv.h"
+
+#include "checkasm.h"
+
+#define MAX_BITS 12
+#define MAX_LEN  (1 << MAX_BITS)
+
+#define randomize_complex(buf, len)                                 \
+    do {                                                            \
+        for (int i = 0; i < len; i++) {                             \
+            buf[i].re = (float)rnd() / (UINT_MAX >> 1) - 1.0f;      \
+            buf[i].im = (float)rnd() / (UINT_MAX >> 1) - 1.0f;      \
+        }                                                           \
+    } while (0)
+
+/* The power of two FFT that all float FFTs and MDCTs are built on */
+static void check_fft_float(void)
+{
+    LOCAL_ALIGNED_32(FFTComplex, in,      [MAX_LEN]);
+    LOCAL_ALIGNED_32(FFTComplex, out_ref, [MAX_LEN]);
+    LOCAL_ALIGNED_32(FFTComplex, out_new, [MAX_LEN]);
+    const float scale = 1.0f;
+
+    declare_func(void, FFTComplex *z);
+
+    for (int bits = 2; bits <= MAX_BITS; bits++) {
+        const int len = 1 << bits;
+        AVTXContext *ctx;
+        av_tx_fn tx;
+
+        if (av_tx_init(&ctx, &tx, AV_TX_FLOAT_FFT, 0, len, &scale, 0) < 0) {
+            fprintf(stderr, "av_tx: failed to init fft_float_%d\n", len);
+            fail();
+            continue;
+        }
+
+        if (check_func(ctx->fft, "fft_float_%d", len)) {
+            randomize_complex(in, len);
+            memcpy(out_ref, in, len * sizeof(*in));
+            memcpy(out_new, in, len * sizeof(*in));
+            call_ref(out_ref);
+            call_new(out_new);
+            if (!float_near_abs_eps_array((float *)out_ref, (float *)out_new,
+                                          16 * FLT_EPSILON * sqrt(len), 2 * len))
+                fail();
+            memcpy(out_new, in, len * sizeof(*in));
+            bench_new(out_new);
+        }
+
+        av_tx_uninit(&ctx);
+    }
+
+    report("fft_float");
+}
+
+void checkasm_check_av_tx(void)
+{
+    check_fft_float();
+}
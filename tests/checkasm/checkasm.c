@@ -184,18 +184,27 @@ static const struct {
     #if CONFIG_HFLIP_FILTER
         { "vf_hflip", checkasm_check_vf_hflip },
     #endif
+    #if CONFIG_LUT3D_FILTER
+        { "vf_lut3d", checkasm_check_vf_lut3d },
+    #endif
     #if CONFIG_NLMEANS_FILTER
         { "vf_nlmeans", checkasm_check_nlmeans },
     #endif
     #if CONFIG_THRESHOLD_FILTER
         { "vf_threshold", checkasm_check_vf_threshold },
     #endif
+    #if CONFIG_TONEMAP_FILTER
+        { "vf_tonemap", checkasm_check_vf_tonemap },
+    #endif
 #endif
 #if CONFIG_SWSCALE
     { "sw_rgb", checkasm_check_sw_rgb },
     { "sw_scale", checkasm_check_sw_scale },
 #endif
 #if CONFIG_AVUTIL
+        { "aes", checkasm_check_aes },
+        { "av_tx", checkasm_check_av_tx },
+        { "crc", checkasm_check_crc },
         { "fixed_dsp", checkasm_check_fixed_dsp },
         { "float_dsp", checkasm_check_float_dsp },
 #endif
@@ -238,6 +247,7 @@ static const struct {
     { "SSE4.1",   "sse4",     AV_CPU_FLAG_SSE4 },
     { "SSE4.2",   "sse42",    AV_CPU_FLAG_SSE42 },
     { "AES-NI",   "aesni",    AV_CPU_FLAG_AESNI },
+    { "CLMUL",    "clmul",    AV_CPU_FLAG_CLMUL },
     { "AVX",      "avx",      AV_CPU_FLAG_AVX },
     { "XOP",      "xop",      AV_CPU_FLAG_XOP },
     { "FMA3",     "fma3",     AV_CPU_FLAG_FMA3 },
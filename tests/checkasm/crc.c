@@ -0,0 +1,91 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "libavutil/crc.h"
+#include "libavutil/crc_internal.h"
+#include "libavutil/mem_internal.h"
+
+#include "checkasm.h"
+
+#define BUF_SIZE 4096
+
+#define randomize_buffer(buf, size)             \
+    do {                                        \
+        for (int i = 0; i < size; i++)          \
+            buf[i] = rnd();                     \
+    } while (0)
+
+static uint32_t crc_c(AVCRCId crc_id, uint32_t crc,
+                      const uint8_t *buffer, size_t length)
+{
+    const AVCRC *ctx = av_crc_get_table(crc_id);
+
+    while (length--)
+        crc = ctx[(uint8_t)crc ^ *buffer++] ^ (crc >> 8);
+
+    return crc;
+}
+
+static ff_crc_func get_crc_func(void)
+{
+    ff_crc_func fn = NULL;
+#if ARCH_X86
+    fn = ff_crc_get_func_x86(av_get_cpu_flags());
+#endif
+    return fn ? fn : crc_c;
+}
+
+void checkasm_check_crc(void)
+{
+    static const struct {
+        AVCRCId id;
+        const char *name;
+    } crcs[] = {
+        { AV_CRC_8_ATM,      "8_atm"      },
+        { AV_CRC_8_EBU,      "8_ebu"      },
+        { AV_CRC_16_ANSI,    "16_ansi"    },
+        { AV_CRC_16_CCITT,   "16_ccitt"   },
+        { AV_CRC_24_IEEE,    "24_ieee"    },
+        { AV_CRC_32_IEEE,    "32_ieee"    },
+        { AV_CRC_32_IEEE_LE, "32_ieee_le" },
+        { AV_CRC_16_ANSI_LE, "16_ansi_le" },
+    };
+    static const size_t lengths[] = { 16, 32, 48, 64, 80, 128, 176, 1024, BUF_SIZE };
+    LOCAL_ALIGNED_16(uint8_t, buf, [BUF_SIZE + 15]);
+    ff_crc_func crc = get_crc_func();
+
+    declare_func(uint32_t, AVCRCId crc_id, uint32_t crc,
+                 const uint8_t *buffer, size_t length);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(crcs); i++) {
+        if (check_func(crc, "crc_%s", crcs[i].name)) {
+            for (int j = 0; j < FF_ARRAY_ELEMS(lengths); j++) {
+                /* unaligned buffers and arbitrary initial states */
+                const uint8_t *src = buf + (rnd() & 15);
+                uint32_t init = j ? rnd() : 0;
+
+                randomize_buffer(buf, BUF_SIZE + 15);
+                if (call_ref(crcs[i].id, init, src, lengths[j]) !=
+                    call_new(crcs[i].id, init, src, lengths[j]))
+                    fail();
+            }
+            bench_new(crcs[i].id, 0, buf, BUF_SIZE);
+        }
+    }
+    report("crc");
+}
@@ -269,12 +269,15 @@ static void test_scalarproduct_float(const float *src0, const float *src1)
 
     declare_func_float(float, const float *src0, const float *src1, int len);
 
-    cprod = call_ref(src0, src1, LEN);
-    oprod = call_new(src0, src1, LEN);
-    if (!float_near_abs_eps(cprod, oprod, ARBITRARY_SCALARPRODUCT_CONST)) {
-        fprintf(stderr, "%- .12f - %- .12f = % .12g\n",
-                cprod, oprod, cprod - oprod);
-        fail();
+    /* also cover lengths that are a multiple of 4 but not of 8 */
+    for (int len = LEN; len >= LEN - 4; len -= 4) {
+        cprod = call_ref(src0, src1, len);
+        oprod = call_new(src0, src1, len);
+        if (!float_near_abs_eps(cprod, oprod, ARBITRARY_SCALARPRODUCT_CONST)) {
+            fprintf(stderr, "%- .12f - %- .12f = % .12g\n",
+                    cprod, oprod, cprod - oprod);
+            fail();
+        }
     }
     bench_new(src0, src1, LEN);
 }
@@ -180,6 +180,163 @@ static void check_interleave_bytes(void)
     }
 }
 
+static void check_shift_words(void *func, const char *report)
+{
+    LOCAL_ALIGNED_32(uint16_t, src, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst0, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst1, [MAX_STRIDE * MAX_HEIGHT]);
+    static const int shifts[] = { 0, 6 };
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, const uint8_t *src, uint8_t *dst,
+                      int width, int height, int srcStride, int dstStride, int shift);
+
+    randomize_buffers((uint8_t *)src, MAX_STRIDE * MAX_HEIGHT * 2);
+
+    if (check_func(func, "%s", report)) {
+        for (int i = 0; i <= 16; i++) {
+            // Try all widths [1,16], and try one random width.
+            int w = i > 0 ? i : (1 + (rnd() % (MAX_STRIDE-2)));
+            int h = 1 + (rnd() % (MAX_HEIGHT-2));
+            int shift = shifts[i & 1];
+
+            memset(dst0, 0, MAX_STRIDE * MAX_HEIGHT * 2);
+            memset(dst1, 0, MAX_STRIDE * MAX_HEIGHT * 2);
+
+            call_ref((const uint8_t *)src, (uint8_t *)dst0, w, h,
+                     MAX_STRIDE * 2, MAX_STRIDE * 2, shift);
+            call_new((const uint8_t *)src, (uint8_t *)dst1, w, h,
+                     MAX_STRIDE * 2, MAX_STRIDE * 2, shift);
+            checkasm_check(uint16_t, dst0, MAX_STRIDE * 2, dst1, MAX_STRIDE * 2,
+                           w + 1, h + 1, "dst");
+        }
+        bench_new((const uint8_t *)src, (uint8_t *)dst1, MAX_STRIDE, MAX_HEIGHT,
+                  MAX_STRIDE * 2, MAX_STRIDE * 2, 6);
+    }
+}
+
+static void check_interleave_words(void)
+{
+    LOCAL_ALIGNED_32(uint16_t, src0, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, src1, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst0, [2 * MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst1, [2 * MAX_STRIDE * MAX_HEIGHT]);
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, const uint8_t *, const uint8_t *,
+                      uint8_t *, int, int, int, int, int, int);
+
+    randomize_buffers((uint8_t *)src0, MAX_STRIDE * MAX_HEIGHT * 2);
+    randomize_buffers((uint8_t *)src1, MAX_STRIDE * MAX_HEIGHT * 2);
+
+    if (check_func(interleaveWords, "interleave_words")) {
+        for (int i = 0; i <= 16; i++) {
+            int w = i > 0 ? i : (1 + (rnd() % (MAX_STRIDE-2)));
+            int h = 1 + (rnd() % (MAX_HEIGHT-2));
+            int shift = i & 1 ? 6 : 0;
+
+            memset(dst0, 0, 4 * MAX_STRIDE * MAX_HEIGHT);
+            memset(dst1, 0, 4 * MAX_STRIDE * MAX_HEIGHT);
+
+            call_ref((const uint8_t *)src0, (const uint8_t *)src1, (uint8_t *)dst0,
+                     w, h, MAX_STRIDE * 2, MAX_STRIDE * 2, MAX_STRIDE * 4, shift);
+            call_new((const uint8_t *)src0, (const uint8_t *)src1, (uint8_t *)dst1,
+                     w, h, MAX_STRIDE * 2, MAX_STRIDE * 2, MAX_STRIDE * 4, shift);
+            checkasm_check(uint16_t, dst0, MAX_STRIDE * 4, dst1, MAX_STRIDE * 4,
+                           2 * w + 2, h + 1, "dst");
+        }
+        bench_new((const uint8_t *)src0, (const uint8_t *)src1, (uint8_t *)dst1,
+                  MAX_STRIDE, MAX_HEIGHT, MAX_STRIDE * 2, MAX_STRIDE * 2,
+                  MAX_STRIDE * 4, 6);
+    }
+}
+
+static void check_deinterleave_words(void)
+{
+    LOCAL_ALIGNED_32(uint16_t, src, [2 * MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst0_u, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst0_v, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst1_u, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst1_v, [MAX_STRIDE * MAX_HEIGHT]);
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, const uint8_t *, uint8_t *, uint8_t *,
+                      int, int, int, int, int, int);
+
+    randomize_buffers((uint8_t *)src, 2 * MAX_STRIDE * MAX_HEIGHT * 2);
+
+    if (check_func(deinterleaveWords, "deinterleave_words")) {
+        for (int i = 0; i <= 16; i++) {
+            int w = i > 0 ? i : (1 + (rnd() % (MAX_STRIDE-2)));
+            int h = 1 + (rnd() % (MAX_HEIGHT-2));
+            int shift = i & 1 ? 6 : 0;
+
+            memset(dst0_u, 0, MAX_STRIDE * MAX_HEIGHT * 2);
+            memset(dst0_v, 0, MAX_STRIDE * MAX_HEIGHT * 2);
+            memset(dst1_u, 0, MAX_STRIDE * MAX_HEIGHT * 2);
+            memset(dst1_v, 0, MAX_STRIDE * MAX_HEIGHT * 2);
+
+            call_ref((const uint8_t *)src, (uint8_t *)dst0_u, (uint8_t *)dst0_v,
+                     w, h, MAX_STRIDE * 4, MAX_STRIDE * 2, MAX_STRIDE * 2, shift);
+            call_new((const uint8_t *)src, (uint8_t *)dst1_u, (uint8_t *)dst1_v,
+                     w, h, MAX_STRIDE * 4, MAX_STRIDE * 2, MAX_STRIDE * 2, shift);
+            checkasm_check(uint16_t, dst0_u, MAX_STRIDE * 2, dst1_u, MAX_STRIDE * 2,
+                           w + 1, h + 1, "dst_u");
+            checkasm_check(uint16_t, dst0_v, MAX_STRIDE * 2, dst1_v, MAX_STRIDE * 2,
+                           w + 1, h + 1, "dst_v");
+        }
+        bench_new((const uint8_t *)src, (uint8_t *)dst1_u, (uint8_t *)dst1_v,
+                  MAX_STRIDE, MAX_HEIGHT, MAX_STRIDE * 4, MAX_STRIDE * 2,
+                  MAX_STRIDE * 2, 6);
+    }
+}
+
+static void check_y210_to_422p(void)
+{
+    LOCAL_ALIGNED_32(uint16_t, src, [2 * MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst0_y, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst0_u, [MAX_STRIDE / 2 * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst0_v, [MAX_STRIDE / 2 * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst1_y, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst1_u, [MAX_STRIDE / 2 * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst1_v, [MAX_STRIDE / 2 * MAX_HEIGHT]);
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
+                      const uint8_t *src, int width, int height,
+                      int lumStride, int chromStride, int srcStride, int shift);
+
+    randomize_buffers((uint8_t *)src, 2 * MAX_STRIDE * MAX_HEIGHT * 2);
+
+    if (check_func(y210toyuv422, "y210toyuv422")) {
+        for (int i = 1; i <= 16; i++) {
+            // Try all even widths [2,32], the last one being random.
+            int w = i < 16 ? 2 * i : 2 + 2 * (rnd() % (MAX_STRIDE / 2 - 1));
+            int h = 1 + (rnd() % (MAX_HEIGHT-2));
+            int shift = i & 1 ? 6 : 0;
+
+            memset(dst0_y, 0, MAX_STRIDE * MAX_HEIGHT * 2);
+            memset(dst0_u, 0, MAX_STRIDE * MAX_HEIGHT);
+            memset(dst0_v, 0, MAX_STRIDE * MAX_HEIGHT);
+            memset(dst1_y, 0, MAX_STRIDE * MAX_HEIGHT * 2);
+            memset(dst1_u, 0, MAX_STRIDE * MAX_HEIGHT);
+            memset(dst1_v, 0, MAX_STRIDE * MAX_HEIGHT);
+
+            call_ref((uint8_t *)dst0_y, (uint8_t *)dst0_u, (uint8_t *)dst0_v,
+                     (const uint8_t *)src, w, h, MAX_STRIDE * 2, MAX_STRIDE,
+                     MAX_STRIDE * 4, shift);
+            call_new((uint8_t *)dst1_y, (uint8_t *)dst1_u, (uint8_t *)dst1_v,
+                     (const uint8_t *)src, w, h, MAX_STRIDE * 2, MAX_STRIDE,
+                     MAX_STRIDE * 4, shift);
+            checkasm_check(uint16_t, dst0_y, MAX_STRIDE * 2, dst1_y, MAX_STRIDE * 2,
+                           FFMIN(w + 1, MAX_STRIDE), h + 1, "dst_y");
+            checkasm_check(uint16_t, dst0_u, MAX_STRIDE, dst1_u, MAX_STRIDE,
+                           FFMIN(w / 2 + 1, MAX_STRIDE / 2), h + 1, "dst_u");
+            checkasm_check(uint16_t, dst0_v, MAX_STRIDE, dst1_v, MAX_STRIDE,
+                           FFMIN(w / 2 + 1, MAX_STRIDE / 2), h + 1, "dst_v");
+        }
+        bench_new((uint8_t *)dst1_y, (uint8_t *)dst1_u, (uint8_t *)dst1_v,
+                  (const uint8_t *)src, MAX_STRIDE, MAX_HEIGHT, MAX_STRIDE * 2,
+                  MAX_STRIDE, MAX_STRIDE * 4, 6);
+    }
+}
+
 void checkasm_check_sw_rgb(void)
 {
     ff_sws_rgb2rgb_init();
@@ -204,4 +361,19 @@ void checkasm_check_sw_rgb(void)
 
     check_interleave_bytes();
     report("interleave_bytes");
+
+    check_shift_words(lshiftWords, "lshift_words");
+    report("lshift_words");
+
+    check_shift_words(rshiftWords, "rshift_words");
+    report("rshift_words");
+
+    check_interleave_words();
+    report("interleave_words");
+
+    check_deinterleave_words();
+    report("deinterleave_words");
+
+    check_y210_to_422p();
+    report("y210toyuv422");
 }
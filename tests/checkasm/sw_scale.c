@@ -134,26 +134,97 @@ static void check_yuv2yuvX(void)
 #undef FILTER_SIZES
 }
 
+static void check_yuv2planeX_hbd(void)
+{
+    struct SwsContext *ctx;
+    int fmi, fsi, isi, i;
+    int dstW;
+#define FILTER_SIZES 4
+    static const int filter_sizes[FILTER_SIZES] = {2, 4, 8, 16};
+#define INPUT_SIZES 6
+    static const int input_sizes[INPUT_SIZES] = {8, 24, 128, 144, 256, 512};
+#define FORMATS 3
+    static const enum AVPixelFormat formats[FORMATS] = {
+        AV_PIX_FMT_YUV420P9LE, AV_PIX_FMT_YUV420P10LE, AV_PIX_FMT_YUV420P16LE,
+    };
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, const int16_t *filter,
+                      int filterSize, const int16_t **src, uint8_t *dest,
+                      int dstW, const uint8_t *dither, int offset);
+
+    // the input is int16_t for 9/10 bit and int32_t for 16 bit output
+    const int16_t *src[LARGEST_FILTER];
+    LOCAL_ALIGNED_32(int32_t, src_pixels, [LARGEST_FILTER * LARGEST_INPUT_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, filter_coeff, [LARGEST_FILTER]);
+    LOCAL_ALIGNED_32(uint16_t, dst0, [LARGEST_INPUT_SIZE]);
+    LOCAL_ALIGNED_32(uint16_t, dst1, [LARGEST_INPUT_SIZE]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+
+    memset(dither, 0, 8);
+    randomize_buffers((uint8_t*)src_pixels, LARGEST_FILTER * LARGEST_INPUT_SIZE * sizeof(int32_t));
+    randomize_buffers((uint8_t*)filter_coeff, LARGEST_FILTER * sizeof(int16_t));
+    for (i = 0; i < LARGEST_FILTER; i++)
+        src[i] = (const int16_t *)&src_pixels[i * LARGEST_INPUT_SIZE];
+
+    ctx = sws_alloc_context();
+    if (sws_init_context(ctx, NULL, NULL) < 0)
+        fail();
+
+    for (fmi = 0; fmi < FORMATS; fmi++) {
+        ctx->dstFormat = formats[fmi];
+        ctx->dstBpc    = av_pix_fmt_desc_get(formats[fmi])->comp[0].depth;
+        ff_getSwsFunc(ctx);
+
+        for (isi = 0; isi < INPUT_SIZES; isi++) {
+            dstW = input_sizes[isi];
+            for (fsi = 0; fsi < FILTER_SIZES; fsi++) {
+                if (check_func(ctx->yuv2planeX, "yuv2planeX_%d_%d_%d",
+                               ctx->dstBpc, filter_sizes[fsi], dstW)) {
+                    memset(dst0, 0, LARGEST_INPUT_SIZE * sizeof(dst0[0]));
+                    memset(dst1, 0, LARGEST_INPUT_SIZE * sizeof(dst1[0]));
+
+                    // the SIMD functions may write past dstW, only compare
+                    // the actual output
+                    call_ref(filter_coeff, filter_sizes[fsi], src, (uint8_t *)dst0, dstW, dither, 0);
+                    call_new(filter_coeff, filter_sizes[fsi], src, (uint8_t *)dst1, dstW, dither, 0);
+                    if (memcmp(dst0, dst1, dstW * sizeof(dst0[0])))
+                        fail();
+                    if (dstW == LARGEST_INPUT_SIZE)
+                        bench_new(filter_coeff, filter_sizes[fsi], src, (uint8_t *)dst1, dstW, dither, 0);
+                }
+            }
+        }
+    }
+    sws_freeContext(ctx);
+#undef FILTER_SIZES
+#undef INPUT_SIZES
+#undef FORMATS
+}
+
 #undef SRC_PIXELS
 #define SRC_PIXELS 128
 
 static void check_hscale(void)
 {
 #define MAX_FILTER_WIDTH 40
-#define FILTER_SIZES 5
-    static const int filter_sizes[FILTER_SIZES] = { 4, 8, 16, 32, 40 };
+#define FILTER_SIZES 6
+    static const int filter_sizes[FILTER_SIZES] = { 4, 8, 12, 16, 32, 40 };
 
-#define HSCALE_PAIRS 2
+#define HSCALE_PAIRS 6
     static const int hscale_pairs[HSCALE_PAIRS][2] = {
-        { 8, 14 },
-        { 8, 18 },
+        {  8, 14 },
+        {  8, 18 },
+        { 10, 14 },
+        { 10, 18 },
+        { 16, 14 },
+        { 16, 18 },
     };
 
     int i, j, fsi, hpi, width;
     struct SwsContext *ctx;
 
-    // padded
-    LOCAL_ALIGNED_32(uint8_t, src, [FFALIGN(SRC_PIXELS + MAX_FILTER_WIDTH - 1, 4)]);
+    // padded, large enough for both 8 and 16 bit input
+    LOCAL_ALIGNED_32(uint16_t, src, [FFALIGN(SRC_PIXELS + MAX_FILTER_WIDTH - 1, 4)]);
     LOCAL_ALIGNED_32(uint32_t, dst0, [SRC_PIXELS]);
     LOCAL_ALIGNED_32(uint32_t, dst1, [SRC_PIXELS]);
 
@@ -171,14 +242,24 @@ static void check_hscale(void)
     if (sws_init_context(ctx, NULL, NULL) < 0)
         fail();
 
-    randomize_buffers(src, SRC_PIXELS + MAX_FILTER_WIDTH - 1);
-
     for (hpi = 0; hpi < HSCALE_PAIRS; hpi++) {
+        ctx->srcBpc = hscale_pairs[hpi][0];
+        ctx->dstBpc = hscale_pairs[hpi][1];
+        switch (ctx->srcBpc) {
+        case 10: ctx->srcFormat = AV_PIX_FMT_YUV420P10LE; break;
+        case 16: ctx->srcFormat = AV_PIX_FMT_YUV420P16LE; break;
+        default: ctx->srcFormat = AV_PIX_FMT_YUV420P;     break;
+        }
+
+        randomize_buffers((uint8_t *)src, sizeof(src[0]) * FFALIGN(SRC_PIXELS + MAX_FILTER_WIDTH - 1, 4));
+        if (ctx->srcBpc > 8) {
+            for (i = 0; i < SRC_PIXELS + MAX_FILTER_WIDTH - 1; i++)
+                src[i] &= (1 << ctx->srcBpc) - 1;
+        }
+
         for (fsi = 0; fsi < FILTER_SIZES; fsi++) {
             width = filter_sizes[fsi];
 
-            ctx->srcBpc = hscale_pairs[hpi][0];
-            ctx->dstBpc = hscale_pairs[hpi][1];
             ctx->hLumFilterSize = ctx->hChrFilterSize = width;
 
             for (i = 0; i < SRC_PIXELS; i++) {
@@ -195,12 +276,16 @@ static void check_hscale(void)
                 //   at (1<<15) - 1
                 //
                 // The coefficients sum to the 1.0 point for the hscale
-                // functions (1 << 14).
+                // functions (1 << 14). For 16-bit input the SIMD functions
+                // rely on this being exact, as they compute in signed
+                // words and add back 0x8000 * (1 << 14) at the end.
 
                 for (j = 0; j < width; j++) {
                     filter[i * width + j] = -((1 << 14) / (width - 1));
                 }
-                filter[i * width + (rnd() % width)] = ((1 << 15) - 1);
+                filter[i * width + (rnd() % width)] = ctx->srcBpc == 16 ?
+                    (1 << 14) + (width - 1) * ((1 << 14) / (width - 1)) :
+                    ((1 << 15) - 1);
             }
 
             for (i = 0; i < MAX_FILTER_WIDTH; i++) {
@@ -216,11 +301,11 @@ static void check_hscale(void)
                 memset(dst0, 0, SRC_PIXELS * sizeof(dst0[0]));
                 memset(dst1, 0, SRC_PIXELS * sizeof(dst1[0]));
 
-                call_ref(NULL, dst0, SRC_PIXELS, src, filter, filterPos, width);
-                call_new(NULL, dst1, SRC_PIXELS, src, filter, filterPos, width);
+                call_ref(ctx, dst0, SRC_PIXELS, (const uint8_t *)src, filter, filterPos, width);
+                call_new(ctx, dst1, SRC_PIXELS, (const uint8_t *)src, filter, filterPos, width);
                 if (memcmp(dst0, dst1, SRC_PIXELS * sizeof(dst0[0])))
                     fail();
-                bench_new(NULL, dst0, SRC_PIXELS, src, filter, filterPos, width);
+                bench_new(ctx, dst0, SRC_PIXELS, (const uint8_t *)src, filter, filterPos, width);
             }
         }
     }
@@ -233,4 +318,6 @@ void checkasm_check_sw_scale(void)
     report("hscale");
     check_yuv2yuvX();
     report("yuv2yuvX");
+    check_yuv2planeX_hbd();
+    report("yuv2planeX_hbd");
 }
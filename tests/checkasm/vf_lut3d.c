@@ -0,0 +1,180 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/lut3d.h"
+#include "libavutil/intfloat.h"
+#include "libavutil/mem.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 256
+#define WIDTH_PADDED (WIDTH + 32)
+#define LUT_SIZE 17
+
+#define randomize_float(f, min, max) \
+    ((min) + ((max) - (min)) * (rnd() & 0xFFFF) / 65535.0f)
+
+static const char *const interp_names[] = {
+    [INTERPOLATE_TRILINEAR]   = "trilinear",
+    [INTERPOLATE_TETRAHEDRAL] = "tetrahedral",
+};
+
+static void set_coeffs(LUT3DRowCoeffs *c, int depth)
+{
+    const int max = depth <= 16 ? (1 << depth) - 1 : 1;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        c->scale[0][i]  = LUT_SIZE - 1;
+        c->scale[1][i]  = LUT_SIZE - 1;
+        c->scale[2][i]  = LUT_SIZE - 1;
+        c->lut_max[i]   = LUT_SIZE - 1;
+        c->in_scale[i]  = 1.0f / max;
+        c->out_scale[i] = max;
+        c->lutsize[i]   = LUT_SIZE;
+        c->lutsize2[i]  = LUT_SIZE * LUT_SIZE;
+        c->lut_last[i]  = LUT_SIZE - 1;
+        c->out_max[i]   = max;
+    }
+}
+
+static void randomize_src(uint8_t *buf, int depth, int isfloat)
+{
+    int i;
+
+    if (isfloat) {
+        float *f = (float *)buf;
+        for (i = 0; i < WIDTH_PADDED; i++)
+            f[i] = randomize_float(f, -0.25f, 1.25f);
+        /* exact lattice points, the range limits and non-finite values */
+        f[0] = 0.0f;
+        f[1] = 1.0f;
+        f[2] = 0.5f;
+        f[3] = av_int2float(0x7fc00000);
+        f[4] = av_int2float(0x7f800000);
+        f[5] = av_int2float(0xff800000);
+    } else if (depth > 8) {
+        uint16_t *s = (uint16_t *)buf;
+        for (i = 0; i < WIDTH_PADDED; i++)
+            s[i] = rnd() & ((1 << depth) - 1);
+        s[0] = 0;
+        s[1] = (1 << depth) - 1;
+    } else {
+        for (i = 0; i < WIDTH_PADDED; i++)
+            buf[i] = rnd();
+        buf[0] = 0;
+        buf[1] = 0xFF;
+    }
+}
+
+static void check_lut3d(const struct rgbvec *lut, const float *const *shaper,
+                        enum AVPixelFormat pix_fmt, const char *type)
+{
+    LOCAL_ALIGNED_32(uint8_t, src_buf, [3], [WIDTH_PADDED * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref_buf, [3], [WIDTH_PADDED * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new_buf, [3], [WIDTH_PADDED * 4]);
+    LOCAL_ALIGNED_32(LUT3DRowCoeffs, c, [1]);
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    const int isfloat = desc->flags & AV_PIX_FMT_FLAG_FLOAT;
+    const int depth = desc->comp[0].depth;
+    const int bytes = desc->comp[0].step;
+    const uint8_t *src[3] = { src_buf[0], src_buf[1], src_buf[2] };
+    uint8_t *dst_ref[3] = { dst_ref_buf[0], dst_ref_buf[1], dst_ref_buf[2] };
+    uint8_t *dst_new[3] = { dst_new_buf[0], dst_new_buf[1], dst_new_buf[2] };
+    LUT3DContext s;
+    int interp, i;
+
+    declare_func(void, uint8_t *const dst[3], const uint8_t *const src[3],
+                 const struct rgbvec *lut, const float *const *shaper,
+                 const LUT3DRowCoeffs *c, int width);
+
+    set_coeffs(c, depth);
+
+    for (interp = INTERPOLATE_TRILINEAR; interp <= INTERPOLATE_TETRAHEDRAL; interp++) {
+        memset(&s, 0, sizeof(s));
+        s.interpolation = interp;
+        ff_lut3d_init(&s, desc);
+
+        if (check_func(s.interp_row, "lut3d_%s_%s%s", interp_names[interp],
+                       type, shaper ? "_shaper" : "")) {
+            /* exercise the tail handling with a width that is not a
+             * multiple of the SIMD block size */
+            const int w = WIDTH - (rnd() & 7);
+
+            for (i = 0; i < 3; i++) {
+                randomize_src(src_buf[i], depth, isfloat);
+                memset(dst_ref_buf[i], 0, WIDTH_PADDED * 4);
+                memset(dst_new_buf[i], 0, WIDTH_PADDED * 4);
+            }
+
+            call_ref(dst_ref, src, lut, shaper, c, w);
+            call_new(dst_new, src, lut, shaper, c, w);
+            for (i = 0; i < 3; i++) {
+                if (isfloat) {
+                    if (!float_near_abs_eps_array((const float *)dst_ref[i],
+                                                  (const float *)dst_new[i],
+                                                  1e-6f, WIDTH_PADDED))
+                        fail();
+                } else if (memcmp(dst_ref[i], dst_new[i], WIDTH_PADDED * bytes)) {
+                    fail();
+                }
+            }
+            bench_new(dst_new, src, lut, shaper, c, WIDTH);
+        }
+    }
+}
+
+void checkasm_check_vf_lut3d(void)
+{
+    struct rgbvec *lut = av_malloc_array(LUT_SIZE * LUT_SIZE * LUT_SIZE, sizeof(*lut));
+    float *shaper[3];
+    int i, j;
+
+    for (i = 0; i < 3; i++)
+        shaper[i] = av_malloc_array(1 << 16, sizeof(*shaper[i]));
+    if (!lut || !shaper[0] || !shaper[1] || !shaper[2])
+        goto end;
+
+    /* slightly out of range values to exercise the output clipping */
+    for (i = 0; i < LUT_SIZE * LUT_SIZE * LUT_SIZE; i++) {
+        lut[i].r = randomize_float(lut[i].r, -0.1f, 1.1f);
+        lut[i].g = randomize_float(lut[i].g, -0.1f, 1.1f);
+        lut[i].b = randomize_float(lut[i].b, -0.1f, 1.1f);
+    }
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 1 << 16; j++)
+            shaper[i][j] = randomize_float(shaper[i][j], 0.0f, LUT_SIZE - 1);
+
+    check_lut3d(lut, NULL, AV_PIX_FMT_GBRP, "8");
+    check_lut3d(lut, (const float *const *)shaper, AV_PIX_FMT_GBRP, "8");
+    report("lut3d_8");
+
+    check_lut3d(lut, NULL, AV_PIX_FMT_GBRP10, "10");
+    check_lut3d(lut, NULL, AV_PIX_FMT_GBRP16, "16");
+    check_lut3d(lut, (const float *const *)shaper, AV_PIX_FMT_GBRP16, "16");
+    report("lut3d_16");
+
+    check_lut3d(lut, NULL, AV_PIX_FMT_GBRPF32, "f32");
+    report("lut3d_f32");
+
+end:
+    av_free(lut);
+    for (i = 0; i < 3; i++)
+        av_free(shaper[i]);
+}
@@ -0,0 +1,102 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/tonemap.h"
+#include "libavutil/mem.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 256
+#define WIDTH_PADDED (WIDTH + 32)
+#define PEAK 10.0
+
+#define randomize_float(min, max) \
+    ((min) + ((max) - (min)) * (rnd() & 0xFFFF) / 65535.0f)
+
+static const struct {
+    enum TonemapAlgorithm tonemap;
+    const char *name;
+    double param;
+} algorithms[] = {
+    { TONEMAP_NONE,     "none",     NAN  },
+    { TONEMAP_LINEAR,   "linear",   1.0  },
+    { TONEMAP_GAMMA,    "gamma",    1.8  },
+    { TONEMAP_CLIP,     "clip",     1.0  },
+    { TONEMAP_REINHARD, "reinhard", 0.5  },
+    { TONEMAP_HABLE,    "hable",    NAN  },
+    { TONEMAP_MOBIUS,   "mobius",   0.3  },
+};
+
+static void check_tonemap(double desat)
+{
+    LOCAL_ALIGNED_32(float, src_buf,     [3], [WIDTH_PADDED]);
+    LOCAL_ALIGNED_32(float, dst_ref_buf, [3], [WIDTH_PADDED]);
+    LOCAL_ALIGNED_32(float, dst_new_buf, [3], [WIDTH_PADDED]);
+    const float *src[3] = { src_buf[0], src_buf[1], src_buf[2] };
+    float *dst_ref[3] = { dst_ref_buf[0], dst_ref_buf[1], dst_ref_buf[2] };
+    float *dst_new[3] = { dst_new_buf[0], dst_new_buf[1], dst_new_buf[2] };
+    TonemapContext s;
+    int alg, i, j;
+
+    declare_func(void, float *const dst[3], const float *const src[3],
+                 const TonemapCoeffs *c, const float *lut, int width);
+
+    for (alg = 0; alg < FF_ARRAY_ELEMS(algorithms); alg++) {
+        memset(&s, 0, sizeof(s));
+        s.tonemap = algorithms[alg].tonemap;
+        s.param   = algorithms[alg].param;
+        s.desat   = desat;
+        s.coeffs  = ff_get_luma_coefficients(AVCOL_SPC_BT2020_NCL);
+        ff_tonemap_init(&s);
+        if (ff_tonemap_set_peak(&s, PEAK) < 0)
+            return;
+
+        if (check_func(s.tonemap_row, "tonemap_%s%s", algorithms[alg].name,
+                       desat > 0 ? "_desat" : "")) {
+            /* exercise the tail handling with a width that is not a
+             * multiple of the SIMD block size */
+            const int w = WIDTH - (rnd() & 7);
+
+            for (i = 0; i < 3; i++) {
+                for (j = 0; j < WIDTH_PADDED; j++)
+                    src_buf[i][j] = randomize_float(0.0f, PEAK);
+                memset(dst_ref_buf[i], 0, WIDTH_PADDED * sizeof(float));
+                memset(dst_new_buf[i], 0, WIDTH_PADDED * sizeof(float));
+            }
+
+            call_ref(dst_ref, src, &s.row_coeffs, s.curve_lut, w);
+            call_new(dst_new, src, &s.row_coeffs, s.curve_lut, w);
+            /* the C code looks most curves up in a gain table, while the
+             * SIMD versions evaluate them directly */
+            for (i = 0; i < 3; i++)
+                if (!float_near_abs_eps_array(dst_ref[i], dst_new[i],
+                                              1e-4f, WIDTH_PADDED))
+                    fail();
+            bench_new(dst_new, src, &s.row_coeffs, s.curve_lut, WIDTH);
+        }
+        av_freep(&s.curve_lut);
+    }
+}
+
+void checkasm_check_vf_tonemap(void)
+{
+    check_tonemap(0.0);
+    check_tonemap(2.0);
+    report("tonemap");
+}
@@ -135,6 +135,11 @@ fate-acodec-flac: CODEC = flac -compression_level 2
 fate-acodec-flac-exact-rice: FMT = flac
 fate-acodec-flac-exact-rice: CODEC = flac -compression_level 2 -exact_rice_parameters 1
 
+# must match fate-acodec-flac, including the MD5 and frame sizes in STREAMINFO
+FATE_ACODEC-$(call ENCDEC, FLAC, FLAC) += fate-acodec-flac-frame-threads
+fate-acodec-flac-frame-threads: FMT = flac
+fate-acodec-flac-frame-threads: CODEC = flac -compression_level 2 -frame_threads 3
+
 FATE_ACODEC-$(call ENCDEC, G723_1, G723_1) += fate-acodec-g723_1
 fate-acodec-g723_1: tests/data/asynth-8000-1.wav
 fate-acodec-g723_1: SRC = tests/data/asynth-8000-1.wav
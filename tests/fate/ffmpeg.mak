@@ -48,6 +48,11 @@ fate-force_key_frames: CMD = enc_dec \
   avi "-c mpeg4 -g 240 -qscale 10 -force_key_frames 0.5,0:00:01.5" \
   framecrc "" "" "-skip_frame nokey"
 
+# Read the packets from a memory mapping of the input file
+FATE_FFMPEG-$(call ALLYES, FILE_PROTOCOL RAWVIDEO_DEMUXER FRAMECRC_MUXER) += fate-ffmpeg-file-mmap
+fate-ffmpeg-file-mmap: tests/data/vsynth1.yuv
+fate-ffmpeg-file-mmap: CMD = framecrc -mmap 1 -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv -c copy
+
 FATE_SAMPLES_FFMPEG-$(call ALLYES, VOBSUB_DEMUXER DVDSUB_DECODER AVFILTER OVERLAY_FILTER DVDSUB_ENCODER) += fate-sub2video
 fate-sub2video: tests/data/vsynth_lena.yuv
 fate-sub2video: CMD = framecrc -auto_conversion_filters \
@@ -390,6 +390,19 @@ fate-filter-telecine: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf telecine
 FATE_FILTER_VSYNTH-$(CONFIG_TRANSPOSE_FILTER) += fate-filter-transpose
 fate-filter-transpose: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf transpose
 
+# frame threaded filters must give the same output as without threads
+FATE_FILTER_VSYNTH-$(CONFIG_TRANSPOSE_FILTER) += fate-filter-transpose-frame-threads
+fate-filter-transpose-frame-threads: CMD = framecrc -filter_threads 3 -filter_thread_type slice+frame -c:v pgmyuv -i $(SRC) -vf transpose
+fate-filter-transpose-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-transpose
+
+FATE_FILTER_VSYNTH-$(call ALLYES, NEGATE_FILTER PERMS_FILTER) += fate-filter-negate-frame-threads
+fate-filter-negate-frame-threads: CMD = framecrc -filter_threads 3 -filter_thread_type frame -c:v pgmyuv -i $(SRC) -vf perms=random,negate
+fate-filter-negate-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-negate
+
+FATE_FILTER_VSYNTH-$(call ALLYES, COLORCHANNELMIXER_FILTER FORMAT_FILTER PERMS_FILTER) += fate-filter-colorchannelmixer-frame-threads
+fate-filter-colorchannelmixer-frame-threads: CMD = framecrc -filter_threads 3 -filter_thread_type slice+frame -c:v pgmyuv -i $(SRC) -vf scale,format=rgb24,perms=random,colorchannelmixer=.31415927:.4:.31415927:0:.27182818:.8:.27182818:0:.2:.6:.2:0 -flags +bitexact -sws_flags +accurate_rnd+bitexact
+fate-filter-colorchannelmixer-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-colorchannelmixer
+
 FATE_TRIM += fate-filter-trim-duration
 fate-filter-trim-duration: CMD = framecrc -i $(SRC) -vf trim=start=0.4:duration=0.05
 
@@ -410,6 +423,10 @@ fate-filter-untile: CMD = framecrc -lavfi testsrc2=d=1:r=2,untile=2x2
 FATE_FILTER_VSYNTH-$(CONFIG_UNSHARP_FILTER) += fate-filter-unsharp
 fate-filter-unsharp: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf unsharp=11:11:-1.5:11:11:-1.5
 
+FATE_FILTER_VSYNTH-$(CONFIG_UNSHARP_FILTER) += fate-filter-unsharp-frame-threads
+fate-filter-unsharp-frame-threads: CMD = framecrc -filter_threads 3 -filter_thread_type slice+frame -c:v pgmyuv -i $(SRC) -vf unsharp=11:11:-1.5:11:11:-1.5
+fate-filter-unsharp-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-unsharp
+
 FATE_FILTER_VSYNTH-$(CONFIG_UNSHARP_FILTER) += fate-filter-unsharp-yuv420p10
 fate-filter-unsharp-yuv420p10: CMD = framecrc -lavfi testsrc2=r=2:d=10,scale,format=yuv420p10,unsharp=11:11:-1.5:11:11:-1.5,scale -pix_fmt yuv420p10le -flags +bitexact -sws_flags +accurate_rnd+bitexact
 
@@ -513,6 +530,12 @@ fate-filter-colorlevels: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf scale,format=r
 FATE_FILTER_VSYNTH-$(CONFIG_COLORLEVELS_FILTER) += fate-filter-colorlevels-16
 fate-filter-colorlevels-16: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf scale,format=rgb48,colorlevels,scale -pix_fmt rgb48le -flags +bitexact -sws_flags +accurate_rnd+bitexact
 
+FATE_FILTER_VSYNTH-$(call ALLYES, FORMAT_FILTER SETPARAMS_FILTER TONEMAP_FILTER) += fate-filter-tonemap-yuv-pq
+fate-filter-tonemap-yuv-pq: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf scale,format=yuv420p10,setparams=color_trc=smpte2084:color_primaries=bt2020:colorspace=bt2020nc,tonemap=linear:desat=0 -flags +bitexact -sws_flags +accurate_rnd+bitexact -frames:v 3
+
+FATE_FILTER_VSYNTH-$(call ALLYES, FORMAT_FILTER SETPARAMS_FILTER TONEMAP_FILTER) += fate-filter-tonemap-yuv-linear
+fate-filter-tonemap-yuv-linear: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf scale,format=p010,setparams=color_trc=linear:colorspace=bt709,tonemap=linear:param=0.8:desat=0 -flags +bitexact -sws_flags +accurate_rnd+bitexact -frames:v 3
+
 FATE_FILTER_VSYNTH-$(CONFIG_COLORBALANCE_FILTER) += fate-filter-colorbalance
 fate-filter-colorbalance: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf scale,format=rgb24,colorbalance=rs=.2 -flags +bitexact -sws_flags +accurate_rnd+bitexact -frames:v 3
 
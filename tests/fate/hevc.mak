@@ -195,6 +195,19 @@ FATE_HEVC += fate-hevc-conformance-$(1)
 fate-hevc-conformance-$(1): CMD = framecrc -flags unaligned -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv420p
 endef
 
+# tiles are decoded in parallel by slice threads, the output must not change
+HEVC_SAMPLES_TILES =            \
+    TILES_A_Cisco_2             \
+    TILES_B_Cisco_1             \
+
+define FATE_HEVC_TEST_SLICE_THREADS
+FATE_HEVC += fate-hevc-conformance-$(1)-slice-threads
+fate-hevc-conformance-$(1)-slice-threads: CMD = framecrc -flags unaligned -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv420p
+fate-hevc-conformance-$(1)-slice-threads: REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(1)
+fate-hevc-conformance-$(1)-slice-threads: THREADS = 4
+fate-hevc-conformance-$(1)-slice-threads: THREAD_TYPE = slice
+endef
+
 define FATE_HEVC_TEST_10BIT
 FATE_HEVC += fate-hevc-conformance-$(1)
 fate-hevc-conformance-$(1): CMD = framecrc -flags unaligned -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv420p10le -vf scale
@@ -231,6 +244,7 @@ fate-hevc-conformance-$(1): CMD = framecrc -flags unaligned -i $(TARGET_SAMPLES)
 endef
 
 $(foreach N,$(HEVC_SAMPLES),$(eval $(call FATE_HEVC_TEST,$(N))))
+$(foreach N,$(HEVC_SAMPLES_TILES),$(eval $(call FATE_HEVC_TEST_SLICE_THREADS,$(N))))
 $(foreach N,$(HEVC_SAMPLES_10BIT),$(eval $(call FATE_HEVC_TEST_10BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_422_10BIT),$(eval $(call FATE_HEVC_TEST_422_10BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_422_10BIN),$(eval $(call FATE_HEVC_TEST_422_10BIN,$(N))))
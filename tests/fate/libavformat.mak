@@ -6,6 +6,11 @@ FATE_LIBAVFORMAT-$(CONFIG_NETWORK) += fate-noproxy
 fate-noproxy: libavformat/tests/noproxy$(EXESUF)
 fate-noproxy: CMD = run libavformat/tests/noproxy$(EXESUF)
 
+FATE_HLS_PREFETCH-$(call ALLYES, NETWORK HTTP_PROTOCOL HLS_DEMUXER WAV_DEMUXER) += fate-hls-prefetch
+FATE_LIBAVFORMAT-$(HAVE_THREADS) += $(FATE_HLS_PREFETCH-yes)
+fate-hls-prefetch: libavformat/tests/hls_prefetch$(EXESUF)
+fate-hls-prefetch: CMD = run libavformat/tests/hls_prefetch$(EXESUF)
+
 FATE_LIBAVFORMAT-$(CONFIG_FFRTMPCRYPT_PROTOCOL) += fate-rtmpdh
 fate-rtmpdh: libavformat/tests/rtmpdh$(EXESUF)
 fate-rtmpdh: CMD = run libavformat/tests/rtmpdh$(EXESUF)
@@ -18,6 +23,10 @@ FATE_LIBAVFORMAT-yes += fate-url
 fate-url: libavformat/tests/url$(EXESUF)
 fate-url: CMD = run libavformat/tests/url$(EXESUF)
 
+FATE_LIBAVFORMAT-$(CONFIG_URING_PROTOCOL) += fate-uring
+fate-uring: libavformat/tests/uring$(EXESUF)
+fate-uring: CMD = run libavformat/tests/uring$(EXESUF) $(TARGET_PATH)/tests/data/fate/uring.dir
+
 FATE_LIBAVFORMAT-$(CONFIG_MOV_MUXER) += fate-movenc
 fate-movenc: libavformat/tests/movenc$(EXESUF)
 fate-movenc: CMD = run libavformat/tests/movenc$(EXESUF)
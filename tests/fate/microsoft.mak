@@ -80,8 +80,32 @@ fate-vc1test_smm0015: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SMM0015.rcv
 FATE_VC1-$(CONFIG_MOV_DEMUXER) += fate-vc1-ism
 fate-vc1-ism: CMD = framecrc -i $(TARGET_SAMPLES)/isom/vc1-wmapro.ism -an
 
-FATE_MICROSOFT-$(CONFIG_VC1_DECODER) += $(FATE_VC1-yes)
-fate-vc1: $(FATE_VC1-yes)
+# the threaded vc1 decoders must give the same output as a single thread
+FATE_VC1_THREADS-$(CONFIG_VC1_DEMUXER)  += fate-vc1_sa00040-frame-threads fate-vc1_sa00040-slice-threads
+FATE_VC1_THREADS-$(CONFIG_VC1_DEMUXER)  += fate-vc1_sa00050-frame-threads fate-vc1_sa00050-slice-threads
+FATE_VC1_THREADS-$(CONFIG_VC1_DEMUXER)  += fate-vc1_sa10091-frame-threads fate-vc1_sa10091-slice-threads
+FATE_VC1_THREADS-$(CONFIG_VC1_DEMUXER)  += fate-vc1_sa10143-frame-threads fate-vc1_sa10143-slice-threads
+FATE_VC1_THREADS-$(CONFIG_VC1_DEMUXER)  += fate-vc1_sa20021-frame-threads fate-vc1_sa20021-slice-threads
+FATE_VC1_THREADS-$(CONFIG_VC1_DEMUXER)  += fate-vc1_ilaced_twomv-frame-threads fate-vc1_ilaced_twomv-slice-threads
+FATE_VC1_THREADS-$(CONFIG_VC1T_DEMUXER) += fate-vc1test_smm0005-frame-threads fate-vc1test_smm0005-slice-threads
+FATE_VC1_THREADS-$(CONFIG_VC1T_DEMUXER) += fate-vc1test_smm0015-frame-threads fate-vc1test_smm0015-slice-threads
+FATE_VC1_THREADS-$(CONFIG_MOV_DEMUXER)  += fate-vc1-ism-frame-threads fate-vc1-ism-slice-threads
+fate-vc1_sa00040-%-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA00040.vc1
+fate-vc1_sa00050-%-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA00050.vc1
+fate-vc1_sa10091-%-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA10091.vc1
+fate-vc1_sa10143-%-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA10143.vc1
+fate-vc1_sa20021-%-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA20021.vc1
+fate-vc1_ilaced_twomv-%-threads: CMD = framecrc -flags +bitexact -i $(TARGET_SAMPLES)/vc1/ilaced_twomv.vc1
+fate-vc1test_smm0005-%-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SMM0005.rcv
+fate-vc1test_smm0015-%-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SMM0015.rcv
+fate-vc1-ism-%-threads: CMD = framecrc -i $(TARGET_SAMPLES)/isom/vc1-wmapro.ism -an
+$(FATE_VC1_THREADS-yes): THREADS = 3
+$(filter %-frame-threads, $(FATE_VC1_THREADS-yes)): THREAD_TYPE = frame
+$(filter %-slice-threads, $(FATE_VC1_THREADS-yes)): THREAD_TYPE = slice
+$(FATE_VC1_THREADS-yes): REF = $(SRC_PATH)/tests/ref/fate/$(patsubst fate-%-frame-threads,%,$(@:fate-%-slice-threads=%))
+
+FATE_MICROSOFT-$(CONFIG_VC1_DECODER) += $(FATE_VC1-yes) $(FATE_VC1_THREADS-yes)
+fate-vc1: $(FATE_VC1-yes) $(FATE_VC1_THREADS-yes)
 
 FATE_MICROSOFT-$(CONFIG_ASF_DEMUXER) += fate-asf-repldata
 fate-asf-repldata: CMD = framecrc -i $(TARGET_SAMPLES)/asf/bug821-2.asf -c copy
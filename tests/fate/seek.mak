@@ -246,6 +246,18 @@ fate-seek-lavf-y4m:      SRC = lavf/lavf.y4m
 
 FATE_SEEK += $(FATE_SEEK_LAVF-yes:%=fate-seek-lavf-%)
 
+# the lazy mov index must seek like the full one
+FATE_SEEK_LAZY_INDEX-$(call ENCDEC,  ALAC,            MOV) += fate-seek-acodec-alac-lazy-index
+FATE_SEEK_LAZY_INDEX-$(call ENCDEC2, MPEG4, PCM_ALAW, MOV) += fate-seek-lavf-mov-lazy-index
+fate-seek-acodec-alac-lazy-index: fate-acodec-alac
+fate-seek-acodec-alac-lazy-index: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/fate/acodec-alac.mov -advanced_editlist 0 -lazy_index 1
+fate-seek-acodec-alac-lazy-index: REF = $(SRC_PATH)/tests/ref/seek/acodec-alac
+fate-seek-lavf-mov-lazy-index: fate-lavf-mov
+fate-seek-lavf-mov-lazy-index: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.mov -advanced_editlist 0 -lazy_index 1
+fate-seek-lavf-mov-lazy-index: REF = $(SRC_PATH)/tests/ref/seek/lavf-mov
+$(FATE_SEEK_LAZY_INDEX-yes): libavformat/tests/seek$(EXESUF)
+FATE_AVCONV += $(FATE_SEEK_LAZY_INDEX-yes)
+
 # extra files
 
 FATE_SEEK_EXTRA-$(CONFIG_MP3_DEMUXER)   += fate-seek-extra-mp3
@@ -275,4 +287,4 @@ fate-seek-%: REF = $(SRC_PATH)/tests/ref/seek/$(@:fate-seek-%=%)
 
 FATE_AVCONV += $(FATE_SEEK)
 FATE_SAMPLES_AVCONV += $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA)
-fate-seek:     $(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA)
+fate-seek:     $(FATE_SEEK) $(FATE_SAMPLES_SEEK) $(FATE_SEEK_EXTRA) $(FATE_SEEK_LAZY_INDEX-yes)
@@ -243,6 +243,16 @@ fate-vsynth%-mjpeg-trell:             ENCOPTS = -qscale 9 -pix_fmt yuvj420p -tre
 fate-vsynth%-mjpeg-huffman:           ENCOPTS = -qscale 9 -pix_fmt yuvj420p -huffman optimal
 fate-vsynth%-mjpeg-trell-huffman:     ENCOPTS = -qscale 9 -pix_fmt yuvj420p -trellis 1 -huffman optimal
 
+# slice threaded encoding puts a restart marker after each macroblock row
+FATE_VCODEC-$(call ENCDEC, MJPEG, AVI)  += mjpeg-rst mjpeg-rst-frame-threads mjpeg-rst-slice-threads
+fate-vsynth%-mjpeg-rst:               ENCOPTS = -qscale 9 -pix_fmt yuvj420p -threads 3 -thread_type slice
+fate-vsynth%-mjpeg-rst-frame-threads: ENCOPTS = -qscale 9 -pix_fmt yuvj420p -threads 3 -thread_type slice
+fate-vsynth%-mjpeg-rst-frame-threads: THREADS = 3
+fate-vsynth%-mjpeg-rst-frame-threads: THREAD_TYPE = frame
+fate-vsynth%-mjpeg-rst-slice-threads: ENCOPTS = -qscale 9 -pix_fmt yuvj420p -threads 3 -thread_type slice
+fate-vsynth%-mjpeg-rst-slice-threads: THREADS = 3
+fate-vsynth%-mjpeg-rst-slice-threads: THREAD_TYPE = slice
+
 FATE_VCODEC-$(call ENCDEC, MPEG1VIDEO, MPEG1VIDEO MPEGVIDEO) += mpeg1 mpeg1b
 fate-vsynth%-mpeg1:              FMT     = mpeg1video
 fate-vsynth%-mpeg1:              CODEC   = mpeg1video
@@ -463,7 +473,10 @@ FATE_VCODEC-$(call ENCDEC, ZLIB, AVI) += zlib
 FATE_VCODEC += $(FATE_VCODEC-yes)
 FATE_VSYNTH1 = $(FATE_VCODEC:%=fate-vsynth1-%)
 FATE_VSYNTH2 = $(FATE_VCODEC:%=fate-vsynth2-%)
-FATE_VSYNTH_LENA = $(FATE_VCODEC:%=fate-vsynth_lena-%)
+# The threaded decodes are compared on the synthetic inputs only
+VSYNTH_LENA_OFF  = mjpeg-rst mjpeg-rst-frame-threads mjpeg-rst-slice-threads
+FATE_VCODEC_LENA = $(filter-out $(VSYNTH_LENA_OFF),$(FATE_VCODEC))
+FATE_VSYNTH_LENA = $(FATE_VCODEC_LENA:%=fate-vsynth_lena-%)
 # Redundant tests because they just resize the input
 RESIZE_OFF   = dnxhd-720p dnxhd-720p-rd dnxhd-720p-10bit dnxhd-1080i \
                dv dv-411 dv-50 avui snow snow-hpel snow-ll vc2-420p \
@@ -373,6 +373,19 @@ fate-xxan-wc4: CMD = framecrc -i $(TARGET_SAMPLES)/wc4-xan/wc4trailer-partial.av
 FATE_VIDEO-$(call DEMDEC, WAV, SMVJPEG) += fate-smvjpeg
 fate-smvjpeg: CMD = framecrc -idct simple -flags +bitexact -i $(TARGET_SAMPLES)/smv/clock.smv -an
 
+# the threaded mjpeg decoders must give the same output as a single thread
+FATE_MJPEG_THREADS-$(call DEMDEC, AVI, MJPEG)   += fate-mjpeg-ticket3229-frame-threads fate-mjpeg-ticket3229-slice-threads
+FATE_MJPEG_THREADS-$(call DEMDEC, MXG, MXPEG)   += fate-mxpeg-frame-threads fate-mxpeg-slice-threads
+FATE_MJPEG_THREADS-$(call DEMDEC, WAV, SMVJPEG) += fate-smvjpeg-frame-threads fate-smvjpeg-slice-threads
+fate-mjpeg-ticket3229-%-threads: CMD = framecrc -idct simple -fflags +bitexact -i $(TARGET_SAMPLES)/mjpeg/mjpeg_field_order.avi -an
+fate-mxpeg-%-threads: CMD = framecrc -idct simple -flags +bitexact -i $(TARGET_SAMPLES)/mxpeg/m1.mxg -an
+fate-smvjpeg-%-threads: CMD = framecrc -idct simple -flags +bitexact -i $(TARGET_SAMPLES)/smv/clock.smv -an
+$(FATE_MJPEG_THREADS-yes): THREADS = 3
+$(filter %-frame-threads, $(FATE_MJPEG_THREADS-yes)): THREAD_TYPE = frame
+$(filter %-slice-threads, $(FATE_MJPEG_THREADS-yes)): THREAD_TYPE = slice
+$(FATE_MJPEG_THREADS-yes): REF = $(SRC_PATH)/tests/ref/fate/$(patsubst fate-%-frame-threads,%,$(@:fate-%-slice-threads=%))
+FATE_VIDEO += $(FATE_MJPEG_THREADS-yes)
+
 FATE_VIDEO += $(FATE_VIDEO-yes)
 
 FATE_SAMPLES_FFMPEG += $(FATE_VIDEO)
@@ -76,6 +76,7 @@ struct hash_impl {
 #include "libavutil/sha512.h"
 #include "libavutil/ripemd.h"
 #include "libavutil/aes.h"
+#include "libavutil/aes_ctr.h"
 #include "libavutil/blowfish.h"
 #include "libavutil/camellia.h"
 #include "libavutil/cast5.h"
@@ -110,6 +111,20 @@ DEFINE_LAVU_MD(sha512,    AVSHA512, sha512, 512);
 DEFINE_LAVU_MD(ripemd128, AVRIPEMD, ripemd, 128);
 DEFINE_LAVU_MD(ripemd160, AVRIPEMD, ripemd, 160);
 
+static void run_lavu_crc32(uint8_t *output,
+                           const uint8_t *input, unsigned size)
+{
+    const AVCRC *crc = av_crc_get_table(AV_CRC_32_IEEE);
+    AV_WB32(output, av_bswap32(av_crc(crc, UINT32_MAX, input, size)));
+}
+
+static void run_lavu_crc32le(uint8_t *output,
+                             const uint8_t *input, unsigned size)
+{
+    const AVCRC *crc = av_crc_get_table(AV_CRC_32_IEEE_LE);
+    AV_WB32(output, av_crc(crc, UINT32_MAX, input, size) ^ UINT32_MAX);
+}
+
 static void run_lavu_aes128(uint8_t *output,
                             const uint8_t *input, unsigned size)
 {
@@ -120,6 +135,31 @@ static void run_lavu_aes128(uint8_t *output,
     av_aes_crypt(aes, output, input, size >> 4, NULL, 0);
 }
 
+static void run_lavu_aes128cbc(uint8_t *output,
+                               const uint8_t *input, unsigned size)
+{
+    static struct AVAES *aes;
+    uint8_t iv[16] = { 0 };
+    if (!aes && !(aes = av_aes_alloc()))
+        fatal_error("out of memory");
+    av_aes_init(aes, hardcoded_key, 128, 1);
+    av_aes_crypt(aes, output, input, size >> 4, iv, 1);
+}
+
+static void run_lavu_aes128ctr(uint8_t *output,
+                               const uint8_t *input, unsigned size)
+{
+    static struct AVAESCTR *aes;
+    static const uint8_t iv[AES_CTR_IV_SIZE] = { 0 };
+    if (!aes) {
+        if (!(aes = av_aes_ctr_alloc()) ||
+            av_aes_ctr_init(aes, hardcoded_key) < 0)
+            fatal_error("out of memory");
+    }
+    av_aes_ctr_set_iv(aes, iv);
+    av_aes_ctr_crypt(aes, output, input, size);
+}
+
 static void run_lavu_blowfish(uint8_t *output,
                               const uint8_t *input, unsigned size)
 {
@@ -205,6 +245,7 @@ static void run_lavu_xtea(uint8_t *output,
 #include <openssl/camellia.h>
 #include <openssl/cast.h>
 #include <openssl/des.h>
+#include <openssl/evp.h>
 #include <openssl/rc4.h>
 
 #define DEFINE_CRYPTO_WRAPPER(suffix, function)                              \
@@ -232,6 +273,30 @@ static void run_crypto_aes128(uint8_t *output,
         AES_encrypt(input + i, output + i, &aes);
 }
 
+static void run_crypto_aes128cbc(uint8_t *output,
+                                 const uint8_t *input, unsigned size)
+{
+    AES_KEY aes;
+    uint8_t iv[16] = { 0 };
+
+    AES_set_decrypt_key(hardcoded_key, 128, &aes);
+    AES_cbc_encrypt(input, output, size & ~15, &aes, iv, AES_DECRYPT);
+}
+
+static void run_crypto_aes128ctr(uint8_t *output,
+                                 const uint8_t *input, unsigned size)
+{
+    static const uint8_t iv[16] = { 0 };
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int len;
+
+    if (!ctx)
+        fatal_error("out of memory");
+    EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), NULL, hardcoded_key, iv);
+    EVP_EncryptUpdate(ctx, output, &len, input, size);
+    EVP_CIPHER_CTX_free(ctx);
+}
+
 static void run_crypto_blowfish(uint8_t *output,
                                 const uint8_t *input, unsigned size)
 {
@@ -646,7 +711,13 @@ struct hash_impl implementations[] = {
     IMPL(lavu,     "RIPEMD-128", ripemd128, "9ab8bfba2ddccc5d99c9d4cdfb844a5f")
     IMPL(tomcrypt, "RIPEMD-128", ripemd128, "9ab8bfba2ddccc5d99c9d4cdfb844a5f")
     IMPL_ALL("RIPEMD-160", ripemd160, "62a5321e4fc8784903bb43ab7752c75f8b25af00")
+    IMPL(lavu,     "CRC-32",    crc32,   "471004e5")
+    IMPL(lavu,     "CRC-32-LE", crc32le, "12554ca6")
     IMPL_ALL("AES-128",    aes128,    "crc:ff6bc888")
+    IMPL(lavu,     "AES-128-CBC", aes128cbc, "crc:ae4a81eb")
+    IMPL(crypto,   "AES-128-CBC", aes128cbc, "crc:ae4a81eb")
+    IMPL(lavu,     "AES-128-CTR", aes128ctr, "crc:b9fd39aa")
+    IMPL(crypto,   "AES-128-CTR", aes128ctr, "crc:b9fd39aa")
     IMPL_ALL("CAMELLIA",   camellia,  "crc:7abb59a7")
     IMPL(lavu,     "CAST-128", cast128, "crc:456aa584")
     IMPL(crypto,   "CAST-128", cast128, "crc:456aa584")